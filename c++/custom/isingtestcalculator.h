@@ -70,6 +70,12 @@ public:
      */
     bool cacheRates() const;
 
+    /*! \brief Function for indicating that the calculator only reads the
+     *         configuration and may be called from several threads at once.
+     *  \return : true.
+     */
+    virtual bool threadSafe() const { return true; }
+
     /*! \brief Function for indicating which process numbers should be
      *         excluded from caching.
      *  \return : A vector containing the process numbers to exclude.
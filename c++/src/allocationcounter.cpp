@@ -0,0 +1,160 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  allocationcounter.cpp
+ *  \brief File for the implementation code of the heap allocation counter.
+ */
+
+#include "allocationcounter.h"
+
+#include <cstdlib>
+#include <new>
+
+
+#ifndef KMCLIB_COUNT_ALLOCATIONS
+// -----------------------------------------------------------------------------
+//
+long heapAllocations()
+{
+    return -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void countHeapAllocation()
+{
+    // NOTHING HERE
+}
+
+
+#else
+// The number of heap allocations made by each thread. A per-thread count
+// needs no synchronization, which keeps the cost of counting negligible.
+static thread_local long n_heap_allocations__ = 0;
+
+
+// -----------------------------------------------------------------------------
+//
+long heapAllocations()
+{
+    return n_heap_allocations__;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void countHeapAllocation()
+{
+    ++n_heap_allocations__;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void* operator new(std::size_t size)
+{
+    ++n_heap_allocations__;
+
+    // Allocate at least one byte so that each call gets a unique pointer.
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    while (ptr == NULL)
+    {
+        std::new_handler handler = std::set_new_handler(NULL);
+        std::set_new_handler(handler);
+        if (handler == NULL)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+        ptr = std::malloc(size == 0 ? 1 : size);
+    }
+    return ptr;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (std::bad_alloc &)
+    {
+        return NULL;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void* operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void operator delete(void* ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void operator delete[](void* ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+
+#if __cplusplus >= 201402L
+// -----------------------------------------------------------------------------
+//
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+#endif // KMCLIB_COUNT_ALLOCATIONS
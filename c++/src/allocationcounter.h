@@ -0,0 +1,38 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  allocationcounter.h
+ *  \brief File for the heap allocation counter interface. For checking
+ *         that the steady-state stepping does not allocate, the global
+ *         operator new is replaced in allocationcounter.cpp to count the
+ *         allocations made by the backend. The counting is a debug aid and
+ *         is only compiled in with KMCLIB_COUNT_ALLOCATIONS defined, as it
+ *         is for the unittests and with the COUNT_ALLOCATIONS cmake option.
+ */
+
+#ifndef __ALLOCATIONCOUNTER__
+#define __ALLOCATIONCOUNTER__
+
+
+/*! \brief Query for the number of heap allocations made by the calling
+ *         thread. This counts all calls to the global operator new and
+ *         all allocations registered with countHeapAllocation().
+ *  \return : The number of heap allocations since the thread started,
+ *            or -1 if the allocations are not counted.
+ */
+long heapAllocations();
+
+
+/*! \brief Register a heap allocation made with malloc or realloc, which
+ *         is not seen by the operator new counting. Does nothing if the
+ *         allocations are not counted.
+ */
+void countHeapAllocation();
+
+
+#endif // __ALLOCATIONCOUNTER__
@@ -0,0 +1,215 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  checkpoint.cpp
+ *  \brief File for the implementation code of the checkpoint reader and writer.
+ */
+
+#include "checkpoint.h"
+
+#include <cstring>
+
+// POSIX, for mapping the file.
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// The first bytes of a checkpoint file.
+static const char magic__[8] = {'K', 'M', 'C', 'L', 'I', 'B', 'C', 'P'};
+
+// Written in the native byte order, for detecting files from other machines.
+static const unsigned int byte_order__ = 0x01020304;
+
+
+// -----------------------------------------------------------------------------
+//
+CheckpointWriter::CheckpointWriter(const std::string & path) :
+    path_(path),
+    tmp_path_(path + ".tmp"),
+    file_(NULL)
+{
+    file_ = std::fopen(tmp_path_.c_str(), "wb");
+    if (file_ == NULL)
+    {
+        throw std::runtime_error("Could not open the checkpoint file " + tmp_path_ + " for writing.");
+    }
+
+    write(magic__, sizeof(magic__));
+    write(CHECKPOINT_VERSION);
+    write(byte_order__);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+CheckpointWriter::~CheckpointWriter()
+{
+    if (file_ != NULL)
+    {
+        std::fclose(file_);
+        std::remove(tmp_path_.c_str());
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CheckpointWriter::section(const char * tag)
+{
+    write(tag, 4);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CheckpointWriter::write(const void * data, const size_t n_bytes)
+{
+    if (n_bytes > 0 && std::fwrite(data, 1, n_bytes, file_) != n_bytes)
+    {
+        throw std::runtime_error("Could not write to the checkpoint file " + tmp_path_ + ".");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CheckpointWriter::close()
+{
+    const bool flushed = (std::fflush(file_) == 0 && fsync(fileno(file_)) == 0);
+    const bool closed = (std::fclose(file_) == 0);
+    file_ = NULL;
+
+    if (!flushed || !closed || std::rename(tmp_path_.c_str(), path_.c_str()) != 0)
+    {
+        std::remove(tmp_path_.c_str());
+        throw std::runtime_error("Could not write the checkpoint file " + path_ + ".");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+CheckpointReader::CheckpointReader(const std::string & path) :
+    path_(path),
+    data_(NULL),
+    size_(0),
+    position_(0)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Could not open the checkpoint file " + path + ".");
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Could not open the checkpoint file " + path + ".");
+    }
+    size_ = status.st_size;
+
+    // The mapping stays valid after the file is closed.
+    if (size_ > 0)
+    {
+        void * data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("Could not map the checkpoint file " + path + ".");
+        }
+        data_ = static_cast<const char*>(data);
+        madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    // Check the header, and release the mapping if it is not accepted.
+    try
+    {
+        readHeader();
+    }
+    catch (...)
+    {
+        if (data_ != NULL)
+        {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        throw;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CheckpointReader::readHeader()
+{
+    char magic[sizeof(magic__)];
+    if (size_ < sizeof(magic__))
+    {
+        throw std::runtime_error("The file " + path_ + " is not a checkpoint file.");
+    }
+    read(magic, sizeof(magic__));
+    if (std::memcmp(magic, magic__, sizeof(magic__)) != 0)
+    {
+        throw std::runtime_error("The file " + path_ + " is not a checkpoint file.");
+    }
+
+    if (read<unsigned int>() != CHECKPOINT_VERSION)
+    {
+        throw std::runtime_error("The checkpoint file " + path_ + " was written with another version of the checkpoint format.");
+    }
+
+    if (read<unsigned int>() != byte_order__)
+    {
+        throw std::runtime_error("The checkpoint file " + path_ + " was written with another byte order.");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+CheckpointReader::~CheckpointReader()
+{
+    if (data_ != NULL)
+    {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CheckpointReader::section(const char * tag)
+{
+    char read_tag[4];
+    read(read_tag, 4);
+    if (std::memcmp(read_tag, tag, 4) != 0)
+    {
+        throw std::runtime_error("The checkpoint file " + path_ + " is corrupt, expected the section " +
+                                 std::string(tag, 4) + ".");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CheckpointReader::read(void * data, const size_t n_bytes)
+{
+    if (n_bytes > remaining())
+    {
+        throw std::runtime_error("The checkpoint file " + path_ + " is truncated.");
+    }
+
+    if (n_bytes > 0)
+    {
+        std::memcpy(data, data_ + position_, n_bytes);
+        position_ += n_bytes;
+    }
+}
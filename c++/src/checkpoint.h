@@ -0,0 +1,268 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  checkpoint.h
+ *  \brief File for the binary checkpoint reader and writer.
+ */
+
+#ifndef __CHECKPOINT__
+#define __CHECKPOINT__
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+
+/// The version of the checkpoint format, to be increased with each change
+/// of the layout of the saved state.
+static const unsigned int CHECKPOINT_VERSION = 6;
+
+
+/*! \brief Class for writing a binary checkpoint file. The file starts with
+ *         a header holding the format version and the byte order, and the
+ *         state of each object follows in a tagged section. Values are
+ *         written in the native layout, so that they can be read back with
+ *         a plain copy. The file is written under a temporary name and
+ *         only takes the given name when it is complete, so that an
+ *         interrupted write never replaces a good checkpoint.
+ */
+class CheckpointWriter {
+
+public:
+
+    /*! \brief Constructor, opening the file and writing the header.
+     *  \param path : The path of the checkpoint file.
+     */
+    explicit CheckpointWriter(const std::string & path);
+
+    /*! \brief Destructor, removing the temporary file if close() was
+     *         never called.
+     */
+    ~CheckpointWriter();
+
+    /*! \brief Start a new section of the file.
+     *  \param tag : The four character tag of the section.
+     */
+    void section(const char * tag);
+
+    /*! \brief Write raw bytes to the file.
+     *  \param data    : Pointer to the first byte.
+     *  \param n_bytes : The number of bytes to write.
+     */
+    void write(const void * data, const size_t n_bytes);
+
+    /*! \brief Write a single value.
+     *  \param value : The value to write.
+     */
+    template <class T>
+    void write(const T & value);
+
+    /*! \brief Write a vector of values, preceded by its size.
+     *  \param values : The values to write.
+     */
+    template <class T>
+    void writeVector(const std::vector<T> & values);
+
+    /*! \brief Write an array of values, preceded by its size, in the same
+     *         format as a vector.
+     *  \param values : Pointer to the first value.
+     *  \param size   : The number of values.
+     */
+    template <class T>
+    void writeArray(const T * values, const size_t size);
+
+    /*! \brief Flush the file and give it its final name.
+     */
+    void close();
+
+protected:
+
+private:
+
+    /// The final path of the file.
+    std::string path_;
+
+    /// The path of the file while it is being written.
+    std::string tmp_path_;
+
+    /// The file handle, or NULL when closed.
+    FILE * file_;
+
+    /// Disabled copy.
+    CheckpointWriter(const CheckpointWriter &);
+
+    /// Disabled assignment.
+    CheckpointWriter & operator=(const CheckpointWriter &);
+
+};
+
+
+/*! \brief Class for reading a binary checkpoint file written by the
+ *         CheckpointWriter. The file is mapped into memory and the values
+ *         are copied out of the mapping as they are read.
+ */
+class CheckpointReader {
+
+public:
+
+    /*! \brief Constructor, mapping the file and checking the header.
+     *  \param path : The path of the checkpoint file.
+     */
+    explicit CheckpointReader(const std::string & path);
+
+    /*! \brief Destructor, unmapping the file.
+     */
+    ~CheckpointReader();
+
+    /*! \brief Check that the next section has the given tag.
+     *  \param tag : The four character tag of the section.
+     */
+    void section(const char * tag);
+
+    /*! \brief Read raw bytes from the file.
+     *  \param data (out) : Pointer to the storage to copy the bytes to.
+     *  \param n_bytes    : The number of bytes to read.
+     */
+    void read(void * data, const size_t n_bytes);
+
+    /*! \brief Read a single value.
+     *  \return : The value read.
+     */
+    template <class T>
+    T read();
+
+    /*! \brief Read a vector of values written with writeVector.
+     *  \param values (out) : The vector to overwrite with the values.
+     */
+    template <class T>
+    void readVector(std::vector<T> & values);
+
+    /*! \brief Read a vector or array of values into an array of the same size.
+     *  \param values (out) : Pointer to the first value to overwrite.
+     *  \param size         : The number of values of the array.
+     */
+    template <class T>
+    void readArray(T * values, const size_t size);
+
+    /*! \brief Query for the number of bytes not yet read.
+     *  \return : The number of bytes left in the file.
+     */
+    size_t remaining() const { return size_ - position_; }
+
+protected:
+
+private:
+
+    /*! \brief Read and check the header of the file.
+     */
+    void readHeader();
+
+    /// The path of the file, for the error messages.
+    std::string path_;
+
+    /// The start of the mapped file.
+    const char * data_;
+
+    /// The size of the file.
+    size_t size_;
+
+    /// The position of the next byte to read.
+    size_t position_;
+
+    /// Disabled copy.
+    CheckpointReader(const CheckpointReader &);
+
+    /// Disabled assignment.
+    CheckpointReader & operator=(const CheckpointReader &);
+
+};
+
+
+// -------------------------------------------------------------------------- //
+// TEMPLATE IMPLEMENTATION CODE FOLLOW
+//
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+void CheckpointWriter::write(const T & value)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be written as bytes.");
+    write(&value, sizeof(T));
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+void CheckpointWriter::writeVector(const std::vector<T> & values)
+{
+    writeArray(values.data(), values.size());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+void CheckpointWriter::writeArray(const T * values, const size_t size)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be written as bytes.");
+    write(static_cast<unsigned long>(size));
+    write(values, size * sizeof(T));
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+T CheckpointReader::read()
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be read as bytes.");
+    T value;
+    read(&value, sizeof(T));
+    return value;
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+void CheckpointReader::readVector(std::vector<T> & values)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be read as bytes.");
+    const unsigned long size = read<unsigned long>();
+    if (size > remaining() / sizeof(T))
+    {
+        throw std::runtime_error("The checkpoint file " + path_ + " is truncated.");
+    }
+    values.resize(size);
+    read(values.data(), size * sizeof(T));
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+void CheckpointReader::readArray(T * values, const size_t size)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be read as bytes.");
+    if (read<unsigned long>() != size)
+    {
+        throw std::runtime_error("The checkpoint file " + path_ + " does not match the size of the array read.");
+    }
+    read(values, size * sizeof(T));
+}
+
+
+#endif // __CHECKPOINT__
@@ -0,0 +1,302 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  compositionrejection.cpp
+ *  \brief File for the implementation code of the CompositionRejection class.
+ */
+
+#include <cmath>
+#include <stdexcept>
+
+#include "compositionrejection.h"
+#include "random.h"
+#include "checkpoint.h"
+
+
+// -----------------------------------------------------------------------------
+//
+CompositionRejection::CompositionRejection() :
+    values_(0),
+    slot_class_(0),
+    slot_position_(0),
+    classes_(0)
+{
+    // NOTHING HERE
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::update(const size_t i, const double value)
+{
+    removeFromClass(i);
+    values_[i] = value;
+    addToClass(i);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::push_back(const double value)
+{
+    values_.push_back(value);
+    slot_class_.push_back(-1);
+    slot_position_.push_back(0);
+    addToClass(values_.size()-1);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::pop_back()
+{
+    removeFromClass(values_.size()-1);
+    values_.pop_back();
+    slot_class_.pop_back();
+    slot_position_.pop_back();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::clear()
+{
+    values_.clear();
+    slot_class_.clear();
+    slot_position_.clear();
+    classes_.clear();
+    exponent_to_class_.clear();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double CompositionRejection::total() const
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        sum += classes_[i].sum;
+    }
+    return sum;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+int CompositionRejection::nClasses() const
+{
+    int n = 0;
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        if (!classes_[i].slots.empty())
+        {
+            ++n;
+        }
+    }
+    return n;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+size_t CompositionRejection::pick() const
+{
+    // Composition step: pick a class by its total weight. The number of
+    // classes is bounded by the spread of the weights, not by the number
+    // of slots, so a linear search is used here.
+    const double rnd = randomDouble01() * total();
+
+    int picked_class = -1;
+    double accumulated = 0.0;
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        if (classes_[i].slots.empty())
+        {
+            continue;
+        }
+
+        picked_class = i;
+        accumulated += classes_[i].sum;
+        if (rnd < accumulated)
+        {
+            break;
+        }
+    }
+
+    // With all weights zero, or no slots at all, there is nothing to pick.
+    if (picked_class < 0)
+    {
+        throw std::runtime_error("No slot with non-zero weight to pick.");
+    }
+
+    // Rejection step: pick a slot uniformly within the class and accept
+    // it with the probability of its weight relative to the class bound.
+    // Each trial is accepted with probability at least 1/2.
+    const RateClass & rate_class = classes_[picked_class];
+    const size_t n_slots = rate_class.slots.size();
+    while (true)
+    {
+        size_t j = static_cast<size_t>(randomDouble01() * n_slots);
+        if (j >= n_slots)
+        {
+            j = n_slots - 1;
+        }
+
+        const size_t slot = rate_class.slots[j];
+        if (randomDouble01() * rate_class.upper_bound < values_[slot])
+        {
+            return slot;
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::rebuild()
+{
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        RateClass & rate_class = classes_[i];
+        rate_class.sum = 0.0;
+        for (size_t j = 0; j < rate_class.slots.size(); ++j)
+        {
+            rate_class.sum += values_[rate_class.slots[j]];
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::addToClass(const size_t i)
+{
+    const double value = values_[i];
+
+    // Slots with zero weight are never picked and are kept out of the classes.
+    if (!(value > 0.0))
+    {
+        slot_class_[i] = -1;
+        return;
+    }
+
+    // Get the binary exponent e such that value is in [2^(e-1), 2^e).
+    int exponent;
+    std::frexp(value, &exponent);
+
+    // Find the class for this exponent, or add a new class.
+    std::map<int, int>::const_iterator it1 = exponent_to_class_.find(exponent);
+    int c;
+    if (it1 == exponent_to_class_.end())
+    {
+        c = classes_.size();
+        RateClass rate_class;
+        rate_class.upper_bound = std::ldexp(1.0, exponent);
+        rate_class.sum = 0.0;
+        classes_.push_back(rate_class);
+        exponent_to_class_[exponent] = c;
+    }
+    else
+    {
+        c = it1->second;
+    }
+
+    // Add the slot.
+    RateClass & rate_class = classes_[c];
+    slot_class_[i]    = c;
+    slot_position_[i] = rate_class.slots.size();
+    rate_class.slots.push_back(i);
+    rate_class.sum += value;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::removeFromClass(const size_t i)
+{
+    const int c = slot_class_[i];
+    if (c == -1)
+    {
+        return;
+    }
+
+    RateClass & rate_class = classes_[c];
+
+    // Swap the slot with the last slot in the class and remove it.
+    const size_t position = slot_position_[i];
+    const size_t last     = rate_class.slots.back();
+    rate_class.slots[position] = last;
+    slot_position_[last] = position;
+    rate_class.slots.pop_back();
+
+    // Keep an emptied class exactly at zero, so that no round-off
+    // can make it eligible for picking.
+    if (rate_class.slots.empty())
+    {
+        rate_class.sum = 0.0;
+    }
+    else
+    {
+        rate_class.sum -= values_[i];
+    }
+
+    slot_class_[i] = -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::saveState(CheckpointWriter & writer) const
+{
+    writer.writeVector(values_);
+    writer.writeVector(slot_class_);
+    writer.writeVector(slot_position_);
+
+    writer.write(static_cast<unsigned long>(classes_.size()));
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        writer.write(classes_[i].upper_bound);
+        writer.write(classes_[i].sum);
+        writer.writeVector(classes_[i].slots);
+    }
+
+    writer.write(static_cast<unsigned long>(exponent_to_class_.size()));
+    std::map<int, int>::const_iterator it = exponent_to_class_.begin();
+    for ( ; it != exponent_to_class_.end(); ++it)
+    {
+        writer.write(it->first);
+        writer.write(it->second);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void CompositionRejection::loadState(CheckpointReader & reader)
+{
+    reader.readVector(values_);
+    reader.readVector(slot_class_);
+    reader.readVector(slot_position_);
+
+    classes_.resize(reader.read<unsigned long>());
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        classes_[i].upper_bound = reader.read<double>();
+        classes_[i].sum = reader.read<double>();
+        reader.readVector(classes_[i].slots);
+    }
+
+    exponent_to_class_.clear();
+    const unsigned long n_exponents = reader.read<unsigned long>();
+    for (unsigned long i = 0; i < n_exponents; ++i)
+    {
+        const int exponent = reader.read<int>();
+        exponent_to_class_[exponent] = reader.read<int>();
+    }
+}
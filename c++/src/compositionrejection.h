@@ -0,0 +1,149 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  compositionrejection.h
+ *  \brief File for the CompositionRejection class definition.
+ */
+
+#ifndef __COMPOSITIONREJECTION__
+#define __COMPOSITIONREJECTION__
+
+#include <vector>
+#include <map>
+#include <cstddef>
+
+// Forward declarations.
+class CheckpointWriter;
+class CheckpointReader;
+
+
+/*! \brief Class for keeping a set of non-negative weights grouped in
+ *         power-of-two classes for composition-rejection sampling, as
+ *         described in J.Chem.Phys. 128, 205101, (2008). A slot with
+ *         weight w in [2^(e-1), 2^e) belongs to the class e. A class is
+ *         first picked by its total weight, and a slot is then picked
+ *         uniformly within the class and accepted with probability
+ *         w / 2^e >= 1/2. Updates are constant time and the expected cost
+ *         of a pick is independent of the number of slots; it scales only
+ *         with the number of classes, i.e. with the spread of the weights.
+ */
+class CompositionRejection {
+
+public:
+
+    /*! \brief Default constructor, giving an empty structure.
+     */
+    CompositionRejection();
+
+    /*! \brief Query for the number of slots.
+     *  \return : The number of slots.
+     */
+    size_t size() const { return values_.size(); }
+
+    /*! \brief Set the weight of a slot.
+     *  \param i     : The slot to update.
+     *  \param value : The new weight of the slot.
+     */
+    void update(const size_t i, const double value);
+
+    /*! \brief Append a slot at the end.
+     *  \param value : The weight of the new slot.
+     */
+    void push_back(const double value);
+
+    /*! \brief Remove the last slot.
+     */
+    void pop_back();
+
+    /*! \brief Remove all slots and classes.
+     */
+    void clear();
+
+    /*! \brief Query for the weight of a slot.
+     *  \param i : The slot to get the weight for.
+     *  \return : The weight stored at the slot.
+     */
+    double value(const size_t i) const { return values_[i]; }
+
+    /*! \brief Query for the sum of all weights.
+     *  \return : The total weight.
+     */
+    double total() const;
+
+    /*! \brief Query for the number of weight classes in use.
+     *  \return : The number of classes holding at least one slot.
+     */
+    int nClasses() const;
+
+    /*! \brief Pick a slot with probability proportional to its weight.
+     *         Throws a std::runtime_error if there is no slot with
+     *         non-zero weight.
+     *  \return : The picked slot.
+     */
+    size_t pick() const;
+
+    /*! \brief Recalculate the total weight of each class from the stored
+     *         weights. This removes any accumulated round-off.
+     */
+    void rebuild();
+
+    /*! \brief Write the weights and classes to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the weights and classes written by saveState, with the
+     *         slots of each class in the order they were written.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
+protected:
+
+private:
+
+    /// A minimal struct for representing a power-of-two weight class.
+    struct RateClass
+    {
+        /// The upper bound 2^e of the weights in this class.
+        double upper_bound;
+        /// The total weight of the slots in this class.
+        double sum;
+        /// The slots in this class.
+        std::vector<size_t> slots;
+    };
+
+    /*! \brief Add a slot to the class matching its weight.
+     *  \param i : The slot to add.
+     */
+    void addToClass(const size_t i);
+
+    /*! \brief Remove a slot from its present class.
+     *  \param i : The slot to remove.
+     */
+    void removeFromClass(const size_t i);
+
+    /// The weight of each slot.
+    std::vector<double> values_;
+
+    /// The class of each slot, -1 for slots with zero weight.
+    std::vector<int> slot_class_;
+
+    /// The position of each slot in the slot list of its class.
+    std::vector<size_t> slot_position_;
+
+    /// The weight classes.
+    std::vector<RateClass> classes_;
+
+    /// Mapping from the binary exponent to the weight class.
+    std::map<int, int> exponent_to_class_;
+
+};
+
+
+#endif // __COMPOSITIONREJECTION__
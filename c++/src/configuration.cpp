@@ -13,15 +13,48 @@
 
 #include <cstdio>
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <stdexcept>
 
 #include "configuration.h"
 #include "latticemap.h"
 #include "process.h"
 #include "matchlist.h"
+#include "threadtasks.h"
+#include "checkpoint.h"
 
-// Temporary data for the match list return.
-static ConfigBucketMatchList tmp_match_list__(0);
+// Temporary data for the match list return, one per thread.
+static thread_local ConfigBucketMatchList tmp_match_list__(0);
+
+
+// -----------------------------------------------------------------------------
+// The mapping from type integers to names.
+static std::vector<std::string> typeNamesFromMap(const std::map<std::string,int> & possible_types)
+{
+    // Loop through the possible types map and find out what the maximum is.
+    std::map<std::string,int>::const_iterator it1 = possible_types.begin();
+    int max_type = 0;
+    for ( ; it1 != possible_types.end(); ++it1)
+    {
+        if (it1->second > max_type)
+        {
+            max_type = it1->second;
+        }
+    }
+
+    // Set the size of the type names list.
+    std::vector<std::string> type_names(max_type+1);
+
+    // Fill the list.
+    it1 = possible_types.begin();
+    for ( ; it1 != possible_types.end(); ++it1 )
+     {
+         type_names[it1->second] = it1->first;
+     }
+
+    return type_names;
+}
 
 
 // -----------------------------------------------------------------------------
@@ -30,10 +63,26 @@ Configuration::Configuration(const std::vector<std::vector<double> >  & coordina
                              const std::vector<std::vector<std::string> > & elements,
                              const std::map<std::string,int> & possible_types) :
     n_moved_(0),
+    storage_(elements.size(), typeNamesFromMap(possible_types).size()),
     elements_(elements),
     atom_id_elements_(elements_.size()),
-    match_lists_(elements_.size()),
+    stale_elements_(0),
+    stale_element_flags_(elements_.size(), 0),
+    stale_atom_id_elements_(0),
+    stale_atom_id_flags_(elements_.size(), 0),
+    type_names_(typeNamesFromMap(possible_types)),
+    match_list_geometries_(1),
+    match_list_geometry_(elements_.size(), 0),
+    match_list_indices_(0),
+    match_list_offsets_(elements_.size() + 1, 0),
+    match_list_signatures_(elements_.size(), 0),
+    packed_match_types_(elements_.size()),
+    containing_entries_(0),
+    containing_offsets_(elements_.size() + 1, 0),
+    changed_match_lists_(elements_.size(), 0),
     possible_types_(possible_types),
+    single_occupancy_(false),
+    site_types_(0),
     latest_event_process_(0),
     latest_event_site_(0)
 {
@@ -42,48 +91,33 @@ Configuration::Configuration(const std::vector<std::vector<double> >  & coordina
     //            present, only the first atom will be detected and labeled with correct ID.
     //            This must be handeled in a generic way in the release version.
 
+    const int n_types = type_names_.size();
+    SiteArray<Coordinate> & site_coordinates = storage_.coordinates();
+    SiteArray<int> & atom_id = storage_.atomID();
+    SiteArray<int> & first_types = storage_.firstTypes();
+    SiteArray<int> & atom_id_types = storage_.atomIDTypes();
+    SiteArray<int> & type_counts = storage_.typeCounts();
 
     // Setup the coordinates and initial atom ids.
     for (size_t i = 0; i < coordinates.size(); ++i)
     {
-        coordinates_.push_back( Coordinate(coordinates[i][0],
-                                           coordinates[i][1],
-                                           coordinates[i][2]));
+        site_coordinates[i] = Coordinate(coordinates[i][0],
+                                         coordinates[i][1],
+                                         coordinates[i][2]);
         // FIXME
-        atom_id_.push_back(i);
+        atom_id[i] = i;
 
         // FIXME
         atom_id_elements_[i] = elements_[i][0];
     }
 
     // Set the atom id coordinates to the same as the coordinates to start with.
-    atom_id_coordinates_ = coordinates_;
-
-    // Loop through the possible types map and find out what the maximum is.
-    std::map<std::string,int>::const_iterator it1 = possible_types.begin();
-    int max_type = 0;
-    for ( ; it1 != possible_types.end(); ++it1)
-    {
-        if (it1->second > max_type)
-        {
-            max_type = it1->second;
-        }
-    }
-
-    // Set the size of the type names list.
-    type_names_ = std::vector<std::string>(max_type+1);
-
-    // Fill the list.
-    it1 = possible_types.begin();
-    for ( ; it1 != possible_types.end(); ++it1 )
-     {
-         type_names_[it1->second] = it1->first;
-     }
+    std::copy(site_coordinates.begin(), site_coordinates.end(),
+              storage_.atomIDCoordinates().begin());
 
     // Setup the types from the elements strings.
     for (size_t i = 0; i < elements_.size(); ++i)
     {
-        TypeBucket tb(type_names_.size());
         for (size_t j = 0; j < elements_[i].size(); ++j)
         {
             // Get the element out at this point.
@@ -93,11 +127,303 @@ Configuration::Configuration(const std::vector<std::vector<double> >  & coordina
             const int type = possible_types.find(element)->second;
 
             // Increase this type counter.
-            tb[type] += 1;
+            type_counts[i * n_types + type] += 1;
+
+            // The first element gives the type of the atom id.
+            if (j == 0)
+            {
+                first_types[i] = type;
+                atom_id_types[i] = type;
+            }
         }
+    }
+}
 
-        // Add to the types vector.
-        types_.push_back(tb);
+
+// -----------------------------------------------------------------------------
+//
+Configuration::Configuration(const std::string & storage_path,
+                             const std::map<std::string,int> & possible_types) :
+    n_moved_(0),
+    storage_(storage_path),
+    elements_(0),
+    atom_id_elements_(0),
+    stale_elements_(0),
+    stale_element_flags_(storage_.size(), 0),
+    stale_atom_id_elements_(0),
+    stale_atom_id_flags_(storage_.size(), 0),
+    type_names_(typeNamesFromMap(possible_types)),
+    match_list_geometries_(1),
+    match_list_geometry_(storage_.size(), 0),
+    match_list_indices_(0),
+    match_list_offsets_(storage_.size() + 1, 0),
+    match_list_signatures_(storage_.size(), 0),
+    packed_match_types_(storage_.size()),
+    containing_entries_(0),
+    containing_offsets_(storage_.size() + 1, 0),
+    changed_match_lists_(storage_.size(), 0),
+    possible_types_(possible_types),
+    single_occupancy_(false),
+    site_types_(0),
+    latest_event_process_(0),
+    latest_event_site_(0)
+{
+    const int n_types = type_names_.size();
+    if (storage_.nTypes() != n_types)
+    {
+        throw std::runtime_error("The site storage file " + storage_path + " is for another number of types.");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// The first type present in a bucket, in the order the element strings
+// are written in.
+static int firstPresentType(const TypeBucket & types)
+{
+    for (int i = 0; i < types.size(); ++i)
+    {
+        if (types[i] > 0)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+const std::vector<std::vector<std::string> > & Configuration::elements() const
+{
+    // The elements of a configuration mapped from a site storage file are
+    // set up on the first query.
+    if (elements_.size() != storage_.size())
+    {
+        elements_.resize(storage_.size());
+        stale_elements_.resize(storage_.size());
+        for (size_t i = 0; i < storage_.size(); ++i)
+        {
+            stale_elements_[i] = i;
+            stale_element_flags_[i] = 1;
+        }
+    }
+
+    // Overwrite the element strings of the stale indices in place, so
+    // that their storage is reused.
+    for (size_t k = 0; k < stale_elements_.size(); ++k)
+    {
+        const int index = stale_elements_[k];
+        const TypeBucket types = siteTypes(index);
+        std::vector<std::string> & elements_at_index = elements_[index];
+        size_t n_elements = 0;
+        for (int i = 0; i < types.size(); ++i)
+        {
+            for (int j = 0; j < types[i]; ++j)
+            {
+                if (n_elements < elements_at_index.size())
+                {
+                    elements_at_index[n_elements] = type_names_[i];
+                }
+                else
+                {
+                    elements_at_index.push_back(type_names_[i]);
+                }
+                ++n_elements;
+            }
+        }
+        elements_at_index.resize(n_elements);
+        stale_element_flags_[index] = 0;
+    }
+    stale_elements_.clear();
+
+    return elements_;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+const std::vector<std::string> & Configuration::atomIDElements() const
+{
+    const SiteArray<int> & atom_id_types = storage_.atomIDTypes();
+    if (atom_id_elements_.size() != atom_id_types.size())
+    {
+        atom_id_elements_.resize(atom_id_types.size());
+        stale_atom_id_elements_.resize(atom_id_types.size());
+        for (size_t i = 0; i < atom_id_types.size(); ++i)
+        {
+            stale_atom_id_elements_[i] = i;
+            stale_atom_id_flags_[i] = 1;
+        }
+    }
+
+    for (size_t k = 0; k < stale_atom_id_elements_.size(); ++k)
+    {
+        const int atom_id = stale_atom_id_elements_[k];
+        atom_id_elements_[atom_id] = type_names_[atom_id_types[atom_id]];
+        stale_atom_id_flags_[atom_id] = 0;
+    }
+    stale_atom_id_elements_.clear();
+
+    return atom_id_elements_;
+}
+
+
+// -----------------------------------------------------------------------------
+// Two match lists have the same geometry if they have the same points in
+// the same order.
+static bool sameGeometry(const ConfigBucketMatchList & geometry,
+                         const ConfigBucketMatchList & match_list)
+{
+    if (geometry.size() != match_list.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < geometry.size(); ++i)
+    {
+        if (!samePoint(geometry[i], match_list[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// Two lists of points are the same if each pair of points is within the
+// tolerance used for comparing match list entries.
+static bool samePoints(const std::vector<Coordinate> & points1,
+                       const std::vector<Coordinate> & points2)
+{
+    if (points1.size() != points2.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < points1.size(); ++i)
+    {
+        if (std::fabs(points1[i].x() - points2[i].x()) > 1.0e-5 ||
+            std::fabs(points1[i].y() - points2[i].y()) > 1.0e-5 ||
+            std::fabs(points1[i].z() - points2[i].z()) > 1.0e-5)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+struct Configuration::MatchListChunk
+{
+    /// The distinct geometries of the chunk.
+    std::vector<ConfigBucketMatchList> geometries;
+
+    /// The entry indices of the match lists of the chunk, one after the other.
+    std::vector<int> indices;
+};
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::initMatchListChunk(const LatticeMap & lattice_map,
+                                       const int range,
+                                       const size_t first,
+                                       const size_t last,
+                                       MatchListChunk & chunk)
+{
+    // The latest template of each basis site, being the points of its
+    // neighbourhood relative to the site, the order that sorts them and
+    // the geometry they sort into.
+    const int n_basis = lattice_map.nBasis();
+    std::vector<std::vector<Coordinate> > template_points(n_basis);
+    std::vector<std::vector<int> > template_order(n_basis);
+    std::vector<int> template_geometry(n_basis, -1);
+
+    // Work storage.
+    std::vector<int> neighbourhood;
+    std::vector<Coordinate> points;
+    ConfigBucketMatchList match_list;
+
+    for (size_t i = first; i < last; ++i)
+    {
+        // Get the points relative to the site.
+        lattice_map.neighbourIndices(i, range, neighbourhood);
+        const Coordinate center = storage_.coordinates()[i];
+        points.resize(neighbourhood.size());
+        for (size_t j = 0; j < neighbourhood.size(); ++j)
+        {
+            Coordinate c = storage_.coordinates()[neighbourhood[j]] - center;
+            lattice_map.wrap(c);
+            points[j] = c;
+        }
+
+        // Sort the points only if they differ from the template of the
+        // basis site, and find the geometry they sort into.
+        const int basis_site = lattice_map.basisSiteFromIndex(i);
+        if (template_geometry[basis_site] == -1 ||
+            !samePoints(template_points[basis_site], points))
+        {
+            match_list.resize(points.size());
+            for (size_t j = 0; j < points.size(); ++j)
+            {
+                match_list[j].index = j;
+                match_list[j].distance = points[j].distanceToOrigin();
+                match_list[j].x = points[j].x();
+                match_list[j].y = points[j].y();
+                match_list[j].z = points[j].z();
+            }
+            std::sort(match_list.begin(), match_list.end());
+
+            std::vector<int> & order = template_order[basis_site];
+            order.resize(match_list.size());
+            for (size_t j = 0; j < match_list.size(); ++j)
+            {
+                order[j] = match_list[j].index;
+            }
+            template_points[basis_site] = points;
+
+            // Sites with the same surroundings share the geometry. Only
+            // sites close to a non-periodic boundary need more than one
+            // geometry per basis site.
+            int geometry = -1;
+            for (size_t g = 0; g < chunk.geometries.size(); ++g)
+            {
+                if (sameGeometry(chunk.geometries[g], match_list))
+                {
+                    geometry = g;
+                    break;
+                }
+            }
+
+            // Store a new geometry without the indices and types.
+            if (geometry == -1)
+            {
+                geometry = chunk.geometries.size();
+                chunk.geometries.push_back(match_list);
+                ConfigBucketMatchList & new_geometry = chunk.geometries.back();
+                for (size_t j = 0; j < new_geometry.size(); ++j)
+                {
+                    new_geometry[j].index = -1;
+                    new_geometry[j].match_types = TypeBucket(type_names_.size());
+                }
+            }
+            template_geometry[basis_site] = geometry;
+        }
+
+        // Store the indices in the sorted order.
+        const std::vector<int> & order = template_order[basis_site];
+        match_list_geometry_[i] = template_geometry[basis_site];
+        match_list_offsets_[i+1] = order.size();
+        for (size_t j = 0; j < order.size(); ++j)
+        {
+            chunk.indices.push_back(neighbourhood[order[j]]);
+        }
     }
 }
 
@@ -105,27 +431,108 @@ Configuration::Configuration(const std::vector<std::vector<double> >  & coordina
 // -----------------------------------------------------------------------------
 //
 void Configuration::initMatchLists( const LatticeMap & lattice_map,
-                                    const int range )
+                                    const int range,
+                                    const int n_threads )
 {
-    // Store the max size of minimal_match_list_
+    const size_t n_indices = storage_.size();
+
+    // Set up the match lists in contiguous chunks of sites.
+    const int n_chunks = std::max(1, std::min(n_threads, static_cast<int>(n_indices)));
+    std::vector<MatchListChunk> chunks(n_chunks);
+    runOnThreads(n_chunks, n_chunks, [&](const int c)
+                 {
+                     initMatchListChunk(lattice_map,
+                                        range,
+                                        chunkStart(n_indices, n_chunks, c),
+                                        chunkStart(n_indices, n_chunks, c + 1),
+                                        chunks[c]);
+                 });
+
+    // Merge the geometries of the chunks in order, which gives the same
+    // geometries in the same order for any number of chunks.
+    match_list_geometries_.clear();
+    std::vector<std::vector<int> > chunk_geometries(n_chunks);
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        const std::vector<ConfigBucketMatchList> & geometries = chunks[c].geometries;
+        for (size_t g = 0; g < geometries.size(); ++g)
+        {
+            int geometry = -1;
+            for (size_t h = 0; h < match_list_geometries_.size(); ++h)
+            {
+                if (sameGeometry(match_list_geometries_[h], geometries[g]))
+                {
+                    geometry = h;
+                    break;
+                }
+            }
+            if (geometry == -1)
+            {
+                geometry = match_list_geometries_.size();
+                match_list_geometries_.push_back(geometries[g]);
+            }
+            chunk_geometries[c].push_back(geometry);
+        }
+    }
+
+    // The offsets from the sizes of the match lists.
     size_t max_size = 0;
-    size_t tmp_size;
+    match_list_offsets_[0] = 0;
+    for (size_t i = 0; i < n_indices; ++i)
+    {
+        max_size = std::max(max_size, match_list_offsets_[i+1]);
+        match_list_offsets_[i+1] += match_list_offsets_[i];
+    }
+
+    // Store the indices, and the signature and packed types of the types
+    // at them.
+    match_list_indices_.resize(match_list_offsets_[n_indices]);
+    runOnThreads(n_chunks, n_chunks, [&](const int c)
+                 {
+                     const size_t chunk_first = chunkStart(n_indices, n_chunks, c);
+                     const size_t chunk_last  = chunkStart(n_indices, n_chunks, c + 1);
+                     std::copy(chunks[c].indices.begin(),
+                               chunks[c].indices.end(),
+                               match_list_indices_.begin() + match_list_offsets_[chunk_first]);
+
+                     ConfigBucketMatchList & match_list = tmp_match_list__;
+                     for (size_t i = chunk_first; i < chunk_last; ++i)
+                     {
+                         match_list_geometry_[i] = chunk_geometries[c][match_list_geometry_[i]];
+                         configMatchList(i, match_list);
+                         match_list_signatures_[i] = presentTypes(match_list);
+                         if (!single_occupancy_)
+                         {
+                             packMatchTypes(match_list, packed_match_types_[i]);
+                         }
+                         changed_match_lists_[i] = 0;
+                     }
+                 });
+
+    // Map each index to its entries in the match lists, by list and
+    // position. An index may have more than one entry in a match list on
+    // small lattices.
+    std::vector<size_t> counts(n_indices + 1, 0);
+    for (size_t j = 0; j < match_list_indices_.size(); ++j)
+    {
+        ++counts[match_list_indices_[j] + 1];
+    }
 
-    // Loop over all lattice sites.
-    for (size_t i = 0; i < types_.size(); ++i)
+    containing_offsets_[0] = 0;
+    for (size_t i = 0; i < n_indices; ++i)
     {
-        // Calculate and store the match list.
-        const int origin_index = i;
-        const std::vector<int> neighbourhood = lattice_map.neighbourIndices(origin_index, range);
-        match_lists_[i] = configMatchList(origin_index,
-                                          neighbourhood,
-                                          lattice_map);
+        containing_offsets_[i+1] = containing_offsets_[i] + counts[i+1];
+        counts[i+1] = containing_offsets_[i];
+    }
+    containing_entries_.resize(containing_offsets_[n_indices]);
 
-        // Store the maximum size
-        tmp_size = match_lists_[i].size();
-        if ( tmp_size > max_size )
+    for (size_t i = 0; i < n_indices; ++i)
+    {
+        for (size_t j = match_list_offsets_[i]; j < match_list_offsets_[i+1]; ++j)
         {
-            max_size = tmp_size;
+            ContainingEntry & entry = containing_entries_[counts[match_list_indices_[j] + 1]++];
+            entry.list     = i;
+            entry.position = j - match_list_offsets_[i];
         }
     }
 
@@ -136,16 +543,210 @@ void Configuration::initMatchLists( const LatticeMap & lattice_map,
 }
 
 
+// -----------------------------------------------------------------------------
+//
+bool Configuration::setSingleOccupancy(const bool single_occupancy)
+{
+    // Only a lattice with a single atom at each site can use the mode.
+    bool single = single_occupancy;
+    for (size_t i = 0; single && i < storage_.size(); ++i)
+    {
+        single = (singleType(siteTypes(i)) > 0);
+    }
+
+    if (single == single_occupancy_)
+    {
+        return single_occupancy_;
+    }
+
+    const size_t n_indices = storage_.size();
+    const int n_types = storage_.nTypes();
+
+    if (single)
+    {
+        // Keep the single type of each site in one byte, and release the
+        // type counts, the first types, the elements and the packed types.
+        site_types_.resize(n_indices);
+        for (size_t i = 0; i < n_indices; ++i)
+        {
+            site_types_[i] = static_cast<unsigned char>(storage_.firstTypes()[i]);
+        }
+        storage_.releaseTypes();
+        releaseElements();
+        std::vector<PackedTypes>().swap(packed_match_types_);
+        single_occupancy_ = true;
+        return single_occupancy_;
+    }
+
+    // Write the type counts and the first types back from the site types.
+    storage_.restoreTypes();
+    for (size_t i = 0; i < n_indices; ++i)
+    {
+        int * type_counts = storage_.typeCounts().data() + i * n_types;
+        std::fill(type_counts, type_counts + n_types, 0);
+        type_counts[site_types_[i]] = 1;
+        storage_.firstTypes()[i] = site_types_[i];
+    }
+    std::vector<unsigned char>().swap(site_types_);
+    single_occupancy_ = false;
+
+    // Pack the match lists again if they are set up.
+    packed_match_types_.resize(n_indices);
+    if (!match_list_indices_.empty())
+    {
+        ConfigBucketMatchList & match_list = tmp_match_list__;
+        for (size_t i = 0; i < n_indices; ++i)
+        {
+            configMatchList(i, match_list);
+            packMatchTypes(match_list, packed_match_types_[i]);
+        }
+    }
+
+    return single_occupancy_;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::releaseElements()
+{
+    std::vector<std::vector<std::string> >().swap(elements_);
+    std::vector<std::string>().swap(atom_id_elements_);
+    std::vector<int>().swap(stale_elements_);
+    std::vector<int>().swap(stale_atom_id_elements_);
+}
+
+
 // -----------------------------------------------------------------------------
 //
 void Configuration::updateMatchList(const int index)
 {
-    // Update the config match lists.
-    ConfigBucketMatchList::iterator it1 = match_lists_[index].begin();
-    const ConfigBucketMatchList::const_iterator end = match_lists_[index].end();
-    for ( ; it1 != end; ++it1 )
+    // The match lists refer to the types, so only the type signature
+    // needs to follow.
+    if (!changed_match_lists_[index])
+    {
+        return;
+    }
+
+    const int * indices = matchListIndices(index);
+    const size_t size = matchListGeometry(index).size();
+
+    TypeSignature signature = 0;
+    if (single_occupancy_)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            signature |= static_cast<TypeSignature>(1) << (site_types_[indices[i]] % 64);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            signature |= siteTypes(indices[i]).signature();
+        }
+    }
+    match_list_signatures_[index] = signature;
+
+    // Pack the types again if they could not be packed before.
+    if (!single_occupancy_ && packed_match_types_[index].empty())
+    {
+        static thread_local ConfigBucketMatchList match_list;
+        configMatchList(index, match_list);
+        packMatchTypes(match_list, packed_match_types_[index]);
+    }
+
+    changed_match_lists_[index] = 0;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::updateMatchListEntries(const int index)
+{
+    const TypeBucket types = siteTypes(index);
+    const int lanes = types.size() - 1;
+
+    // Check if the types can be packed.
+    bool packable = true;
+    for (int i = 1; i < types.size(); ++i)
     {
-        (*it1).match_types = types_[(*it1).index];
+        packable = packable && types[i] <= PACKED_TYPES_MAX_COUNT;
+    }
+
+    for (size_t i = containing_offsets_[index]; i < containing_offsets_[index+1]; ++i)
+    {
+        const int list     = containing_entries_[i].list;
+        const int position = containing_entries_[i].position;
+
+        // Rewrite the lanes of the packed types at the entry of the
+        // index, or leave them to be packed again when the list is updated.
+        PackedTypes & packed = packed_match_types_[list];
+        if (packable && !packed.empty())
+        {
+            unsigned char * lane = &packed[position * lanes];
+            for (int j = 0; j < lanes; ++j)
+            {
+                lane[j] = static_cast<unsigned char>(types[j + 1]);
+            }
+        }
+        else
+        {
+            packed.clear();
+        }
+
+        changed_match_lists_[list] = 1;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ConfigBucketMatchList Configuration::configMatchList(const int index) const
+{
+    ConfigBucketMatchList match_list;
+    configMatchList(index, match_list);
+    return match_list;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::configMatchList(const int index,
+                                    ConfigBucketMatchList & match_list) const
+{
+    // Combine the shared geometry with the indices and types of this index.
+    const ConfigBucketMatchList & geometry = matchListGeometry(index);
+    const int * indices = matchListIndices(index);
+
+    match_list.resize(geometry.size());
+    for (size_t i = 0; i < geometry.size(); ++i)
+    {
+        ConfigBucketMatchListEntry & entry = match_list[i];
+        entry.index       = indices[i];
+        entry.distance    = geometry[i].distance;
+        entry.x           = geometry[i].x;
+        entry.y           = geometry[i].y;
+        entry.z           = geometry[i].z;
+        entry.match_types = siteTypes(indices[i]);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::siteMatchTypes(const int index, PackedTypes & types) const
+{
+    const int * indices = matchListIndices(index);
+    const size_t size = matchListGeometry(index).size();
+
+    // The same padded layout as packSiteTypes(). Assigning to a buffer of
+    // the same size does not allocate.
+    const size_t n_bytes = size + PACKED_TYPES_PADDING;
+    types.assign(((n_bytes + PACKED_TYPES_PADDING - 1) / PACKED_TYPES_PADDING) * PACKED_TYPES_PADDING, 0);
+    for (size_t i = 0; i < size; ++i)
+    {
+        types[i] = site_types_[indices[i]];
     }
 }
 
@@ -160,7 +761,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
     tmp_match_list__.resize(indices.size());
 
     // Extract the coordinate of the first index.
-    const Coordinate center = coordinates_[origin_index];
+    const Coordinate center = storage_.coordinates()[origin_index];
 
     // Setup the needed iterators.
     std::vector<int>::const_iterator it_index  = indices.begin();
@@ -181,7 +782,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
         for ( ; it_index != end; ++it_index, ++it_match_list)
         {
             // Center.
-            Coordinate c = coordinates_[(*it_index)] - center;
+            Coordinate c = storage_.coordinates()[(*it_index)] - center;
 
             // Wrap with coorect periodicity.
             lattice_map.wrap(c, 0);
@@ -192,7 +793,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
             const double distance = c.distanceToOrigin();
 
             // Get the type.
-            (*it_match_list).match_types = types_[(*it_index)];
+            (*it_match_list).match_types = siteTypes(*it_index);
 
             // Save in the match list.
             (*it_match_list).distance = distance;
@@ -209,7 +810,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
         for ( ; it_index != end; ++it_index, ++it_match_list)
         {
             // Center.
-            Coordinate c = coordinates_[(*it_index)] - center;
+            Coordinate c = storage_.coordinates()[(*it_index)] - center;
 
             // Wrap with coorect periodicity.
             lattice_map.wrap(c, 0);
@@ -219,7 +820,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
             const double distance = c.distanceToOrigin();
 
             // Get the type.
-            (*it_match_list).match_types = types_[(*it_index)];
+            (*it_match_list).match_types = siteTypes(*it_index);
 
             // Save in the match list.
             (*it_match_list).distance = distance;
@@ -241,7 +842,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
         for ( ; it_index != end; ++it_index, ++it_match_list)
         {
             // Center.
-            Coordinate c = coordinates_[(*it_index)] - center;
+            Coordinate c = storage_.coordinates()[(*it_index)] - center;
 
             // Wrap with coorect periodicity.
             lattice_map.wrap(c);
@@ -249,7 +850,7 @@ const ConfigBucketMatchList & Configuration::configMatchList(const int origin_in
             const double distance = c.distanceToOrigin();
 
             // Get the type.
-            (*it_match_list).match_types = types_[(*it_index)];
+            (*it_match_list).match_types = siteTypes(*it_index);
 
             // Save in the match list.
             (*it_match_list).distance = distance;
@@ -276,13 +877,13 @@ void Configuration::performBucketProcess(Process & process,
     latest_event_process_ = process.processNumber();
     latest_event_site_    = site_index;
 
-    // Get the proper match lists.
+    // Get the process match list and the indices of the site match list.
     const ProcessBucketMatchList & process_match_list = process.processMatchList();
-    const ConfigBucketMatchList & site_match_list     = configMatchList(site_index);
+    const int * site_indices = matchListIndices(site_index);
 
     // Iterators to the match list entries.
     ProcessBucketMatchList::const_iterator it1 = process_match_list.begin();
-    ConfigBucketMatchList::const_iterator it2 = site_match_list.begin();
+    const int * it2 = site_indices;
 
     // Iterators to the info storages.
     std::vector<int>::iterator it3 = process.affectedIndices().begin();
@@ -292,84 +893,109 @@ void Configuration::performBucketProcess(Process & process,
     // Reset the moved counter.
     n_moved_ = 0;
 
+    // Leave the single occupancy mode before a process that may change
+    // the number of atoms at a site.
+    if (single_occupancy_ && !process.singleAtomUpdates())
+    {
+        setSingleOccupancy(false);
+    }
+
     // Loop over the match lists and get the types and indices out.
     for( ; it1 != process_match_list.end(); ++it1, ++it2)
     {
-        // Find out the update type.
-        const TypeBucket & update_types = (*it1).update_types;
-
         // Get the index out of the configuration match list.
-        const int index = (*it2).index;
+        const int index = (*it2);
 
-        // ML: Prototyping.
-        int sum = 0;
-        for (int i = 0; i  < update_types.size(); ++i)
+        // In the single occupancy mode only the site type is set, and the
+        // match lists read it from the site.
+        if (single_occupancy_)
         {
-            // NOTE: Cast needed for clang.
-            sum += std::abs(update_types[i]);
-        }
+            const int update_type = (*it1).update_type;
+            if (update_type <= 0)
+            {
+                continue;
+            }
 
-        // NOTE: The !(update_types[0] > 0) is needed for handling the wildcard match.
-        if (sum > 0 && !(update_types[0] > 0))
+            site_types_[index] = static_cast<unsigned char>(update_type);
+            for (size_t i = containing_offsets_[index]; i < containing_offsets_[index+1]; ++i)
+            {
+                changed_match_lists_[containing_entries_[i].list] = 1;
+            }
+        }
+        else
         {
-            // Get the atom id to apply the move vector to.
-            const int atom_id = atom_id_[index];
-
-            // Apply the move vector to the atom coordinate.
-            atom_id_coordinates_[atom_id] += (*it1).move_coordinate;
+            // Find out the update type.
+            const TypeBucket & update_types = (*it1).update_types;
 
-            // Set the type at this index.
-            for (int i = 0; i < types_[index].size(); ++i)
+            // ML: Prototyping.
+            int sum = 0;
+            for (int i = 0; i  < update_types.size(); ++i)
             {
-                types_[index][i] += update_types[i];
+                // NOTE: Cast needed for clang.
+                sum += std::abs(update_types[i]);
             }
 
-            // Set the elements at this index.
-
-            // ML: FIXME: This is not a good solution.
-            //            We should store the update types as
-            //            a vector of strings in the match list entry,
-            //            instead of regenerating that list every time here.
-            std::vector<std::string> elements_at_index;
-            for (int i = 0; i < types_[index].size(); ++i)
+            // NOTE: The !(update_types[0] > 0) is needed for handling the wildcard match.
+            if (!(sum > 0 && !(update_types[0] > 0)))
             {
-                for (int j = 0; j < types_[index][i]; ++j)
-                {
-                    elements_at_index.push_back(type_names_[i]);
-                }
+                continue;
             }
-            elements_[index] = elements_at_index;
 
-            // Update the atom id element.
-            if (!(*it1).has_move_coordinate)
+            // Set the type at this index, in the type counts of the
+            // storage and in the match lists.
+            int * type_counts = storage_.typeCounts().data() + index * storage_.nTypes();
+            for (int i = 0; i < storage_.nTypes(); ++i)
             {
-                // ML: FIXME: This behavior should be deprecated.
-                //            Now we only take the first occuring type at the site.
-                //            This is expected behavior but incorrect in general and
-                //            works only for one atom per site simulations.
-                atom_id_elements_[atom_id] = elements_[index][0];
+                type_counts[i] += update_types[i];
             }
+            updateMatchListEntries(index);
+            storage_.firstTypes()[index] = firstPresentType(siteTypes(index));
+        }
 
-            // Mark this index as affected.
-            (*it3) = index;
-            ++it3;
+        // Get the atom id to apply the move vector to.
+        const int atom_id = storage_.atomID()[index];
 
-            // Mark this atom_id as moved.
-            (*it4) = atom_id;
-            ++it4;
-            ++n_moved_;
+        // Apply the move vector to the atom coordinate.
+        storage_.atomIDCoordinates()[atom_id] += (*it1).move_coordinate;
 
-            // Save this move vector.
-            (*it5) = (*it1).move_coordinate;
-            ++it5;
+        // Only the types are updated while stepping. The elements at
+        // this index are flagged and written on query, if set up.
+        if (!elements_.empty() && !stale_element_flags_[index])
+        {
+            stale_element_flags_[index] = 1;
+            stale_elements_.push_back(index);
         }
+
+        // Update the atom id type.
+        if (!(*it1).has_move_coordinate)
+        {
+            // ML: FIXME: This behavior should be deprecated.
+            //            Now we only take the first occuring type at the site.
+            //            This is expected behavior but incorrect in general and
+            //            works only for one atom per site simulations.
+            setAtomIDType(atom_id, firstType(index));
+        }
+
+        // Mark this index as affected.
+        (*it3) = index;
+        ++it3;
+
+        // Mark this atom_id as moved.
+        (*it4) = atom_id;
+        ++it4;
+        ++n_moved_;
+
+        // Save this move vector.
+        (*it5) = (*it1).move_coordinate;
+        ++it5;
     }
 
     // Perform the moves on all involved atom-IDs.
     const std::vector< std::pair<int,int> > & process_id_moves = process.idMoves();
 
-    // Local vector to store the atom id updates in.
-    std::vector<std::pair<int,int> > id_updates(process_id_moves.size());
+    // Work vector to store the atom id updates in.
+    std::vector<std::pair<int,int> > & id_updates = id_updates_;
+    id_updates.resize(process_id_moves.size());
 
     // Setup the id updates list.
     for (size_t i = 0; i < process_id_moves.size(); ++i)
@@ -377,10 +1003,10 @@ void Configuration::performBucketProcess(Process & process,
         const int match_list_index_from = process_id_moves[i].first;
         const int match_list_index_to   = process_id_moves[i].second;
 
-        const int lattice_index_from = site_match_list[match_list_index_from].index;
-        const int lattice_index_to   = site_match_list[match_list_index_to].index;
+        const int lattice_index_from = site_indices[match_list_index_from];
+        const int lattice_index_to   = site_indices[match_list_index_to];
 
-        id_updates[i].first  = atom_id_[lattice_index_from];
+        id_updates[i].first  = storage_.atomID()[lattice_index_from];
         id_updates[i].second = lattice_index_to;
     }
 
@@ -391,13 +1017,13 @@ void Configuration::performBucketProcess(Process & process,
         const int index = id_updates[i].second;
 
         // Set the atom id at this lattice site index.
-        atom_id_[index] = id;
+        storage_.atomID()[index] = id;
 
 
         // ML: FIXME: This behavior should be deprecated.
         // See above comment.
-        // Update the element type of this atom ID.
-        atom_id_elements_[id] = elements_[index][0];
+        // Update the type of this atom ID.
+        setAtomIDType(id, firstType(index));
 
     }
 }
@@ -410,15 +1036,203 @@ std::vector<int> Configuration::particlesPerType() const
     // Allocate space for the return values.
     std::vector<int> particles_per_type(possible_types_.size(), 0);
 
+    // Count the single atom of each site in the single occupancy mode.
+    if (single_occupancy_)
+    {
+        for (size_t i = 0; i < site_types_.size(); ++i)
+        {
+            ++particles_per_type[site_types_[i]];
+        }
+        return particles_per_type;
+    }
+
     // Loop over each site and sum the number of particle.
-    for (size_t i = 0; i < types_.size(); ++i)
+    for (size_t i = 0; i < storage_.size(); ++i)
     {
+        const TypeBucket types = siteTypes(i);
         for (size_t j = 0; j < particles_per_type.size(); ++j)
         {
-            particles_per_type[j] += types_[i][j];
+            particles_per_type[j] += types[j];
         }
     }
 
     // DONE.
     return particles_per_type;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::writeStorage(const std::string & path) const
+{
+    storage_.write(path, single_occupancy_ ? site_types_.data() : NULL);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::saveState(CheckpointWriter & writer) const
+{
+    writer.section("CONF");
+    const size_t n_indices = storage_.size();
+    const int n_types = type_names_.size();
+    writer.write(static_cast<unsigned long>(n_indices));
+    writer.write(n_types);
+    writer.write(single_occupancy_);
+
+    // The types of all indices, as the single type of each index in the
+    // single occupancy mode and otherwise one bucket after the other.
+    if (single_occupancy_)
+    {
+        writer.writeVector(site_types_);
+    }
+    else
+    {
+        writer.writeArray(storage_.typeCounts().data(), n_indices * n_types);
+        writer.writeArray(storage_.firstTypes().data(), n_indices);
+    }
+
+    // The atom id state.
+    writer.writeArray(storage_.atomID().data(), n_indices);
+    writer.writeArray(storage_.atomIDTypes().data(), n_indices);
+    writer.writeArray(storage_.atomIDCoordinates().data(), n_indices);
+    writer.write(n_moved_);
+    writer.writeVector(moved_atom_ids_);
+    writer.writeVector(recent_move_vectors_);
+    writer.write(latest_event_process_);
+    writer.write(latest_event_site_);
+
+    // The geometries, as the points of each entry.
+    writer.write(static_cast<unsigned long>(match_list_geometries_.size()));
+    for (size_t g = 0; g < match_list_geometries_.size(); ++g)
+    {
+        const ConfigBucketMatchList & geometry = match_list_geometries_[g];
+        std::vector<double> points(geometry.size() * 4);
+        for (size_t j = 0; j < geometry.size(); ++j)
+        {
+            points[4*j]     = geometry[j].distance;
+            points[4*j + 1] = geometry[j].x;
+            points[4*j + 2] = geometry[j].y;
+            points[4*j + 3] = geometry[j].z;
+        }
+        writer.writeVector(points);
+    }
+
+    // The match lists.
+    writer.writeVector(match_list_geometry_);
+    writer.writeVector(match_list_indices_);
+    writer.writeVector(match_list_offsets_);
+    writer.writeVector(match_list_signatures_);
+    writer.writeVector(containing_entries_);
+    writer.writeVector(containing_offsets_);
+    writer.writeVector(changed_match_lists_);
+
+    // The packed types of all match lists, one after the other, being
+    // empty in the single occupancy mode.
+    std::vector<unsigned long> packed_sizes(n_indices, 0);
+    if (!single_occupancy_)
+    {
+        for (size_t i = 0; i < n_indices; ++i)
+        {
+            packed_sizes[i] = packed_match_types_[i].size();
+        }
+    }
+    writer.writeVector(packed_sizes);
+    for (size_t i = 0; i < n_indices && !single_occupancy_; ++i)
+    {
+        writer.write(packed_match_types_[i].data(), packed_match_types_[i].size());
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Configuration::loadState(CheckpointReader & reader)
+{
+    reader.section("CONF");
+    const size_t n_indices = storage_.size();
+    const int n_types = type_names_.size();
+    if (reader.read<unsigned long>() != n_indices || reader.read<int>() != n_types)
+    {
+        throw std::runtime_error("The checkpoint does not match the sites and types of the configuration.");
+    }
+
+    // Read the types into the site types or the site storage, and release
+    // the other.
+    single_occupancy_ = reader.read<bool>();
+    if (single_occupancy_)
+    {
+        reader.readVector(site_types_);
+        if (site_types_.size() != n_indices)
+        {
+            throw std::runtime_error("The checkpoint does not match the sites of the configuration.");
+        }
+        storage_.releaseTypes();
+        std::vector<PackedTypes>().swap(packed_match_types_);
+    }
+    else
+    {
+        std::vector<unsigned char>().swap(site_types_);
+        storage_.restoreTypes();
+        reader.readArray(storage_.typeCounts().data(), n_indices * n_types);
+        reader.readArray(storage_.firstTypes().data(), n_indices);
+        packed_match_types_.resize(n_indices);
+    }
+
+    reader.readArray(storage_.atomID().data(), n_indices);
+    reader.readArray(storage_.atomIDTypes().data(), n_indices);
+    reader.readArray(storage_.atomIDCoordinates().data(), n_indices);
+    n_moved_ = reader.read<int>();
+    reader.readVector(moved_atom_ids_);
+    reader.readVector(recent_move_vectors_);
+    latest_event_process_ = reader.read<int>();
+    latest_event_site_ = reader.read<int>();
+
+    match_list_geometries_.resize(reader.read<unsigned long>());
+    std::vector<double> points;
+    for (size_t g = 0; g < match_list_geometries_.size(); ++g)
+    {
+        reader.readVector(points);
+        ConfigBucketMatchList & geometry = match_list_geometries_[g];
+        geometry.resize(points.size() / 4);
+        for (size_t j = 0; j < geometry.size(); ++j)
+        {
+            geometry[j].index       = -1;
+            geometry[j].distance    = points[4*j];
+            geometry[j].x           = points[4*j + 1];
+            geometry[j].y           = points[4*j + 2];
+            geometry[j].z           = points[4*j + 3];
+            geometry[j].match_types = TypeBucket(n_types);
+        }
+    }
+
+    reader.readVector(match_list_geometry_);
+    reader.readVector(match_list_indices_);
+    reader.readVector(match_list_offsets_);
+    reader.readVector(match_list_signatures_);
+    reader.readVector(containing_entries_);
+    reader.readVector(containing_offsets_);
+    reader.readVector(changed_match_lists_);
+
+    std::vector<unsigned long> packed_sizes;
+    reader.readVector(packed_sizes);
+
+    if (match_list_geometry_.size() != n_indices ||
+        match_list_offsets_.size() != n_indices + 1 ||
+        match_list_signatures_.size() != n_indices ||
+        containing_offsets_.size() != n_indices + 1 ||
+        changed_match_lists_.size() != n_indices ||
+        packed_sizes.size() != n_indices)
+    {
+        throw std::runtime_error("The checkpoint does not match the match lists of the configuration.");
+    }
+
+    for (size_t i = 0; i < n_indices && !single_occupancy_; ++i)
+    {
+        packed_match_types_[i].resize(packed_sizes[i]);
+        reader.read(packed_match_types_[i].data(), packed_sizes[i]);
+    }
+
+    // Set the elements up from the read types on query.
+    releaseElements();
+}
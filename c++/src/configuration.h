@@ -19,12 +19,23 @@
 #include <string>
 #include <map>
 #include "matchlist.h"
+#include "packedtypes.h"
 #include "coordinate.h"
 #include "typebucket.h"
+#include "sitestorage.h"
 
 // Forward declarations.
 class LatticeMap;
 class Process;
+class CheckpointWriter;
+class CheckpointReader;
+
+/// A minimal struct for the position of an entry of an index in a match list.
+struct ContainingEntry
+{
+    int list;
+    int position;
+};
 
 /*! \brief Class for defining the configuration used in a KMC simulation to
  *         use for communicating elements and positions to and from python.
@@ -42,36 +53,108 @@ public:
                   const std::vector< std::vector<std::string> > & elements,
                   const std::map<std::string,int> & possible_types);
 
-    /*! \brief Initiate the calculation of the match lists.
+    /*! \brief Constructor for setting up the configuration from a site
+     *         storage file, e.g. written by writeStorage(). The coordinates,
+     *         the types and the atom id state are mapped from the file and
+     *         paged in when used, and the file is shared with all other
+     *         configurations mapping it. The element strings are set up
+     *         from the types when first queried.
+     *  \param storage_path  : The path of the site storage file.
+     *  \param possible_types: A global mapping from type string to number.
+     */
+    Configuration(const std::string & storage_path,
+                  const std::map<std::string,int> & possible_types);
+
+    /*! \brief Initiate the calculation of the match lists. The match list
+     *         of a site is only sorted if its points differ from those of
+     *         the latest site on the same basis site, as they do close to
+     *         non-periodic boundaries, and otherwise takes the order of
+     *         that site. The result does not depend on the number of threads.
      *  \param lattice_map : The lattice map needed to get coordinates wrapped.
      *  \param range       : The number of shells to include.
+     *  \param n_threads   : The number of threads to use, defaults to one.
+     */
+    void initMatchLists(const LatticeMap & lattice_map,
+                        const int range,
+                        const int n_threads=1);
+
+    /*! \brief Set the single occupancy mode, where the type of the single
+     *         atom at each site is kept in one byte, for matching each entry
+     *         with a single compare and without any multiplicity. The byte
+     *         of each site is then the only type state: the type counts and
+     *         the first types of the site storage are released, the match
+     *         lists are not packed but gathered with siteMatchTypes(), and
+     *         the types and elements are set up from the bytes on query.
+     *         The mode is only set if each site holds exactly one atom, and
+     *         is left on its own before a process that may change that. The
+     *         type counts are restored and the match lists packed again
+     *         when the mode is left.
+     *  \param single_occupancy : True to use the mode if possible.
+     *  \return : True if the mode is in use.
      */
-    void initMatchLists(const LatticeMap & lattice_map, const int range);
+    bool setSingleOccupancy(const bool single_occupancy);
+
+    /*! \brief Query for the single occupancy mode.
+     *  \return : True if the single type of each site is used for matching.
+     */
+    bool singleOccupancy() const { return single_occupancy_; }
 
     /*! \brief Const query for the coordinates.
      *  \return : The coordinates of the configuration.
      */
-    const std::vector<Coordinate> & coordinates() const { return coordinates_; }
+    const SiteArray<Coordinate> & coordinates() const { return storage_.coordinates(); }
 
     /*! \brief Const query for the atom id coordinates.
      *  \return : The atom id coordinates of the configuration.
      */
-    const std::vector<Coordinate> & atomIDCoordinates() const { return atom_id_coordinates_; }
+    const SiteArray<Coordinate> & atomIDCoordinates() const { return storage_.atomIDCoordinates(); }
 
-    /*! \brief Const query for the elements.
+    /*! \brief Const query for the elements. The element strings are not
+     *         updated while stepping, but are brought up to date with the
+     *         types of the sites that changed on query.
      *  \return : The elements of the configuration.
      */
-    const std::vector<std::vector<std::string> > & elements() const { return elements_; }
+    const std::vector<std::vector<std::string> > & elements() const;
+
+    /*! \brief Const query for the atom id elements, brought up to date with
+     *         the atom id types on query.
+     *  \return : The atom id elements of the configuration.
+     */
+    const std::vector<std::string> & atomIDElements() const;
 
     /*! \brief Const query for the atom id types.
-     *  \return : The atom id types of the configuration.
+     *  \return : The type integer of each atom id.
      */
-    const std::vector<std::string> & atomIDElements() const { return atom_id_elements_; }
+    const SiteArray<int> & atomIDTypes() const { return storage_.atomIDTypes(); }
+
+    /*! \brief Query for the type of the first atom at an index, being the
+     *         type used for the atom id at the index.
+     *  \param index : The index to get the type for.
+     *  \return : The type integer of the first atom at the index.
+     */
+    int firstType(const int index) const
+    { return single_occupancy_ ? site_types_[index] : storage_.firstTypes()[index]; }
 
     /*! \brief Const query for the types.
-     *  \return : The types of the configuration.
+     *  \return : The types of the configuration, as a view of the type
+     *             counts in the site storage, or of the site types in the
+     *             single occupancy mode.
      */
-    const std::vector<TypeBucket> & types() const { return types_; }
+    TypeBucketArray types() const
+    {
+        if (single_occupancy_)
+        {
+            return TypeBucketArray(site_types_.data(), storage_.size(), storage_.nTypes());
+        }
+        return TypeBucketArray(storage_.typeCounts().data(), storage_.size(), storage_.nTypes());
+    }
+
+    /*! \brief Const query for the types at one index.
+     *  \param index : The index to get the types for.
+     *  \return : The types at the index, as a view of the site storage,
+     *             or set up from the site type in the single occupancy mode.
+     */
+    const TypeBucket siteTypes(const int index) const { return types()[index]; }
 
     /*! \brief Const query for the moved atom ids.
      *  \return : A copy of the moved atom ids, resized to correct length.
@@ -108,16 +191,74 @@ public:
                                                   const LatticeMap & lattice_map) const;
 
 
-    /*! \brief Update the cached match list for the given index.
+    /*! \brief Update the cached match list for the given index. The match
+     *         lists refer to the types at their sites, and this only updates
+     *         the type signature of the match list if any of its sites
+     *         changed since the last update.
      *  \param index : The index to update the match list for.
      */
     void updateMatchList(const int index);
 
-    /*! \brief Return the cached match list without update.
+    /*! \brief Return a copy of the cached match list without update.
      *  \param index : The index to get the match list for.
      *  \return : The match list.
      */
-    const ConfigBucketMatchList & configMatchList(const int index) const { return match_lists_[index]; }
+    ConfigBucketMatchList configMatchList(const int index) const;
+
+    /*! \brief Get the cached match list without update, reusing the
+     *         storage of the given match list.
+     *  \param index           : The index to get the match list for.
+     *  \param match_list (out): The match list to overwrite.
+     */
+    void configMatchList(const int index,
+                         ConfigBucketMatchList & match_list) const;
+
+    /*! \brief Const query for the geometry of the match list of an index.
+     *         Sites with the same surroundings share the geometry, which
+     *         holds the sorted distances and coordinates relative to the
+     *         site, but not the indices or types of the entries.
+     *  \param index : The index to get the geometry for.
+     *  \return : The shared match list geometry.
+     */
+    const ConfigBucketMatchList & matchListGeometry(const int index) const
+    { return match_list_geometries_[match_list_geometry_[index]]; }
+
+    /*! \brief Const query for the indices of the entries in the match list
+     *         of an index, in the order of its geometry.
+     *  \param index : The index to get the match list indices for.
+     *  \return : Pointer to the first of the indices.
+     */
+    const int * matchListIndices(const int index) const
+    { return match_list_indices_.data() + match_list_offsets_[index]; }
+
+    /*! \brief Query for the number of distinct match list geometries.
+     *  \return : The number of geometries shared by the match lists.
+     */
+    int nMatchListGeometries() const { return static_cast<int>(match_list_geometries_.size()); }
+
+    /*! \brief Const query for the signature of the types present in the
+     *         match list of an index, kept up to date with the match list.
+     *  \param index : The index to get the signature for.
+     *  \return : The type signature of the match list.
+     */
+    TypeSignature matchListSignature(const int index) const { return match_list_signatures_[index]; }
+
+    /*! \brief Const query for the packed types of the match list of an
+     *         index, kept up to date with the match list. No packed types
+     *         are kept in the single occupancy mode, where this must not be
+     *         called.
+     *  \param index : The index to get the packed types for.
+     *  \return : The packed types of the match list.
+     */
+    const PackedTypes & packedMatchTypes(const int index) const { return packed_match_types_[index]; }
+
+    /*! \brief Gather the single type of each entry of the match list of an
+     *         index, as packed by packSiteTypes(), in the single occupancy
+     *         mode.
+     *  \param index      : The index to get the types for.
+     *  \param types (out) : The type of each entry of the match list.
+     */
+    void siteMatchTypes(const int index, PackedTypes & types) const;
 
     /*! \brief Perform the given process.
      *  \param process : The process to perform, which will be updated with the affected
@@ -144,12 +285,12 @@ public:
     /*! \brief Get the atom id coordinates.
      *  \return : The list of atom id coordinates.
      */
-    const std::vector<Coordinate> & atomIdCoordinates() const { return atom_id_coordinates_; }
+    const SiteArray<Coordinate> & atomIdCoordinates() const { return storage_.atomIDCoordinates(); }
 
     /*! \brief Get the atom id at each lattice site.
      *  \retrurn : The list of atom ids for the lattice sites.
      */
-    const std::vector<int> & atomID() const { return atom_id_; }
+    const SiteArray<int> & atomID() const { return storage_.atomID(); }
 
     /*! \brief Set the update info on the configuration. This is used
      *         in connection with setting up processes of bucket type.
@@ -173,30 +314,96 @@ public:
      */
     std::vector<int> particlesPerType() const;
 
+    /*! \brief Write the coordinates, the types and the atom id state to a
+     *         site storage file, for setting up configurations that map it.
+     *  \param path : The path of the file to write.
+     */
+    void writeStorage(const std::string & path) const;
+
+    /*! \brief Query if the per site arrays are mapped from a site storage file.
+     *  \return : True if mapped.
+     */
+    bool mapped() const { return storage_.mapped(); }
+
+    /*! \brief Write the types, the atom id state and the match lists to
+     *         a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the state written by saveState. The match lists are
+     *         read as written and need not be initiated first. The
+     *         configuration must have the same sites and types as the
+     *         saved one, and the elements are brought up to date with the
+     *         read types on query.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
 protected:
 
 private:
 
+    /// The match list data set up for a contiguous chunk of sites.
+    struct MatchListChunk;
+
+    /*! \brief Set up the match list geometries and indices of a contiguous
+     *         chunk of sites, with geometry ids local to the chunk, and
+     *         the size of the match list of each site i at offset i+1.
+     *  \param lattice_map : The lattice map needed to get coordinates wrapped.
+     *  \param range       : The number of shells to include.
+     *  \param first       : The first site of the chunk.
+     *  \param last        : One past the last site of the chunk.
+     *  \param chunk (out) : The geometries and indices of the chunk.
+     */
+    void initMatchListChunk(const LatticeMap & lattice_map,
+                            const int range,
+                            const size_t first,
+                            const size_t last,
+                            MatchListChunk & chunk);
+
+    /*! \brief Rewrite the packed types of an index in all match lists after
+     *         its types changed, and flag the match lists for update.
+     *  \param index : The index that changed.
+     */
+    void updateMatchListEntries(const int index);
+
+    /*! \brief Release the element strings, to be set up from the types
+     *         again when queried.
+     */
+    void releaseElements();
+
+    /*! \brief Set the type of an atom id and flag its element for update.
+     *  \param atom_id : The atom id to set the type for.
+     *  \param type    : The type to set.
+     */
+    inline
+    void setAtomIDType(const int atom_id, const int type);
+
     /// Counter for the number of moved atom ids the last move.
     int n_moved_;
 
-    /// The lattice coordinates.
-    std::vector<Coordinate> coordinates_;
+    /// The coordinates, the atom ids and the integer types of the sites,
+    /// on the heap or mapped from a file.
+    SiteStorage storage_;
 
-    /// The coordinates for each atom id.
-    std::vector<Coordinate> atom_id_coordinates_;
+    /// The lattice elements, updated from the types on query.
+    mutable std::vector<std::vector<std::string> > elements_;
 
-    /// The lattice elements.
-    std::vector<std::vector<std::string> > elements_;
+    /// The elements per atom id, updated from the atom id types on query.
+    mutable std::vector<std::string> atom_id_elements_;
 
-    /// The elements per atom id.
-    std::vector<std::string> atom_id_elements_;
+    /// The indices with elements that are behind their types.
+    mutable std::vector<int> stale_elements_;
 
-    /// The the lattice elements in integer representation.
-    std::vector<TypeBucket> types_;
+    /// Flags for the indices with elements that are behind their types.
+    mutable std::vector<char> stale_element_flags_;
 
-    /// The atom id for each lattice point.
-    std::vector<int> atom_id_;
+    /// The atom ids with elements that are behind their types.
+    mutable std::vector<int> stale_atom_id_elements_;
+
+    /// Flags for the atom ids with elements that are behind their types.
+    mutable std::vector<char> stale_atom_id_flags_;
 
     /// The first n_moved_ elements hold the moved atom ids.
     std::vector<int> moved_atom_ids_;
@@ -207,8 +414,32 @@ private:
     /// The mapping from type integers to names.
     std::vector<std::string> type_names_;
 
-    /// The match lists for all indices.
-    std::vector< ConfigBucketMatchList > match_lists_;
+    /// The distinct match list geometries.
+    std::vector< ConfigBucketMatchList > match_list_geometries_;
+
+    /// The geometry of the match list of each index.
+    std::vector<int> match_list_geometry_;
+
+    /// The entry indices of all match lists, one after the other.
+    std::vector<int> match_list_indices_;
+
+    /// The offset of the match list indices of each index.
+    std::vector<size_t> match_list_offsets_;
+
+    /// The signature of the types present in the match list of each index.
+    std::vector<TypeSignature> match_list_signatures_;
+
+    /// The packed types of the match list of each index.
+    std::vector<PackedTypes> packed_match_types_;
+
+    /// The match list entries of each index, one index after the other.
+    std::vector<ContainingEntry> containing_entries_;
+
+    /// The offset of the containing entries of each index.
+    std::vector<size_t> containing_offsets_;
+
+    /// Flags for the match lists with entries that changed since their last update.
+    std::vector<char> changed_match_lists_;
 
     /// The update info.
     std::vector< std::map<std::string, int> > update_info_;
@@ -216,12 +447,23 @@ private:
     /// Mapping from string to int representation of types.
     std::map<std::string,int> possible_types_;
 
+    /// If the single type of each site is used for matching.
+    bool single_occupancy_;
+
+    /// The type of the single atom at each site in the single occupancy
+    /// mode, being the only type state of the sites in the mode, and
+    /// empty otherwise.
+    std::vector<unsigned char> site_types_;
+
     /// The process number of the latest event that took place.
     int latest_event_process_;
 
     /// The site index of the latest event that took place.
     int latest_event_site_;
 
+    /// Work vector for the atom id updates of an event.
+    std::vector<std::pair<int,int> > id_updates_;
+
 };
 
 
@@ -253,6 +495,18 @@ std::vector<Coordinate> Configuration::recentMoveVectors() const
 
 
 
+// -----------------------------------------------------------------------------
+//
+void Configuration::setAtomIDType(const int atom_id, const int type)
+{
+    storage_.atomIDTypes()[atom_id] = type;
+    if (!atom_id_elements_.empty() && !stale_atom_id_flags_[atom_id])
+    {
+        stale_atom_id_flags_[atom_id] = 1;
+        stale_atom_id_elements_.push_back(atom_id);
+    }
+}
+
 
 #endif // __CONFIGURATION__
 
@@ -28,12 +28,19 @@ CustomRateProcess::CustomRateProcess(const Configuration & first,
                                      const std::vector<int> & move_origins,
                                      const std::vector<Coordinate> & move_vectors,
                                      const int process_number,
-                                     const bool cache_rate) :
+                                     const bool cache_rate,
+                                     const double rate_upper_bound) :
     Process(first, second, rate, basis_sites, move_origins, move_vectors, process_number)
 {
     // Set the cache rate flag.
     cache_rate_ = cache_rate;
 
+    // The site rates are individual and must always be stored.
+    uniform_site_rates_ = false;
+
+    // Set the upper bound for lazy rate evaluation.
+    rate_upper_bound_ = rate_upper_bound;
+
     // Save the cutoff if it is larger than what we have allready.
     if (cutoff > cutoff_)
     {
@@ -52,31 +59,24 @@ void CustomRateProcess::addSite(const int index,
                                 const double rate,
                                 const double multiplicity)
 {
-    sites_.push_back(index);
+    const double site_rate = multiplicity * rate;
+    addSiteSlot(index);
     site_multiplicity_.push_back(multiplicity);
     site_rates_.push_back(rate);
-    total_rate_ += multiplicity * rate;
+    pushSiteRate(site_rate);
+    updateTotalRate(site_rate);
 }
 
 
 // -----------------------------------------------------------------------------
 //
-void CustomRateProcess::removeSite(const int index)
+void CustomRateProcess::removeSiteAt(const size_t slot)
 {
-    // Find the index to remove.
-    std::vector<int>::iterator it1 = std::find(sites_.begin(),
-                                               sites_.end(),
-                                               index);
-
-    // Swap the index to remove with the last index.
-    std::vector<int>::iterator last = sites_.end()-1;
-    std::swap((*it1), (*last));
-
-    // Remove the last index from the list.
-    sites_.pop_back();
+    // Swap the index to remove with the last index and remove it.
+    removeSiteSlot(slot);
 
     // Calculate the positions in the site_rates_ vector.
-    std::vector<double>::iterator it2 = site_rates_.begin() + (it1-sites_.begin());
+    std::vector<double>::iterator it2 = site_rates_.begin() + slot;
     std::vector<double>::iterator last_rate = site_rates_.end()-1;
 
     // Swap and remove.
@@ -87,33 +87,18 @@ void CustomRateProcess::removeSite(const int index)
     site_rates_.pop_back();
 
     // Calculate the position in the site_multiplicity_ vector.
-    std::vector<double>::iterator it3 = site_multiplicity_.begin() + (it1-sites_.begin());
+    std::vector<double>::iterator it3 = site_multiplicity_.begin() + slot;
     std::vector<double>::iterator last_multiplicity = site_multiplicity_.end()-1;
 
     // Swap and remove.
     std::swap((*it3), (*last_multiplicity));
 
-    // Update the total rate.
-    total_rate_ -= site_rate * site_multiplicity_.back();
-
+    const double multiplicity = site_multiplicity_.back();
     site_multiplicity_.pop_back();
 
-}
-
+    // Move the last rate into the freed slot.
+    removeSiteRate(slot);
 
-// -----------------------------------------------------------------------------
-//
-void CustomRateProcess::updateRateTable()
-{
-    // Resize and update the incremental rate table.
-    incremental_rate_table_.resize(site_multiplicity_.size());
-    double previous = 0.0;
-    for (size_t i = 0; i < site_multiplicity_.size(); ++i)
-    {
-        incremental_rate_table_[i] = previous + (site_rates_[i] * site_multiplicity_[i]);
-        previous = incremental_rate_table_[i];
-    }
-
-    // DONE
+    // Update the total rate.
+    updateTotalRate(-site_rate * multiplicity);
 }
-
@@ -24,7 +24,7 @@ public:
 
     /*! \brief Default constructor needed for use in std::vector SWIG wrapping.
      */
-    CustomRateProcess() {}
+    CustomRateProcess() { uniform_site_rates_ = false; }
 
 
     /*! \brief Constructor for the process. Note that the configurations given
@@ -45,6 +45,12 @@ public:
      *                         i.e., if only elements are moved on the lattice and no
      *                         atom id moves are considered.
      *  \param process_number: The id number of the process.
+     *  \param cache_rate    : If the rates of the process can be cached.
+     *  \param rate_upper_bound : An upper bound for the custom rates of the
+     *                            process. If positive the sites are listed
+     *                            with this rate, and the custom rate is only
+     *                            evaluated when a site is picked. The event is
+     *                            then accepted with probability rate/bound.
      */
     CustomRateProcess(const Configuration & first,
                       const Configuration & second,
@@ -54,7 +60,8 @@ public:
                       const std::vector<int> & move_origins=std::vector<int>(0),
                       const std::vector<Coordinate> & move_vectors=std::vector<Coordinate>(0),
                       const int process_number=-1,
-                      const bool cache_rate=false);
+                      const bool cache_rate=false,
+                      const double rate_upper_bound=0.0);
 
     /*! \brief Virtual destructor needed for inheritance.
      */
@@ -70,17 +77,19 @@ public:
                          const double rate,
                          const double multiplicity);
 
-    /*! \brief Remove the index from the list of available sites.
-     *  \param index : The index to remove.
+    /*! \brief Remove the site at a slot of the list of available sites.
+     *  \param slot : The slot to remove.
      */
-    virtual void removeSite(const int index);
+    virtual void removeSiteAt(const size_t slot);
 
+protected:
 
-    /*! \brief Update the rate table prior to drawing a rate.
+    /*! \brief Query for the total rate of a listed site.
+     *  \param slot : The slot of the site in the list of sites.
+     *  \return : The individual rate times the multiplicity of the site.
      */
-    virtual void updateRateTable();
-
-protected:
+    virtual double siteRate(const size_t slot) const
+    { return site_multiplicity_[slot] * site_rates_[slot]; }
 
 private:
 
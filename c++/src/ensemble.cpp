@@ -0,0 +1,105 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  ensemble.cpp
+ *  \brief File for the implementation code of the Ensemble class.
+ */
+
+#include "ensemble.h"
+#include "mpicommons.h"
+#include "threadtasks.h"
+
+#include <algorithm>
+#include <exception>
+#include <random>
+#include <stdexcept>
+
+
+// -----------------------------------------------------------------------------
+//
+Ensemble::Ensemble(const Configuration & configuration,
+                   const LatticeMap & lattice_map,
+                   const Interactions & interactions,
+                   const int n_replicas,
+                   const int seed,
+                   const double start_time,
+                   const SELECTION_ENGINE selection_engine) :
+    configurations_(std::max(n_replicas, 0), configuration),
+    timers_(std::max(n_replicas, 0)),
+    models_(),
+    n_steps_(std::max(n_replicas, 0), 0),
+    thread_safe_(!interactions.useCustomRates() || interactions.rateCalculator().threadSafe())
+{
+    if (n_replicas < 1)
+    {
+        throw std::runtime_error("The ensemble needs at least one replica.");
+    }
+
+    // Generate well separated seeds for the replica streams.
+    std::vector<unsigned int> seeds(n_replicas);
+    std::seed_seq seed_sequence{seed};
+    seed_sequence.generate(seeds.begin(), seeds.end());
+
+    // The models refer to the configurations and timers, which are
+    // allocated once above and never moved.
+    models_.reserve(n_replicas);
+    for (int i = 0; i < n_replicas; ++i)
+    {
+        timers_[i].propagateTimeInterval(start_time);
+        models_.emplace_back(configurations_[i],
+                             timers_[i],
+                             lattice_map,
+                             interactions,
+                             selection_engine);
+        models_[i].seedRandomStream(seeds[i]);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Ensemble::run(const int n_steps, const int n_threads)
+{
+    if (n_threads < 1)
+    {
+        throw std::runtime_error("The ensemble needs at least one thread.");
+    }
+
+    if (n_threads > 1 && !thread_safe_)
+    {
+        throw std::runtime_error("The ensemble can only use several threads with a thread safe rate calculator.");
+    }
+
+    if (n_threads > 1 && MPICommons::size() > 1)
+    {
+        throw std::runtime_error("The ensemble can not use several threads with more than one MPI process.");
+    }
+
+    // Run each replica on a worker thread, and pass any error on after all
+    // replicas are done.
+    std::vector<std::exception_ptr> errors(models_.size());
+    runOnThreads(n_threads, models_.size(), [&](const int i)
+                 {
+                     try
+                     {
+                         n_steps_[i] += models_[i].runSteps(n_steps);
+                     }
+                     catch (...)
+                     {
+                         errors[i] = std::current_exception();
+                     }
+                 });
+
+    for (size_t i = 0; i < errors.size(); ++i)
+    {
+        if (errors[i])
+        {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+}
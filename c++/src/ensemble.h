@@ -0,0 +1,115 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  ensemble.h
+ *  \brief File for the Ensemble class definition.
+ */
+
+#ifndef __ENSEMBLE__
+#define __ENSEMBLE__
+
+#include <vector>
+
+#include "configuration.h"
+#include "simulationtimer.h"
+#include "latticemodel.h"
+
+
+/*! \brief Class for running an ensemble of statistically independent
+ *         replicas of a lattice KMC model in one process. Each replica is
+ *         a LatticeModel with a configuration, a timer and a random number
+ *         stream of its own, set up from the same configuration, lattice
+ *         map and interactions. The replicas are stepped concurrently on
+ *         worker threads, one replica per thread at a time.
+ */
+class Ensemble {
+
+public:
+
+    /*! \brief Constructor for setting up the replicas.
+     *  \param configuration    : The configuration each replica starts from.
+     *  \param lattice_map      : A lattice map object describing the lattice.
+     *  \param interactions     : An interactions object describing all interactions
+     *                            and possible processes in the system.
+     *  \param n_replicas       : The number of replicas.
+     *  \param seed             : The seed from which the seeds of the random
+     *                            number streams of the replicas are generated.
+     *  \param start_time       : The simulation time to start from.
+     *  \param selection_engine : The engine to use for picking sites within
+     *                            a process, defaults to SUM_TREE.
+     */
+    Ensemble(const Configuration & configuration,
+             const LatticeMap & lattice_map,
+             const Interactions & interactions,
+             const int n_replicas,
+             const int seed,
+             const double start_time=0.0,
+             const SELECTION_ENGINE selection_engine=SUM_TREE);
+
+    /*! \brief Run a batch of steps on each replica, with LatticeModel::runSteps.
+     *         The outcome for each replica depends only on its own random
+     *         number stream and not on the number of threads.
+     *  \param n_steps   : The maximum number of steps for each replica.
+     *  \param n_threads : The number of worker threads to use. More than one
+     *                     thread requires a thread safe rate calculator if
+     *                     custom rates are used.
+     */
+    void run(const int n_steps, const int n_threads);
+
+    /*! \brief Query for the number of replicas.
+     *  \return : The number of replicas.
+     */
+    int nReplicas() const { return static_cast<int>(models_.size()); }
+
+    /*! \brief Query for a replica.
+     *  \param replica : The replica to get.
+     *  \return : A handle to the model of the replica.
+     */
+    const LatticeModel & model(const int replica) const { return models_[replica]; }
+
+    /*! \brief Query for the configuration of a replica.
+     *  \param replica : The replica to get the configuration for.
+     *  \return : A handle to the configuration of the replica.
+     */
+    const Configuration & configuration(const int replica) const { return configurations_[replica]; }
+
+    /*! \brief Query for the simulation time of a replica.
+     *  \param replica : The replica to get the time for.
+     *  \return : The simulation time of the replica.
+     */
+    double simulationTime(const int replica) const { return timers_[replica].simulationTime(); }
+
+    /*! \brief Query for the number of steps taken by a replica.
+     *  \param replica : The replica to get the number of steps for.
+     *  \return : The number of steps taken by the replica in all runs.
+     */
+    long nSteps(const int replica) const { return n_steps_[replica]; }
+
+protected:
+
+private:
+
+    /// The configuration of each replica.
+    std::vector<Configuration> configurations_;
+
+    /// The timer of each replica.
+    std::vector<SimulationTimer> timers_;
+
+    /// The model of each replica, referring to its configuration and timer.
+    std::vector<LatticeModel> models_;
+
+    /// The number of steps taken by each replica.
+    std::vector<long> n_steps_;
+
+    /// If the rate calculator may be called from several threads.
+    bool thread_safe_;
+
+};
+
+
+#endif // __ENSEMBLE__
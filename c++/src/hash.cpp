@@ -121,16 +121,19 @@ unsigned long int hashCustomRateInput(const int index,
     // Get cutoff distance from the process.
     const double cutoff = process.cutoff();
 
-    // This is the source of configuration information we will need.
-    const ConfigBucketMatchList & config_match_list  = configuration.configMatchList(index);
-
-    // This is the data to hash.
-    std::vector<int> data_to_hash;
+    // This is the source of configuration information we will need, stored
+    // per thread to be reused between calls.
+    static thread_local ConfigBucketMatchList config_match_list;
+    configuration.configMatchList(index, config_match_list);
+
+    // This is the data to hash, stored per thread to be reused between calls.
+    static thread_local std::vector<int> data_to_hash;
+    data_to_hash.clear();
     data_to_hash.push_back(process_number);
 
     // Add the match types of the config match list to the data to hash.
     ConfigBucketMatchList::const_iterator it1 = config_match_list.begin();
-    while ( (*it1).distance <= cutoff && it1 != config_match_list.end())
+    while ( it1 != config_match_list.end() && (*it1).distance <= cutoff )
     {
         for (int i = 0; i < (*it1).match_types.size(); ++i)
         {
@@ -11,6 +11,7 @@
  */
 
 #include <algorithm>
+#include <stdexcept>
 
 #include "interactions.h"
 #include "random.h"
@@ -18,23 +19,7 @@
 #include "latticemap.h"
 #include "ratecalculator.h"
 #include "matchlist.h"
-
-
-// -----------------------------------------------------------------------------
-// Function for comparing two entries in the probability list.
-bool pairComp(const std::pair<double,int> & p1,
-              const std::pair<double, int> & p2)
-{
-    // This skips all processes with no available sites.
-    if (p2.second == 0)
-    {
-        return false;
-    }
-    else
-    {
-        return (p1.first < p2.first);
-    }
-}
+#include "checkpoint.h"
 
 
 // -----------------------------------------------------------------------------
@@ -45,10 +30,14 @@ Interactions::Interactions(const std::vector<Process> & processes,
     custom_rate_processes_(0),
     process_pointers_(processes.size(), NULL),
     probability_table_(processes.size(), std::pair<double,int>(0.0,0)),
+    process_rate_tree_(processes.size()),
+    process_trie_(),
     implicit_wildcards_(implicit_wildcards),
     use_custom_rates_(false),
     rate_calculator_placeholder_(RateCalculator()),
-    rate_calculator_(rate_calculator_placeholder_)
+    rate_calculator_(rate_calculator_placeholder_),
+    resummation_interval_(1000000),
+    n_updates_(0)
 {
     // Point the process pointers to the right places.
     for (size_t i = 0; i < processes_.size(); ++i)
@@ -56,6 +45,9 @@ Interactions::Interactions(const std::vector<Process> & processes,
         process_pointers_[i] = &processes_[i];
     }
 
+    // Build the trie for matching.
+    process_trie_.build(process_pointers_);
+
     // DONE
 }
 
@@ -69,9 +61,13 @@ Interactions::Interactions(const std::vector<CustomRateProcess> & processes,
     custom_rate_processes_(processes),
     process_pointers_(processes.size(), NULL),
     probability_table_(processes.size(), std::pair<double,int>(0.0,0)),
+    process_rate_tree_(processes.size()),
+    process_trie_(),
     implicit_wildcards_(implicit_wildcards),
     use_custom_rates_(true),
-    rate_calculator_(rate_calculator)
+    rate_calculator_(rate_calculator),
+    resummation_interval_(1000000),
+    n_updates_(0)
 {
     // Point the process pointers to the right places.
     for (size_t i = 0; i < custom_rate_processes_.size(); ++i)
@@ -79,10 +75,44 @@ Interactions::Interactions(const std::vector<CustomRateProcess> & processes,
         process_pointers_[i] = &custom_rate_processes_[i];
     }
 
+    // Build the trie for matching.
+    process_trie_.build(process_pointers_);
+
     // DONE
 }
 
 
+// -----------------------------------------------------------------------------
+//
+Interactions::Interactions(const Interactions & other) :
+    processes_(other.processes_),
+    custom_rate_processes_(other.custom_rate_processes_),
+    process_pointers_(other.process_pointers_.size(), NULL),
+    probability_table_(other.probability_table_),
+    process_rate_tree_(other.process_rate_tree_),
+    process_trie_(other.process_trie_),
+    implicit_wildcards_(other.implicit_wildcards_),
+    use_custom_rates_(other.use_custom_rates_),
+    rate_calculator_placeholder_(RateCalculator()),
+    rate_calculator_(other.use_custom_rates_ ? other.rate_calculator_ : rate_calculator_placeholder_),
+    resummation_interval_(other.resummation_interval_),
+    n_updates_(other.n_updates_)
+{
+    // Point the process pointers to the copied processes.
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        if (use_custom_rates_)
+        {
+            process_pointers_[i] = &custom_rate_processes_[i];
+        }
+        else
+        {
+            process_pointers_[i] = &processes_[i];
+        }
+    }
+}
+
+
 // -----------------------------------------------------------------------------
 //
 int Interactions::maxRange() const
@@ -101,6 +131,40 @@ int Interactions::maxRange() const
 }
 
 
+// -----------------------------------------------------------------------------
+//
+int Interactions::minRange() const
+{
+    // Loop through all processes and find the smallest range in each of them.
+    int min_range = maxRange();
+
+    std::vector<Process*>::const_iterator it1 = process_pointers_.begin();
+    for ( ; it1 != process_pointers_.end(); ++it1 )
+    {
+        min_range = std::min( min_range, std::max(1, (**it1).range()) );
+    }
+
+    // Return.
+    return min_range;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+bool Interactions::singleOccupancy() const
+{
+    // Bucket processes may add or remove atoms at a site.
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        if (process_pointers_[i]->bucketProcess())
+        {
+            return false;
+        }
+    }
+    return process_trie_.singleOccupancy();
+}
+
+
 // -----------------------------------------------------------------------------
 //
 void Interactions::updateProcessMatchLists(const Configuration & configuration,
@@ -138,39 +202,46 @@ void Interactions::updateProcessMatchLists(const Configuration & configuration,
         const ConfigBucketMatchList config_matchlist = configuration.configMatchList(index);
 
         // Perform the match where we add wildcards to fill the vacancies in the
-        // process match list.
-        ProcessBucketMatchList::iterator it1 = process_matchlist.begin();
+        // process match list. The new match list is built in one pass.
+        ProcessBucketMatchList::const_iterator it1 = process_matchlist.begin();
         ConfigBucketMatchList::const_iterator it2 = config_matchlist.begin();
 
+        ProcessBucketMatchList new_matchlist;
+        new_matchlist.reserve(config_matchlist.size());
+
         // Insert the wildcards and update the indexing.
         int old_index = 0;
         int new_index = 0;
         std::vector<int> index_mapping(config_matchlist.size());
 
-        for ( ; it1 != process_matchlist.end() && it2 != config_matchlist.end(); ++it1, ++it2 )
+        for ( ; it1 != process_matchlist.end() && it2 != config_matchlist.end(); ++it2 )
         {
             // Check if there is a match in lattice point.
             if( ! samePoint(*it1, *it2) )
             {
-                // If not matching, add a wildcard entry to it1.
-                ProcessBucketMatchListEntry wildcard_entry;// = (*it2);
+                // If not matching, add a wildcard entry.
+                ProcessBucketMatchListEntry wildcard_entry;
                 wildcard_entry.initWildcard(*it2);
-
-                it1 = process_matchlist.insert(it1, wildcard_entry);
-                // it1 now points to the newly inserted position.
+                new_matchlist.push_back(wildcard_entry);
 
                 ++new_index;
             }
             else
             {
                 // Add the mapping.
+                new_matchlist.push_back(*it1);
                 index_mapping[old_index] = new_index;
 
+                ++it1;
                 ++old_index;
                 ++new_index;
            }
         }
 
+        // Keep any process entries beyond the configuration match list.
+        new_matchlist.insert(new_matchlist.end(), it1, process_matchlist.cend());
+        process_matchlist.swap(new_matchlist);
+
         // With this mapping information we can update the process id moves.
         index_mapping.resize(old_index);
         std::vector<std::pair<int,int> > & id_moves = p.idMoves();
@@ -183,6 +254,9 @@ void Interactions::updateProcessMatchLists(const Configuration & configuration,
             id_moves[j].second = index_mapping[old_index_second];
         }
     }
+
+    // The match lists now hold the wildcards.
+    process_trie_.build(process_pointers_);
 }
 
 
@@ -221,6 +295,36 @@ void Interactions::updateProbabilityTable()
         // Store the number of available processes to filter out zeroes later.
         (*it2).second = n_sites;
     }
+
+    // Set all weights in the process selection tree and remove any
+    // round-off accumulated from the incremental updates.
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        const Process & process = (*process_pointers_[i]);
+        const double rate = (process.nSites() > 0) ? process.totalRate() : 0.0;
+        process_rate_tree_.update(i, rate);
+    }
+    process_rate_tree_.rebuild();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Interactions::updateProcessRate(const int process_index)
+{
+    // Processes without available sites must never be picked, regardless
+    // of any round-off left in their total rate.
+    const Process & process = (*process_pointers_[process_index]);
+    const double rate = (process.nSites() > 0) ? process.totalRate() : 0.0;
+    process_rate_tree_.update(process_index, rate);
+
+    // Remove the round-off in the partial sums at the given interval.
+    ++n_updates_;
+    if (resummation_interval_ > 0 && n_updates_ >= resummation_interval_)
+    {
+        process_rate_tree_.rebuild();
+        n_updates_ = 0;
+    }
 }
 
 
@@ -228,29 +332,15 @@ void Interactions::updateProbabilityTable()
 //
 int Interactions::pickProcessIndex() const
 {
-    // PERFORMME:
-    // This implements the O(N) SSA algorithm.
-    // One could consider implementing the O(logN) SSA-GB algorithm,
-    // or the O(1) algorithm described in J.Chem.Phys. 128, 205101, (2008)
-    // but it is typically the re-matching after an event that sets the
-    // limit in terms of scaling with the number of processes.
-
-    // Get a random number between 0.0 and the total imcremented rate.
+    // This implements the O(logN) SSA-GB algorithm, with the total rate
+    // of each process stored in a binary indexed tree.
+
+    // Get a random number between 0.0 and the total rate.
     const double rnd = randomDouble01() * totalRate();
-    const std::pair<double,int> rnd_pair(rnd,1);
-
-    // Find the lower bound - corresponding to the first element for which
-    // the accumulated rate is not smaller than rnd, and the number
-    // of available processes is larger than zero.
-    const std::vector<std::pair<double, int> >::const_iterator begin = probability_table_.begin();
-    const std::vector<std::pair<double, int> >::const_iterator end   = probability_table_.end();
-    const std::vector<std::pair<double, int> >::const_iterator it1   = std::lower_bound( begin,
-                                                                                         end,
-                                                                                         rnd_pair,
-                                                                                         pairComp );
-
-    // Find the index in the process list.
-    return it1-begin;
+
+    // Find the process that owns this point on the accumulated rate axis.
+    // Processes with no available sites have zero weight and are skipped.
+    return static_cast<int>(process_rate_tree_.search(rnd));
 }
 
 
@@ -260,9 +350,8 @@ Process* Interactions::pickProcess()
 {
     const int index = pickProcessIndex();
 
-    // Update the process internal probablility table if needed.
-    process_pointers_[index]->updateRateTable();
-
+    // The process site rate tree is kept up to date incrementally,
+    // so there is no table to update before picking a site.
     return process_pointers_[index];
 }
 
@@ -274,7 +363,99 @@ void Interactions::clearMatching()
     for (size_t i = 0; i < process_pointers_.size(); ++i)
     {
         process_pointers_[i]->clearSites();
+        process_rate_tree_.update(i, 0.0);
+    }
+    process_rate_tree_.rebuild();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Interactions::setSelectionEngine(const SELECTION_ENGINE selection_engine)
+{
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        process_pointers_[i]->setSelectionEngine(selection_engine);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Interactions::setResummationInterval(const int interval)
+{
+    resummation_interval_ = interval;
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        process_pointers_[i]->setResummationInterval(interval);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double Interactions::totalRateDrift() const
+{
+    double exact = 0.0;
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        const Process & process = (*process_pointers_[i]);
+        if (process.nSites() > 0)
+        {
+            exact += process.totalRate() - process.totalRateDrift();
+        }
     }
+    return totalRate() - exact;
 }
 
 
+// -----------------------------------------------------------------------------
+//
+void Interactions::saveState(CheckpointWriter & writer) const
+{
+    writer.section("INTR");
+    writer.write(static_cast<unsigned long>(process_pointers_.size()));
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        process_pointers_[i]->saveState(writer);
+    }
+
+    writer.write(static_cast<unsigned long>(probability_table_.size()));
+    for (size_t i = 0; i < probability_table_.size(); ++i)
+    {
+        writer.write(probability_table_[i].first);
+        writer.write(probability_table_[i].second);
+    }
+
+    process_rate_tree_.saveState(writer);
+    writer.write(resummation_interval_);
+    writer.write(n_updates_);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Interactions::loadState(CheckpointReader & reader)
+{
+    reader.section("INTR");
+    if (reader.read<unsigned long>() != process_pointers_.size())
+    {
+        throw std::runtime_error("The checkpoint does not match the number of processes of the model.");
+    }
+
+    for (size_t i = 0; i < process_pointers_.size(); ++i)
+    {
+        process_pointers_[i]->loadState(reader);
+    }
+
+    probability_table_.resize(reader.read<unsigned long>());
+    for (size_t i = 0; i < probability_table_.size(); ++i)
+    {
+        probability_table_[i].first = reader.read<double>();
+        probability_table_[i].second = reader.read<int>();
+    }
+
+    process_rate_tree_.loadState(reader);
+    resummation_interval_ = reader.read<int>();
+    n_updates_ = reader.read<int>();
+}
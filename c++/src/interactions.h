@@ -19,11 +19,15 @@
 #include "process.h"
 #include "customrateprocess.h"
 #include "ratecalculator.h"
+#include "sumtree.h"
+#include "processtrie.h"
 
 
 // Forward declarations.
 class Configuration;
 class LatticeMap;
+class CheckpointWriter;
+class CheckpointReader;
 
 /*! \brief Class for holding information about all interactions and possible
  *         processes in the system.
@@ -49,16 +53,41 @@ public:
                  const bool implicit_wildcards,
                  const RateCalculator & rate_calculator);
 
+    /*! \brief Copy constructor. The copy gets processes of its own, so that
+     *         the matching on the copy does not affect the original.
+     *  \param other : The interactions to copy.
+     */
+    Interactions(const Interactions & other);
+
     /*! \brief Get the max range of all processes.
      *  \return : The max range in shells.
      */
     int maxRange() const;
 
+    /*! \brief Get the min range of all processes.
+     *  \return : The min range in shells.
+     */
+    int minRange() const;
+
+    /*! \brief Query if the processes keep a single atom at each site of a
+     *         lattice, being the case when no process is a bucket process
+     *         and each process match list entry is a wildcard or holds a
+     *         single atom. A configuration with a single atom at each site
+     *         can then be matched in its single occupancy mode.
+     *  \return : True if the processes keep single occupancy.
+     */
+    bool singleOccupancy() const;
+
     /*! \brief Query for the custom rates flag.
      *  \return : The custom rates flag, (true) if we use custom rates.
      */
     bool useCustomRates() const { return use_custom_rates_; }
 
+    /*! \brief Query for the implicit wildcards flag.
+     *  \return : The implicit wildcards flag given at construction.
+     */
+    bool implicitWildcards() const { return implicit_wildcards_; }
+
     /*! \brief Update the process matchlists with implicit wildcards if needed.
      *  \param configuration : The configuration needed to determine wildcard positions.
      *  \param lattice_map   : The lattice map to determine wildcard positions.
@@ -76,6 +105,12 @@ public:
      */
     const std::vector<Process*> & processes() const { return process_pointers_; }
 
+    /*! \brief Const query for the trie over the process match lists.
+     *  \return : A handle to the process trie, kept up to date with the
+     *            process match lists.
+     */
+    const ProcessTrie & processTrie() const { return process_trie_; }
+
     /*! \brief Const query for the rate calculator reference.
      *  \return : A handle to the rate calculator in use.
      */
@@ -87,19 +122,28 @@ public:
     int totalAvailableSites() const;
 
     /*! \brief Const query for the probability table.
-     *  \return : A handle to the present probability table.
+     *  \return : A handle to the probability table as calculated at the
+     *            latest call to updateProbabilityTable().
      */
     const std::vector<std::pair<double,int> > & probabilityTable() const { return probability_table_; }
 
     /*! \brief Recalculate the table of process probabilities based on the
      *         number of available sites for each process and their rates.
+     *         This also rebuilds the process selection tree from scratch.
      */
     void updateProbabilityTable();
 
+    /*! \brief Update the weight of a single process in the process selection
+     *         tree after its list of available sites has changed. This is
+     *         an O(log N) operation that leaves the probability table untouched.
+     *  \param process_index : The index of the process to update.
+     */
+    void updateProcessRate(const int process_index);
+
     /*! \brief Query for the total rate of the system.
      *  \return : The total rate.
      */
-    double totalRate() const { return probability_table_.back().first; }
+    double totalRate() const { return process_rate_tree_.total(); }
 
     /*! \brief Pick an availabe process according to its probability.
      *  \return : The index of a possible available process picked according
@@ -119,6 +163,42 @@ public:
      */
     void clearMatching();
 
+    /*! \brief Set the engine used by all processes for picking a site.
+     *  \param selection_engine : The engine to use.
+     */
+    void setSelectionEngine(const SELECTION_ENGINE selection_engine);
+
+    /*! \brief Set the number of updates between exact resummations, for
+     *         the total rate of each process as well as for the process
+     *         selection tree.
+     *  \param interval : The number of updates, zero for never.
+     */
+    void setResummationInterval(const int interval);
+
+    /*! \brief Query for the resummation interval.
+     *  \return : The number of updates between exact resummations.
+     */
+    int resummationInterval() const { return resummation_interval_; }
+
+    /*! \brief Diagnostic query for the accumulated round-off in the total
+     *         rate, compared to an exact sum over all listed sites of all
+     *         processes. This is an O(N) operation.
+     *  \return : The incremental total rate minus the exact total rate.
+     */
+    double totalRateDrift() const;
+
+    /*! \brief Write the listed sites and rates of all processes and the
+     *         process selection tree to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the state written by saveState. The processes must be
+     *         the same as those of the saved interactions.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
 protected:
 
 private:
@@ -135,6 +215,12 @@ private:
     /// The probability table.
     std::vector<std::pair<double,int> > probability_table_;
 
+    /// The process selection tree, holding the total rate of each process.
+    SumTree process_rate_tree_;
+
+    /// The trie over the process match lists, for matching all processes at once.
+    ProcessTrie process_trie_;
+
     /// The flag indicating if implicit wildcards should  be used.
     bool implicit_wildcards_;
 
@@ -147,6 +233,12 @@ private:
     /// A reference to the rate calculator to use.
     const RateCalculator & rate_calculator_;
 
+    /// The number of process rate updates between rebuilds of the tree.
+    int resummation_interval_;
+
+    /// The number of process rate updates since the latest rebuild.
+    int n_updates_;
+
 };
 
 
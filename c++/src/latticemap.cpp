@@ -31,8 +31,8 @@ struct CellIndex {
 };
 
 
-// Temporary storage for the indices form cell.
-static std::vector<int> tmp_cell_indices__;
+// Temporary storage for the indices form cell, one per thread.
+static thread_local std::vector<int> tmp_cell_indices__;
 
 
 // -----------------------------------------------------------------------------
@@ -54,24 +54,37 @@ LatticeMap::LatticeMap(const int n_basis,
 std::vector<int> LatticeMap::neighbourIndices(const int index,
                                               const int shells) const
 {
-    // PERFORMME
+    std::vector<int> neighbours;
+    neighbours.reserve(static_cast<int>(std::pow((2.0*shells + 1), 3) * n_basis_));
+    appendNeighbourIndices(index, shells, neighbours);
+    return neighbours;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void LatticeMap::neighbourIndices(const int index,
+                                  const int shells,
+                                  std::vector<int> & neighbours) const
+{
+    neighbours.clear();
+    appendNeighbourIndices(index, shells, neighbours);
+}
 
+
+// -----------------------------------------------------------------------------
+//
+void LatticeMap::appendNeighbourIndices(const int index,
+                                        const int shells,
+                                        std::vector<int> & neighbours,
+                                        std::vector<int> * neighbour_shells) const
+{
     // Get the cell index.
     CellIndex c;
     indexToCell(index, c.i, c.j, c.k);
 
     const CellIndex & cell = c;
 
-    // Setup the return data structure.
-    const int n_neighbours = static_cast<int>(std::pow((2.0*shells + 1), 3) * n_basis_);
-    std::vector<int> neighbours(n_neighbours);
-
-    // Get a pointer to the neighbours data for direct write access.
-    int* neighbours_ptr = &neighbours[0];
-
-    // A counter to know how much we have added.
-    int counter = 0;
-
     for (int i = cell.i - shells; i <= cell.i + shells; ++i)
     {
         int ii = i;
@@ -127,27 +140,27 @@ std::vector<int> LatticeMap::neighbourIndices(const int index,
                         // Go on only if k is within bounds.
                         if (0 <= kk && kk < repetitions_[2])
                         {
-                            // Take a reference to the mapped data.
-                            const std::vector<int> & indices = indicesFromCell(ii,jj,kk);
-                            // Copy data over from the neighbour cell.
-                            size_t size = n_basis_ * sizeof(int);
-                            std::memcpy(neighbours_ptr, &indices[0], size);
-
-                            // Increment the pointer.
-                            neighbours_ptr += n_basis_;
+                            // Add the indices of the neighbour cell.
+                            const int first = ((ii * repetitions_[1] + jj) * repetitions_[2] + kk) * n_basis_;
+                            for (int l = 0; l < n_basis_; ++l)
+                            {
+                                neighbours.push_back(first + l);
+                            }
 
-                            // Increment the counter.
-                            counter += n_basis_;
+                            // Add the shell of the neighbour cell if asked for.
+                            if (neighbour_shells != NULL)
+                            {
+                                const int shell = std::max(std::abs(i - cell.i),
+                                                           std::max(std::abs(j - cell.j),
+                                                                    std::abs(k - cell.k)));
+                                neighbour_shells->insert(neighbour_shells->end(), n_basis_, shell);
+                            }
                         }
                     }
                 }
             }
         }
     }
-
-    // Resize and return.
-    neighbours.resize(counter);
-    return neighbours;
 }
 
 
@@ -156,26 +169,23 @@ std::vector<int> LatticeMap::neighbourIndices(const int index,
 std::vector<int> LatticeMap::supersetNeighbourIndices(const std::vector<int> & indices,
                                                       const int shells) const
 {
-    // PERFORMME:
-    // We can use several different stategies here and this might
-    // be performance critical, thus we need to time it. So, for now,
-    // use the simplest possible naive implementation.
-
     std::vector<int> superset;
+    supersetNeighbourIndices(indices, shells, superset);
+    return superset;
+}
+
 
+// -----------------------------------------------------------------------------
+//
+void LatticeMap::supersetNeighbourIndices(const std::vector<int> & indices,
+                                          const int shells,
+                                          std::vector<int> & superset) const
+{
+    // Add the neighbourlists of all indices to the superset.
+    superset.clear();
     for (size_t i = 0; i < indices.size(); ++i)
     {
-        // Get the index.
-        const int index = indices[i];
-
-        // And its neighbours.
-        const std::vector<int> neighbours = neighbourIndices(index, shells);
-
-        // Add its neighbourlist to the superset.
-        for (size_t j = 0; j < neighbours.size(); ++j)
-        {
-            superset.push_back(neighbours[j]);
-        }
+        appendNeighbourIndices(indices[i], shells, superset);
     }
 
     // Sort the superset.
@@ -183,8 +193,48 @@ std::vector<int> LatticeMap::supersetNeighbourIndices(const std::vector<int> & i
 
     // Get the unique elements out.
     superset.resize(std::unique(superset.begin(), superset.end())-superset.begin());
+}
 
-    return superset;
+
+// -----------------------------------------------------------------------------
+//
+void LatticeMap::supersetNeighbourIndices(const std::vector<int> & indices,
+                                          const int shells,
+                                          std::vector<int> & superset,
+                                          std::vector<int> & superset_shells) const
+{
+    // Add the neighbourlists of all indices with their shells. The work
+    // vectors are kept per thread so that their storage is reused.
+    static thread_local std::vector<int> neighbours;
+    static thread_local std::vector<int> neighbour_shells;
+    static thread_local std::vector<std::pair<int,int> > index_shells;
+
+    neighbours.clear();
+    neighbour_shells.clear();
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        appendNeighbourIndices(indices[i], shells, neighbours, &neighbour_shells);
+    }
+
+    // Sort on index and then shell, and keep the first, smallest shell
+    // of each index.
+    index_shells.resize(neighbours.size());
+    for (size_t i = 0; i < neighbours.size(); ++i)
+    {
+        index_shells[i] = std::pair<int,int>(neighbours[i], neighbour_shells[i]);
+    }
+    std::sort(index_shells.begin(), index_shells.end());
+
+    superset.clear();
+    superset_shells.clear();
+    for (size_t i = 0; i < index_shells.size(); ++i)
+    {
+        if (superset.empty() || superset.back() != index_shells[i].first)
+        {
+            superset.push_back(index_shells[i].first);
+            superset_shells.push_back(index_shells[i].second);
+        }
+    }
 }
 
 
@@ -199,6 +249,9 @@ const std::vector<int> & LatticeMap::indicesFromCell(const int i,
     const int tmp2 = tmp1 * repetitions_[2] + k;
     const int tmp3 = tmp2 * n_basis_;
 
+    // The storage of a new thread is not yet sized.
+    tmp_cell_indices__.resize(n_basis_);
+
     for (int l = 0; l < n_basis_; ++l)
     {
         tmp_cell_indices__[l] = tmp3 + l;
@@ -46,6 +46,16 @@ public:
      */
     std::vector<int> neighbourIndices(const int index, const int shells=1) const;
 
+    /*! \brief Get the neighbouring indices of a given index into a vector
+     *         given by the caller, whose storage is reused between calls.
+     * \param index            : The index to query for.
+     * \param shells           : The number of shells to include.
+     * \param neighbours (out) : The list of indices.
+     */
+    void neighbourIndices(const int index,
+                          const int shells,
+                          std::vector<int> & neighbours) const;
+
     /*! \brief Get the unique neighbouring indices of a set of given
      *         indices.
      * \param indices : The vector of indices to get the neighbours for.
@@ -54,6 +64,31 @@ public:
     std::vector<int> supersetNeighbourIndices(const std::vector<int> & indices,
                                               const int shells) const;
 
+    /*! \brief Get the unique neighbouring indices of a set of given
+     *         indices into a vector given by the caller, whose storage
+     *         is reused between calls.
+     * \param indices        : The vector of indices to get the neighbours for.
+     * \param shells         : The number of shells to include.
+     * \param superset (out) : The list of indices.
+     */
+    void supersetNeighbourIndices(const std::vector<int> & indices,
+                                  const int shells,
+                                  std::vector<int> & superset) const;
+
+    /*! \brief Get the unique neighbouring indices of a set of given
+     *         indices together with the smallest number of shells that
+     *         reaches each of them from any of the given indices.
+     * \param indices              : The vector of indices to get the neighbours for.
+     * \param shells               : The number of shells to include.
+     * \param superset (out)       : The list of indices.
+     * \param superset_shells (out) : The smallest number of shells around the given
+     *                               indices that includes each index in the superset.
+     */
+    void supersetNeighbourIndices(const std::vector<int> & indices,
+                                  const int shells,
+                                  std::vector<int> & superset,
+                                  std::vector<int> & superset_shells) const;
+
     /*! \brief Get the indices from a given cell.
      * \param i : The cell index in the a direction.
      * \param j : The cell index in the b direction.
@@ -149,6 +184,18 @@ protected:
 
 private:
 
+    /*! \brief Append the neighbouring indices of a given index to a vector.
+     * \param index                 : The index to query for.
+     * \param shells                : The number of shells to include.
+     * \param neighbours (out)       : The vector to append the indices to.
+     * \param neighbour_shells (out) : If not NULL, the shell of each appended index
+     *                                is appended to this vector.
+     */
+    void appendNeighbourIndices(const int index,
+                                const int shells,
+                                std::vector<int> & neighbours,
+                                std::vector<int> * neighbour_shells = NULL) const;
+
     /// The number of basis points in the elemntary unitcell.
     int n_basis_;
     /// The number of repetitions along the a, b and c directions.
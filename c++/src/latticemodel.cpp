@@ -15,46 +15,127 @@
 #include "configuration.h"
 #include "simulationtimer.h"
 #include "random.h"
+#include "allocationcounter.h"
+#include "checkpoint.h"
 
+#include <chrono>
 #include <cstdio>
+#include <stdexcept>
+
+
+// -----------------------------------------------------------------------------
+// The wall clock time in seconds since the given time point.
+static double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 
 // -----------------------------------------------------------------------------
 //
 LatticeModel::LatticeModel(Configuration & configuration,
                            SimulationTimer & simulation_timer,
                            const LatticeMap & lattice_map,
-                           const Interactions & interactions) :
+                           const Interactions & interactions,
+                           const SELECTION_ENGINE selection_engine,
+                           const int n_threads) :
     configuration_(configuration),
     simulation_timer_(simulation_timer),
     lattice_map_(lattice_map),
     interactions_(interactions),
-    matcher_(configuration.coordinates().size(), interactions.processes().size())
+    matcher_(configuration.coordinates().size(), interactions.processes().size()),
+    step_pending_(false),
+    step_start_time_(0.0),
+    n_null_events_(0),
+    n_step_allocations_(heapAllocations() < 0 ? -1 : 0),
+    max_range_(interactions.maxRange()),
+    mixed_ranges_(interactions.minRange() < max_range_),
+    random_stream_(),
+    model_stream_(NULL),
+    setup_timings_(),
+    checkpoint_path_(""),
+    checkpoint_interval_(0.0),
+    last_checkpoint_()
 {
+    // Set the site selection engine before any sites are added.
+    interactions_.setSelectionEngine(selection_engine);
+
+    if (n_threads < 1)
+    {
+        throw std::runtime_error("The lattice model needs at least one thread.");
+    }
+    matcher_.setNumberOfThreads(n_threads);
+
     // Setup the mapping between coordinates and processes.
-    calculateInitialMatching();
+    calculateInitialMatching(n_threads);
 
     // Initialize the interactions table here.
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     interactions_.updateProbabilityTable();
+    setup_timings_.probability_table = secondsSince(start);
 }
 
 
 // -----------------------------------------------------------------------------
 //
-void LatticeModel::calculateInitialMatching()
+LatticeModel::LatticeModel(Configuration & configuration,
+                           SimulationTimer & simulation_timer,
+                           const LatticeMap & lattice_map,
+                           const Interactions & interactions,
+                           const std::string & checkpoint,
+                           const int n_threads) :
+    configuration_(configuration),
+    simulation_timer_(simulation_timer),
+    lattice_map_(lattice_map),
+    interactions_(interactions),
+    matcher_(configuration.coordinates().size(), interactions.processes().size()),
+    step_pending_(false),
+    step_start_time_(0.0),
+    n_null_events_(0),
+    n_step_allocations_(heapAllocations() < 0 ? -1 : 0),
+    max_range_(interactions.maxRange()),
+    mixed_ranges_(interactions.minRange() < max_range_),
+    random_stream_(),
+    model_stream_(NULL),
+    setup_timings_(),
+    checkpoint_path_(""),
+    checkpoint_interval_(0.0),
+    last_checkpoint_()
+{
+    if (n_threads < 1)
+    {
+        throw std::runtime_error("The lattice model needs at least one thread.");
+    }
+    matcher_.setNumberOfThreads(n_threads);
+
+    // Read the state in place of the initial matching.
+    readCheckpoint(checkpoint, true);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::calculateInitialMatching(const int n_threads)
 {
-    // Calculate the match lists.
-    configuration_.initMatchLists(lattice_map_, interactions_.maxRange());
+    // Calculate the match lists, with a single type per entry if the
+    // processes keep a single atom at each site.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    configuration_.setSingleOccupancy(interactions_.singleOccupancy());
+    configuration_.initMatchLists(lattice_map_, interactions_.maxRange(), n_threads);
+    setup_timings_.match_lists = secondsSince(start);
 
     // Update the interactions matchlists.
+    start = std::chrono::steady_clock::now();
     interactions_.clearMatching();
     interactions_.updateProcessMatchLists(configuration_, lattice_map_);
+    setup_timings_.process_match_lists = secondsSince(start);
 
    // Match all centeres.
-    std::vector<int> indices;
-
-    for(size_t i = 0; i < configuration_.elements().size(); ++i)
+    start = std::chrono::steady_clock::now();
+    std::vector<int> indices(configuration_.types().size());
+    for(size_t i = 0; i < indices.size(); ++i)
     {
-        indices.push_back(i);
+        indices[i] = i;
     }
 
     // Match.
@@ -62,6 +143,7 @@ void LatticeModel::calculateInitialMatching()
                                configuration_,
                                lattice_map_,
                                indices);
+    setup_timings_.matching = secondsSince(start);
 }
 
 // -----------------------------------------------------------------------------
@@ -69,12 +151,142 @@ void LatticeModel::calculateInitialMatching()
 void LatticeModel::propagateTime()
 {
     // Propagate the time.
+    const ScopedRandomStream stream(model_stream_);
     simulation_timer_.propagateTime(interactions_.totalRate());
 }
 
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::seedRandomStream(const int seed)
+{
+    random_stream_.seed(seed);
+    model_stream_ = &random_stream_;
+}
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::save(const std::string & path) const
+{
+    CheckpointWriter writer(path);
+
+    // The size of the system, for checking that a checkpoint is read
+    // into a model of the same system.
+    writer.section("MODL");
+    writer.write(static_cast<unsigned long>(configuration_.types().size()));
+    writer.write(static_cast<unsigned long>(interactions_.processes().size()));
+
+    writer.write(step_pending_);
+    writer.write(step_start_time_);
+    writer.write(n_null_events_);
+
+    // The state of the stream the model draws from.
+    const ScopedRandomStream stream(model_stream_);
+    const std::string random_state = randomState();
+    writer.write(model_stream_ != NULL);
+    writer.writeVector(std::vector<char>(random_state.begin(), random_state.end()));
+
+    configuration_.saveState(writer);
+    simulation_timer_.saveState(writer);
+    interactions_.saveState(writer);
+    matcher_.saveState(writer);
+
+    writer.close();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::load(const std::string & path)
+{
+    readCheckpoint(path, false);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::readCheckpoint(const std::string & path, const bool restart)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CheckpointReader reader(path);
+
+    reader.section("MODL");
+    const unsigned long n_sites = reader.read<unsigned long>();
+    const unsigned long n_processes = reader.read<unsigned long>();
+    if (n_sites != configuration_.types().size() ||
+        n_processes != interactions_.processes().size())
+    {
+        throw std::runtime_error("The checkpoint " + path + " is not for a model of the same system.");
+    }
+
+    step_pending_ = reader.read<bool>();
+    step_start_time_ = reader.read<double>();
+    n_null_events_ = reader.read<long>();
+
+    // Draw from a stream of the model if the saved model did.
+    model_stream_ = reader.read<bool>() ? &random_stream_ : NULL;
+    std::vector<char> random_state;
+    reader.readVector(random_state);
+    {
+        const ScopedRandomStream stream(model_stream_);
+        setRandomState(std::string(random_state.begin(), random_state.end()));
+    }
+
+    configuration_.loadState(reader);
+    if (restart)
+    {
+        setup_timings_.match_lists = secondsSince(start);
+
+        // The process match lists get their wildcards from the read
+        // configuration match lists.
+        start = std::chrono::steady_clock::now();
+        interactions_.updateProcessMatchLists(configuration_, lattice_map_);
+        setup_timings_.process_match_lists = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+    }
+
+    simulation_timer_.loadState(reader);
+    interactions_.loadState(reader);
+    matcher_.loadState(reader);
+
+    if (restart)
+    {
+        setup_timings_.matching = secondsSince(start);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::setCheckpointInterval(const std::string & path, const double seconds)
+{
+    checkpoint_path_ = path;
+    checkpoint_interval_ = seconds;
+    last_checkpoint_ = std::chrono::steady_clock::now();
+}
+
+
 // -----------------------------------------------------------------------------
 //
 void LatticeModel::singleStep()
+{
+    // Count the heap allocations made during the step, if counted.
+    const ScopedRandomStream stream(model_stream_);
+    if (n_step_allocations_ < 0)
+    {
+        performStep();
+        return;
+    }
+
+    const long n_allocations = heapAllocations();
+    performStep();
+    n_step_allocations_ += heapAllocations() - n_allocations;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void LatticeModel::performStep()
 {
     // Select a process.
     Process & process = (*interactions_.pickProcess());
@@ -82,19 +294,106 @@ void LatticeModel::singleStep()
     // Select a site.
     const int site_index = process.pickSite();
 
+    // Processes with lazy rates are listed with an upper bound of the rate.
+    // Evaluate the real rate now and accept the event with probability
+    // rate/bound. A rejected event is a null event that leaves the
+    // configuration unchanged, with the time propagated as usual.
+    const double rate_upper_bound = process.rateUpperBound();
+    if (rate_upper_bound > 0.0)
+    {
+        const double rate = matcher_.evaluateRate(site_index,
+                                                  process,
+                                                  interactions_,
+                                                  configuration_);
+        if (rate > rate_upper_bound)
+        {
+            throw std::runtime_error("A custom rate exceeds the rate upper bound of its process.");
+        }
+
+        if (randomDouble01() * rate_upper_bound >= rate)
+        {
+            ++n_null_events_;
+            return;
+        }
+    }
+
     // Perform the operation.
     configuration_.performBucketProcess(process, site_index, lattice_map_);
 
     // Run the re-matching of the affected sites and their neighbours.
-    const std::vector<int> & indices = \
-        lattice_map_.supersetNeighbourIndices(process.affectedIndices(), interactions_.maxRange());
+    // The matcher pushes the new total rates of all touched processes
+    // to the process selection tree on the interactions object, so there
+    // is no need to recalculate the full probability table here.
+    if (mixed_ranges_)
+    {
+        // Only rematch each process at the indices within its own range
+        // of the affected sites.
+        lattice_map_.supersetNeighbourIndices(process.affectedIndices(),
+                                              max_range_,
+                                              neighbour_indices_,
+                                              neighbour_shells_);
 
-    matcher_.calculateMatching(interactions_,
-                               configuration_,
-                               lattice_map_,
-                               indices);
+        matcher_.calculateMatching(interactions_,
+                                   configuration_,
+                                   lattice_map_,
+                                   neighbour_indices_,
+                                   neighbour_shells_,
+                                   matcher_scratch_);
+    }
+    else
+    {
+        lattice_map_.supersetNeighbourIndices(process.affectedIndices(),
+                                              max_range_,
+                                              neighbour_indices_);
 
-    // Update the interactions' probability table.
-    interactions_.updateProbabilityTable();
+        matcher_.calculateMatching(interactions_,
+                                   configuration_,
+                                   lattice_map_,
+                                   neighbour_indices_,
+                                   matcher_scratch_);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+int LatticeModel::runSteps(const int n_steps,
+                           const double dump_time,
+                           const double last_time)
+{
+    step_pending_ = false;
+
+    for (int step = 0; step < n_steps; ++step)
+    {
+        // Stop if no step can be taken.
+        if (interactions_.totalAvailableSites() == 0)
+        {
+            return step;
+        }
+
+        // Propagate the time.
+        step_start_time_ = simulation_timer_.simulationTime();
+        propagateTime();
+
+        // Stop before the step is performed if the time interval is reached.
+        if (dump_time >= 0.0 &&
+            (simulation_timer_.simulationTime() - last_time) >= dump_time)
+        {
+            step_pending_ = true;
+            return step;
+        }
+
+        // Perform the step.
+        singleStep();
+
+        // Write a checkpoint if the wall clock interval has passed.
+        if (checkpoint_interval_ > 0.0 && secondsSince(last_checkpoint_) >= checkpoint_interval_)
+        {
+            save(checkpoint_path_);
+            last_checkpoint_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    return n_steps;
 }
 
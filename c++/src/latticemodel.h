@@ -17,15 +17,40 @@
 #define __LATTICEMODEL__
 
 
+#include <chrono>
+#include <string>
+
 #include "latticemap.h"
 #include "interactions.h"
 #include "matcher.h"
+#include "random.h"
 
 // Forward declarations.
 class Configuration;
 class SimulationTimer;
 class Process;
 
+/*! \brief The wall clock time in seconds spent in each phase of the setup of
+ *         a lattice model. For a model restarted from a checkpoint the match
+ *         lists and the matching are read, and their timings are the time
+ *         spent reading them.
+ */
+struct SetupTimings {
+
+    /// Setting up the configuration match lists.
+    double match_lists;
+
+    /// Adding the implicit wildcards to the process match lists.
+    double process_match_lists;
+
+    /// Matching all sites with all processes.
+    double matching;
+
+    /// Setting up the process probability table.
+    double probability_table;
+};
+
+
 /// Class for defining and running a lattice KMC model.
 class LatticeModel {
 
@@ -37,20 +62,141 @@ public:
      *  \param lattice_map      : A lattice map object describing the lattice.
      *  \param interactions     : An interactions object describing all interactions
      *                         and possible processes in the system.
+     *  \param selection_engine : The engine to use for picking sites within
+     *                            a process, defaults to SUM_TREE.
+     *  \param n_threads        : The number of threads to use for the setup,
+     *                            for matching and for thread safe custom
+     *                            rate calculators, defaults to one.
      */
     LatticeModel(Configuration & configuration,
                  SimulationTimer & simulation_timer,
                  const LatticeMap & lattice_map,
-                 const Interactions & interactions);
+                 const Interactions & interactions,
+                 const SELECTION_ENGINE selection_engine=SUM_TREE,
+                 const int n_threads=1);
+
+    /*! \brief Constructor for restarting a model from a checkpoint written
+     *         by save(). The configuration, lattice map and interactions must
+     *         describe the same system as the saved model, e.g. as set up by
+     *         the same script. The match lists, the listed sites of each
+     *         process, the stored rates, the simulation time and the random
+     *         number state are read from the checkpoint instead of being
+     *         recalculated, and the model continues exactly as the saved one
+     *         would have.
+     *  \param configuration    : The configuration to run the simulation on.
+     *  \param simulation_timer : The timer for the simulation.
+     *  \param lattice_map      : A lattice map object describing the lattice.
+     *  \param interactions     : An interactions object describing all interactions
+     *                            and possible processes in the system.
+     *  \param checkpoint       : The path of the checkpoint file.
+     *  \param n_threads        : The number of threads to use for matching and
+     *                            for thread safe custom rate calculators,
+     *                            defaults to one.
+     */
+    LatticeModel(Configuration & configuration,
+                 SimulationTimer & simulation_timer,
+                 const LatticeMap & lattice_map,
+                 const Interactions & interactions,
+                 const std::string & checkpoint,
+                 const int n_threads=1);
 
     /*! \brief Function for taking one time step in the KMC lattice model.
+     *         For processes with a rate upper bound the step may be a
+     *         null event that leaves the configuration unchanged.
      */
     void singleStep();
 
+    /*! \brief Query for the number of null events, i.e. steps where a lazily
+     *         evaluated custom rate was rejected against its upper bound.
+     *  \return : The number of null events.
+     */
+    long nNullEvents() const { return n_null_events_; }
+
+    /*! \brief Query for the number of heap allocations made by singleStep().
+     *         The work storage of the steps is kept on the model between
+     *         steps, so this count should stop growing once the largest
+     *         neighbourhoods have been seen. For checking that steady-state
+     *         stepping does not allocate.
+     *  \return : The number of heap allocations made by all steps so far,
+     *            or -1 if the backend is built without counting them, see
+     *            allocationcounter.h.
+     */
+    long nStepAllocations() const { return n_step_allocations_; }
+
     /*! \brief Function for updating the time for the single step.
      */
     void propagateTime();
 
+    /*! \brief Give the model a random number stream of its own, that all
+     *         random numbers of its steps and time propagation are drawn
+     *         from. Without a stream of its own the model draws from the
+     *         stream in use on the calling thread, which is the shared
+     *         generator by default. Models with streams of their own can be
+     *         stepped concurrently on different threads.
+     *  \param seed : The seed of the stream.
+     */
+    void seedRandomStream(const int seed);
+
+    /*! \brief Run a batch of steps natively, where each step is a call to
+     *         propagateTime() followed by singleStep(). The batch ends early
+     *         if no process is available, or if a time interval is given and
+     *         the time propagated for a step reaches it. In the latter case the
+     *         time is propagated but singleStep() is not performed for that
+     *         step, so that the configuration can be dumped before it is
+     *         completed. This is flagged by stepPending().
+     *  \param n_steps   : The maximum number of steps to take.
+     *  \param dump_time : The time interval after last_time at which to stop,
+     *                     or a negative value for no time stop.
+     *  \param last_time : The time from which the dump time is counted.
+     *  \return : The number of completed steps.
+     */
+    int runSteps(const int n_steps,
+                 const double dump_time=-1.0,
+                 const double last_time=0.0);
+
+    /*! \brief Query for the flag indicating that the latest call to runSteps
+     *         stopped on the time interval with the time of a step propagated
+     *         but singleStep() not yet performed.
+     *  \return : The step pending flag.
+     */
+    bool stepPending() const { return step_pending_; }
+
+    /*! \brief Query for the simulation time before the time of the latest
+     *         step taken by runSteps was propagated.
+     *  \return : The start time of the latest step.
+     */
+    double stepStartTime() const { return step_start_time_; }
+
+    /*! \brief Write the complete state of the model to a binary checkpoint
+     *         file, being the configuration and its match lists, the
+     *         simulation time, the listed sites and rates of all processes,
+     *         the stored custom rates and the random number state. The
+     *         random number state is that of the stream of the model, or of
+     *         the stream in use on the calling thread if the model has none.
+     *  \param path : The path of the checkpoint file.
+     */
+    void save(const std::string & path) const;
+
+    /*! \brief Read the state of the model from a checkpoint file written by
+     *         save() on a model of the same system, e.g. for going back to an
+     *         earlier state.
+     *  \param path : The path of the checkpoint file.
+     */
+    void load(const std::string & path);
+
+    /*! \brief Let runSteps write a checkpoint after each step where the
+     *         given wall clock interval has passed since the latest one.
+     *  \param path    : The path of the checkpoint file, overwritten each time.
+     *  \param seconds : The wall clock interval in seconds, zero or negative
+     *                   to stop writing checkpoints.
+     */
+    void setCheckpointInterval(const std::string & path, const double seconds);
+
+    /*! \brief Query for the time spent in each phase of the setup.
+     *  \return : The setup timings.
+     */
+    const SetupTimings & setupTimings() const { return setup_timings_; }
+
     /*! \brief Query for the interactions.
      *  \return : A handle to the interactions stored on the class.
      */
@@ -72,8 +218,22 @@ private:
 
     /*! \brief Private helper function to initiate matching of all
      *         processes with all indices in the configuration.
+     *  \param n_threads : The number of threads to use.
+     */
+    void calculateInitialMatching(const int n_threads);
+
+    /*! \brief Private helper function to read the state of the model.
+     *  \param path    : The path of the checkpoint file.
+     *  \param restart : If the model is being restarted, in which case the
+     *                   process match lists are set up from the read match
+     *                   lists of the configuration.
      */
-    void calculateInitialMatching();
+    void readCheckpoint(const std::string & path, const bool restart);
+
+    /*! \brief Private helper function to take one time step, called by
+     *         singleStep() which counts the heap allocations made.
+     */
+    void performStep();
 
     /// A reference to the configuration given at construction.
     Configuration & configuration_;
@@ -89,6 +249,52 @@ private:
 
     /// The Matcher to use for calculating matches and update the process lists.
     Matcher matcher_;
+
+    /// Flag indicating that runSteps stopped with a step pending.
+    bool step_pending_;
+
+    /// The simulation time at the start of the latest step in runSteps.
+    double step_start_time_;
+
+    /// The number of rejected lazy rate events.
+    long n_null_events_;
+
+    /// The number of heap allocations made by the steps.
+    long n_step_allocations_;
+
+    /// The max range of all processes, in shells.
+    int max_range_;
+
+    /// If the processes have different ranges, in which case each process
+    /// is only rematched around the changed sites within its own range.
+    bool mixed_ranges_;
+
+    /// Work vector for the indices to rematch after a step.
+    std::vector<int> neighbour_indices_;
+
+    /// Work vector for the shell of each index to rematch after a step.
+    std::vector<int> neighbour_shells_;
+
+    /// Work vectors for the matching after a step.
+    MatcherScratch matcher_scratch_;
+
+    /// The random number stream of the model.
+    RandomStream random_stream_;
+
+    /// Pointer to the random number stream of the model, or NULL if it has none.
+    RandomStream * model_stream_;
+
+    /// The time spent in each phase of the setup.
+    SetupTimings setup_timings_;
+
+    /// The path of the automatic checkpoints.
+    std::string checkpoint_path_;
+
+    /// The wall clock interval of the automatic checkpoints, zero for none.
+    double checkpoint_interval_;
+
+    /// The wall clock time of the latest automatic checkpoint.
+    std::chrono::steady_clock::time_point last_checkpoint_;
 };
 
 
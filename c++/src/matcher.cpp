@@ -16,21 +16,95 @@
 
 #include "matcher.h"
 #include "matchlist.h"
+#include "packedtypes.h"
 #include "process.h"
 #include "interactions.h"
 #include "latticemap.h"
 #include "configuration.h"
 #include "latticemap.h"
 #include "hash.h"
+#include "checkpoint.h"
 
 #include "mpicommons.h"
 #include "mpiroutines.h"
 
+// The least number of index and process pairs to match on each thread.
+static const size_t min_pairs_per_thread__ = 2048;
+
+// The least number of custom rates to calculate on each thread.
+static const size_t min_rates_per_thread__ = 64;
+
+
+// Work storage for the arguments to the custom rate call-backs.
+struct RateCallbackScratch
+{
+    ConfigBucketMatchList config_match_list;
+    std::vector<double> geometry;
+    std::vector<std::string> types_before;
+    std::vector<std::string> types_after;
+    std::vector<TypeBucket> occupations;
+    std::vector<TypeBucket> update;
+    TypeBucket zero_bucket;
+};
+
+// The call-back work storage, one per thread so that rates can be
+// calculated concurrently.
+static thread_local RateCallbackScratch rate_callback_scratch__;
+
+
+// -----------------------------------------------------------------------------
+// Get the multiplicity of a process on a site it matches, from the packed
+// types if they can be compared and otherwise from the full match list.
+// The types of a configuration in single occupancy mode are not packed and
+// are never compared here.
+static double siteMultiplicity(const Process & process,
+                               const PackedTypes & process_types,
+                               const Configuration & configuration,
+                               const int index)
+{
+    const ProcessBucketMatchList & process_match_list = process.processMatchList();
+    if (!configuration.singleOccupancy())
+    {
+        const PackedTypes & config_types = configuration.packedMatchTypes(index);
+        const int config_lanes = packedLanes(configuration.matchListGeometry(index));
+        if (packedComparable(process_match_list, process_types, config_lanes, config_types))
+        {
+            return packedMultiplicity(&process_types[0],
+                                      &config_types[0],
+                                      process_match_list.size() * config_lanes);
+        }
+    }
+
+    static thread_local ConfigBucketMatchList config_match_list;
+    configuration.configMatchList(index, config_match_list);
+    return multiplicity(process_match_list, config_match_list);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+template <class T_task>
+void Matcher::runChunks(const int n_chunks,
+                        const T_task & task) const
+{
+    // Run a single chunk directly on the calling thread.
+    if (n_chunks == 1)
+    {
+        task(0);
+    }
+    else
+    {
+        thread_pool_.run(n_chunks, n_chunks, task);
+    }
+}
+
+
 // -----------------------------------------------------------------------------
 //
 Matcher::Matcher(const size_t & sites, const size_t & processes) :
     rate_table_(),
-    inverse_table_(sites, std::vector<bool>(processes, false))
+    site_matches_(sites),
+    n_threads_(1)
 {
     // NOTHING HERE YET
 }
@@ -42,13 +116,50 @@ void Matcher::calculateMatching(Interactions & interactions,
                                 Configuration & configuration,
                                 const LatticeMap & lattice_map,
                                 const std::vector<int> & indices)
+{
+    MatcherScratch scratch;
+    calculateMatching(interactions,
+                      configuration,
+                      lattice_map,
+                      indices,
+                      scratch);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::calculateMatching(Interactions & interactions,
+                                Configuration & configuration,
+                                const LatticeMap & lattice_map,
+                                const std::vector<int> & indices,
+                                MatcherScratch & scratch)
+{
+    calculateMatching(interactions,
+                      configuration,
+                      lattice_map,
+                      indices,
+                      std::vector<int>(),
+                      scratch);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::calculateMatching(Interactions & interactions,
+                                Configuration & configuration,
+                                const LatticeMap & lattice_map,
+                                const std::vector<int> & indices,
+                                const std::vector<int> & index_shells,
+                                MatcherScratch & scratch)
 {
     // PERFORMME: What happens in this function is
     //            highly performance critical.
 
     // Build the list of indices and processes to match.
 
-    std::vector<std::pair<int,int> > index_process_to_match;
+    std::vector<std::pair<int,int> > & index_process_to_match = scratch.index_process_to_match;
+    index_process_to_match.clear();
+
     for(size_t i = 0; i < indices.size(); ++i)
     {
         // Get the index.
@@ -61,8 +172,16 @@ void Matcher::calculateMatching(Interactions & interactions,
         // For each process, check if we should try to match.
         for (size_t j = 0; j < interactions.processes().size(); ++j)
         {
+            const Process & process = (*interactions.processes()[j]);
+
+            // Skip processes whose range does not reach a changed site.
+            if (!index_shells.empty() && std::max(1, process.range()) < index_shells[i])
+            {
+                continue;
+            }
+
             // Check if the basis site is listed.
-            const std::vector<int> & process_basis_sites = (*interactions.processes()[j]).basisSites();
+            const std::vector<int> & process_basis_sites = process.basisSites();
             if ( std::find(process_basis_sites.begin(), process_basis_sites.end(), basis_site) != process_basis_sites.end() )
             {
                 // This is a potential match.
@@ -80,32 +199,40 @@ void Matcher::calculateMatching(Interactions & interactions,
 
     // Generate the lists of tasks.
 
-    std::vector<RemoveTask> remove_tasks;
-    std::vector<RateTask>   update_tasks;
-    std::vector<RateTask>   add_tasks;
+    std::vector<RemoveTask> & remove_tasks = scratch.remove_tasks;
+    std::vector<RateTask>   & update_tasks = scratch.update_tasks;
+    std::vector<RateTask>   & add_tasks    = scratch.add_tasks;
 
     matchIndicesWithProcesses(index_process_to_match,
                               interactions,
                               configuration,
-                              remove_tasks,
-                              update_tasks,
-                              add_tasks);
+                              scratch);
 
     // Calculate the new rates if needed.
 
     if (interactions.useCustomRates())
     {
         // Create a common task list for getting a good load balance.
-        std::vector<RateTask> global_tasks;
-        std::vector<ratekey>  global_keys;
-        std::vector<int>      global_process_numbers;
+        std::vector<RateTask> & global_tasks = scratch.rate_tasks;
+        std::vector<ratekey>  & global_keys  = scratch.rate_keys;
+        global_tasks.clear();
+        global_keys.clear();
 
         // Find out which tasks are allready calculated and stored.
-        std::vector<int> add_task_indices;
+        std::vector<int> & add_task_indices = scratch.add_task_indices;
+        add_task_indices.clear();
+
         for (size_t i = 0; i < add_tasks.size(); ++i)
         {
-            // Calculate the key.
+            // Processes with lazy rates are listed with their upper bound.
             const Process & process = (*interactions.processes()[add_tasks[i].process]);
+            if (process.rateUpperBound() > 0.0)
+            {
+                add_tasks[i].rate = process.rateUpperBound();
+                continue;
+            }
+
+            // Calculate the key.
             const int index   = add_tasks[i].index;
             const ratekey key = hashCustomRateInput(index, process, configuration);
 
@@ -118,17 +245,25 @@ void Matcher::calculateMatching(Interactions & interactions,
             {
                 global_tasks.push_back(add_tasks[i]);
                 global_keys.push_back(key);
-                global_process_numbers.push_back(process.processNumber());
                 add_task_indices.push_back(i);
             }
         }
 
         // The same procedure for the update tasks.
-        std::vector<int> update_task_indices;
+        std::vector<int> & update_task_indices = scratch.update_task_indices;
+        update_task_indices.clear();
+
         for (size_t i = 0; i < update_tasks.size(); ++i)
         {
-            // Calculate the key.
+            // Processes with lazy rates are listed with their upper bound.
             const Process & process = (*interactions.processes()[update_tasks[i].process]);
+            if (process.rateUpperBound() > 0.0)
+            {
+                update_tasks[i].rate = process.rateUpperBound();
+                continue;
+            }
+
+            // Calculate the key.
             const int index   = update_tasks[i].index;
             const ratekey key = hashCustomRateInput(index, process, configuration);
 
@@ -141,7 +276,6 @@ void Matcher::calculateMatching(Interactions & interactions,
             {
                 global_tasks.push_back(update_tasks[i]);
                 global_keys.push_back(key);
-                global_process_numbers.push_back(process.processNumber());
                 update_task_indices.push_back(i);
             }
         }
@@ -149,15 +283,25 @@ void Matcher::calculateMatching(Interactions & interactions,
         // ------------------------------------------------------------------------
         // Here comes the MPI parallelism
         // ------------------------------------------------------------------------
-        // Split up the tasks.
-        std::vector<RateTask> local_tasks = splitOverProcesses(global_tasks);
-        std::vector<double> local_tasks_rates(local_tasks.size(), 0.0);
+        std::vector<double> & global_tasks_rates = scratch.rates;
+
+        if (MPICommons::size() > 1)
+        {
+            // Split up the tasks.
+            const std::vector<RateTask> local_tasks = splitOverProcesses(global_tasks);
+            std::vector<double> local_tasks_rates(local_tasks.size(), 0.0);
 
-        // Update in parallel.
-        updateRates(local_tasks_rates, local_tasks, interactions, configuration);
+            // Update in parallel.
+            updateRates(local_tasks_rates, local_tasks, interactions, configuration);
 
-        // Join the results.
-        const std::vector<double> global_tasks_rates = joinOverProcesses(local_tasks_rates);
+            // Join the results.
+            global_tasks_rates = joinOverProcesses(local_tasks_rates);
+        }
+        else
+        {
+            global_tasks_rates.resize(global_tasks.size());
+            updateRates(global_tasks_rates, global_tasks, interactions, configuration);
+        }
         // ------------------------------------------------------------------------
 
         // Copy the results over to the tasks vectors.
@@ -178,8 +322,7 @@ void Matcher::calculateMatching(Interactions & interactions,
         for (size_t i = 0; i < global_tasks_rates.size(); ++i)
         {
             // But only if the procees can safely be cached.
-            const int process_number = global_process_numbers[i];
-            if ((*interactions.processes()[process_number]).cacheRate())
+            if ((*interactions.processes()[global_tasks[i].process]).cacheRate())
             {
                 const ratekey key = global_keys[i];
                 const double rate = global_tasks_rates[i];
@@ -192,11 +335,13 @@ void Matcher::calculateMatching(Interactions & interactions,
     updateProcesses(remove_tasks,
                     update_tasks,
                     add_tasks,
-                    interactions);
+                    interactions,
+                    scratch.touched_processes);
 
     // DONE
 }
 
+
 // -----------------------------------------------------------------------------
 //
 void Matcher::matchIndicesWithProcesses(const std::vector<std::pair<int,int> > & index_process_to_match,
@@ -206,96 +351,280 @@ void Matcher::matchIndicesWithProcesses(const std::vector<std::pair<int,int> > &
                                         std::vector<RateTask>   & update_tasks,
                                         std::vector<RateTask>   & add_tasks) const
 {
-    // Setup local variables for running in parallel.
-    std::vector< std::pair<int,int> > local_index_process_to_match = \
-        splitOverProcesses(index_process_to_match);
+    MatcherScratch scratch;
+    matchIndicesWithProcesses(index_process_to_match,
+                              interactions,
+                              configuration,
+                              scratch);
+
+    remove_tasks.swap(scratch.remove_tasks);
+    update_tasks.swap(scratch.update_tasks);
+    add_tasks.swap(scratch.add_tasks);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::matchIndicesWithProcesses(const std::vector<std::pair<int,int> > & index_process_to_match,
+                                        const Interactions  & interactions,
+                                        const Configuration & configuration,
+                                        MatcherScratch & scratch) const
+{
+    // Setup local variables for running in parallel, but only split and
+    // join when there is more than one MPI process.
+    const bool split = (MPICommons::size() > 1);
+
+    std::vector< std::pair<int,int> > split_index_process_to_match;
+    if (split)
+    {
+        split_index_process_to_match = splitOverProcesses(index_process_to_match);
+    }
+    const std::vector< std::pair<int,int> > & local_index_process_to_match = \
+        split ? split_index_process_to_match : index_process_to_match;
 
     // These are the local task types to fill with matching restults.
     const int n_local_tasks = local_index_process_to_match.size();
-    std::vector<int> local_task_types(n_local_tasks, 0);
+    std::vector<int> & task_types = scratch.task_types;
+    task_types.assign(n_local_tasks, 0);
+
+    // Match contiguous chunks of the pairs on separate threads. Each chunk
+    // writes the task types of its own pairs only.
+    const int n_match_chunks = nChunks(n_local_tasks, min_pairs_per_thread__);
+    scratch.chunk_is_matching.resize(std::max(n_match_chunks, static_cast<int>(scratch.chunk_is_matching.size())));
+    scratch.chunk_matching.resize(scratch.chunk_is_matching.size());
+
+    runChunks(n_match_chunks, [&](const int chunk)
+              {
+                  matchChunk(local_index_process_to_match,
+                             chunkStart(n_local_tasks, n_match_chunks, chunk),
+                             chunkStart(n_local_tasks, n_match_chunks, chunk+1),
+                             interactions,
+                             configuration,
+                             scratch.chunk_is_matching[chunk],
+                             scratch.chunk_matching[chunk],
+                             task_types);
+              });
+
+    // Join the result - parallel.
+    if (split)
+    {
+        task_types = joinOverProcesses(task_types);
+    }
+
+    // Loop again and add the tasks to the taks vectors. The first chunk
+    // fills the output vectors directly and each other chunk its own task
+    // vectors, which are appended in chunk order so that the tasks come
+    // out in the same order regardless of the number of threads.
+    const size_t n_tasks = index_process_to_match.size();
+    const int n_task_chunks = nChunks(n_tasks, min_pairs_per_thread__);
+
+    scratch.remove_tasks.clear();
+    scratch.update_tasks.clear();
+    scratch.add_tasks.clear();
+
+    const bool single_occupancy = (configuration.singleOccupancy() &&
+                                   interactions.processTrie().singleOccupancy());
+
+    const size_t n_chunk_tasks = std::max(n_task_chunks, static_cast<int>(scratch.chunk_remove_tasks.size()));
+    scratch.chunk_remove_tasks.resize(n_chunk_tasks);
+    scratch.chunk_update_tasks.resize(n_chunk_tasks);
+    scratch.chunk_add_tasks.resize(n_chunk_tasks);
+
+    runChunks(n_task_chunks, [&](const int chunk)
+              {
+                  std::vector<RemoveTask> & remove_tasks = (chunk == 0) ? scratch.remove_tasks : scratch.chunk_remove_tasks[chunk];
+                  std::vector<RateTask>   & update_tasks = (chunk == 0) ? scratch.update_tasks : scratch.chunk_update_tasks[chunk];
+                  std::vector<RateTask>   & add_tasks    = (chunk == 0) ? scratch.add_tasks    : scratch.chunk_add_tasks[chunk];
+
+                  if (chunk != 0)
+                  {
+                      remove_tasks.clear();
+                      update_tasks.clear();
+                      add_tasks.clear();
+                  }
+
+                  const size_t begin = chunkStart(n_tasks, n_task_chunks, chunk);
+                  const size_t end   = chunkStart(n_tasks, n_task_chunks, chunk+1);
+
+                  for (size_t i = begin; i < end; ++i)
+                  {
+                      const int index = index_process_to_match[i].first;
+                      const int p_idx = index_process_to_match[i].second;
+                      const Process & process = (*interactions.processes()[p_idx]);
+
+                      // If no match and previous match - remove.
+                      if (task_types[i] == 1)
+                      {
+                          RemoveTask t;
+                          t.index   = index;
+                          t.process = p_idx;
+                          remove_tasks.push_back(t);
+                      }
+
+                      else if (task_types[i] == 2 || task_types[i] == 3)
+                      {
+                          // Get the multiplicity, which is always one with
+                          // a single atom at each site.
+                          const double m = single_occupancy ? 1.0 :
+                              siteMultiplicity(process,
+                                               interactions.processTrie().packedMatchTypes(p_idx),
+                                               configuration,
+                                               index);
+
+                          RateTask t;
+                          t.index        = index;
+                          t.process      = p_idx;
+                          t.rate         = process.rateConstant();
+                          t.multiplicity = m;
+
+                          // If match and previous match - update the rate.
+                          if (task_types[i] == 2)
+                          {
+                              update_tasks.push_back(t);
+                          }
+
+                          // If match and not previous match - add.
+                          else if (task_types[i] == 3)
+                          {
+                              add_tasks.push_back(t);
+                          }
+                      }
+                  }
+              });
+
+    for (int chunk = 1; chunk < n_task_chunks; ++chunk)
+    {
+        scratch.remove_tasks.insert(scratch.remove_tasks.end(),
+                                    scratch.chunk_remove_tasks[chunk].begin(),
+                                    scratch.chunk_remove_tasks[chunk].end());
+        scratch.update_tasks.insert(scratch.update_tasks.end(),
+                                    scratch.chunk_update_tasks[chunk].begin(),
+                                    scratch.chunk_update_tasks[chunk].end());
+        scratch.add_tasks.insert(scratch.add_tasks.end(),
+                                 scratch.chunk_add_tasks[chunk].begin(),
+                                 scratch.chunk_add_tasks[chunk].end());
+    }
+
+    // DONE
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::matchChunk(const std::vector<std::pair<int,int> > & index_process_to_match,
+                         const size_t begin,
+                         const size_t end,
+                         const Interactions  & interactions,
+                         const Configuration & configuration,
+                         std::vector<char> & is_matching,
+                         std::vector<int> & matching,
+                         std::vector<int> & task_types) const
+{
+    // The pairs of each index are consecutive. Match each index against
+    // all processes at once in the process trie, and flag the processes
+    // that match until the next index comes up. The flags are all cleared
+    // again when the chunk is done.
+    const ProcessTrie & process_trie = interactions.processTrie();
+    const bool single_occupancy = (configuration.singleOccupancy() && process_trie.singleOccupancy());
+    is_matching.resize(interactions.processes().size(), 0);
+    matching.clear();
+    int matched_index = -1;
 
     // Loop over pairs to match.
-    for (size_t i = 0; i < local_index_process_to_match.size(); ++i)
+    for (size_t i = begin; i < end; ++i)
     {
         // Get the process and index to match.
-        const int index = local_index_process_to_match[i].first;
-        const int p_idx = local_index_process_to_match[i].second;
-        Process & process = (*interactions.processes()[p_idx]);
+        const int index = index_process_to_match[i].first;
+        const int p_idx = index_process_to_match[i].second;
 
         // Perform the matching.
-        const bool in_list = inverse_table_[index][p_idx];
+        const bool in_list = site_matches_.isListed(index, p_idx);
+
+        if (index != matched_index)
+        {
+            for (size_t j = 0; j < matching.size(); ++j)
+            {
+                is_matching[matching[j]] = 0;
+            }
+            matching.clear();
+
+            // Match on the shared geometry and the single type of each
+            // entry, or the packed types, or on the full match list if
+            // the types are not packed.
+            const ConfigBucketMatchList & geometry = configuration.matchListGeometry(index);
+            if (single_occupancy)
+            {
+                static thread_local PackedTypes site_types;
+                configuration.siteMatchTypes(index, site_types);
+                process_trie.match(geometry,
+                                   site_types,
+                                   configuration.matchListSignature(index),
+                                   matching,
+                                   true);
+            }
+            else if (!configuration.singleOccupancy() &&
+                     !configuration.packedMatchTypes(index).empty() &&
+                     process_trie.packedLanes() == packedLanes(geometry))
+            {
+                process_trie.match(geometry,
+                                   configuration.packedMatchTypes(index),
+                                   configuration.matchListSignature(index),
+                                   matching);
+            }
+            else
+            {
+                static thread_local ConfigBucketMatchList config_match_list;
+                configuration.configMatchList(index, config_match_list);
+                process_trie.match(config_match_list,
+                                   configuration.matchListSignature(index),
+                                   matching);
+            }
 
-        // ML:
-        const bool is_match = whateverMatch(process.processMatchList(),
-                                            configuration.configMatchList(index));
+            for (size_t j = 0; j < matching.size(); ++j)
+            {
+                is_matching[matching[j]] = 1;
+            }
+            matched_index = index;
+        }
+
+        const bool is_match = is_matching[p_idx];
 
         // Determine what to do with this pair of processes and indices.
         if (!is_match && in_list)
         {
             // If no match and previous match - remove.
-            local_task_types[i] = 1;
+            task_types[i] = 1;
         }
         else if (is_match && in_list)
         {
             // If match and previous match - update the rate.
-            local_task_types[i] = 2;
+            task_types[i] = 2;
         }
         else if (is_match && !in_list)
         {
             // If match and not previous match - add.
-            local_task_types[i] = 3;
+            task_types[i] = 3;
         }
     }
 
-    // Join the result - parallel.
-    const std::vector<int> task_types = joinOverProcesses(local_task_types);
-
-    // Loop again (not in parallel) and add the tasks to the taks vectors.
-    const size_t n_tasks = index_process_to_match.size();
-    for (size_t i = 0; i < n_tasks; ++i)
+    for (size_t j = 0; j < matching.size(); ++j)
     {
-        const int index = index_process_to_match[i].first;
-        const int p_idx = index_process_to_match[i].second;
-        const Process & process = (*interactions.processes()[p_idx]);
-
-        // If no match and previous match - remove.
-        if (task_types[i] == 1)
-        {
-            RemoveTask t;
-            t.index   = index;
-            t.process = p_idx;
-            remove_tasks.push_back(t);
-        }
-
-        else if (task_types[i] == 2 || task_types[i] == 3)
-        {
-            // Get the multiplicity.
-            const double m = multiplicity(process.processMatchList(),
-                                          configuration.configMatchList(index));
-
-            RateTask t;
-            t.index        = index;
-            t.process      = p_idx;
-            t.rate         = process.rateConstant();
-            t.multiplicity = m;
-
-            // If match and previous match - update the rate.
-            if (task_types[i] == 2)
-            {
-                update_tasks.push_back(t);
-            }
-
-            // If match and not previous match - add.
-            else if (task_types[i] == 3)
-            {
-                add_tasks.push_back(t);
-            }
-        }
+        is_matching[matching[j]] = 0;
     }
+    matching.clear();
+}
 
-    // DONE
+
+// -----------------------------------------------------------------------------
+//
+int Matcher::nChunks(const size_t n_items, const size_t min_items_per_chunk) const
+{
+    const size_t n_chunks = std::min(static_cast<size_t>(n_threads_),
+                                     n_items / min_items_per_chunk);
+    return std::max(static_cast<int>(n_chunks), 1);
 }
 
+
 // -----------------------------------------------------------------------------
 //
 bool Matcher::isMatch(const ProcessBucketMatchList & process_match_list,
@@ -462,16 +791,43 @@ void Matcher::updateProcesses(const std::vector<RemoveTask> & remove_tasks,
                               const std::vector<RateTask>   & update_tasks,
                               const std::vector<RateTask>   & add_tasks,
                               Interactions & interactions)
+{
+    std::vector<int> touched_processes;
+    updateProcesses(remove_tasks,
+                    update_tasks,
+                    add_tasks,
+                    interactions,
+                    touched_processes);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::updateProcesses(const std::vector<RemoveTask> & remove_tasks,
+                              const std::vector<RateTask>   & update_tasks,
+                              const std::vector<RateTask>   & add_tasks,
+                              Interactions & interactions,
+                              std::vector<int> & touched_processes)
 {
     // This could perhaps be OpenMP parallelized.
 
+    // Keep track of which processes are touched, so that only these
+    // need to be updated in the process selection tree.
+    touched_processes.clear();
+
+    // The slot of each site in the list of sites of a process is kept in
+    // the site match table, so that the sites are removed without a
+    // lookup in the process.
+
     // Remove.
     for (size_t i = 0; i < remove_tasks.size(); ++i)
     {
         const int index = remove_tasks[i].index;
         const int p_idx = remove_tasks[i].process;
-        interactions.processes()[p_idx]->removeSite(index);
-        inverse_table_[index][p_idx] = false;
+        removeProcessSite(site_matches_.remove(index, p_idx),
+                          p_idx,
+                          *interactions.processes()[p_idx]);
+        touched_processes.push_back(p_idx);
     }
 
     // Update.
@@ -480,8 +836,11 @@ void Matcher::updateProcesses(const std::vector<RemoveTask> & remove_tasks,
         const int index   = update_tasks[i].index;
         const int p_idx   = update_tasks[i].process;
         const double rate = update_tasks[i].rate;
-        interactions.processes()[p_idx]->removeSite(index);
-        interactions.processes()[p_idx]->addSite(index, rate);
+        Process & process = *interactions.processes()[p_idx];
+        removeProcessSite(site_matches_.slot(index, p_idx), p_idx, process);
+        process.addSite(index, rate);
+        site_matches_.setSlot(index, p_idx, process.nSites() - 1);
+        touched_processes.push_back(p_idx);
     }
 
     // Add.
@@ -490,8 +849,36 @@ void Matcher::updateProcesses(const std::vector<RemoveTask> & remove_tasks,
         const int index   = add_tasks[i].index;
         const int p_idx   = add_tasks[i].process;
         const double rate = add_tasks[i].rate;
-        interactions.processes()[p_idx]->addSite(index, rate);
-        inverse_table_[index][p_idx] = true;
+        Process & process = *interactions.processes()[p_idx];
+        process.addSite(index, rate);
+        site_matches_.add(index, p_idx, process.nSites() - 1);
+        touched_processes.push_back(p_idx);
+    }
+
+    // Push the new total rates of the touched processes to the interactions.
+    std::sort(touched_processes.begin(), touched_processes.end());
+    const std::vector<int>::iterator end = std::unique(touched_processes.begin(),
+                                                       touched_processes.end());
+    std::vector<int>::const_iterator it1 = touched_processes.begin();
+    for ( ; it1 != end; ++it1 )
+    {
+        interactions.updateProcessRate(*it1);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::removeProcessSite(const int slot,
+                                const int p_idx,
+                                Process & process)
+{
+    process.removeSiteAt(slot);
+
+    // The site of the last slot was moved into the freed slot.
+    if (slot < static_cast<int>(process.nSites()))
+    {
+        site_matches_.setSlot(process.sites()[slot], p_idx, slot);
     }
 }
 
@@ -507,17 +894,61 @@ void Matcher::updateRates(std::vector<double>         & new_rates,
     // interactions object, to get an updated rate for each process.
     const RateCalculator & rate_calculator = interactions.rateCalculator();
 
-    for (size_t i = 0; i < tasks.size(); ++i)
+    // Calculators that allow it are called from several threads, each
+    // writing the rates of a contiguous chunk of the tasks.
+    const int n_chunks = rate_calculator.threadSafe() ? nChunks(tasks.size(), min_rates_per_thread__) : 1;
+
+    runChunks(n_chunks, [&](const int chunk)
+              {
+                  const size_t begin = chunkStart(tasks.size(), n_chunks, chunk);
+                  const size_t end   = chunkStart(tasks.size(), n_chunks, chunk+1);
+
+                  for (size_t i = begin; i < end; ++i)
+                  {
+                      // Get the rate process to use.
+                      const Process & process = (*interactions.processes()[tasks[i].process]);
+
+                      // Get the coordinate index.
+                      const int index = tasks[i].index;
+
+                      // Calculate the new rate.
+                      new_rates[i] = updateSingleRate(index, process, configuration, rate_calculator);
+                  }
+              });
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double Matcher::evaluateRate(const int index,
+                             const Process       & process,
+                             const Interactions  & interactions,
+                             const Configuration & configuration)
+{
+    // Use a stored value if possible.
+    ratekey key = 0;
+    if (process.cacheRate())
     {
-        // Get the rate process to use.
-        const Process & process = (*interactions.processes()[tasks[i].process]);
+        key = hashCustomRateInput(index, process, configuration);
+        if (rate_table_.stored(key) != -1)
+        {
+            return rate_table_.retrieve(key);
+        }
+    }
 
-        // Get the coordinate index.
-        const int index = tasks[i].index;
+    // Calculate the rate.
+    const double rate = updateSingleRate(index,
+                                         process,
+                                         configuration,
+                                         interactions.rateCalculator());
 
-        // Calculate the new rate.
-        new_rates[i] = updateSingleRate(index, process, configuration, rate_calculator);
+    // And store it if allowed.
+    if (process.cacheRate())
+    {
+        rate_table_.store(key, rate);
     }
+
+    return rate;
 }
 
 
@@ -530,17 +961,18 @@ double Matcher::updateSingleRate(const int index,
 {
     // Get the match lists.
     const ProcessBucketMatchList & process_match_list = process.processMatchList();
-    const ConfigBucketMatchList & config_match_list   = configuration.configMatchList(index);
+    RateCallbackScratch & scratch = rate_callback_scratch__;
+    ConfigBucketMatchList & config_match_list = scratch.config_match_list;
+    configuration.configMatchList(index, config_match_list);
 
-    // We will also need the elements.
-    const std::vector<std::vector<std::string> > & elements = configuration.elements();
-    const std::vector<TypeBucket> & types = configuration.types();
+    // We will also need the types.
+    const TypeBucketArray types = configuration.types();
 
     // Get cutoff distance from the process.
     const double cutoff = process.cutoff();
     ConfigBucketMatchList::const_iterator it1 = config_match_list.begin();
     int len = 0;
-    while ( (*it1).distance <= cutoff && it1 != config_match_list.end())
+    while ( it1 != config_match_list.end() && (*it1).distance <= cutoff )
     {
         ++it1;
         ++len;
@@ -548,10 +980,16 @@ double Matcher::updateSingleRate(const int index,
 
     const size_t distance = it1 - config_match_list.begin();
 
-    // Allocate memory for the numpy geometry and copy the data over.
-    std::vector<double> numpy_geo(len*3);
-    std::vector<std::string> types_before(distance);
-    std::vector<TypeBucket> occupations(distance);
+    // Copy the data over to the work storage of this thread.
+    std::vector<double>      & numpy_geo    = scratch.geometry;
+    std::vector<std::string> & types_before = scratch.types_before;
+    std::vector<std::string> & types_after  = scratch.types_after;
+    std::vector<TypeBucket>  & occupations  = scratch.occupations;
+    std::vector<TypeBucket>  & update       = scratch.update;
+
+    numpy_geo.resize(len*3);
+    types_before.resize(distance);
+    occupations.resize(distance);
 
     for (size_t i = 0; i < distance; ++i)
     {
@@ -564,13 +1002,22 @@ double Matcher::updateSingleRate(const int index,
         numpy_geo[3*i+2] = coord.z();
 
         const int idx   = config_match_list[i].index;
-        types_before[i] = elements[idx][0];
+        types_before[i] = configuration.typeName(configuration.firstType(idx));
         occupations[i]  = types[idx];
     }
 
     // Types after the process.
-    std::vector<std::string> types_after = types_before;
-    std::vector<TypeBucket> update(len, TypeBucket(occupations[0].size()));
+    types_after = types_before;
+
+    if (scratch.zero_bucket.size() != occupations[0].size())
+    {
+        scratch.zero_bucket = TypeBucket(occupations[0].size());
+    }
+    update.resize(len);
+    for (int i = 0; i < len; ++i)
+    {
+        update[i] = scratch.zero_bucket;
+    }
 
     // Loop over the process match list and update the types_after vector.
     for (size_t i = 0; i < process_match_list.size(); ++i)
@@ -640,3 +1087,23 @@ double Matcher::updateSingleRate(const int index,
                                                           global_z);
     }
 }
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::saveState(CheckpointWriter & writer) const
+{
+    writer.section("MTCH");
+    rate_table_.saveState(writer);
+    site_matches_.saveState(writer);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Matcher::loadState(CheckpointReader & reader)
+{
+    reader.section("MTCH");
+    rate_table_.loadState(reader);
+    site_matches_.loadState(reader);
+}
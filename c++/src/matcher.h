@@ -18,6 +18,8 @@
 
 #include "matchlist.h"
 #include "ratetable.h"
+#include "sitematchtable.h"
+#include "threadtasks.h"
 
 // Forward declarations.
 class Interactions;
@@ -25,6 +27,8 @@ class Configuration;
 class Process;
 class LatticeMap;
 class RateCalculator;
+class CheckpointWriter;
+class CheckpointReader;
 
 /// A minimal struct for representing a task with a rate.
 struct RateTask
@@ -44,6 +48,48 @@ struct RemoveTask
 };
 
 
+/*! \brief Struct for holding the work vectors of the matching. An instance
+ *         kept by the caller between calls to Matcher::calculateMatching
+ *         lets the vectors keep their capacity, so that the matching after
+ *         each step does not allocate memory once the largest sizes are seen.
+ */
+struct MatcherScratch
+{
+    /// The index and process pairs to match.
+    std::vector<std::pair<int,int> > index_process_to_match;
+    /// The task type of each pair.
+    std::vector<int> task_types;
+    /// The remove tasks from the matching.
+    std::vector<RemoveTask> remove_tasks;
+    /// The update tasks from the matching.
+    std::vector<RateTask> update_tasks;
+    /// The add tasks from the matching.
+    std::vector<RateTask> add_tasks;
+    /// The remove tasks of each chunk but the first, when matching on several threads.
+    std::vector<std::vector<RemoveTask> > chunk_remove_tasks;
+    /// The update tasks of each chunk but the first.
+    std::vector<std::vector<RateTask> > chunk_update_tasks;
+    /// The add tasks of each chunk but the first.
+    std::vector<std::vector<RateTask> > chunk_add_tasks;
+    /// The flags for the processes matching the present index of each chunk.
+    std::vector<std::vector<char> > chunk_is_matching;
+    /// The processes matching the present index of each chunk.
+    std::vector<std::vector<int> > chunk_matching;
+    /// The custom rate tasks without a stored rate.
+    std::vector<RateTask> rate_tasks;
+    /// The rate table keys of the custom rate tasks.
+    std::vector<ratekey> rate_keys;
+    /// The positions in the add tasks of the custom rate tasks.
+    std::vector<int> add_task_indices;
+    /// The positions in the update tasks of the custom rate tasks.
+    std::vector<int> update_task_indices;
+    /// The calculated custom rates.
+    std::vector<double> rates;
+    /// The processes touched by the tasks.
+    std::vector<int> touched_processes;
+};
+
+
 /*! \brief Class for matching local geometries.
  */
 class Matcher {
@@ -52,7 +98,8 @@ public:
 
     /*! \brief Constructor for the mather.
      *  \param sites : The number of sites in the system.
-     *  \param processes : The number of processes in the system.
+     *  \param processes : The number of processes in the system. The memory
+     *                    used does not depend on it.
      */
     Matcher(const size_t & sites, const size_t & processes);
 
@@ -69,6 +116,42 @@ public:
                            const LatticeMap & lattice_map,
                            const std::vector<int> & indices);
 
+    /*! \brief Calculate/update the matching of provided indices with
+     *         all possible processes, using work vectors given by the caller.
+     *  \param interactions  : The interactions object holding info on possible processes.
+     *  \param configuration : The configuration which the list of indices refers to.
+     *  \param lattice_map   : The lattice map describing the configuration.
+     *  \param indices       : The configuration indices for which the neighbourhood should
+     *                         be matched against all possible processes.
+     *  \param scratch       : The work vectors to use, which keep their capacity between calls.
+     */
+    void calculateMatching(Interactions & interactions,
+                           Configuration & configuration,
+                           const LatticeMap & lattice_map,
+                           const std::vector<int> & indices,
+                           MatcherScratch & scratch);
+
+    /*! \brief Calculate/update the matching of provided indices with the
+     *         processes whose range reaches the changed sites, using work
+     *         vectors given by the caller.
+     *  \param interactions  : The interactions object holding info on possible processes.
+     *  \param configuration : The configuration which the list of indices refers to.
+     *  \param lattice_map   : The lattice map describing the configuration.
+     *  \param indices       : The configuration indices for which the neighbourhood should
+     *                         be matched.
+     *  \param index_shells  : The number of shells from each index to the nearest changed
+     *                         site. An index is only matched against the processes with at
+     *                         least this range, as the neighbourhoods of the other processes
+     *                         are unchanged. If empty all processes are matched.
+     *  \param scratch       : The work vectors to use, which keep their capacity between calls.
+     */
+    void calculateMatching(Interactions & interactions,
+                           Configuration & configuration,
+                           const LatticeMap & lattice_map,
+                           const std::vector<int> & indices,
+                           const std::vector<int> & index_shells,
+                           MatcherScratch & scratch);
+
     /*! \brief Calculate the matching for a list of match tasks (pairs of indices and processes).
      *  \param index_process_to_match : The list of indices and process numbers to match.
      *  \param interactions           : The interactions to get the processes from.
@@ -84,6 +167,44 @@ public:
                                    std::vector<RateTask>   & update_tasks,
                                    std::vector<RateTask>   & add_tasks) const;
 
+    /*! \brief Calculate the matching for a list of match tasks, leaving the
+     *         remove, update and add tasks in the work vectors.
+     *  \param index_process_to_match : The list of indices and process numbers to match.
+     *  \param interactions           : The interactions to get the processes from.
+     *  \param configuration          : The configuration which the index refers to.
+     *  \param scratch (out)          : The work vectors to use and fill with the tasks.
+     */
+    void matchIndicesWithProcesses(const std::vector<std::pair<int,int> > & index_process_to_match,
+                                   const Interactions  & interactions,
+                                   const Configuration & configuration,
+                                   MatcherScratch & scratch) const;
+
+    /*! \brief Set the number of threads to use for matching, and for
+     *         updating rates if the rate calculator is thread safe. Each
+     *         thread gets a contiguous chunk of the work, and the results
+     *         are merged in chunk order so that they do not depend on the
+     *         number of threads.
+     *  \param n_threads : The number of threads, one for serial matching.
+     */
+    void setNumberOfThreads(const int n_threads) { n_threads_ = n_threads; }
+
+    /*! \brief Query for the number of threads.
+     *  \return : The number of threads used for matching.
+     */
+    int numberOfThreads() const { return n_threads_; }
+
+    /*! \brief Write the stored custom rates and the processes listed for
+     *         each site to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the stored custom rates and listed processes written
+     *         by saveState.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
     /*! \brief Update the rates of the rate tasks by calling the
      *         backend call-back function of the RateCalculator stored
      *         on the interactions object.
@@ -108,6 +229,20 @@ public:
                          const std::vector<RateTask>   & to_add,
                          Interactions & interactions);
 
+    /*! \brief Update the processes with the given tasks, using a work vector
+     *         given by the caller.
+     *  \param remove_tasks  : A vector with remove tasks for updating the processes.
+     *  \param update_tasks  : A vector with update tasks for updating the processes.
+     *  \param add_tasks     : A vector with add tasks for updating the processes.
+     *  \param interactions  : The interactions to get the processes from.
+     *  \param touched_processes : Work vector for the processes touched by the tasks.
+     */
+    void updateProcesses(const std::vector<RemoveTask> & to_remove,
+                         const std::vector<RateTask>   & to_update,
+                         const std::vector<RateTask>   & to_add,
+                         Interactions & interactions,
+                         std::vector<int> & touched_processes);
+
     /*! \brief Calculate the rate for a single process using the rate calculator.
      *  \param index           : The index to perform the process at.
      *  \param process         : The process to perform.
@@ -120,6 +255,20 @@ public:
                             const Configuration  & configuration,
                             const RateCalculator & rate_calculator) const;
 
+    /*! \brief Evaluate the custom rate of a process at a single index, for
+     *         processes with lazily evaluated rates. The rate table is used
+     *         if the rate of the process can be cached.
+     *  \param index         : The index to perform the process at.
+     *  \param process       : The process to perform.
+     *  \param interactions  : The interactions to get the rate calculator from.
+     *  \param configuration : The configuration the index is referring to.
+     *  \returns : The custom rate for the process at the given index.
+     */
+    double evaluateRate(const int index,
+                        const Process       & process,
+                        const Interactions  & interactions,
+                        const Configuration & configuration);
+
     /*! \brief Calculate/update the matching of a provided index and process.
      *  \param process       : The process to check against and update if needed.
      *  \param configuration : The configuration which the index refers to.
@@ -157,11 +306,65 @@ protected:
 
 private:
 
+    /*! \brief Match a contiguous chunk of index and process pairs.
+     *  \param index_process_to_match : The pairs to match.
+     *  \param begin                  : The first pair of the chunk.
+     *  \param end                    : One past the last pair of the chunk.
+     *  \param interactions           : The interactions to get the processes from.
+     *  \param configuration          : The configuration which the indices refer to.
+     *  \param is_matching            : Work vector of flags for the matching processes,
+     *                                  all zero on entry and exit.
+     *  \param matching               : Work vector for the matching processes.
+     *  \param task_types (out)       : The task type of each pair in the chunk is
+     *                                  written to this vector, zero for no task,
+     *                                  one for remove, two for update and three for add.
+     */
+    void matchChunk(const std::vector<std::pair<int,int> > & index_process_to_match,
+                    const size_t begin,
+                    const size_t end,
+                    const Interactions  & interactions,
+                    const Configuration & configuration,
+                    std::vector<char> & is_matching,
+                    std::vector<int> & matching,
+                    std::vector<int> & task_types) const;
+
+    /*! \brief Get the number of chunks to split work over.
+     *  \param n_items             : The number of work items.
+     *  \param min_items_per_chunk : The least number of items worth a thread.
+     *  \return : The number of chunks, between one and the number of threads.
+     */
+    int nChunks(const size_t n_items, const size_t min_items_per_chunk) const;
+
+    /*! \brief Run chunks of work on the threads of the pool, or directly on the
+     *         calling thread if there is only one chunk.
+     *  \param n_chunks : The number of chunks.
+     *  \param task     : The function object to call with each chunk number.
+     */
+    template <class T_task>
+    void runChunks(const int n_chunks,
+                   const T_task & task) const;
+
+    /*! \brief Remove a site from a process at its slot, and update the slot
+     *         of the site moved into the freed slot in the site match table.
+     *  \param slot    : The slot of the site in the list of sites of the process.
+     *  \param p_idx   : The process number.
+     *  \param process : The process to remove the site from.
+     */
+    void removeProcessSite(const int slot,
+                           const int p_idx,
+                           Process & process);
+
     /// The rate table for storing calculated custom rates.
     RateTable rate_table_;
 
-    /// The inverse matching information table.
-    std::vector<std::vector<bool> > inverse_table_;
+    /// The processes each site is listed with, and its slot in each of them.
+    SiteMatchTable site_matches_;
+
+    /// The number of threads to use.
+    int n_threads_;
+
+    /// The worker threads for the chunks, kept between the matching calls.
+    mutable ThreadPool thread_pool_;
 
 };
 
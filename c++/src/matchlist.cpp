@@ -15,6 +15,50 @@
 #include "matchlist.h"
 #include "configuration.h"
 
+
+// -----------------------------------------------------------------------------
+// The type set by an update at a site holding a single atom, being the
+// one added type if the update swaps one atom for another. Updates adding
+// a wildcard are not performed and leave the site unchanged.
+static int singleUpdateType(const TypeBucket & update)
+{
+    if (update[0] > 0)
+    {
+        return 0;
+    }
+
+    int added     = 0;
+    int n_added   = 0;
+    int n_removed = 0;
+    for (int i = 0; i < update.size(); ++i)
+    {
+        if (update[i] == 1 && i > 0)
+        {
+            added = i;
+            ++n_added;
+        }
+        else if (update[i] == -1 && i > 0)
+        {
+            ++n_removed;
+        }
+        else if (update[i] != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (n_added == 0 && n_removed == 0)
+    {
+        return 0;
+    }
+    if (n_added == 1 && n_removed == 1)
+    {
+        return added;
+    }
+    return -1;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 void configurationsToMatchList(const Configuration & first,
@@ -25,7 +69,7 @@ void configurationsToMatchList(const Configuration & first,
                                std::vector<int> & affected_indices)
 {
     // Get a handle to the coordinates and elements.
-    const std::vector<Coordinate> & coords = first.coordinates();
+    const SiteArray<Coordinate> & coords = first.coordinates();
 
     // The update types to set up.
     std::vector<TypeBucket> update_types;
@@ -109,6 +153,7 @@ void configurationsToMatchList(const Configuration & first,
         // Set the values.
         pm.match_types  = first.types()[i];
         pm.update_types = update_types[i];
+        pm.update_type  = singleUpdateType(update_types[i]);
 
         pm.distance    = distance;
         pm.coordinate  = coordinate;
@@ -199,3 +244,33 @@ double multiplicity(const ProcessBucketMatchList & process_match_list,
     // Done.
     return static_cast<double>(m);
 }
+
+
+// -----------------------------------------------------------------------------
+//
+TypeSignature requiredTypes(const ProcessBucketMatchList & process_match_list)
+{
+    TypeSignature signature = 0;
+    for (size_t i = 0; i < process_match_list.size(); ++i)
+    {
+        // Wildcards match any types.
+        if (process_match_list[i].match_types[0] != 1)
+        {
+            signature |= process_match_list[i].match_types.signature();
+        }
+    }
+    return signature;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+TypeSignature presentTypes(const ConfigBucketMatchList & config_match_list)
+{
+    TypeSignature signature = 0;
+    for (size_t i = 0; i < config_match_list.size(); ++i)
+    {
+        signature |= config_match_list[i].match_types.signature();
+    }
+    return signature;
+}
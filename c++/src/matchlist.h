@@ -53,6 +53,24 @@ double multiplicity(const ProcessBucketMatchList & process_match_list,
                     const ConfigBucketMatchList & config_match_list);
 
 
+/*! \brief Get the signature of the types a process matchlist requires,
+ *         being the union of the signatures of its non-wildcard entries.
+ *         A configuration matchlist can only match if its signature has
+ *         all these bits set.
+ *  \param process_match_list : The process matchlist.
+ *  \return : The required type signature.
+ */
+TypeSignature requiredTypes(const ProcessBucketMatchList & process_match_list);
+
+
+/*! \brief Get the signature of the types present in a configuration
+ *         matchlist, being the union of the signatures of its entries.
+ *  \param config_match_list : The configuration matchlist.
+ *  \return : The present type signature.
+ */
+TypeSignature presentTypes(const ConfigBucketMatchList & config_match_list);
+
+
 /*! \brief Determines if matchlists m1 and m2 match.
  *  \param m1: The first match list to compare.
  *  \param m2: The second match list to compare.
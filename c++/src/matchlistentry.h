@@ -120,6 +120,10 @@ public:
     /// The update types used in bucket mode.
     TypeBucket update_types;
 
+    /// The type set by the update at a site holding a single atom, zero if
+    /// the update leaves the site unchanged and -1 for any other update.
+    int update_type;
+
 
     bool match(const MinimalMatchListEntry & m2) const
     {
@@ -150,6 +154,7 @@ public:
         coordinate = Coordinate(c.x, c.y, c.z);
         match_types  = TypeBucket(c.match_types.size());
         update_types = TypeBucket(c.match_types.size());
+        update_type  = 0;
         match_types[0] = 1;           // Indicating wildcard.
     }
 };
@@ -0,0 +1 @@
+#define RUNMPI false
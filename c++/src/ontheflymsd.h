@@ -116,8 +116,8 @@ private:
     /// The histogram bin counts.
     std::vector<int> histogram_bin_counts_;
 
-    /// The tracking type.
-    std::string track_type_;
+    /// The tracking type, or -1 if the type is not present in the configuration.
+    int track_type_;
 
     /// The max time for binning.
     double t_max_;
@@ -0,0 +1,98 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  packedtypes.cpp
+ *  \brief File for the implementation code of the packed match types.
+ */
+
+#include "packedtypes.h"
+
+#include <algorithm>
+
+
+// -----------------------------------------------------------------------------
+//
+bool packedComparable(const ProcessBucketMatchList & process_match_list,
+                      const PackedTypes & process_types,
+                      const int config_lanes,
+                      const PackedTypes & config_types)
+{
+    const int lanes = packedLanes(process_match_list);
+    const size_t n_bytes = process_match_list.size() * lanes;
+    return (lanes == config_lanes &&
+            process_types.size() >= n_bytes + PACKED_TYPES_PADDING &&
+            config_types.size() >= n_bytes + PACKED_TYPES_PADDING);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double packedMultiplicity(const unsigned char * process,
+                          const unsigned char * config,
+                          const int n_bytes)
+{
+    // In the common case each type is either not required or fully taken,
+    // and there are no combinations to count.
+    if (packedUnitMultiplicity(process, config, n_bytes))
+    {
+        return 1.0;
+    }
+
+    // Otherwise count as in the scalar multiplicity. Wildcards are packed
+    // as zeros and are skipped with the types that are not required.
+    int m = 1;
+    for (int i = 0; i < n_bytes; ++i)
+    {
+        const int r = process[i];
+        if (r > 0)
+        {
+            const int n = config[i];
+            const int n_minus_r = n - r;
+            const int max = std::max(r, n_minus_r);
+            const int min = std::min(r, n_minus_r);
+
+            if (min != 0)
+            {
+                // Calculate n! / (r!(n-r)!)
+                int local_n = n;
+                for (int j = n - 1; j > max; --j)
+                {
+                    local_n *= j;
+                }
+
+                int local_r = min;
+                for (int j = min-1; j > 0; --j)
+                {
+                    local_r *= j;
+                }
+
+                m *= (local_n / local_r);
+            }
+        }
+    }
+
+    return static_cast<double>(m);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double packedMultiplicity(const ProcessBucketMatchList & process_match_list,
+                          const PackedTypes & process_types,
+                          const ConfigBucketMatchList & config_match_list,
+                          const PackedTypes & config_types)
+{
+    if (packedComparable(process_match_list, process_types, packedLanes(config_match_list), config_types))
+    {
+        return packedMultiplicity(&process_types[0],
+                                  &config_types[0],
+                                  process_match_list.size() * packedLanes(process_match_list));
+    }
+
+    return multiplicity(process_match_list, config_match_list);
+}
@@ -0,0 +1,357 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  packedtypes.h
+ *  \brief File for the packed match types and the kernels comparing them.
+ */
+
+#ifndef __PACKEDTYPES__
+#define __PACKEDTYPES__
+
+#include <vector>
+
+#include "matchlist.h"
+
+// The kernels are selected at build time. The vectorised versions are used
+// when the compiler targets AVX2 or SSE2, unless NO_SIMD is defined.
+#if !defined(NO_SIMD) && defined(__AVX2__)
+#define PACKED_TYPES_AVX2
+#include <immintrin.h>
+#elif !defined(NO_SIMD) && defined(__SSE2__)
+#define PACKED_TYPES_SSE2
+#include <emmintrin.h>
+#endif
+
+
+/*! \brief The match types of a match list packed as one byte lane per
+ *         type and entry, without the wildcard slot. Wildcard entries are
+ *         packed as zeros, so that they match anything. The buffer is
+ *         padded with zeros to a multiple of PACKED_TYPES_PADDING bytes
+ *         and holds at least PACKED_TYPES_PADDING bytes after the last
+ *         entry, so that a kernel may read a full chunk from any entry.
+ *         An empty buffer means that the types could not be packed.
+ */
+typedef std::vector<unsigned char> PackedTypes;
+
+/// The padding of the packed buffers, being the widest kernel chunk.
+static const int PACKED_TYPES_PADDING = 32;
+
+/// The largest number of atoms of one type that can be packed in a lane.
+static const int PACKED_TYPES_MAX_COUNT = 255;
+
+
+/*! \brief Pack the match types of a match list.
+ *  \param match_list  : The process or configuration match list to pack.
+ *  \param packed (out): The packed types, or empty if a count is too
+ *                       large to fit in a lane. The storage of the buffer
+ *                       is reused if it has the right size.
+ *  \return : True if the types could be packed.
+ */
+template <class T>
+bool packMatchTypes(const T & match_list, PackedTypes & packed);
+
+
+/*! \brief Get the type of a bucket holding a single atom, being the byte
+ *         an entry is packed as in the single occupancy mode.
+ *  \param types : The types of the bucket.
+ *  \return : The type of the atom, zero for a wildcard, or -1 if the bucket
+ *            does not hold exactly one atom of a type that fits in a byte.
+ */
+inline
+int singleType(const TypeBucket & types);
+
+
+/*! \brief Pack the types of a match list with a single atom or a wildcard
+ *         at each entry as one byte per entry, holding the type of the atom
+ *         or zero for a wildcard. The padding is the same as for the
+ *         packed match types, but an entry compares with a single byte
+ *         compare and a match always has the multiplicity one.
+ *  \param match_list  : The process or configuration match list to pack.
+ *  \param packed (out): The packed types, or empty if an entry does not
+ *                       hold a single atom.
+ *  \return : True if the types could be packed.
+ */
+template <class T>
+bool packSiteTypes(const T & match_list, PackedTypes & packed);
+
+
+/*! \brief Get the number of lanes per entry in the packed types of
+ *         a match list.
+ *  \param match_list : The match list.
+ *  \return : The number of types without the wildcard, or zero for an
+ *            empty match list.
+ */
+template <class T>
+int packedLanes(const T & match_list);
+
+
+/*! \brief Check that each lane in the process types is less than or
+ *         equal to the corresponding lane in the configuration types.
+ *         The kernels read full chunks, so both buffers must be padded.
+ *  \param process : Pointer to the first packed process lane.
+ *  \param config  : Pointer to the first packed configuration lane.
+ *  \param n_bytes : The number of lanes to compare.
+ *  \return : True if the process types match the configuration types.
+ */
+inline
+bool packedMatch(const unsigned char * process,
+                 const unsigned char * config,
+                 const int n_bytes);
+
+
+/*! \brief Check that a process requires either none or all of the atoms of
+ *         each type in the configuration, for each lane, in which case the
+ *         multiplicity of the match is one.
+ *  \param process : Pointer to the first packed process lane.
+ *  \param config  : Pointer to the first packed configuration lane.
+ *  \param n_bytes : The number of lanes to compare.
+ *  \return : True if the multiplicity is one.
+ */
+inline
+bool packedUnitMultiplicity(const unsigned char * process,
+                            const unsigned char * config,
+                            const int n_bytes);
+
+
+/*! \brief Check if the packed types of a process match list can be compared
+ *         with packed configuration types, with the same lanes per entry
+ *         and padding for the full process match list.
+ *  \param process_match_list : The process matchlist.
+ *  \param process_types      : The packed types of the process matchlist.
+ *  \param config_lanes       : The lanes per entry of the configuration types.
+ *  \param config_types       : The packed configuration types.
+ *  \return : True if the packed types can be compared.
+ */
+bool packedComparable(const ProcessBucketMatchList & process_match_list,
+                      const PackedTypes & process_types,
+                      const int config_lanes,
+                      const PackedTypes & config_types);
+
+
+/*! \brief Calculate the multiplicity of a match from the packed types.
+ *  \param process : Pointer to the first packed process lane.
+ *  \param config  : Pointer to the first packed configuration lane.
+ *  \param n_bytes : The number of lanes to compare.
+ *  \return : The multiplicity of the match.
+ */
+double packedMultiplicity(const unsigned char * process,
+                          const unsigned char * config,
+                          const int n_bytes);
+
+
+/*! \brief Calculate the multiplicity of a set of matching matchlists, using
+ *         the packed types when they can be compared.
+ *  \param process_match_list : The process matchlist to compare.
+ *  \param process_types      : The packed types of the process matchlist.
+ *  \param config_match_list  : The configuration matchlist to compare.
+ *  \param config_types       : The packed types of the configuration matchlist.
+ *  \return : The multiplicity of the match.
+ */
+double packedMultiplicity(const ProcessBucketMatchList & process_match_list,
+                          const PackedTypes & process_types,
+                          const ConfigBucketMatchList & config_match_list,
+                          const PackedTypes & config_types);
+
+
+// -------------------------------------------------------------------------- //
+// TEMPLATE AND INLINE IMPLEMENTATION CODE FOLLOW
+//
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+int packedLanes(const T & match_list)
+{
+    if (match_list.empty())
+    {
+        return 0;
+    }
+    return match_list[0].match_types.size() - 1;
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+int singleType(const TypeBucket & types)
+{
+    if (types[0] != 0)
+    {
+        return 0;
+    }
+
+    int type = -1;
+    for (int i = 1; i < types.size(); ++i)
+    {
+        if (types[i] == 0)
+        {
+            continue;
+        }
+        if (types[i] != 1 || type != -1)
+        {
+            return -1;
+        }
+        type = i;
+    }
+
+    return (type > PACKED_TYPES_MAX_COUNT) ? -1 : type;
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+bool packSiteTypes(const T & match_list, PackedTypes & packed)
+{
+    const size_t n_bytes = match_list.size() + PACKED_TYPES_PADDING;
+    const size_t size = ((n_bytes + PACKED_TYPES_PADDING - 1) / PACKED_TYPES_PADDING) * PACKED_TYPES_PADDING;
+
+    // Assigning to a buffer of the same size does not allocate.
+    packed.assign(size, 0);
+
+    for (size_t i = 0; i < match_list.size(); ++i)
+    {
+        const int type = singleType(match_list[i].match_types);
+        if (type < 0)
+        {
+            packed.clear();
+            return false;
+        }
+        packed[i] = static_cast<unsigned char>(type);
+    }
+
+    return true;
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+template <class T>
+bool packMatchTypes(const T & match_list, PackedTypes & packed)
+{
+    const int lanes = packedLanes(match_list);
+    const size_t n_bytes = match_list.size() * lanes + PACKED_TYPES_PADDING;
+    const size_t size = ((n_bytes + PACKED_TYPES_PADDING - 1) / PACKED_TYPES_PADDING) * PACKED_TYPES_PADDING;
+
+    // Assigning to a buffer of the same size does not allocate.
+    packed.assign(size, 0);
+
+    unsigned char * lane = &packed[0];
+    for (size_t i = 0; i < match_list.size(); ++i, lane += lanes)
+    {
+        const TypeBucket & types = match_list[i].match_types;
+
+        // Wildcards are left as zeros.
+        if (types[0] != 0)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < lanes; ++j)
+        {
+            const int count = types[j + 1];
+            if (count < 0 || count > PACKED_TYPES_MAX_COUNT)
+            {
+                packed.clear();
+                return false;
+            }
+            lane[j] = static_cast<unsigned char>(count);
+        }
+    }
+
+    return true;
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+bool packedMatch(const unsigned char * process,
+                 const unsigned char * config,
+                 const int n_bytes)
+{
+#if defined(PACKED_TYPES_AVX2)
+    for (int i = 0; i < n_bytes; i += 32)
+    {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(process + i));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(config + i));
+        const __m256i le = _mm256_cmpeq_epi8(_mm256_max_epu8(p, c), c);
+        if (_mm256_movemask_epi8(le) != -1)
+        {
+            return false;
+        }
+    }
+    return true;
+#elif defined(PACKED_TYPES_SSE2)
+    for (int i = 0; i < n_bytes; i += 16)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(process + i));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(config + i));
+        const __m128i le = _mm_cmpeq_epi8(_mm_max_epu8(p, c), c);
+        if (_mm_movemask_epi8(le) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+    return true;
+#else
+    for (int i = 0; i < n_bytes; ++i)
+    {
+        if (process[i] > config[i])
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+bool packedUnitMultiplicity(const unsigned char * process,
+                            const unsigned char * config,
+                            const int n_bytes)
+{
+#if defined(PACKED_TYPES_AVX2)
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < n_bytes; i += 32)
+    {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(process + i));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(config + i));
+        const __m256i unit = _mm256_or_si256(_mm256_cmpeq_epi8(p, zero), _mm256_cmpeq_epi8(p, c));
+        if (_mm256_movemask_epi8(unit) != -1)
+        {
+            return false;
+        }
+    }
+    return true;
+#elif defined(PACKED_TYPES_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < n_bytes; i += 16)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(process + i));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(config + i));
+        const __m128i unit = _mm_or_si128(_mm_cmpeq_epi8(p, zero), _mm_cmpeq_epi8(p, c));
+        if (_mm_movemask_epi8(unit) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+    return true;
+#else
+    for (int i = 0; i < n_bytes; ++i)
+    {
+        if (process[i] != 0 && process[i] != config[i])
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+
+#endif // __PACKEDTYPES__
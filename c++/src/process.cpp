@@ -12,11 +12,14 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cmath>
+#include <stdexcept>
 
 #include "process.h"
 #include "random.h"
 #include "configuration.h"
 #include "matchlistentry.h"
+#include "checkpoint.h"
 
 // -----------------------------------------------------------------------------
 //
@@ -32,16 +35,25 @@ Process::Process(const Configuration & first,
     range_(1),
     rate_(rate),
     cutoff_(0.0),
+    rate_upper_bound_(0.0),
     sites_(0),
+    site_slots_indexed_(false),
     affected_indices_(0),
     basis_sites_(basis_sites),
     id_moves_(0),
-    total_rate_(0.0)
+    total_rate_(0.0),
+    total_rate_compensation_(0.0),
+    resummation_interval_(1000000),
+    n_updates_(0),
+    selection_engine_(SUM_TREE)
 {
     // Determine if this is a bucket process by looking at the update info
     // on the second configuration.
     bucket_process_ = (second.updateInfo().size() != 0);
 
+    // Only processes without buckets can start with uniform site rates.
+    uniform_site_rates_ = !bucket_process_;
+
     // Generate the matchlist from the configurations.
     configurationsToMatchList(first,
                               second,
@@ -104,9 +116,20 @@ void Process::addSite(const int index,
                       const double rate,
                       const double multiplicity)
 {
-    sites_.push_back(index);
+    // Leave the uniform mode as soon as a site deviates from unity.
+    if (uniform_site_rates_ && multiplicity != 1.0)
+    {
+        storeSiteRates();
+    }
+
+    const double site_rate = multiplicity * rate_;
+    addSiteSlot(index);
     site_multiplicity_.push_back(multiplicity);
-    total_rate_ += multiplicity * rate_;
+    if (!uniform_site_rates_)
+    {
+        pushSiteRate(site_rate);
+    }
+    updateTotalRate(site_rate);
 }
 
 
@@ -114,25 +137,234 @@ void Process::addSite(const int index,
 //
 void Process::removeSite(const int index)
 {
-    // Find the index to remove.
-    std::vector<int>::iterator it1 = std::find(sites_.begin(),
-                                               sites_.end(),
-                                               index);
-    // Swap the index to remove with the last index.
-    std::vector<int>::iterator last = sites_.end()-1;
-    std::swap((*it1), (*last));
-    // Remove the last index from the list.
-    sites_.pop_back();
+    indexSiteSlots();
+    removeSiteAt(site_slots_.find(index));
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::removeSiteAt(const size_t slot)
+{
+    // Swap the index to remove with the last index and remove it.
+    removeSiteSlot(slot);
 
     // Calculate the position in the site_multiplicity_ vector.
-    std::vector<double>::iterator it3 = site_multiplicity_.begin() + (it1-sites_.begin());
+    std::vector<double>::iterator it3 = site_multiplicity_.begin() + slot;
     std::vector<double>::iterator last_multiplicity = site_multiplicity_.end()-1;
 
     // Swap and remove.
     std::swap((*it3), (*last_multiplicity));
-    total_rate_ -= site_multiplicity_.back() * rate_;
+    const double site_rate = site_multiplicity_.back() * rate_;
     site_multiplicity_.pop_back();
 
+    // Move the last rate into the freed slot.
+    if (!uniform_site_rates_)
+    {
+        removeSiteRate(slot);
+    }
+
+    updateTotalRate(-site_rate);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::updateTotalRate(const double delta)
+{
+    // Neumaier's variant of Kahan summation, where the low order bits
+    // lost in the sum are kept in the compensation term. The sum and the
+    // difference are stored through volatiles, since -ffast-math would
+    // otherwise fold the lost bits to zero.
+    volatile double sum = total_rate_ + delta;
+    volatile double difference;
+    if (std::fabs(total_rate_) >= std::fabs(delta))
+    {
+        difference = total_rate_ - sum;
+        total_rate_compensation_ += difference + delta;
+    }
+    else
+    {
+        difference = delta - sum;
+        total_rate_compensation_ += difference + total_rate_;
+    }
+    total_rate_ = sum;
+
+    // Resum exactly at the given interval.
+    ++n_updates_;
+    if (resummation_interval_ > 0 && n_updates_ >= resummation_interval_)
+    {
+        resumTotalRate();
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::resumTotalRate()
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        sum += siteRate(i);
+    }
+
+    total_rate_ = sum;
+    total_rate_compensation_ = 0.0;
+    n_updates_ = 0;
+
+    // Remove any round-off from the partial sums as well.
+    updateRateTable();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double Process::totalRateDrift() const
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        sum += siteRate(i);
+    }
+    return totalRate() - sum;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::addSiteSlot(const int index)
+{
+    if (site_slots_indexed_)
+    {
+        site_slots_.set(index, sites_.size());
+    }
+    sites_.push_back(index);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::removeSiteSlot(const size_t slot)
+{
+    const int index = sites_[slot];
+    const int last_index = sites_.back();
+
+    if (site_slots_indexed_)
+    {
+        site_slots_.erase(index);
+        if (last_index != index)
+        {
+            site_slots_.set(last_index, slot);
+        }
+    }
+
+    // Move the last index into the freed slot and remove the last slot.
+    sites_[slot] = last_index;
+    sites_.pop_back();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::indexSiteSlots() const
+{
+    if (site_slots_indexed_)
+    {
+        return;
+    }
+
+    site_slots_.clear();
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        site_slots_.set(sites_[i], i);
+    }
+    site_slots_indexed_ = true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::storeSiteRates()
+{
+    uniform_site_rates_ = false;
+    for (size_t i = 0; i < site_multiplicity_.size(); ++i)
+    {
+        pushSiteRate(site_multiplicity_[i] * rate_);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::pushSiteRate(const double site_rate)
+{
+    if (selection_engine_ == COMPOSITION_REJECTION)
+    {
+        site_rate_classes_.push_back(site_rate);
+    }
+    else
+    {
+        site_rate_tree_.push_back(site_rate);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::removeSiteRate(const size_t slot)
+{
+    if (selection_engine_ == COMPOSITION_REJECTION)
+    {
+        const size_t last_slot = site_rate_classes_.size() - 1;
+        if (slot != last_slot)
+        {
+            site_rate_classes_.update(slot, site_rate_classes_.value(last_slot));
+        }
+        site_rate_classes_.pop_back();
+    }
+    else
+    {
+        const size_t last_slot = site_rate_tree_.size() - 1;
+        if (slot != last_slot)
+        {
+            site_rate_tree_.update(slot, site_rate_tree_.value(last_slot));
+        }
+        site_rate_tree_.pop_back();
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::setSelectionEngine(const SELECTION_ENGINE selection_engine)
+{
+    if (selection_engine == selection_engine_)
+    {
+        return;
+    }
+
+    // Move the site rates over to the storage of the new engine.
+    if (selection_engine == COMPOSITION_REJECTION)
+    {
+        site_rate_classes_.clear();
+        for (size_t i = 0; i < site_rate_tree_.size(); ++i)
+        {
+            site_rate_classes_.push_back(site_rate_tree_.value(i));
+        }
+        site_rate_tree_.clear();
+    }
+    else
+    {
+        site_rate_tree_.clear();
+        for (size_t i = 0; i < site_rate_classes_.size(); ++i)
+        {
+            site_rate_tree_.push_back(site_rate_classes_.value(i));
+        }
+        site_rate_classes_.clear();
+    }
+
+    selection_engine_ = selection_engine;
 }
 
 
@@ -141,9 +373,15 @@ void Process::removeSite(const int index)
 void Process::clearSites()
 {
     sites_.clear();
+    site_slots_.clear();
+    site_slots_indexed_ = false;
     site_multiplicity_.clear();
     site_rates_.clear();
+    site_rate_tree_.clear();
+    site_rate_classes_.clear();
     total_rate_ = 0.0;
+    total_rate_compensation_ = 0.0;
+    n_updates_ = 0;
 }
 
 
@@ -151,25 +389,28 @@ void Process::clearSites()
 //
 int Process::pickSite() const
 {
-    // PERFORMME: This implementation works but is unnecessarily slow
-    //            in the case when no buckets are used, and therefore
-    //            multiplicity is one for all sites. For the Ising spin
-    //            model this means a 30% (!) extra increase in running time,
-    //            with no benefit at al. Should be fixed before release.
+    // With the same rate on all sites a uniform draw is enough.
+    if (uniform_site_rates_)
+    {
+        const size_t n_sites = sites_.size();
+        size_t site_index = static_cast<size_t>(randomDouble01() * n_sites);
+        if (site_index >= n_sites)
+        {
+            site_index = n_sites - 1;
+        }
+        return sites_[site_index];
+    }
 
-    // Get the total rate.
-    const double total_rate = incremental_rate_table_.back();
+    if (selection_engine_ == COMPOSITION_REJECTION)
+    {
+        return sites_[site_rate_classes_.pick()];
+    }
 
     // Get a random number between 0.0 and the total rate.
-    const double rnd = randomDouble01() * total_rate;
+    const double rnd = randomDouble01() * site_rate_tree_.total();
 
     // Pick the site.
-    const std::vector<double>::const_iterator begin = incremental_rate_table_.begin();
-    const std::vector<double>::const_iterator end   = incremental_rate_table_.end();
-    const std::vector<double>::const_iterator it1   = std::lower_bound( begin, end, rnd);
-
-    // Get the site index.
-    const int site_index = it1-begin;
+    const size_t site_index = site_rate_tree_.search(rnd);
 
     // Return the site.
     return sites_[site_index];
@@ -180,8 +421,24 @@ int Process::pickSite() const
 //
 bool Process::isListed(const int index) const
 {
-    // Search in the list to find out if it is added.
-    return std::find(sites_.begin(), sites_.end(), index) != sites_.end();
+    // Look up the slot of the index.
+    indexSiteSlots();
+    return site_slots_.find(index) != -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+bool Process::singleAtomUpdates() const
+{
+    for (size_t i = 0; i < match_list_.size(); ++i)
+    {
+        if (match_list_[i].update_type < 0)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 
@@ -189,15 +446,70 @@ bool Process::isListed(const int index) const
 //
 void Process::updateRateTable()
 {
-    // Resize and update the incremental rate table.
-    incremental_rate_table_.resize(site_multiplicity_.size());
-    double previous = 0.0;
-    for (size_t i = 0; i < site_multiplicity_.size(); ++i)
+    // The site rates are stored exactly, so a rebuild of the partial
+    // sums is all that is needed.
+    if (selection_engine_ == COMPOSITION_REJECTION)
+    {
+        site_rate_classes_.rebuild();
+    }
+    else
     {
-        incremental_rate_table_[i] = previous + (rate_ * site_multiplicity_[i]);
-        previous = incremental_rate_table_[i];
+        site_rate_tree_.rebuild();
     }
 
     // DONE
 }
 
+
+// -----------------------------------------------------------------------------
+//
+void Process::saveState(CheckpointWriter & writer) const
+{
+    writer.section("PROC");
+    writer.write(process_number_);
+    writer.write(rate_);
+
+    writer.writeVector(sites_);
+    writer.writeVector(site_multiplicity_);
+    writer.writeVector(site_rates_);
+
+    writer.write(static_cast<int>(selection_engine_));
+    writer.write(uniform_site_rates_);
+    site_rate_tree_.saveState(writer);
+    site_rate_classes_.saveState(writer);
+
+    writer.write(total_rate_);
+    writer.write(total_rate_compensation_);
+    writer.write(resummation_interval_);
+    writer.write(n_updates_);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void Process::loadState(CheckpointReader & reader)
+{
+    reader.section("PROC");
+    const int process_number = reader.read<int>();
+    const double rate = reader.read<double>();
+    if (process_number != process_number_ || rate != rate_)
+    {
+        throw std::runtime_error("The checkpoint does not match the processes of the model.");
+    }
+
+    reader.readVector(sites_);
+    site_slots_.clear();
+    site_slots_indexed_ = false;
+    reader.readVector(site_multiplicity_);
+    reader.readVector(site_rates_);
+
+    selection_engine_ = static_cast<SELECTION_ENGINE>(reader.read<int>());
+    uniform_site_rates_ = reader.read<bool>();
+    site_rate_tree_.loadState(reader);
+    site_rate_classes_.loadState(reader);
+
+    total_rate_ = reader.read<double>();
+    total_rate_compensation_ = reader.read<double>();
+    resummation_interval_ = reader.read<int>();
+    n_updates_ = reader.read<int>();
+}
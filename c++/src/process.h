@@ -17,8 +17,16 @@
 #include <map>
 #include <string>
 #include "matchlist.h"
+#include "slotmap.h"
+#include "sumtree.h"
+#include "compositionrejection.h"
 
 class Configuration;
+class CheckpointWriter;
+class CheckpointReader;
+
+/// The available engines for picking a site weighted by its rate.
+enum SELECTION_ENGINE {SUM_TREE, COMPOSITION_REJECTION};
 
 /*! \brief Class for defining a possible process int the system.
  */
@@ -28,7 +36,21 @@ public:
 
     /*! \brief Default constructor needed for use in std::vector SWIG wrapping.
      */
-    Process() {}
+    Process() :
+        cache_rate_(false),
+        process_number_(-1),
+        range_(1),
+        rate_(0.0),
+        cutoff_(0.0),
+        rate_upper_bound_(0.0),
+        bucket_process_(false),
+        total_rate_(0.0),
+        total_rate_compensation_(0.0),
+        resummation_interval_(1000000),
+        n_updates_(0),
+        selection_engine_(SUM_TREE),
+        uniform_site_rates_(true)
+    {}
 
     /*! \brief Constructor for the process. Note that the configurations given
      *         to the process are local configurations and no periodic boundaries
@@ -65,7 +87,30 @@ public:
     /*! \brief Query for the total rate.
      *  \return : The total rate of the process.
      */
-    double totalRate() const { return total_rate_; }
+    double totalRate() const { return total_rate_ + total_rate_compensation_; }
+
+    /*! \brief Recalculate the total rate exactly from the listed sites and
+     *         rebuild the site rate storage. This is done automatically every
+     *         resummationInterval() site updates.
+     */
+    void resumTotalRate();
+
+    /*! \brief Set the number of site updates between automatic exact
+     *         resummations of the total rate.
+     *  \param interval : The number of updates, zero for never.
+     */
+    void setResummationInterval(const int interval) { resummation_interval_ = interval; }
+
+    /*! \brief Query for the resummation interval.
+     *  \return : The number of site updates between exact resummations.
+     */
+    int resummationInterval() const { return resummation_interval_; }
+
+    /*! \brief Diagnostic query for the accumulated round-off in the
+     *         incrementally updated total rate. This sums over all sites.
+     *  \return : The incremental total rate minus the exact total rate.
+     */
+    double totalRateDrift() const;
 
     /*! \brief Add the index to the list of available sites.
      *  \param index        : The index to add.
@@ -77,24 +122,58 @@ public:
                          const double rate=0.0,
                          const double multiplicity=1.0);
 
-    /*! \brief Remove the index from the list of available sites.
+    /*! \brief Remove the index from the list of available sites. The slot
+     *         of the index is looked up, see isListed().
      *  \param index : The index to remove.
      */
-    virtual void removeSite(const int index);
+    void removeSite(const int index);
+
+    /*! \brief Remove the site at a slot of the list of available sites in
+     *         constant time, by moving the site of the last slot into it.
+     *         A caller that keeps track of the slots of the sites itself,
+     *         as the Matcher does, finds the moved site in sites().
+     *  \param slot : The slot to remove.
+     */
+    virtual void removeSiteAt(const size_t slot);
 
     /*! \brief Remove all indices from the list of available sites.
      */
     virtual void clearSites();
 
     /*! \brief Pick a site weighted by its individual total rate (multiplicity).
+     *         The site rates are kept up to date by addSite and removeSite
+     *         so no preparation is needed. This is an O(log N) operation with
+     *         the SUM_TREE engine and of constant expected cost in the number
+     *         of sites with the COMPOSITION_REJECTION engine. As long as all
+     *         sites have the same rate the site is drawn uniformly in
+     *         constant time without touching the site rate storage.
      *  \return : An available process.
      */
     virtual int pickSite() const;
 
-    /*! \brief Update the rate table prior to drawing a rate.
+    /*! \brief Recalculate the partial sums of the site rates from the
+     *         stored site rates. This is not needed prior to drawing a rate
+     *         but removes any accumulated round-off.
      */
     virtual void updateRateTable();
 
+    /*! \brief Set the engine to use for picking sites. The present site
+     *         rates are moved over to the storage of the new engine.
+     *  \param selection_engine : The engine to use.
+     */
+    void setSelectionEngine(const SELECTION_ENGINE selection_engine);
+
+    /*! \brief Query for the engine used for picking sites.
+     *  \return : The selection engine.
+     */
+    SELECTION_ENGINE selectionEngine() const { return selection_engine_; }
+
+    /*! \brief Query for the uniform site rate flag.
+     *  \return : True if all sites have the same rate and the site rate
+     *            storage is bypassed.
+     */
+    bool uniformSiteRates() const { return uniform_site_rates_; }
+
     /*! \brief Returns true if the process rates can be cached.
      *  \return : True if rates can be cached. False if no caching is allowed.
      */
@@ -105,12 +184,21 @@ public:
      */
     double rateConstant() const { return rate_; }
 
+    /*! \brief Query for the upper bound of the custom rates of the process.
+     *         If positive, sites are listed with this rate and the custom
+     *         rate is only evaluated when a site is picked.
+     *  \return : The rate upper bound, zero if not used.
+     */
+    double rateUpperBound() const { return rate_upper_bound_; }
+
     /*! \brief Query for the number of listed possible sites for this process.
      *  \return : The number of listed indices.
      */
     size_t nSites() const {return sites_.size(); }
 
     /*! \brief Determine if an index is listed as available site for this process.
+     *         This is a constant time lookup, once the slots of the listed
+     *         indices are indexed on the first lookup by index.
      *  \param index : The index to check.
      *  \return : True if match.
      */
@@ -179,8 +267,77 @@ public:
      */
     bool bucketProcess() const { return bucket_process_; }
 
+    /*! \brief Query if each update of the process swaps the single atom at
+     *         a site for another, or leaves the site unchanged, so that it
+     *         can be performed on the site types of the single occupancy
+     *         mode.
+     *  \return : True if all updates are single atom updates.
+     */
+    bool singleAtomUpdates() const;
+
+    /*! \brief Write the listed sites, their rates and the total rate to
+     *         a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the listed sites, their rates and the total rate written
+     *         by saveState, in the order and with the round-off they were
+     *         written with.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
 protected:
 
+    /*! \brief Append an index to the list of available sites and record
+     *         its slot, if the slots are indexed.
+     *  \param index : The index to add.
+     */
+    void addSiteSlot(const int index);
+
+    /*! \brief Remove a slot from the list of available sites in constant
+     *         time by moving the last index into it.
+     *  \param slot : The slot to remove.
+     */
+    void removeSiteSlot(const size_t slot);
+
+    /*! \brief Index the slots of the listed indices for lookup by index,
+     *         unless they are indexed already.
+     */
+    void indexSiteSlots() const;
+
+    /*! \brief Append the rate of a newly added site to the storage of the
+     *         selection engine in use.
+     *  \param site_rate : The total rate of the site.
+     */
+    void pushSiteRate(const double site_rate);
+
+    /*! \brief Remove a slot from the storage of the selection engine by
+     *         moving the rate of the last slot into it, mirroring the
+     *         swap-with-last removal from the site lists.
+     *  \param slot : The slot to remove.
+     */
+    void removeSiteRate(const size_t slot);
+
+    /*! \brief Add a change to the total rate with Neumaier compensated
+     *         summation, and resum exactly if the resummation interval
+     *         is reached.
+     *  \param delta : The change of the total rate.
+     */
+    void updateTotalRate(const double delta);
+
+    /*! \brief Query for the total rate of a listed site.
+     *  \param slot : The slot of the site in the list of sites.
+     *  \return : The rate times the multiplicity of the site.
+     */
+    virtual double siteRate(const size_t slot) const { return site_multiplicity_[slot] * rate_; }
+
+    /*! \brief Leave the uniform site rate mode by storing the rates of all
+     *         present sites with the selection engine in use.
+     */
+    void storeSiteRates();
+
     // If the process rate can be cached.
     bool cache_rate_;
 
@@ -196,17 +353,32 @@ protected:
     /// The cutoff radius primitive unit-cell fractional units.
     double cutoff_;
 
+    /// The upper bound for lazily evaluated custom rates, zero if not used.
+    double rate_upper_bound_;
+
     /// The available sites for this process.
     std::vector<int> sites_;
 
+    /// The slot in sites_ of each listed index. It is only set up on the
+    /// first lookup by index, so that stepping through the Matcher, which
+    /// keeps the slots itself, does no hashing.
+    mutable SlotMap site_slots_;
+
+    /// If the slots are indexed in site_slots_ and kept up to date.
+    mutable bool site_slots_indexed_;
+
     /// The multiplicity for the available sites for this process.
     std::vector<double> site_multiplicity_;
 
     /// The list of individual site rates.
     std::vector<double> site_rates_;
 
-    /// The incremental rates.
-    std::vector<double> incremental_rate_table_;
+    /// The total rate of each listed site, in the same order as the sites.
+    SumTree site_rate_tree_;
+
+    /// The site rates grouped in classes, used in place of the tree with
+    /// the COMPOSITION_REJECTION engine.
+    CompositionRejection site_rate_classes_;
 
     /// The match list for comparing against local configurations.
     ProcessBucketMatchList match_list_;
@@ -228,6 +400,22 @@ protected:
     /// The total available rate for this process.
     double total_rate_;
 
+    /// The running compensation for round-off in the total rate.
+    double total_rate_compensation_;
+
+    /// The number of site updates between exact resummations, zero for never.
+    int resummation_interval_;
+
+    /// The number of site updates since the latest exact resummation.
+    int n_updates_;
+
+    /// The engine used for picking sites.
+    SELECTION_ENGINE selection_engine_;
+
+    /// Flag indicating that all sites have unit multiplicity, so that the
+    /// site rates are not stored and sites are drawn uniformly.
+    bool uniform_site_rates_;
+
 private:
 
 };
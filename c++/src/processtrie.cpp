@@ -0,0 +1,242 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  processtrie.cpp
+ *  \brief File for the implementation code of the ProcessTrie class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "processtrie.h"
+#include "process.h"
+
+
+// -----------------------------------------------------------------------------
+// Two process match list entries at the same depth are interchangeable in
+// the trie if they match exactly the same configuration entries. This holds
+// for any two wildcards, and for entries with the same point and types.
+static bool sameMatch(const ProcessBucketMatchListEntry & e1,
+                      const ProcessBucketMatchListEntry & e2)
+{
+    const bool wildcard1 = (e1.match_types[0] == 1);
+    const bool wildcard2 = (e2.match_types[0] == 1);
+
+    if (wildcard1 || wildcard2)
+    {
+        return wildcard1 && wildcard2;
+    }
+
+    const double epsi = 1.0e-5;
+    return e1.match_types == e2.match_types &&
+        std::fabs(e1.distance - e2.distance) <= epsi &&
+        std::fabs(e1.coordinate.x() - e2.coordinate.x()) <= epsi &&
+        std::fabs(e1.coordinate.y() - e2.coordinate.y()) <= epsi &&
+        std::fabs(e1.coordinate.z() - e2.coordinate.z()) <= epsi;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ProcessTrie::ProcessTrie() :
+    nodes_(1),
+    lanes_(-1),
+    single_occupancy_(false),
+    process_types_(0)
+{
+    // The empty root matches nothing.
+    nodes_[0].required_types = ~static_cast<TypeSignature>(0);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void ProcessTrie::build(const std::vector<Process*> & processes)
+{
+    nodes_.clear();
+    nodes_.resize(1);
+    lanes_ = -1;
+    process_types_.resize(processes.size());
+
+    // The node each process ends at, with the types it requires.
+    std::vector<std::pair<int,TypeSignature> > process_types;
+
+    for (size_t p = 0; p < processes.size(); ++p)
+    {
+        const ProcessBucketMatchList & match_list = processes[p]->processMatchList();
+
+        // Follow the shared prefix and branch off where it ends.
+        int node = 0;
+        for (size_t i = 0; i < match_list.size(); ++i)
+        {
+            int next = -1;
+            const std::vector<int> & children = nodes_[node].children;
+            for (size_t c = 0; c < children.size(); ++c)
+            {
+                if (sameMatch(nodes_[children[c]].entry, match_list[i]))
+                {
+                    next = children[c];
+                    break;
+                }
+            }
+
+            if (next == -1)
+            {
+                next = nodes_.size();
+                nodes_.push_back(Node());
+                nodes_[next].entry = match_list[i];
+                nodes_[node].children.push_back(next);
+            }
+
+            node = next;
+        }
+
+        nodes_[node].processes.push_back(p);
+        process_types.push_back(std::pair<int,TypeSignature>(node, requiredTypes(match_list)));
+        packMatchTypes(match_list, process_types_[p]);
+    }
+
+    // Pack the entry of each node. The packed comparison is only used if
+    // all entries have the same number of lanes and could be packed.
+    bool packed = true;
+    for (size_t n = 1; n < nodes_.size(); ++n)
+    {
+        const ProcessBucketMatchList entry(1, nodes_[n].entry);
+        const int lanes = ::packedLanes(entry);
+        packed = packMatchTypes(entry, nodes_[n].types) && packed;
+        if (lanes_ == -1)
+        {
+            lanes_ = lanes;
+        }
+        packed = packed && (lanes == lanes_);
+    }
+    if (!packed)
+    {
+        lanes_ = -1;
+    }
+
+    // The single types, if all entries have one.
+    single_occupancy_ = true;
+    for (size_t n = 1; n < nodes_.size(); ++n)
+    {
+        const int type = singleType(nodes_[n].entry.match_types);
+        single_occupancy_ = single_occupancy_ && (type >= 0);
+        nodes_[n].site_type = static_cast<unsigned char>(std::max(type, 0));
+    }
+
+    // The children are always added after their parents, so the types
+    // required below each node can be collected in reverse order.
+    for (size_t n = 0; n < nodes_.size(); ++n)
+    {
+        nodes_[n].required_types = ~static_cast<TypeSignature>(0);
+    }
+    for (size_t i = 0; i < process_types.size(); ++i)
+    {
+        nodes_[process_types[i].first].required_types &= process_types[i].second;
+    }
+    for (size_t n = nodes_.size(); n > 0; --n)
+    {
+        Node & node = nodes_[n-1];
+        for (size_t c = 0; c < node.children.size(); ++c)
+        {
+            node.required_types &= nodes_[node.children[c]].required_types;
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void ProcessTrie::match(const ConfigBucketMatchList & config_match_list,
+                        std::vector<int> & matching) const
+{
+    match(config_match_list, presentTypes(config_match_list), matching);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void ProcessTrie::match(const ConfigBucketMatchList & config_match_list,
+                        const TypeSignature present_types,
+                        std::vector<int> & matching) const
+{
+    match(config_match_list, PackedTypes(), present_types, matching);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void ProcessTrie::match(const ConfigBucketMatchList & config_match_list,
+                        const PackedTypes & config_types,
+                        const TypeSignature present_types,
+                        std::vector<int> & matching,
+                        const bool site_types) const
+{
+    // Nothing can match if the types required by all processes are not
+    // present.
+    if ((nodes_[0].required_types & ~present_types) != 0)
+    {
+        return;
+    }
+
+    // Compare the packed types if the configuration types line up with
+    // the lanes of the nodes.
+    const bool packed = (!site_types && lanes_ >= 0 && !config_types.empty() &&
+                         ::packedLanes(config_match_list) == lanes_);
+
+    // Depth first traversal of all branches that match, where the depth
+    // of a node is the position in the configuration match list to
+    // compare its children with. The stack is kept per thread so that
+    // its storage is reused between calls.
+    static thread_local std::vector<std::pair<int,size_t> > stack;
+
+    stack.clear();
+    stack.push_back(std::pair<int,size_t>(0, 0));
+
+    while (!stack.empty())
+    {
+        const int node     = stack.back().first;
+        const size_t depth = stack.back().second;
+        stack.pop_back();
+
+        const Node & n = nodes_[node];
+        matching.insert(matching.end(), n.processes.begin(), n.processes.end());
+
+        if (depth == config_match_list.size())
+        {
+            continue;
+        }
+
+        const MinimalMatchListEntry & config_entry = config_match_list[depth];
+        const unsigned char * config_lanes = packed ? &config_types[depth * lanes_] : 0;
+        for (size_t c = 0; c < n.children.size(); ++c)
+        {
+            // Reject branches requiring types that are not present before
+            // comparing the entry.
+            const Node & child = nodes_[n.children[c]];
+            if ((child.required_types & ~present_types) != 0)
+            {
+                continue;
+            }
+
+            const bool match = site_types ?
+                (child.site_type == 0 ||
+                 (child.site_type == config_types[depth] && samePoint(child.entry, config_entry))) :
+                packed ?
+                (child.entry.match_types[0] == 1 ||
+                 (packedMatch(&child.types[0], config_lanes, lanes_) && samePoint(child.entry, config_entry))) :
+                child.entry.match(config_entry);
+
+            if (match)
+            {
+                stack.push_back(std::pair<int,size_t>(n.children[c], depth + 1));
+            }
+        }
+    }
+}
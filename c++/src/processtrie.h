@@ -0,0 +1,156 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  processtrie.h
+ *  \brief File for the ProcessTrie class definition.
+ */
+
+#ifndef __PROCESSTRIE__
+#define __PROCESSTRIE__
+
+#include <vector>
+
+#include "matchlist.h"
+#include "packedtypes.h"
+
+// Forward declarations.
+class Process;
+
+
+/*! \brief Class for matching a configuration match list against the match
+ *         lists of all processes in one traversal. The process match lists
+ *         are stored as a prefix tree, where processes with identical
+ *         leading entries share the path through the tree. Since bucket
+ *         types match by inclusion more than one branch may match, and the
+ *         traversal follows all of them. Each node also holds the types
+ *         that all processes below it require, so that branches that can
+ *         not match a neighbourhood are rejected with a bit test, and
+ *         the types of each node are packed for comparing them with the
+ *         packed types of a configuration match list. When all entries are
+ *         wildcards or hold a single atom each node also holds its type in
+ *         a single byte, for the single occupancy mode of the configuration.
+ */
+class ProcessTrie {
+
+public:
+
+    /*! \brief Default constructor, giving an empty trie.
+     */
+    ProcessTrie();
+
+    /*! \brief Build the trie from the match lists of the processes.
+     *  \param processes : The processes, identified by their position
+     *                     in this vector.
+     */
+    void build(const std::vector<Process*> & processes);
+
+    /*! \brief Find all processes that match a configuration match list.
+     *  \param config_match_list : The configuration match list to match.
+     *  \param matching (out)    : The processes that match are appended to
+     *                             this vector, in no particular order.
+     */
+    void match(const ConfigBucketMatchList & config_match_list,
+               std::vector<int> & matching) const;
+
+    /*! \brief Find all processes that match a configuration match list,
+     *         given the signature of the types present in it. Branches
+     *         whose processes all require types that are not present are
+     *         skipped without comparing any entries.
+     *  \param config_match_list : The configuration match list to match.
+     *  \param present_types     : The type signature of the configuration match list.
+     *  \param matching (out)    : The processes that match are appended to
+     *                             this vector, in no particular order.
+     */
+    void match(const ConfigBucketMatchList & config_match_list,
+               const TypeSignature present_types,
+               std::vector<int> & matching) const;
+
+    /*! \brief Find all processes that match a configuration match list,
+     *         given its type signature and packed types. The entries are
+     *         compared on the packed types when these are available and
+     *         have packedLanes() lanes per entry, and only the points of
+     *         the configuration match list are then used.
+     *         With site_types set the configuration types are packed
+     *         with one byte per entry by packSiteTypes(), and each entry
+     *         is compared on its type alone, which requires the trie to be
+     *         in singleOccupancy() mode.
+     *  \param config_match_list : The configuration match list to match.
+     *  \param config_types      : The packed types of the configuration match list.
+     *  \param present_types     : The type signature of the configuration match list.
+     *  \param matching (out)    : The processes that match are appended to
+     *                             this vector, in no particular order.
+     *  \param site_types        : True if the configuration types hold a
+     *                             single type per entry.
+     */
+    void match(const ConfigBucketMatchList & config_match_list,
+               const PackedTypes & config_types,
+               const TypeSignature present_types,
+               std::vector<int> & matching,
+               const bool site_types=false) const;
+
+    /*! \brief Const query for the packed types of the full match list of
+     *         a process, as of the last build.
+     *  \param process : The position of the process in the build vector.
+     *  \return : The packed types of the process match list.
+     */
+    const PackedTypes & packedMatchTypes(const int process) const { return process_types_[process]; }
+
+    /*! \brief Query for the number of packed lanes per entry of the nodes.
+     *  \return : The number of lanes, or -1 if the nodes are not packed.
+     */
+    int packedLanes() const { return lanes_; }
+
+    /*! \brief Query if all entries of all processes are wildcards or hold
+     *         a single atom, so that they can be matched on single types.
+     *  \return : True if the nodes hold their single types.
+     */
+    bool singleOccupancy() const { return single_occupancy_; }
+
+    /*! \brief Query for the number of nodes, including the root.
+     *  \return : The number of nodes in the trie.
+     */
+    int nNodes() const { return static_cast<int>(nodes_.size()); }
+
+protected:
+
+private:
+
+    /// A minimal struct for representing a node in the trie.
+    struct Node
+    {
+        /// The match list entry leading to this node.
+        ProcessBucketMatchListEntry entry;
+        /// The child nodes.
+        std::vector<int> children;
+        /// The processes whose match lists end at this node.
+        std::vector<int> processes;
+        /// The types required by all processes at or below this node.
+        TypeSignature required_types;
+        /// The packed types of the entry.
+        PackedTypes types;
+        /// The single type of the entry, or zero for a wildcard.
+        unsigned char site_type;
+    };
+
+    /// The nodes, with the root first.
+    std::vector<Node> nodes_;
+
+    /// The number of packed lanes per entry, or -1 if not all entries
+    /// could be packed.
+    int lanes_;
+
+    /// If the nodes hold single types.
+    bool single_occupancy_;
+
+    /// The packed types of the match list of each process.
+    std::vector<PackedTypes> process_types_;
+
+};
+
+
+#endif // __PROCESSTRIE__
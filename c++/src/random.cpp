@@ -15,6 +15,7 @@
 #include "mpicommons.h"
 #include "mpiroutines.h"
 #include <ctime>
+#include <sstream>
 #include <stdexcept>
 
 // c++11
@@ -41,6 +42,11 @@ static std::random_device rng_device__;
 
 static RNG_TYPE rng_type__ = MT;
 
+// The per-thread random number streams, and the stream in use on each
+// thread, or NULL for the shared generator.
+static thread_local RandomStream rng_thread__;
+static thread_local RandomStream * rng_in_use__ = NULL;
+
 // -----------------------------------------------------------------------------
 //
 bool setRngType(const RNG_TYPE rng_type)
@@ -130,6 +136,12 @@ void seedRandom(const bool time_seed, int seed)
 //
 double randomDouble01()
 {
+    // Threads with a stream of their own use it.
+    if (rng_in_use__ != NULL)
+    {
+        return std::generate_canonical<double, 32>(*rng_in_use__);
+    }
+
     switch (rng_type__)
     {
     case MT:
@@ -155,3 +167,126 @@ double randomDouble01()
     }
 }
 
+
+// -----------------------------------------------------------------------------
+//
+void seedThreadRandom(const int seed)
+{
+    rng_thread__.seed(seed);
+    rng_in_use__ = &rng_thread__;
+}
+
+
+// -----------------------------------------------------------------------------
+// The state of an engine as text.
+template <class T_engine>
+static std::string engineState(const T_engine & engine)
+{
+    std::ostringstream state;
+    state << engine;
+    return state.str();
+}
+
+
+// -----------------------------------------------------------------------------
+// Set the state of an engine from text.
+template <class T_engine>
+static void setEngineState(T_engine & engine, std::istream & state)
+{
+    state >> engine;
+    if (state.fail())
+    {
+        throw std::runtime_error("Invalid random number generator state.");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+std::string randomState()
+{
+    // The state is prefixed with the type of the generator, where the
+    // streams of threads and models are of MT type.
+    const RNG_TYPE rng_type = (rng_in_use__ != NULL) ? MT : rng_type__;
+    std::ostringstream prefix;
+    prefix << rng_type << " ";
+
+    if (rng_in_use__ != NULL)
+    {
+        return prefix.str() + engineState(*rng_in_use__);
+    }
+
+    switch (rng_type__)
+    {
+    case MT:
+        return prefix.str() + engineState(rng_mt__);
+    case MINSTD:
+        return prefix.str() + engineState(rng_minstd__);
+    case RANLUX24:
+        return prefix.str() + engineState(rng_ranlux24__);
+    case RANLUX48:
+        return prefix.str() + engineState(rng_ranlux48__);
+    default:
+        throw std::runtime_error("The state of the random device can not be saved.");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void setRandomState(const std::string & state)
+{
+    std::istringstream stream(state);
+    int rng_type = -1;
+    stream >> rng_type;
+
+    const RNG_TYPE rng_type_in_use = (rng_in_use__ != NULL) ? MT : rng_type__;
+    if (stream.fail() || rng_type != rng_type_in_use)
+    {
+        throw std::runtime_error("The random number generator state is for another type of generator.");
+    }
+
+    if (rng_in_use__ != NULL)
+    {
+        setEngineState(*rng_in_use__, stream);
+        return;
+    }
+
+    switch (rng_type__)
+    {
+    case MT:
+        setEngineState(rng_mt__, stream);
+        break;
+    case MINSTD:
+        setEngineState(rng_minstd__, stream);
+        break;
+    case RANLUX24:
+        setEngineState(rng_ranlux24__, stream);
+        break;
+    case RANLUX48:
+        setEngineState(rng_ranlux48__, stream);
+        break;
+    default:
+        throw std::runtime_error("The state of the random device can not be set.");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ScopedRandomStream::ScopedRandomStream(RandomStream * stream) :
+    previous_(rng_in_use__)
+{
+    if (stream != NULL)
+    {
+        rng_in_use__ = stream;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ScopedRandomStream::~ScopedRandomStream()
+{
+    rng_in_use__ = previous_;
+}
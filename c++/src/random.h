@@ -13,6 +13,11 @@
 #ifndef __RANDOM__
 #define __RANDOM__
 
+#include <string>
+
+// c++11
+#include <random>
+
 /// The supported random number generator types.
 enum RNG_TYPE {MT, MINSTD, RANLUX24, RANLUX48, DEVICE};
 
@@ -38,5 +43,67 @@ void seedRandom(const bool time_seed, int seed);
 double randomDouble01();
 
 
+/*! \brief Give the calling thread its own std::mt19937 random number
+ *         stream. After this call randomDouble01() on this thread draws
+ *         from the thread stream instead of the shared generator, so that
+ *         worker threads can draw numbers without synchronization.
+ *  \param seed : An integer to use as seed for the thread stream.
+ */
+void seedThreadRandom(const int seed);
+
+
+/*! \brief Get the state of the random number stream in use on the calling
+ *         thread, being the stream of a ScopedRandomStream, the thread
+ *         stream or the shared generator, e.g. for writing a checkpoint.
+ *         The state of the DEVICE generator can not be saved.
+ *  \return : The state of the stream as text.
+ */
+std::string randomState();
+
+/*! \brief Set the state of the random number stream in use on the calling
+ *         thread, so that it continues from where the state was saved.
+ *  \param state : A state returned by randomState() for the same type
+ *                 of generator.
+ */
+void setRandomState(const std::string & state);
+
+
+/// A random number stream that can be owned by e.g. a model.
+typedef std::mt19937 RandomStream;
+
+
+/*! \brief Class for drawing random numbers from a given stream on the
+ *         calling thread. While an object lives, randomDouble01() on the
+ *         thread that created it draws from its stream. The stream used
+ *         before is used again when the object goes out of scope.
+ */
+class ScopedRandomStream {
+
+public:
+
+    /*! \brief Constructor for starting to use the stream.
+     *  \param stream : The stream to draw from, or NULL to keep using the
+     *                  stream in use on the calling thread.
+     */
+    explicit ScopedRandomStream(RandomStream * stream);
+
+    /*! \brief Destructor, restoring the stream used before.
+     */
+    ~ScopedRandomStream();
+
+private:
+
+    /// The stream in use on the thread before, or NULL for the shared generator.
+    RandomStream * previous_;
+
+    /// Disabled copy.
+    ScopedRandomStream(const ScopedRandomStream &);
+
+    /// Disabled assignment.
+    ScopedRandomStream & operator=(const ScopedRandomStream &);
+
+};
+
+
 #endif // __RANDOM__
 
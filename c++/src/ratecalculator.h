@@ -90,6 +90,16 @@ public:
                                       const double global_z) const {
                 return rate_constant; }
 
+    /*! \brief Query for the thread safety of the callback functions. A
+     *         calculator that returns true may be called concurrently from
+     *         several threads, and the Matcher then evaluates rates in
+     *         parallel when it is given more than one thread. Calculators
+     *         implemented in Python must not return true.
+     * \return : The base class implementation returns false.
+     */
+    virtual
+    bool threadSafe() const { return false; }
+
 
 protected:
 
@@ -11,6 +11,7 @@
  */
 
 #include "ratetable.h"
+#include "checkpoint.h"
 #include <stdexcept>
 
 
@@ -77,3 +78,45 @@ double RateTable::retrieve(const ratekey key)
     return tables_.at(nt).at(key);
 }
 
+
+// -----------------------------------------------------------------------------
+//
+void RateTable::saveState(CheckpointWriter & writer) const
+{
+    writer.write(n_tables_);
+    writer.write(max_size_);
+    writer.write(current_table_);
+
+    for (size_t i = 0; i < tables_.size(); ++i)
+    {
+        writer.write(static_cast<unsigned long>(tables_[i].size()));
+        std::unordered_map<ratekey, double>::const_iterator it = tables_[i].begin();
+        for ( ; it != tables_[i].end(); ++it)
+        {
+            writer.write(it->first);
+            writer.write(it->second);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void RateTable::loadState(CheckpointReader & reader)
+{
+    n_tables_ = reader.read<int>();
+    max_size_ = reader.read<unsigned int>();
+    current_table_ = reader.read<int>();
+
+    tables_.resize(n_tables_);
+    for (size_t i = 0; i < tables_.size(); ++i)
+    {
+        tables_[i].clear();
+        const unsigned long size = reader.read<unsigned long>();
+        for (unsigned long j = 0; j < size; ++j)
+        {
+            const ratekey key = reader.read<ratekey>();
+            tables_[i][key] = reader.read<double>();
+        }
+    }
+}
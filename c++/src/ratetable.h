@@ -17,6 +17,10 @@
 #include <unordered_map>
 #include <vector>
 
+// Forward declarations.
+class CheckpointWriter;
+class CheckpointReader;
+
 // NOTE: This implementation is based on the c++11 std::unordered_map.
 
 
@@ -52,6 +56,17 @@ public:
      */
     double retrieve(const ratekey key);
 
+    /*! \brief Write the stored rates to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the stored rates written by saveState, each in the
+     *         table it was stored in.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
 protected:
 
 private:
@@ -12,6 +12,7 @@
 
 #include "simulationtimer.h"
 #include "random.h"
+#include "checkpoint.h"
 #include <cmath>
 
 // -----------------------------------------------------------------------------
@@ -32,3 +33,21 @@ void SimulationTimer::propagateTime(const double total_rate)
     const double dt  = -std::log(rnd)/total_rate;
     simulation_time_ += dt;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+void SimulationTimer::saveState(CheckpointWriter & writer) const
+{
+    writer.section("TIME");
+    writer.write(simulation_time_);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SimulationTimer::loadState(CheckpointReader & reader)
+{
+    reader.section("TIME");
+    simulation_time_ = reader.read<double>();
+}
@@ -13,6 +13,10 @@
 #ifndef __SIMULATIONTIMER__
 #define __SIMULATIONTIMER__
 
+// Forward declarations.
+class CheckpointWriter;
+class CheckpointReader;
+
 /*! \brief Class for keeping track of simulation (KMC) time.
  */
 class SimulationTimer {
@@ -28,11 +32,26 @@ public:
      */
     void propagateTime(const double total_rate);
 
+    /*! \brief Propagate the time by a fixed interval.
+     *  \param time_interval: The time to add.
+     */
+    void propagateTimeInterval(const double time_interval) { simulation_time_ += time_interval; }
+
     /*! \brief Query for the simulation time.
      *  \return : The current simulation time.
      */
     double simulationTime() const { return simulation_time_; }
 
+    /*! \brief Write the simulation time to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the simulation time written by saveState.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
 protected:
 
 private:
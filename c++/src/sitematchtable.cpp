@@ -0,0 +1,215 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sitematchtable.cpp
+ *  \brief File for the implementation code of the SiteMatchTable class.
+ */
+
+#include "sitematchtable.h"
+#include "checkpoint.h"
+
+#include <stdexcept>
+
+
+// -----------------------------------------------------------------------------
+//
+SiteMatchTable::SiteMatchTable(const size_t n_sites) :
+    sites_(n_sites)
+{
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        sites_[i].n_listed = 0;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+bool SiteMatchTable::isListed(const int index, const int process) const
+{
+    const SiteMatches & site = sites_[index];
+    const int n = site.n_listed;
+
+    for (int i = 0; i < n && i < SITE_MATCHES_IN_PLACE; ++i)
+    {
+        if (site.in_place[i].process == process)
+        {
+            return true;
+        }
+    }
+
+    for (int i = SITE_MATCHES_IN_PLACE; i < n; ++i)
+    {
+        if (site.overflow[i - SITE_MATCHES_IN_PLACE].process == process)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteMatchTable::add(const int index, const int process, const int slot)
+{
+    SiteMatches & site = sites_[index];
+    const ListedProcess listed_process = {process, slot};
+
+    if (site.n_listed < SITE_MATCHES_IN_PLACE)
+    {
+        site.in_place[site.n_listed] = listed_process;
+    }
+    else
+    {
+        site.overflow.push_back(listed_process);
+    }
+
+    ++site.n_listed;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+int SiteMatchTable::remove(const int index, const int process)
+{
+    SiteMatches & site = sites_[index];
+    const int last = site.n_listed - 1;
+
+    // Move the last process into the position of the process and drop
+    // the last position.
+    ListedProcess & listed_process = find(index, process);
+    const int slot = listed_process.slot;
+    listed_process = entry(index, last);
+
+    // The overflow keeps its capacity, so that a site that moves in and
+    // out of overflow during stepping does not allocate each time.
+    if (last >= SITE_MATCHES_IN_PLACE)
+    {
+        site.overflow.pop_back();
+    }
+
+    site.n_listed = last;
+    return slot;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+const SiteMatchTable::ListedProcess & SiteMatchTable::entry(const int index, const int i) const
+{
+    const SiteMatches & site = sites_[index];
+    if (i < SITE_MATCHES_IN_PLACE)
+    {
+        return site.in_place[i];
+    }
+    else
+    {
+        return site.overflow[i - SITE_MATCHES_IN_PLACE];
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteMatchTable::ListedProcess & SiteMatchTable::entry(const int index, const int i)
+{
+    SiteMatches & site = sites_[index];
+    if (i < SITE_MATCHES_IN_PLACE)
+    {
+        return site.in_place[i];
+    }
+    else
+    {
+        return site.overflow[i - SITE_MATCHES_IN_PLACE];
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+int SiteMatchTable::position(const int index, const int process) const
+{
+    // The process is listed, so the last position is not checked.
+    const int last = sites_[index].n_listed - 1;
+    int i = 0;
+    while (i < last && entry(index, i).process != process)
+    {
+        ++i;
+    }
+    return i;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteMatchTable::saveState(CheckpointWriter & writer) const
+{
+    // The number of listed processes of each site, followed by the
+    // processes and their slots of all sites one site after the other.
+    std::vector<int> n_listed(sites_.size());
+    size_t n_total = 0;
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        n_listed[i] = sites_[i].n_listed;
+        n_total += n_listed[i];
+    }
+
+    std::vector<int> listed_processes;
+    std::vector<int> listed_slots;
+    listed_processes.reserve(n_total);
+    listed_slots.reserve(n_total);
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        for (int j = 0; j < n_listed[i]; ++j)
+        {
+            listed_processes.push_back(listed(i, j));
+            listed_slots.push_back(listedSlot(i, j));
+        }
+    }
+
+    writer.writeVector(n_listed);
+    writer.writeVector(listed_processes);
+    writer.writeVector(listed_slots);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteMatchTable::loadState(CheckpointReader & reader)
+{
+    std::vector<int> n_listed;
+    std::vector<int> listed_processes;
+    std::vector<int> listed_slots;
+    reader.readVector(n_listed);
+    reader.readVector(listed_processes);
+    reader.readVector(listed_slots);
+
+    if (n_listed.size() != sites_.size())
+    {
+        throw std::runtime_error("The checkpoint does not match the number of sites in the site match table.");
+    }
+
+    // Add the processes back in their order, keeping the overflow storage.
+    size_t position = 0;
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        sites_[i].n_listed = 0;
+        sites_[i].overflow.clear();
+        for (int j = 0; j < n_listed[i]; ++j)
+        {
+            if (position >= listed_processes.size() || position >= listed_slots.size())
+            {
+                throw std::runtime_error("The checkpoint does not match the number of listed processes in the site match table.");
+            }
+            add(i, listed_processes[position], listed_slots[position]);
+            ++position;
+        }
+    }
+}
@@ -0,0 +1,197 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sitematchtable.h
+ *  \brief File for the SiteMatchTable class definition.
+ */
+
+#ifndef __SITEMATCHTABLE__
+#define __SITEMATCHTABLE__
+
+#include <vector>
+#include <cstddef>
+
+// Forward declarations.
+class CheckpointWriter;
+class CheckpointReader;
+
+/// The number of processes stored in place for each site.
+static const int SITE_MATCHES_IN_PLACE = 3;
+
+
+/*! \brief Class for keeping track of which processes each site is listed
+ *         with. Each site stores the numbers of its listed processes in a
+ *         short unordered list, together with the slot of the site in the
+ *         list of sites of each process, so that a site can be removed from
+ *         a process without looking its slot up. The memory scales with the
+ *         number of matches rather than with sites times processes. The first few
+ *         processes of a site are stored in place, and only sites with more
+ *         matches than that allocate any memory of their own, which they
+ *         keep for reuse when their matches drop back. Different
+ *         sites can be updated concurrently.
+ */
+class SiteMatchTable {
+
+public:
+
+    /*! \brief Constructor for a table with no matches.
+     *  \param n_sites : The number of sites.
+     */
+    SiteMatchTable(const size_t n_sites);
+
+    /*! \brief Query for the number of sites.
+     *  \return : The number of sites in the table.
+     */
+    size_t size() const { return sites_.size(); }
+
+    /*! \brief Check if a process is listed for a site.
+     *  \param index   : The site to check.
+     *  \param process : The process number to check for.
+     *  \return : True if the process is listed for the site.
+     */
+    bool isListed(const int index, const int process) const;
+
+    /*! \brief List a process for a site. The process must not already
+     *         be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number to list.
+     *  \param slot    : The slot of the site in the list of sites of the
+     *                   process.
+     */
+    void add(const int index, const int process, const int slot);
+
+    /*! \brief Remove a process from the list of a site. The process must
+     *         be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number to remove.
+     *  \return : The slot the site had in the list of sites of the process.
+     */
+    int remove(const int index, const int process);
+
+    /*! \brief Query for the slot of a site in the list of sites of a
+     *         process. The process must be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number.
+     *  \return : The slot of the site in the list of sites of the process.
+     */
+    int slot(const int index, const int process) const { return find(index, process).slot; }
+
+    /*! \brief Set the slot of a site in the list of sites of a process,
+     *         after the site was moved within the list. The process must
+     *         be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number.
+     *  \param slot    : The new slot of the site.
+     */
+    void setSlot(const int index, const int process, const int slot) { find(index, process).slot = slot; }
+
+    /*! \brief Query for the number of processes listed for a site.
+     *  \param index : The site.
+     *  \return : The number of listed processes.
+     */
+    int nListed(const int index) const { return sites_[index].n_listed; }
+
+    /*! \brief Query for a process listed for a site.
+     *  \param index : The site.
+     *  \param i     : The position in the list of the site, in
+     *                 [0, nListed(index)).
+     *  \return : The process number at the position.
+     */
+    int listed(const int index, const int i) const { return entry(index, i).process; }
+
+    /*! \brief Query for the slot of a site in the list of sites of a
+     *         process listed for it.
+     *  \param index : The site.
+     *  \param i     : The position in the list of the site, in
+     *                 [0, nListed(index)).
+     *  \return : The slot of the site with the process at the position.
+     */
+    int listedSlot(const int index, const int i) const { return entry(index, i).slot; }
+
+    /*! \brief Write the listed processes of all sites to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the listed processes written by saveState, in the
+     *         order they were listed.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
+protected:
+
+private:
+
+    /// A minimal struct for representing a process listed for a site.
+    struct ListedProcess
+    {
+        /// The process number.
+        int process;
+        /// The slot of the site in the list of sites of the process.
+        int slot;
+    };
+
+    /// A minimal struct for representing the processes listed for a site.
+    struct SiteMatches
+    {
+        /// The number of listed processes.
+        int n_listed;
+        /// The first listed processes.
+        ListedProcess in_place[SITE_MATCHES_IN_PLACE];
+        /// The listed processes that do not fit in place.
+        std::vector<ListedProcess> overflow;
+    };
+
+    /*! \brief Get the entry at a position in the list of a site.
+     *  \param index : The site.
+     *  \param i     : The position in the list of the site.
+     *  \return : The entry at the position.
+     */
+    const ListedProcess & entry(const int index, const int i) const;
+
+    /*! \brief Get the entry at a position in the list of a site.
+     *  \param index : The site.
+     *  \param i     : The position in the list of the site.
+     *  \return : The entry at the position.
+     */
+    ListedProcess & entry(const int index, const int i);
+
+    /*! \brief Get the entry of a process listed for a site. The process
+     *         must be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number.
+     *  \return : The entry of the process.
+     */
+    const ListedProcess & find(const int index, const int process) const
+    { return entry(index, position(index, process)); }
+
+    /*! \brief Get the entry of a process listed for a site. The process
+     *         must be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number.
+     *  \return : The entry of the process.
+     */
+    ListedProcess & find(const int index, const int process)
+    { return entry(index, position(index, process)); }
+
+    /*! \brief Get the position of a process listed for a site. The
+     *         process must be listed for the site.
+     *  \param index   : The site.
+     *  \param process : The process number.
+     *  \return : The position of the process in the list of the site.
+     */
+    int position(const int index, const int process) const;
+
+    /// The listed processes of each site.
+    std::vector<SiteMatches> sites_;
+
+};
+
+
+#endif // __SITEMATCHTABLE__
@@ -0,0 +1,473 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sitestorage.cpp
+ *  \brief File for the implementation code of the SiteStorage class.
+ */
+
+#include "sitestorage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// POSIX, for mapping the file.
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// The coordinates are stored as three doubles.
+static_assert(sizeof(Coordinate) == 3 * sizeof(double),
+              "The site storage layout needs a Coordinate to be three doubles.");
+
+// The first bytes of a site storage file.
+static const char magic__[8] = {'K', 'M', 'C', 'L', 'I', 'B', 'S', 'S'};
+
+// Written in the native byte order, for detecting files from other machines.
+static const unsigned int byte_order__ = 0x01020304;
+
+// The header of a site storage file.
+struct SiteStorageHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned long long n_sites;
+    unsigned long long n_types;
+};
+
+// The number of arrays in a site storage file.
+static const int n_arrays__ = 6;
+
+
+// -----------------------------------------------------------------------------
+// Round a size up to the next multiple of the storage alignment.
+static size_t align(const size_t size)
+{
+    return (size + SITE_STORAGE_ALIGNMENT - 1) / SITE_STORAGE_ALIGNMENT * SITE_STORAGE_ALIGNMENT;
+}
+
+
+// -----------------------------------------------------------------------------
+// The offsets of the arrays in a storage file, in the order of the layout,
+// with the size of the file in the last element.
+static void layout(const size_t n_sites,
+                   const size_t n_types,
+                   size_t (&offsets)[n_arrays__ + 1])
+{
+    const size_t sizes[n_arrays__] = {n_sites * sizeof(Coordinate),
+                                      n_sites * sizeof(Coordinate),
+                                      n_sites * sizeof(int),
+                                      n_sites * sizeof(int),
+                                      n_sites * sizeof(int),
+                                      n_sites * n_types * sizeof(int)};
+
+    offsets[0] = align(sizeof(SiteStorageHeader));
+    for (int i = 0; i < n_arrays__; ++i)
+    {
+        offsets[i + 1] = align(offsets[i] + sizes[i]);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// Copy the pages of an array that differ, so that pages that are the same
+// in both arrays are left unwritten.
+template <class T>
+static void copyChangedPages(const SiteArray<T> & from, SiteArray<T> & to)
+{
+    const char * src = reinterpret_cast<const char*>(from.data());
+    char * dst = reinterpret_cast<char*>(to.data());
+    const size_t n_bytes = from.size() * sizeof(T);
+
+    for (size_t start = 0; start < n_bytes; start += SITE_STORAGE_ALIGNMENT)
+    {
+        const size_t n = std::min(SITE_STORAGE_ALIGNMENT, n_bytes - start);
+        if (std::memcmp(src + start, dst + start, n) != 0)
+        {
+            std::memcpy(dst + start, src + start, n);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage::SiteStorage() :
+    n_types_(0),
+    path_(""),
+    map_(NULL),
+    map_size_(0),
+    types_released_(false)
+{
+    // NOTHING HERE
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage::SiteStorage(const size_t n_sites, const int n_types) :
+    n_types_(n_types),
+    path_(""),
+    map_(NULL),
+    map_size_(0),
+    types_released_(false)
+{
+    coordinates_.allocate(n_sites, Coordinate(0.0, 0.0, 0.0));
+    atom_id_coordinates_.allocate(n_sites, Coordinate(0.0, 0.0, 0.0));
+    atom_id_.allocate(n_sites, 0);
+    first_types_.allocate(n_sites, 0);
+    atom_id_types_.allocate(n_sites, 0);
+    type_counts_.allocate(n_sites * n_types, 0);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage::SiteStorage(const std::string & path, const size_t n_sites, const int n_types) :
+    n_types_(n_types),
+    path_(""),
+    map_(NULL),
+    map_size_(0),
+    types_released_(false)
+{
+    map(path, true, n_sites, n_types);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage::SiteStorage(const std::string & path) :
+    n_types_(0),
+    path_(""),
+    map_(NULL),
+    map_size_(0),
+    types_released_(false)
+{
+    map(path, false, 0, 0);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage::SiteStorage(const SiteStorage & other) :
+    n_types_(other.n_types_),
+    path_(""),
+    map_(NULL),
+    map_size_(0),
+    coordinates_(),
+    atom_id_coordinates_(),
+    atom_id_(),
+    first_types_(),
+    atom_id_types_(),
+    type_counts_(),
+    types_released_(false)
+{
+    if (!other.mapped())
+    {
+        coordinates_ = other.coordinates_;
+        atom_id_coordinates_ = other.atom_id_coordinates_;
+        atom_id_ = other.atom_id_;
+        first_types_ = other.first_types_;
+        atom_id_types_ = other.atom_id_types_;
+        type_counts_ = other.type_counts_;
+        types_released_ = other.types_released_;
+        return;
+    }
+
+    // Map the same file and bring the pages written by the other storage
+    // up to date. The coordinates are never written.
+    map(other.path_, false, 0, 0);
+    if (size() != other.size() || n_types_ != other.n_types_)
+    {
+        unmap();
+        throw std::runtime_error("The site storage file " + other.path_ + " changed while it was mapped.");
+    }
+
+    copyChangedPages(other.atom_id_coordinates_, atom_id_coordinates_);
+    copyChangedPages(other.atom_id_, atom_id_);
+    copyChangedPages(other.atom_id_types_, atom_id_types_);
+    if (other.types_released_)
+    {
+        releaseTypes();
+    }
+    else
+    {
+        copyChangedPages(other.first_types_, first_types_);
+        copyChangedPages(other.type_counts_, type_counts_);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage & SiteStorage::operator=(const SiteStorage & other)
+{
+    if (this != &other)
+    {
+        SiteStorage copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SiteStorage::~SiteStorage()
+{
+    unmap();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::map(const std::string & path,
+                      const bool create,
+                      const size_t n_sites,
+                      const int n_types)
+{
+    const int fd = create ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Could not open the site storage file " + path + ".");
+    }
+
+    size_t offsets[n_arrays__ + 1];
+    SiteStorageHeader header;
+
+    if (create)
+    {
+        // Give the file its size, without writing the arrays.
+        layout(n_sites, n_types, offsets);
+        if (ftruncate(fd, offsets[n_arrays__]) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Could not set the size of the site storage file " + path + ".");
+        }
+
+        std::memcpy(header.magic, magic__, sizeof(magic__));
+        header.version = SITE_STORAGE_VERSION;
+        header.byte_order = byte_order__;
+        header.n_sites = n_sites;
+        header.n_types = n_types;
+    }
+    else
+    {
+        // Check the header before the file is mapped.
+        if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            std::memcmp(header.magic, magic__, sizeof(magic__)) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("The file " + path + " is not a site storage file.");
+        }
+        if (header.version != SITE_STORAGE_VERSION)
+        {
+            ::close(fd);
+            throw std::runtime_error("The site storage file " + path + " was written with another version of the layout.");
+        }
+        if (header.byte_order != byte_order__)
+        {
+            ::close(fd);
+            throw std::runtime_error("The site storage file " + path + " was written with another byte order.");
+        }
+
+        layout(header.n_sites, header.n_types, offsets);
+        struct stat status;
+        if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < offsets[n_arrays__])
+        {
+            ::close(fd);
+            throw std::runtime_error("The site storage file " + path + " is truncated.");
+        }
+    }
+
+    // The mapping stays valid after the file is closed.
+    void * data = mmap(NULL, offsets[n_arrays__], PROT_READ | PROT_WRITE,
+                       create ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("Could not map the site storage file " + path + ".");
+    }
+
+    map_ = static_cast<char*>(data);
+    map_size_ = offsets[n_arrays__];
+    path_ = path;
+    n_types_ = header.n_types;
+
+    if (create)
+    {
+        std::memcpy(map_, &header, sizeof(header));
+    }
+    else
+    {
+        // Keep the lattice coordinates read-only, so that they stay shared.
+        mprotect(map_ + offsets[0], offsets[1] - offsets[0], PROT_READ);
+    }
+
+    const size_t n = header.n_sites;
+    coordinates_.refer(reinterpret_cast<Coordinate*>(map_ + offsets[0]), n);
+    atom_id_coordinates_.refer(reinterpret_cast<Coordinate*>(map_ + offsets[1]), n);
+    atom_id_.refer(reinterpret_cast<int*>(map_ + offsets[2]), n);
+    first_types_.refer(reinterpret_cast<int*>(map_ + offsets[3]), n);
+    atom_id_types_.refer(reinterpret_cast<int*>(map_ + offsets[4]), n);
+    type_counts_.refer(reinterpret_cast<int*>(map_ + offsets[5]), n * header.n_types);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::unmap()
+{
+    if (map_ != NULL)
+    {
+        munmap(map_, map_size_);
+        map_ = NULL;
+        map_size_ = 0;
+        path_ = "";
+        coordinates_.refer(NULL, 0);
+        atom_id_coordinates_.refer(NULL, 0);
+        atom_id_.refer(NULL, 0);
+        first_types_.refer(NULL, 0);
+        atom_id_types_.refer(NULL, 0);
+        type_counts_.refer(NULL, 0);
+        types_released_ = false;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::swap(SiteStorage & other)
+{
+    std::swap(n_types_, other.n_types_);
+    path_.swap(other.path_);
+    std::swap(map_, other.map_);
+    std::swap(map_size_, other.map_size_);
+    coordinates_.swap(other.coordinates_);
+    atom_id_coordinates_.swap(other.atom_id_coordinates_);
+    atom_id_.swap(other.atom_id_);
+    first_types_.swap(other.first_types_);
+    atom_id_types_.swap(other.atom_id_types_);
+    type_counts_.swap(other.type_counts_);
+    std::swap(types_released_, other.types_released_);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::write(const std::string & path,
+                        const unsigned char * single_types) const
+{
+    if (types_released_ && single_types == NULL)
+    {
+        throw std::runtime_error("The types of the site storage are released and must be given for writing it.");
+    }
+
+    SiteStorage file(path, size(), n_types_);
+    std::memcpy(file.coordinates_.data(), coordinates_.data(), size() * sizeof(Coordinate));
+    std::memcpy(file.atom_id_coordinates_.data(), atom_id_coordinates_.data(), size() * sizeof(Coordinate));
+    std::memcpy(file.atom_id_.data(), atom_id_.data(), size() * sizeof(int));
+    std::memcpy(file.atom_id_types_.data(), atom_id_types_.data(), size() * sizeof(int));
+
+    // The new file is filled with zeros, so only the single atom of each
+    // site is counted.
+    if (single_types != NULL)
+    {
+        for (size_t i = 0; i < size(); ++i)
+        {
+            file.first_types_[i] = single_types[i];
+            file.type_counts_[i * n_types_ + single_types[i]] = 1;
+        }
+    }
+    else
+    {
+        std::memcpy(file.first_types_.data(), first_types_.data(), size() * sizeof(int));
+        std::memcpy(file.type_counts_.data(), type_counts_.data(), type_counts_.size() * sizeof(int));
+    }
+    file.flush();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::releaseTypes()
+{
+    if (types_released_)
+    {
+        return;
+    }
+
+    // Hand the pages back to the file. The arrays start on pages of their
+    // own, see layout().
+    if (map_ != NULL)
+    {
+        size_t offsets[n_arrays__ + 1];
+        layout(size(), n_types_, offsets);
+        madvise(map_ + offsets[3], offsets[4] - offsets[3], MADV_DONTNEED);
+        madvise(map_ + offsets[5], offsets[6] - offsets[5], MADV_DONTNEED);
+    }
+
+    first_types_.refer(NULL, 0);
+    type_counts_.refer(NULL, 0);
+    types_released_ = true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::restoreTypes()
+{
+    if (!types_released_)
+    {
+        return;
+    }
+
+    const size_t n_sites = size();
+    if (map_ != NULL)
+    {
+        size_t offsets[n_arrays__ + 1];
+        layout(n_sites, n_types_, offsets);
+        first_types_.refer(reinterpret_cast<int*>(map_ + offsets[3]), n_sites);
+        type_counts_.refer(reinterpret_cast<int*>(map_ + offsets[5]), n_sites * n_types_);
+    }
+    else
+    {
+        first_types_.allocate(n_sites, 0);
+        type_counts_.allocate(n_sites * n_types_, 0);
+    }
+    types_released_ = false;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::flush()
+{
+    if (map_ != NULL && msync(map_, map_size_, MS_SYNC) != 0)
+    {
+        throw std::runtime_error("Could not write the site storage file " + path_ + ".");
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SiteStorage::setSite(const size_t index, const Coordinate & coordinate, const int type)
+{
+    coordinates_[index] = coordinate;
+    atom_id_coordinates_[index] = coordinate;
+    atom_id_[index] = index;
+    first_types_[index] = type;
+    atom_id_types_[index] = type;
+
+    int * counts = type_counts_.data() + index * n_types_;
+    std::fill(counts, counts + n_types_, 0);
+    counts[type] = 1;
+}
@@ -0,0 +1,465 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sitestorage.h
+ *  \brief File for the storage of the per site arrays of a configuration.
+ */
+
+#ifndef __SITESTORAGE__
+#define __SITESTORAGE__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "coordinate.h"
+
+
+/// The version of the site storage file layout.
+static const unsigned int SITE_STORAGE_VERSION = 1;
+
+/// The alignment in bytes of the arrays in a site storage file, being a
+/// page on common systems, so that each array starts on a page of its own.
+static const size_t SITE_STORAGE_ALIGNMENT = 4096;
+
+
+/*! \brief Class for a fixed size array of per site values, held either in
+ *         a vector of its own or in memory owned by a SiteStorage, e.g. a
+ *         mapped file. A copy of an array always holds its values in a
+ *         vector of its own.
+ */
+template <class T>
+class SiteArray {
+
+public:
+
+    /*! \brief Default constructor, giving an empty array.
+     */
+    SiteArray() : values_(0), data_(NULL), size_(0) {}
+
+    /*! \brief Copy constructor, copying the values into a vector of
+     *         its own.
+     *  \param other : The array to copy.
+     */
+    SiteArray(const SiteArray & other) :
+        values_(other.begin(), other.end()),
+        data_(values_.data()),
+        size_(other.size_)
+    {}
+
+    /*! \brief Assignment, copying the values into a vector of its own.
+     *  \param other : The array to copy.
+     *  \return : A reference to this array.
+     */
+    SiteArray & operator=(const SiteArray & other)
+    {
+        if (this != &other)
+        {
+            values_.assign(other.begin(), other.end());
+            data_ = values_.data();
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    /*! \brief Query for the number of values.
+     *  \return : The size of the array.
+     */
+    size_t size() const { return size_; }
+
+    /*! \brief Query for an empty array.
+     *  \return : True if the array holds no values.
+     */
+    bool empty() const { return size_ == 0; }
+
+    /*! \brief Access operator.
+     *  \param i : The index to access at.
+     *  \return : A reference to the value.
+     */
+    T & operator[](const size_t i) { return data_[i]; }
+
+    /*! \brief Access operator, const version.
+     *  \param i : The index to access at.
+     *  \return : A const reference to the value.
+     */
+    const T & operator[](const size_t i) const { return data_[i]; }
+
+    /*! \brief Query for the values.
+     *  \return : A pointer to the first value.
+     */
+    T * data() { return data_; }
+
+    /*! \brief Query for the values, const version.
+     *  \return : A const pointer to the first value.
+     */
+    const T * data() const { return data_; }
+
+    /*! \brief Iterator to the first value.
+     */
+    T * begin() { return data_; }
+
+    /*! \brief Iterator past the last value.
+     */
+    T * end() { return data_ + size_; }
+
+    /*! \brief Const iterator to the first value.
+     */
+    const T * begin() const { return data_; }
+
+    /*! \brief Const iterator past the last value.
+     */
+    const T * end() const { return data_ + size_; }
+
+    /*! \brief Check if the arrays hold the same values.
+     *  \param other : The array to compare with.
+     *  \return : True if the values are equal.
+     */
+    inline
+    bool operator==(const SiteArray & other) const;
+
+    /*! \brief Check if the arrays differ.
+     *  \param other : The array to compare with.
+     *  \return : True if any value differs.
+     */
+    bool operator!=(const SiteArray & other) const { return !(*this == other); }
+
+protected:
+
+private:
+
+    /*! \brief Hold the given number of values in a vector of its own.
+     *  \param size  : The number of values.
+     *  \param value : The value to fill the array with.
+     */
+    void allocate(const size_t size, const T & value)
+    {
+        values_.assign(size, value);
+        data_ = values_.data();
+        size_ = size;
+    }
+
+    /*! \brief Refer to values held elsewhere.
+     *  \param data : Pointer to the first value.
+     *  \param size : The number of values.
+     */
+    void refer(T * data, const size_t size)
+    {
+        std::vector<T>().swap(values_);
+        data_ = data;
+        size_ = size;
+    }
+
+    /*! \brief Swap the contents with another array.
+     *  \param other : The array to swap with.
+     */
+    void swap(SiteArray & other)
+    {
+        values_.swap(other.values_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    /// The values, when held in a vector of its own.
+    std::vector<T> values_;
+
+    /// Pointer to the first value.
+    T * data_;
+
+    /// The number of values.
+    size_t size_;
+
+    /// The storage sets up the arrays.
+    friend class SiteStorage;
+
+};
+
+
+/*! \brief Class for the bulky per site arrays of a configuration: the
+ *         coordinates, the atom id coordinates, the atom id of each site,
+ *         the type of the first atom at each site, the type of each atom
+ *         id and the number of atoms of each type at each site. The arrays
+ *         are held either on the heap or in a memory mapped file.
+ *
+ *         A storage file is mapped copy-on-write, so that its pages are
+ *         read from the file when first used and written pages stay
+ *         private to the process. Pages that are never written, e.g. all
+ *         of the lattice coordinates, are shared with all other processes
+ *         and copies mapping the same file. Changes are never written
+ *         back to the file.
+ *
+ *         The layout of a storage file, with all values in the native
+ *         byte order, is
+ *
+ *           bytes 0-7   : the characters "KMCLIBSS"
+ *           bytes 8-11  : the layout version, as an unsigned int
+ *           bytes 12-15 : the byte order marker 0x01020304, as an unsigned int
+ *           bytes 16-23 : the number of sites n, as an unsigned long long
+ *           bytes 24-31 : the number of types m including the wildcard,
+ *                         as an unsigned long long
+ *
+ *         followed by the arrays, each starting at the next multiple of
+ *         SITE_STORAGE_ALIGNMENT bytes:
+ *
+ *           coordinates         : n x 3 doubles, x, y and z of each site
+ *           atom id coordinates : n x 3 doubles, x, y and z of each atom id
+ *           atom ids            : n ints, the atom id at each site
+ *           first types         : n ints, the type of the first atom at each site
+ *           atom id types       : n ints, the type of each atom id
+ *           type counts         : n x m ints, the number of atoms of each
+ *                                 type at each site
+ *
+ *         The first types and the type counts can be released when the
+ *         types are kept elsewhere, e.g. one byte per site for a
+ *         configuration with a single atom at each site.
+ */
+class SiteStorage {
+
+public:
+
+    /*! \brief Default constructor, giving an empty storage on the heap.
+     */
+    SiteStorage();
+
+    /*! \brief Constructor for a storage on the heap, filled with zeros.
+     *  \param n_sites : The number of sites.
+     *  \param n_types : The number of types, including the wildcard.
+     */
+    SiteStorage(const size_t n_sites, const int n_types);
+
+    /*! \brief Constructor for creating a new storage file of the given
+     *         size to be filled, e.g. site by site with setSite(). The file
+     *         is mapped shared, so that the values written through the
+     *         arrays end up in the file. Pages that are never written take
+     *         no space on file systems with sparse files.
+     *  \param path    : The path of the file to create.
+     *  \param n_sites : The number of sites.
+     *  \param n_types : The number of types, including the wildcard.
+     */
+    SiteStorage(const std::string & path, const size_t n_sites, const int n_types);
+
+    /*! \brief Constructor for mapping an existing storage file copy-on-write.
+     *  \param path : The path of the storage file.
+     */
+    explicit SiteStorage(const std::string & path);
+
+    /*! \brief Copy constructor. A copy of a storage on the heap is on the
+     *         heap. A copy of a mapped storage maps the same file again and
+     *         only copies the pages that differ from the file, so that the
+     *         copies share all pages that neither of them has written.
+     *  \param other : The storage to copy.
+     */
+    SiteStorage(const SiteStorage & other);
+
+    /*! \brief Assignment, with the semantics of the copy constructor.
+     *  \param other : The storage to copy.
+     *  \return : A reference to this storage.
+     */
+    SiteStorage & operator=(const SiteStorage & other);
+
+    /*! \brief Destructor, unmapping the file if any.
+     */
+    ~SiteStorage();
+
+    /*! \brief Write the arrays to a new storage file.
+     *  \param path         : The path of the file to write.
+     *  \param single_types : The type of the single atom at each site, to
+     *                        write the first types and the type counts
+     *                        from, e.g. after releaseTypes(). If NULL the
+     *                        arrays are written as they are.
+     */
+    void write(const std::string & path,
+               const unsigned char * single_types=NULL) const;
+
+    /*! \brief Release the first types and the type counts, for keeping the
+     *         types of the sites elsewhere. The arrays are empty until
+     *         restored with restoreTypes(). The pages of a mapped storage
+     *         are handed back, and read from the file again if restored.
+     */
+    void releaseTypes();
+
+    /*! \brief Restore the first types and the type counts after
+     *         releaseTypes(). The values are to be set again by the caller.
+     */
+    void restoreTypes();
+
+    /*! \brief Query if the first types and the type counts are released.
+     *  \return : True if released.
+     */
+    bool typesReleased() const { return types_released_; }
+
+    /*! \brief Flush the values written to a created storage file.
+     */
+    void flush();
+
+    /*! \brief Set all values of a site with a single atom, with the atom id
+     *         and atom id coordinates of the site itself.
+     *  \param index      : The index of the site.
+     *  \param coordinate : The coordinate of the site.
+     *  \param type       : The type of the atom at the site.
+     */
+    void setSite(const size_t index, const Coordinate & coordinate, const int type);
+
+    /*! \brief Query for the number of sites.
+     *  \return : The number of sites.
+     */
+    size_t size() const { return coordinates_.size(); }
+
+    /*! \brief Query for the number of types.
+     *  \return : The number of types, including the wildcard.
+     */
+    int nTypes() const { return n_types_; }
+
+    /*! \brief Query for the path of the mapped file.
+     *  \return : The path of the file, empty for a storage on the heap.
+     */
+    const std::string & path() const { return path_; }
+
+    /*! \brief Query if the arrays are held in a mapped file.
+     *  \return : True if mapped.
+     */
+    bool mapped() const { return map_ != NULL; }
+
+    /*! \brief Query for the coordinates. The coordinates of a mapped
+     *         storage file are read-only.
+     */
+    SiteArray<Coordinate> & coordinates() { return coordinates_; }
+
+    /*! \brief Const query for the coordinates.
+     */
+    const SiteArray<Coordinate> & coordinates() const { return coordinates_; }
+
+    /*! \brief Query for the atom id coordinates.
+     */
+    SiteArray<Coordinate> & atomIDCoordinates() { return atom_id_coordinates_; }
+
+    /*! \brief Const query for the atom id coordinates.
+     */
+    const SiteArray<Coordinate> & atomIDCoordinates() const { return atom_id_coordinates_; }
+
+    /*! \brief Query for the atom id at each site.
+     */
+    SiteArray<int> & atomID() { return atom_id_; }
+
+    /*! \brief Const query for the atom id at each site.
+     */
+    const SiteArray<int> & atomID() const { return atom_id_; }
+
+    /*! \brief Query for the type of the first atom at each site.
+     */
+    SiteArray<int> & firstTypes() { return first_types_; }
+
+    /*! \brief Const query for the type of the first atom at each site.
+     */
+    const SiteArray<int> & firstTypes() const { return first_types_; }
+
+    /*! \brief Query for the type of each atom id.
+     */
+    SiteArray<int> & atomIDTypes() { return atom_id_types_; }
+
+    /*! \brief Const query for the type of each atom id.
+     */
+    const SiteArray<int> & atomIDTypes() const { return atom_id_types_; }
+
+    /*! \brief Query for the number of atoms of each type at each site,
+     *         with the nTypes() counts of site i starting at i*nTypes().
+     */
+    SiteArray<int> & typeCounts() { return type_counts_; }
+
+    /*! \brief Const query for the number of atoms of each type at each site.
+     */
+    const SiteArray<int> & typeCounts() const { return type_counts_; }
+
+protected:
+
+private:
+
+    /*! \brief Map a storage file and point the arrays into it.
+     *  \param path   : The path of the file.
+     *  \param create : If true a new file is created with the given sizes
+     *                  and mapped shared, otherwise an existing file is
+     *                  mapped copy-on-write.
+     *  \param n_sites : The number of sites of a new file.
+     *  \param n_types : The number of types of a new file.
+     */
+    void map(const std::string & path,
+             const bool create,
+             const size_t n_sites,
+             const int n_types);
+
+    /*! \brief Unmap the file if any.
+     */
+    void unmap();
+
+    /*! \brief Swap the contents with another storage.
+     *  \param other : The storage to swap with.
+     */
+    void swap(SiteStorage & other);
+
+    /// The number of types.
+    int n_types_;
+
+    /// The path of the mapped file.
+    std::string path_;
+
+    /// The start of the mapped file, or NULL.
+    char * map_;
+
+    /// The size of the mapped file.
+    size_t map_size_;
+
+    /// The coordinates of the sites.
+    SiteArray<Coordinate> coordinates_;
+
+    /// The coordinates of each atom id.
+    SiteArray<Coordinate> atom_id_coordinates_;
+
+    /// The atom id at each site.
+    SiteArray<int> atom_id_;
+
+    /// The type of the first atom at each site.
+    SiteArray<int> first_types_;
+
+    /// The type of each atom id.
+    SiteArray<int> atom_id_types_;
+
+    /// The number of atoms of each type at each site.
+    SiteArray<int> type_counts_;
+
+    /// If the first types and the type counts are released.
+    bool types_released_;
+
+};
+
+
+// -----------------------------------------------------------------------------
+// INLINE FUNCTION IMPLEMENTATIONS FOLLOW
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+template <class T>
+bool SiteArray<T>::operator==(const SiteArray & other) const
+{
+    if (size_ != other.size_)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < size_; ++i)
+    {
+        if (!(data_[i] == other.data_[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+#endif // __SITESTORAGE__
@@ -0,0 +1,192 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  slotmap.cpp
+ *  \brief File for the implementation code of the SlotMap class.
+ */
+
+#include "slotmap.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// The number of buckets of a new map.
+static const size_t n_initial_buckets__ = 8;
+
+
+// -----------------------------------------------------------------------------
+//
+SlotMap::SlotMap() :
+    keys_(n_initial_buckets__, -1),
+    slots_(n_initial_buckets__, 0),
+    mask_(0),
+    shift_(64),
+    n_keys_(0)
+{
+    setBuckets(n_initial_buckets__);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+long SlotMap::find(const int key) const
+{
+    for (size_t b = home(key); keys_[b] != -1; b = (b + 1) & mask_)
+    {
+        if (keys_[b] == key)
+        {
+            return static_cast<long>(slots_[b]);
+        }
+    }
+    return -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+size_t SlotMap::probes(const int key) const
+{
+    size_t n_probes = 1;
+    for (size_t b = home(key); keys_[b] != -1 && keys_[b] != key; b = (b + 1) & mask_)
+    {
+        ++n_probes;
+    }
+    return n_probes;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SlotMap::set(const int key, const size_t slot)
+{
+    size_t b = home(key);
+    for ( ; keys_[b] != -1; b = (b + 1) & mask_)
+    {
+        if (keys_[b] == key)
+        {
+            slots_[b] = slot;
+            return;
+        }
+    }
+
+    // Keep the table at most half full so that the probe sequences stay short.
+    if (2 * (n_keys_ + 1) > keys_.size())
+    {
+        grow();
+        set(key, slot);
+        return;
+    }
+
+    keys_[b]  = key;
+    slots_[b] = slot;
+    ++n_keys_;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+size_t SlotMap::erase(const int key)
+{
+    size_t b = home(key);
+    while (keys_[b] != key)
+    {
+        b = (b + 1) & mask_;
+    }
+    const size_t slot = slots_[b];
+
+    // Shift the following keys of the probe sequence back into the gap,
+    // so that no tombstones are needed.
+    size_t gap = b;
+    for (size_t next = (gap + 1) & mask_; keys_[next] != -1; next = (next + 1) & mask_)
+    {
+        // A key may fill the gap if its home is not cyclically in (gap, next].
+        const size_t next_home = home(keys_[next]);
+        if (((next - next_home) & mask_) >= ((next - gap) & mask_))
+        {
+            keys_[gap]  = keys_[next];
+            slots_[gap] = slots_[next];
+            gap = next;
+        }
+    }
+    keys_[gap] = -1;
+    --n_keys_;
+
+    return slot;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SlotMap::clear()
+{
+    std::fill(keys_.begin(), keys_.end(), -1);
+    n_keys_ = 0;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SlotMap::grow()
+{
+    std::vector<int> old_keys(2 * keys_.size(), -1);
+    std::vector<size_t> old_slots(2 * slots_.size(), 0);
+    old_keys.swap(keys_);
+    old_slots.swap(slots_);
+    setBuckets(keys_.size());
+    n_keys_ = 0;
+
+    for (size_t i = 0; i < old_keys.size(); ++i)
+    {
+        if (old_keys[i] != -1)
+        {
+            set(old_keys[i], old_slots[i]);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SlotMap::saveState(CheckpointWriter & writer) const
+{
+    writer.writeVector(keys_);
+    writer.writeVector(slots_);
+    writer.write(static_cast<unsigned long>(mask_));
+    writer.write(static_cast<unsigned long>(n_keys_));
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SlotMap::loadState(CheckpointReader & reader)
+{
+    reader.readVector(keys_);
+    reader.readVector(slots_);
+    mask_ = reader.read<unsigned long>();
+    n_keys_ = reader.read<unsigned long>();
+
+    if (keys_.size() != mask_ + 1 || slots_.size() != keys_.size() || keys_.size() < n_initial_buckets__ || (keys_.size() & mask_) != 0)
+    {
+        throw std::runtime_error("The checkpoint does not match the buckets of a slot map.");
+    }
+    setBuckets(keys_.size());
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SlotMap::setBuckets(const size_t n_buckets)
+{
+    mask_ = n_buckets - 1;
+    shift_ = 64;
+    for (size_t n = n_buckets; n > 1; n >>= 1)
+    {
+        --shift_;
+    }
+}
@@ -0,0 +1,125 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  slotmap.h
+ *  \brief File for the SlotMap class definition.
+ */
+
+#ifndef __SLOTMAP__
+#define __SLOTMAP__
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Forward declarations.
+class CheckpointWriter;
+class CheckpointReader;
+
+
+/*! \brief Class for mapping non-negative lattice indices to slots in a
+ *         list. The map is an open addressing hash table with linear
+ *         probing in one flat array, so that inserting and erasing keys
+ *         does not allocate memory once the table has grown to hold the
+ *         largest number of keys seen.
+ */
+class SlotMap {
+
+public:
+
+    /*! \brief Default constructor, giving an empty map.
+     */
+    SlotMap();
+
+    /*! \brief Query for the number of keys in the map.
+     *  \return : The number of keys.
+     */
+    size_t size() const { return n_keys_; }
+
+    /*! \brief Look up the slot of a key.
+     *  \param key : The key to look up.
+     *  \return : The slot of the key, or -1 if the key is not in the map.
+     */
+    long find(const int key) const;
+
+    /*! \brief Set the slot of a key, inserting the key if not present.
+     *  \param key  : The key, must be non-negative.
+     *  \param slot : The slot to store for the key.
+     */
+    void set(const int key, const size_t slot);
+
+    /*! \brief Remove a key from the map. The key must be present.
+     *  \param key : The key to remove.
+     *  \return : The slot the key was stored with.
+     */
+    size_t erase(const int key);
+
+    /*! \brief Query for the number of buckets probed to find a key, for
+     *         checking how well the keys are spread over the buckets.
+     *  \param key : The key to look up.
+     *  \return : The number of buckets probed, at least one.
+     */
+    size_t probes(const int key) const;
+
+    /*! \brief Remove all keys, keeping the storage.
+     */
+    void clear();
+
+    /*! \brief Write the buckets to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the buckets written by saveState.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
+protected:
+
+private:
+
+    /*! \brief Get the bucket where the probing for a key starts, from the
+     *         high bits of a 64 bit Fibonacci hash of the key. The low bits
+     *         of the product only depend on the low bits of the key, which
+     *         would put strided keys in few buckets.
+     *  \param key : The key.
+     *  \return : The first bucket to probe.
+     */
+    size_t home(const int key) const
+    { return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> shift_); }
+
+    /*! \brief Set the number of buckets, keeping the mask and shift in sync.
+     *  \param n_buckets : The number of buckets, a power of two.
+     */
+    void setBuckets(const size_t n_buckets);
+
+    /*! \brief Double the number of buckets and insert all keys again.
+     */
+    void grow();
+
+    /// The key in each bucket, -1 for an empty bucket.
+    std::vector<int> keys_;
+
+    /// The slot in each bucket.
+    std::vector<size_t> slots_;
+
+    /// The number of buckets minus one, the number of buckets being a power of two.
+    size_t mask_;
+
+    /// The shift of the hash down to the bits of the bucket, 64 minus the
+    /// base two logarithm of the number of buckets.
+    int shift_;
+
+    /// The number of keys in the map.
+    size_t n_keys_;
+
+};
+
+
+#endif // __SLOTMAP__
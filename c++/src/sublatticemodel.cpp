@@ -0,0 +1,389 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sublatticemodel.cpp
+ *  \brief File for the implementation code of the SublatticeModel class.
+ */
+
+
+#include "sublatticemodel.h"
+#include "configuration.h"
+#include "simulationtimer.h"
+#include "process.h"
+#include "random.h"
+#include "mpicommons.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+// -----------------------------------------------------------------------------
+//
+SublatticeModel::SublatticeModel(Configuration & configuration,
+                                 SimulationTimer & simulation_timer,
+                                 const LatticeMap & lattice_map,
+                                 const Interactions & interactions,
+                                 const int n_threads,
+                                 const double time_window) :
+    configuration_(configuration),
+    simulation_timer_(simulation_timer),
+    lattice_map_(lattice_map),
+    max_range_(interactions.maxRange()),
+    mixed_ranges_(interactions.minRange() < max_range_),
+    n_threads_(n_threads),
+    time_window_(time_window),
+    matcher_(configuration.coordinates().size(), interactions.processes().size())
+{
+    // Custom rates are evaluated through a single rate calculator and the
+    // MPI parallelism of the Matcher can not be used from several threads.
+    if (interactions.useCustomRates())
+    {
+        throw std::runtime_error("The sublattice model does not support custom rates.");
+    }
+    if (MPICommons::size() > 1)
+    {
+        throw std::runtime_error("The sublattice model can not be run with MPI.");
+    }
+    if (n_threads_ < 1)
+    {
+        throw std::runtime_error("The sublattice model needs at least one thread.");
+    }
+    if (!(time_window_ > 0.0))
+    {
+        throw std::runtime_error("The sublattice model time window must be positive.");
+    }
+
+    // Setup the blocks.
+    partition();
+
+    // Give each block a copy of the processes.
+    std::vector<Process> processes;
+    for (size_t i = 0; i < interactions.processes().size(); ++i)
+    {
+        processes.push_back(*interactions.processes()[i]);
+    }
+
+    block_scratch_.resize(block_indices_.size());
+    block_interactions_.reserve(block_indices_.size());
+    for (size_t i = 0; i < block_indices_.size(); ++i)
+    {
+        block_interactions_.emplace_back(processes, interactions.implicitWildcards());
+    }
+
+    // Setup the mapping between coordinates and processes.
+    calculateInitialMatching();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SublatticeModel::partition()
+{
+    const int repetitions[3] = { lattice_map_.repetitionsA(),
+                                 lattice_map_.repetitionsB(),
+                                 lattice_map_.repetitionsC() };
+
+    // A block must be wide enough that an event in one block can not
+    // change the matching of a site in another block of the same colour.
+    // Use an even number of blocks along each direction so that the
+    // colouring holds over periodic boundaries, and a single block along
+    // directions that are too short to be divided.
+    const int min_width = 2 * max_range_ + 1;
+    blocks_per_direction_.resize(3);
+    for (int d = 0; d < 3; ++d)
+    {
+        int n_blocks = repetitions[d] / min_width;
+        n_blocks -= n_blocks % 2;
+        blocks_per_direction_[d] = std::max(n_blocks, 1);
+    }
+
+    const int n_blocks = blocks_per_direction_[0] * blocks_per_direction_[1] * blocks_per_direction_[2];
+
+    // Colour the blocks as a checkerboard over the divided directions.
+    int n_colours = 1;
+    colour_of_block_.resize(n_blocks);
+    for (int bi = 0; bi < blocks_per_direction_[0]; ++bi)
+    {
+        for (int bj = 0; bj < blocks_per_direction_[1]; ++bj)
+        {
+            for (int bk = 0; bk < blocks_per_direction_[2]; ++bk)
+            {
+                const int b[3] = {bi, bj, bk};
+                int colour = 0;
+                n_colours = 1;
+                for (int d = 0; d < 3; ++d)
+                {
+                    if (blocks_per_direction_[d] > 1)
+                    {
+                        colour = 2 * colour + b[d] % 2;
+                        n_colours *= 2;
+                    }
+                }
+                const int block = (bi * blocks_per_direction_[1] + bj) * blocks_per_direction_[2] + bk;
+                colour_of_block_[block] = colour;
+            }
+        }
+    }
+
+    colour_blocks_.resize(n_colours);
+    for (int block = 0; block < n_blocks; ++block)
+    {
+        colour_blocks_[colour_of_block_[block]].push_back(block);
+    }
+
+    // Assign each index to the block of its cell.
+    const size_t n_indices = configuration_.elements().size();
+    block_of_index_.resize(n_indices);
+    block_indices_.resize(n_blocks);
+    for (size_t index = 0; index < n_indices; ++index)
+    {
+        int cell[3];
+        lattice_map_.indexToCell(index, cell[0], cell[1], cell[2]);
+
+        int b[3];
+        for (int d = 0; d < 3; ++d)
+        {
+            b[d] = cell[d] * blocks_per_direction_[d] / repetitions[d];
+        }
+
+        const int block = (b[0] * blocks_per_direction_[1] + b[1]) * blocks_per_direction_[2] + b[2];
+        block_of_index_[index] = block;
+        block_indices_[block].push_back(index);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SublatticeModel::calculateInitialMatching()
+{
+    // Calculate the match lists, with a single type per entry if the
+    // processes keep a single atom at each site. All blocks have the
+    // same processes.
+    configuration_.setSingleOccupancy(block_interactions_[0].singleOccupancy());
+    configuration_.initMatchLists(lattice_map_, max_range_, n_threads_);
+
+    // Match the indices of each block with its own processes. The blocks
+    // own disjoint sets of sites and can be matched concurrently.
+    thread_pool_.run(n_threads_, nBlocks(), [this](const int block)
+                     {
+                         Interactions & interactions = block_interactions_[block];
+                         interactions.clearMatching();
+                         interactions.updateProcessMatchLists(configuration_, lattice_map_);
+                         matcher_.calculateMatching(interactions,
+                                                    configuration_,
+                                                    lattice_map_,
+                                                    block_indices_[block],
+                                                    block_scratch_[block]);
+                         interactions.updateProbabilityTable();
+                     });
+}
+
+
+// -----------------------------------------------------------------------------
+//
+long SublatticeModel::runCycles(const int n_cycles)
+{
+    long n_events = 0;
+
+    for (int cycle = 0; cycle < n_cycles; ++cycle)
+    {
+        // Run the colours in a random order to avoid a systematic bias
+        // from always running the same colour first.
+        std::vector<int> colours(nColours());
+        for (size_t i = 0; i < colours.size(); ++i)
+        {
+            colours[i] = i;
+        }
+        for (size_t i = colours.size(); i > 1; --i)
+        {
+            const size_t j = std::min(static_cast<size_t>(randomDouble01() * i), i - 1);
+            std::swap(colours[i-1], colours[j]);
+        }
+
+        for (size_t c = 0; c < colours.size(); ++c)
+        {
+            const std::vector<int> & blocks = colour_blocks_[colours[c]];
+            const int n_blocks = blocks.size();
+
+            // Seed each block from the main stream, so that the outcome
+            // does not depend on the number of threads or their scheduling.
+            std::vector<int> seeds(n_blocks);
+            for (int i = 0; i < n_blocks; ++i)
+            {
+                seeds[i] = static_cast<int>(randomDouble01() * 2147483646.0);
+            }
+
+            // Run all blocks of this colour.
+            std::vector<std::vector<int> > boundary_indices(n_blocks);
+            std::vector<long> block_events(n_blocks, 0);
+
+            thread_pool_.run(n_threads_, n_blocks, [&](const int i)
+                             {
+                                 seedThreadRandom(seeds[i]);
+                                 block_events[i] = runBlock(blocks[i], boundary_indices[i]);
+                             });
+
+            // Reconcile the sites outside the blocks that were touched.
+            std::vector<int> indices;
+            for (int i = 0; i < n_blocks; ++i)
+            {
+                indices.insert(indices.end(), boundary_indices[i].begin(), boundary_indices[i].end());
+                n_events += block_events[i];
+            }
+            rematchBoundaries(indices);
+        }
+
+        // Each block has now been run for the time window.
+        simulation_timer_.propagateTimeInterval(time_window_);
+    }
+
+    return n_events;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+long SublatticeModel::runBlock(const int block,
+                               std::vector<int> & boundary_indices)
+{
+    Interactions & interactions = block_interactions_[block];
+
+    long n_events = 0;
+    double time = 0.0;
+    std::vector<int> indices;
+    std::vector<int> shells;
+    std::vector<int> block_indices;
+    std::vector<int> block_shells;
+
+    while (interactions.totalAvailableSites() > 0)
+    {
+        // Propagate the block time and stop at the end of the window.
+        time += -std::log(randomDouble01()) / interactions.totalRate();
+        if (time > time_window_)
+        {
+            break;
+        }
+
+        // Select a process and a site.
+        Process & process = (*interactions.pickProcess());
+        const int site_index = process.pickSite();
+
+        // Perform the operation. The sites written are owned by this block
+        // or an inactive neighbour, but the moved atom bookkeeping on the
+        // configuration is shared.
+        {
+            std::lock_guard<std::mutex> lock(event_mutex_);
+            configuration_.performBucketProcess(process, site_index, lattice_map_);
+        }
+
+        // Re-match the affected sites and their neighbours in this block,
+        // and leave the others for after the window. With mixed ranges
+        // each process is only rematched within its own range.
+        if (mixed_ranges_)
+        {
+            lattice_map_.supersetNeighbourIndices(process.affectedIndices(), max_range_, indices, shells);
+        }
+        else
+        {
+            lattice_map_.supersetNeighbourIndices(process.affectedIndices(), max_range_, indices);
+        }
+
+        block_indices.clear();
+        block_shells.clear();
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            if (block_of_index_[indices[i]] == block)
+            {
+                block_indices.push_back(indices[i]);
+                if (mixed_ranges_)
+                {
+                    block_shells.push_back(shells[i]);
+                }
+            }
+            else
+            {
+                boundary_indices.push_back(indices[i]);
+            }
+        }
+
+        matcher_.calculateMatching(interactions,
+                                   configuration_,
+                                   lattice_map_,
+                                   block_indices,
+                                   block_shells,
+                                   block_scratch_[block]);
+        ++n_events;
+    }
+
+    return n_events;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SublatticeModel::rematchBoundaries(const std::vector<int> & indices)
+{
+    // Group the unique indices by the block owning them.
+    std::vector<int> unique_indices(indices);
+    std::sort(unique_indices.begin(), unique_indices.end());
+    unique_indices.resize(std::unique(unique_indices.begin(), unique_indices.end()) - unique_indices.begin());
+
+    std::vector<std::vector<int> > indices_per_block(nBlocks());
+    for (size_t i = 0; i < unique_indices.size(); ++i)
+    {
+        indices_per_block[block_of_index_[unique_indices[i]]].push_back(unique_indices[i]);
+    }
+
+    std::vector<int> blocks;
+    for (int block = 0; block < nBlocks(); ++block)
+    {
+        if (!indices_per_block[block].empty())
+        {
+            blocks.push_back(block);
+        }
+    }
+
+    // Each block matches its own sites, so this can run concurrently.
+    thread_pool_.run(n_threads_, blocks.size(), [&](const int i)
+                     {
+                         const int block = blocks[i];
+                         matcher_.calculateMatching(block_interactions_[block],
+                                                    configuration_,
+                                                    lattice_map_,
+                                                    indices_per_block[block],
+                                                    block_scratch_[block]);
+                     });
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double SublatticeModel::totalRate() const
+{
+    double total_rate = 0.0;
+    for (size_t i = 0; i < block_interactions_.size(); ++i)
+    {
+        total_rate += block_interactions_[i].totalRate();
+    }
+    return total_rate;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+int SublatticeModel::totalAvailableSites() const
+{
+    int n_sites = 0;
+    for (size_t i = 0; i < block_interactions_.size(); ++i)
+    {
+        n_sites += block_interactions_[i].totalAvailableSites();
+    }
+    return n_sites;
+}
@@ -0,0 +1,224 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*! \file  sublatticemodel.h
+ *  \brief File for the SublatticeModel class definition.
+ */
+
+
+
+#ifndef __SUBLATTICEMODEL__
+#define __SUBLATTICEMODEL__
+
+
+#include <vector>
+#include <mutex>
+
+#include "latticemap.h"
+#include "interactions.h"
+#include "matcher.h"
+#include "threadtasks.h"
+
+// Forward declarations.
+class Configuration;
+class SimulationTimer;
+
+/*! \brief Class for running a lattice KMC model on several threads with
+ *         the synchronous sublattice scheme of Shim and Amar,
+ *         Phys. Rev. B 71, 125432 (2005).
+ *
+ *         The cell grid of the lattice map is partitioned into blocks that
+ *         are at least 2*maxRange+1 cells wide, and the blocks are coloured
+ *         as a checkerboard so that no two blocks of the same colour can
+ *         read or write the same sites. Each block keeps its own copy of the
+ *         processes and thereby its own selection structures. A cycle runs
+ *         each colour in turn for the time window, with all blocks of the
+ *         active colour running independently on the worker threads. Sites
+ *         outside a block touched by its events are rematched after each
+ *         colour, and the simulation time is propagated by the time window
+ *         after each cycle.
+ */
+class SublatticeModel {
+
+public:
+
+    /*! \brief Constructor for setting up the model.
+     *  \param configuration    : The configuration to run the simulation on.
+     *  \param simulation_timer : The timer for the simulation.
+     *  \param lattice_map      : A lattice map object describing the lattice.
+     *  \param interactions     : An interactions object describing all interactions
+     *                            and possible processes in the system. Custom
+     *                            rates are not supported.
+     *  \param n_threads        : The number of worker threads to use.
+     *  \param time_window      : The time each block is run for in each cycle.
+     */
+    SublatticeModel(Configuration & configuration,
+                    SimulationTimer & simulation_timer,
+                    const LatticeMap & lattice_map,
+                    const Interactions & interactions,
+                    const int n_threads,
+                    const double time_window);
+
+    /*! \brief Run a number of cycles, where each cycle runs all blocks of
+     *         each colour for the time window.
+     *  \param n_cycles : The number of cycles to run.
+     *  \return : The number of events performed.
+     */
+    long runCycles(const int n_cycles);
+
+    /*! \brief Query for the number of blocks.
+     *  \return : The number of blocks the lattice is partitioned into.
+     */
+    int nBlocks() const { return static_cast<int>(block_interactions_.size()); }
+
+    /*! \brief Query for the number of blocks along each lattice direction.
+     *  \return : The number of blocks in the a, b and c directions.
+     */
+    const std::vector<int> & blocksPerDirection() const { return blocks_per_direction_; }
+
+    /*! \brief Query for the number of colours.
+     *  \return : The number of colours, i.e. the number of windows per cycle.
+     */
+    int nColours() const { return static_cast<int>(colour_blocks_.size()); }
+
+    /*! \brief Query for the block owning an index.
+     *  \param index : The index to query for.
+     *  \return : The block the index belongs to.
+     */
+    int blockOfIndex(const int index) const { return block_of_index_[index]; }
+
+    /*! \brief Query for the colour of a block.
+     *  \param block : The block to query for.
+     *  \return : The colour of the block.
+     */
+    int colourOfBlock(const int block) const { return colour_of_block_[block]; }
+
+    /*! \brief Query for the interactions of a block.
+     *  \param block : The block to get the interactions for.
+     *  \return : A handle to the interactions holding the sites of the block.
+     */
+    const Interactions & blockInteractions(const int block) const { return block_interactions_[block]; }
+
+    /*! \brief Query for the total rate of the system.
+     *  \return : The sum of the total rates of all blocks.
+     */
+    double totalRate() const;
+
+    /*! \brief Query for the number of available sites in the whole system.
+     *  \return : The sum of the available sites of all blocks.
+     */
+    int totalAvailableSites() const;
+
+    /*! \brief Query for the number of worker threads.
+     *  \return : The number of worker threads.
+     */
+    int nThreads() const { return n_threads_; }
+
+    /*! \brief Query for the time window.
+     *  \return : The time each block is run for in each cycle.
+     */
+    double timeWindow() const { return time_window_; }
+
+    /*! \brief Query for the configuration.
+     *  \return : A handle to the configuration stored on the class.
+     */
+    const Configuration & configuration() const { return configuration_; }
+
+    /*! \brief Query for the lattice map.
+     *  \return : A handle to the lattice map stored on the class.
+     */
+    const LatticeMap & latticeMap() const { return lattice_map_; }
+
+protected:
+
+private:
+
+    /*! \brief Private helper function to partition the cell grid into
+     *         coloured blocks.
+     */
+    void partition();
+
+    /*! \brief Private helper function to initiate matching of all
+     *         processes with all indices of each block.
+     */
+    void calculateInitialMatching();
+
+    /*! \brief Run the events of a block for the time window.
+     *  \param block               : The block to run.
+     *  \param boundary_indices (out) : The indices outside the block that
+     *                               need to be rematched.
+     *  \return : The number of events performed.
+     */
+    long runBlock(const int block,
+                  std::vector<int> & boundary_indices);
+
+    /*! \brief Rematch indices with the processes of the blocks owning them.
+     *  \param indices : The indices to rematch, in any order and possibly
+     *                   with duplicates.
+     */
+    void rematchBoundaries(const std::vector<int> & indices);
+
+    /// A reference to the configuration given at construction.
+    Configuration & configuration_;
+
+    /// A reference to the timer given at construction.
+    SimulationTimer & simulation_timer_;
+
+    /// A description of the lattice.
+    LatticeMap lattice_map_;
+
+    /// The max range of the interactions.
+    int max_range_;
+
+    /// If the processes have different ranges, in which case each process
+    /// is only rematched within its own range of the changed sites.
+    bool mixed_ranges_;
+
+    /// The number of worker threads.
+    int n_threads_;
+
+    /// The time each block is run for in each cycle.
+    double time_window_;
+
+    /// The number of blocks along each lattice direction.
+    std::vector<int> blocks_per_direction_;
+
+    /// The block owning each index.
+    std::vector<int> block_of_index_;
+
+    /// The colour of each block.
+    std::vector<int> colour_of_block_;
+
+    /// The indices of each block.
+    std::vector<std::vector<int> > block_indices_;
+
+    /// The blocks of each colour.
+    std::vector<std::vector<int> > colour_blocks_;
+
+    /// The interactions of each block. The process pointers of each
+    /// element refer into the element itself, so the vector is never
+    /// resized after construction.
+    std::vector<Interactions> block_interactions_;
+
+    /// The work vectors for the matching of each block.
+    std::vector<MatcherScratch> block_scratch_;
+
+    /// The Matcher shared by all blocks, where each site belongs to one block.
+    Matcher matcher_;
+
+    /// Lock for the shared event bookkeeping on the configuration.
+    std::mutex event_mutex_;
+
+    /// The worker threads running the blocks, kept between the colours.
+    ThreadPool thread_pool_;
+
+};
+
+
+#endif // __SUBLATTICEMODEL__
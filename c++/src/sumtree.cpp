@@ -0,0 +1,212 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sumtree.cpp
+ *  \brief File for the implementation code of the SumTree class.
+ */
+
+#include "sumtree.h"
+#include "checkpoint.h"
+
+
+// -----------------------------------------------------------------------------
+//
+SumTree::SumTree() :
+    values_(0),
+    tree_(1, 0.0),
+    top_bit_(0)
+{
+    // NOTHING HERE
+}
+
+
+// -----------------------------------------------------------------------------
+//
+SumTree::SumTree(const size_t size) :
+    values_(size, 0.0),
+    tree_(size+1, 0.0),
+    top_bit_(0)
+{
+    rebuild();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::resize(const size_t size)
+{
+    values_.resize(size, 0.0);
+    rebuild();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::update(const size_t i, const double value)
+{
+    const double delta = value - values_[i];
+    values_[i] = value;
+
+    // Propagate the difference upwards through the tree.
+    const size_t n = values_.size();
+    for (size_t j = i+1; j <= n; j += (j & (~j + 1)))
+    {
+        tree_[j] += delta;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::push_back(const double value)
+{
+    // The new node j covers the slots (j - lowbit(j), j], where all
+    // but the last one are already present in the tree.
+    const size_t j = values_.size() + 1;
+    const size_t lowbit = (j & (~j + 1));
+    const double node = value + partialSum(j-1) - partialSum(j-lowbit);
+
+    values_.push_back(value);
+    tree_.push_back(node);
+
+    if ((top_bit_ << 1) <= j)
+    {
+        top_bit_ = (top_bit_ == 0) ? 1 : (top_bit_ << 1);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::pop_back()
+{
+    // No node below the last one covers the last slot, so there
+    // are no partial sums to update.
+    values_.pop_back();
+    tree_.pop_back();
+
+    if (top_bit_ > values_.size())
+    {
+        top_bit_ >>= 1;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::clear()
+{
+    values_.clear();
+    tree_.assign(1, 0.0);
+    top_bit_ = 0;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+double SumTree::partialSum(const size_t n) const
+{
+    double sum = 0.0;
+    for (size_t j = n; j > 0; j -= (j & (~j + 1)))
+    {
+        sum += tree_[j];
+    }
+    return sum;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+size_t SumTree::search(const double target) const
+{
+    // Walk down the tree and find the largest position for which the
+    // partial sum is not larger than the target.
+    const size_t n = values_.size();
+    size_t pos = 0;
+    double remaining = target;
+
+    for (size_t step = top_bit_; step > 0; step >>= 1)
+    {
+        const size_t next = pos + step;
+        if (next <= n && tree_[next] <= remaining)
+        {
+            pos = next;
+            remaining -= tree_[next];
+        }
+    }
+
+    // The next slot owns the target. Round-off in the partial sums may
+    // put the target on a slot without weight, or at or beyond the total,
+    // in which case the next slot with weight is taken, or else the last.
+    while (pos < n && !(values_[pos] > 0.0))
+    {
+        ++pos;
+    }
+
+    if (pos == n)
+    {
+        while (pos > 0 && !(values_[pos-1] > 0.0))
+        {
+            --pos;
+        }
+        return (pos > 0) ? pos-1 : 0;
+    }
+
+    return pos;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::rebuild()
+{
+    const size_t n = values_.size();
+    tree_.assign(n+1, 0.0);
+
+    // Linear time construction by pushing each partial sum to its parent.
+    for (size_t j = 1; j <= n; ++j)
+    {
+        tree_[j] += values_[j-1];
+        const size_t parent = j + (j & (~j + 1));
+        if (parent <= n)
+        {
+            tree_[parent] += tree_[j];
+        }
+    }
+
+    // Find the highest bit for the search.
+    top_bit_ = 1;
+    while ((top_bit_ << 1) <= n)
+    {
+        top_bit_ <<= 1;
+    }
+    if (n == 0)
+    {
+        top_bit_ = 0;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::saveState(CheckpointWriter & writer) const
+{
+    writer.writeVector(values_);
+    writer.writeVector(tree_);
+    writer.write(static_cast<unsigned long>(top_bit_));
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void SumTree::loadState(CheckpointReader & reader)
+{
+    reader.readVector(values_);
+    reader.readVector(tree_);
+    top_bit_ = reader.read<unsigned long>();
+}
@@ -0,0 +1,133 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  sumtree.h
+ *  \brief File for the SumTree class definition.
+ */
+
+#ifndef __SUMTREE__
+#define __SUMTREE__
+
+#include <vector>
+#include <cstddef>
+
+// Forward declarations.
+class CheckpointWriter;
+class CheckpointReader;
+
+
+/*! \brief Class for keeping a set of non-negative weights in a binary
+ *         indexed (Fenwick) tree. Setting a single weight and searching
+ *         for the slot that owns a given point in the accumulated sum are
+ *         both O(log N) operations, which makes the class suitable as a
+ *         selection structure for the SSA-GB algorithm.
+ */
+class SumTree {
+
+public:
+
+    /*! \brief Default constructor, giving an empty tree.
+     */
+    SumTree();
+
+    /*! \brief Constructor for a tree with all weights set to zero.
+     *  \param size : The number of slots in the tree.
+     */
+    SumTree(const size_t size);
+
+    /*! \brief Resize the tree. Slots that are added are set to zero and
+     *         the tree is rebuilt from the stored weights.
+     *  \param size : The new number of slots.
+     */
+    void resize(const size_t size);
+
+    /*! \brief Query for the number of slots.
+     *  \return : The number of slots in the tree.
+     */
+    size_t size() const { return values_.size(); }
+
+    /*! \brief Set the weight of a slot and propagate the difference to
+     *         the partial sums.
+     *  \param i     : The slot to update.
+     *  \param value : The new weight of the slot.
+     */
+    void update(const size_t i, const double value);
+
+    /*! \brief Append a slot at the end of the tree in O(log N) time.
+     *  \param value : The weight of the new slot.
+     */
+    void push_back(const double value);
+
+    /*! \brief Remove the last slot of the tree in constant time.
+     */
+    void pop_back();
+
+    /*! \brief Remove all slots from the tree.
+     */
+    void clear();
+
+    /*! \brief Query for the weight of a slot.
+     *  \param i : The slot to get the weight for.
+     *  \return : The weight stored at the slot.
+     */
+    double value(const size_t i) const { return values_[i]; }
+
+    /*! \brief Query for the sum of the first n weights.
+     *  \param n : The number of slots to sum over.
+     *  \return : The accumulated weight of slots 0 to n-1.
+     */
+    double partialSum(const size_t n) const;
+
+    /*! \brief Query for the sum of all weights.
+     *  \return : The total weight of the tree.
+     */
+    double total() const { return partialSum(values_.size()); }
+
+    /*! \brief Find the slot that owns the point target on the accumulated
+     *         weight axis, i.e. the first slot i for which the sum of
+     *         slots 0 to i is larger than target. Slots with zero weight
+     *         are never returned, also when round-off in the partial sums
+     *         puts the target on one, unless all slots have zero weight.
+     *  \param target : A value on the interval [0.0, total()).
+     *  \return : The selected slot.
+     */
+    size_t search(const double target) const;
+
+    /*! \brief Recalculate all partial sums from the stored weights.
+     *         This removes any accumulated round-off in the tree.
+     */
+    void rebuild();
+
+    /*! \brief Write the weights and partial sums to a checkpoint.
+     *  \param writer : The checkpoint writer.
+     */
+    void saveState(CheckpointWriter & writer) const;
+
+    /*! \brief Read the weights and partial sums written by saveState.
+     *         The partial sums are read as written, with their round-off.
+     *  \param reader : The checkpoint reader.
+     */
+    void loadState(CheckpointReader & reader);
+
+protected:
+
+private:
+
+    /// The weight of each slot.
+    std::vector<double> values_;
+
+    /// The Fenwick tree partial sums, one based indexing.
+    std::vector<double> tree_;
+
+    /// The largest power of two not larger than the size.
+    size_t top_bit_;
+
+};
+
+
+#endif // __SUMTREE__
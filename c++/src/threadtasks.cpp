@@ -0,0 +1,180 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  threadtasks.cpp
+ *  \brief File for the implementation code of the shared memory task runner.
+ */
+
+#include "threadtasks.h"
+
+#include <algorithm>
+
+
+// -----------------------------------------------------------------------------
+//
+ThreadPool::ThreadPool() :
+    threads_(0),
+    task_(NULL),
+    n_tasks_(0),
+    n_workers_(0),
+    next_task_(0),
+    errors_(0),
+    n_running_(0),
+    generation_(0),
+    stop_(false)
+{
+    // NOTHING HERE
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ThreadPool::ThreadPool(const ThreadPool &) :
+    threads_(0),
+    task_(NULL),
+    n_tasks_(0),
+    n_workers_(0),
+    next_task_(0),
+    errors_(0),
+    n_running_(0),
+    generation_(0),
+    stop_(false)
+{
+    // NOTHING HERE
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ThreadPool & ThreadPool::operator=(const ThreadPool &)
+{
+    return *this;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (size_t i = 0; i < threads_.size(); ++i)
+    {
+        threads_[i].join();
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void ThreadPool::run(const int n_threads,
+                     const int n_tasks,
+                     const std::function<void(const int)> & task)
+{
+    const int n_workers = std::min(n_threads, n_tasks);
+    if (n_workers <= 0)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Start the threads not yet in the pool. They take part in this run.
+    while (static_cast<int>(threads_.size()) < n_workers)
+    {
+        threads_.push_back(std::thread(&ThreadPool::work, this, static_cast<int>(threads_.size())));
+    }
+
+    task_      = &task;
+    n_tasks_   = n_tasks;
+    n_workers_ = n_workers;
+    n_running_ = n_workers;
+    next_task_ = 0;
+    errors_.assign(n_tasks, std::exception_ptr());
+    ++generation_;
+    wake_.notify_all();
+
+    done_.wait(lock, [this]() { return n_running_ == 0; });
+    task_ = NULL;
+
+    // Pass the first error on to the caller.
+    for (int t = 0; t < n_tasks; ++t)
+    {
+        if (errors_[t])
+        {
+            std::exception_ptr error = errors_[t];
+            errors_.assign(n_tasks, std::exception_ptr());
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void ThreadPool::work(const int id)
+{
+    unsigned long seen = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        wake_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+        if (stop_)
+        {
+            return;
+        }
+        seen = generation_;
+
+        // Only the first threads of the pool take part in small runs.
+        if (id >= n_workers_)
+        {
+            continue;
+        }
+
+        const std::function<void(const int)> & task = *task_;
+        const int n_tasks = n_tasks_;
+        lock.unlock();
+
+        // Keep any error for the caller, as a task that throws would
+        // otherwise terminate the program.
+        int t;
+        while ((t = next_task_++) < n_tasks)
+        {
+            try
+            {
+                task(t);
+            }
+            catch (...)
+            {
+                errors_[t] = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        if (--n_running_ == 0)
+        {
+            done_.notify_one();
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void runOnThreads(const int n_threads,
+                  const int n_tasks,
+                  const std::function<void(const int)> & task)
+{
+    ThreadPool pool;
+    pool.run(n_threads, n_tasks, task);
+}
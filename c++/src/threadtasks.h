@@ -0,0 +1,150 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*! \file  threadtasks.h
+ *  \brief File for the shared memory task runner interface.
+ */
+
+#ifndef __THREADTASKS__
+#define __THREADTASKS__
+
+#include <functional>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/*! \brief Class for a pool of worker threads that are kept between calls,
+ *         so that work split over threads many times per step does not pay
+ *         for creating and joining the threads each time. The threads are
+ *         started when first needed and joined on destruction. The calling
+ *         thread never runs a task itself, see runOnThreads(). A pool may
+ *         only be run from one thread at the time. An exception thrown by
+ *         a task is passed on to the calling thread.
+ */
+class ThreadPool {
+
+public:
+
+    /*! \brief Default constructor, for a pool without threads.
+     */
+    ThreadPool();
+
+    /*! \brief Copy constructor. The threads are not shared, the copy starts
+     *         its own threads when first run.
+     */
+    ThreadPool(const ThreadPool & other);
+
+    /*! \brief Assignment operator. The threads of this pool are kept.
+     *  \return : A reference to this pool.
+     */
+    ThreadPool & operator=(const ThreadPool & other);
+
+    /*! \brief Destructor, stopping and joining the threads.
+     */
+    ~ThreadPool();
+
+    /*! \brief Run the tasks 0 to n_tasks-1 on up to n_threads threads of
+     *         the pool and wait for all of them to finish. The pool is
+     *         grown to the number of threads used if needed. If any task
+     *         throws, the remaining tasks are still run and the exception
+     *         of the first task that threw is rethrown after all are done.
+     *  \param n_threads : The maximum number of threads to use.
+     *  \param n_tasks   : The number of tasks.
+     *  \param task      : The function to call with each task number.
+     */
+    void run(const int n_threads,
+             const int n_tasks,
+             const std::function<void(const int)> & task);
+
+    /*! \brief Query for the number of started threads.
+     *  \return : The number of threads in the pool.
+     */
+    int size() const { return threads_.size(); }
+
+private:
+
+    /*! \brief The loop of each worker thread, waiting for and running tasks.
+     *  \param id : The number of the thread in the pool.
+     */
+    void work(const int id);
+
+    /// The worker threads.
+    std::vector<std::thread> threads_;
+
+    /// The mutex guarding the state shared with the workers.
+    std::mutex mutex_;
+
+    /// Condition for waking the workers on new tasks or stop.
+    std::condition_variable wake_;
+
+    /// Condition for waking the caller when all workers are done.
+    std::condition_variable done_;
+
+    /// The task of the current run.
+    const std::function<void(const int)> * task_;
+
+    /// The number of tasks of the current run.
+    int n_tasks_;
+
+    /// The number of threads taking part in the current run.
+    int n_workers_;
+
+    /// The next task to hand out.
+    std::atomic<int> next_task_;
+
+    /// The exception thrown by each task of the current run, if any.
+    std::vector<std::exception_ptr> errors_;
+
+    /// The number of workers still running tasks in the current run.
+    int n_running_;
+
+    /// Increased for each run, for the workers to see new tasks.
+    unsigned long generation_;
+
+    /// Flag for stopping the workers.
+    bool stop_;
+
+};
+
+
+
+/*! \brief Run the tasks 0 to n_tasks-1 on up to n_threads new threads and
+ *         wait for all of them to finish. An exception thrown by a task is
+ *         rethrown on the calling thread, see ThreadPool::run(). Use a
+ *         ThreadPool for work that is run repeatedly. The tasks are handed
+ *         out in order, but may complete in any order. The calling thread
+ *         never runs a task itself, so that per-thread state set up in a
+ *         task, e.g. with seedThreadRandom(), does not leak out of the call.
+ *  \param n_threads : The maximum number of threads to use.
+ *  \param n_tasks   : The number of tasks.
+ *  \param task      : The function to call with each task number.
+ */
+void runOnThreads(const int n_threads,
+                  const int n_tasks,
+                  const std::function<void(const int)> & task);
+
+
+/*! \brief Split n_items in n_chunks contiguous chunks of near equal size.
+ *  \param n_items  : The number of items to split.
+ *  \param n_chunks : The number of chunks.
+ *  \param chunk    : The chunk to get the start of, in [0, n_chunks].
+ *  \return : The first item of the chunk, or n_items for chunk n_chunks.
+ */
+inline
+size_t chunkStart(const size_t n_items, const int n_chunks, const int chunk)
+{
+    return n_items * chunk / n_chunks;
+}
+
+
+#endif // __THREADTASKS__
@@ -13,13 +13,15 @@
 #include <iostream>
 #include <cstring>
 #include "typebucket.h"
+#include "allocationcounter.h"
 
 
 // -----------------------------------------------------------------------------
 //
 TypeBucket::TypeBucket() :
     size_(0),
-    raw_data_(NULL)
+    view_(false),
+    raw_data_(inline_data_)
 {
     // NOTHING HERE
 }
@@ -28,10 +30,10 @@ TypeBucket::TypeBucket() :
 // -----------------------------------------------------------------------------
 //
 TypeBucket::TypeBucket(const int size) :
-    size_(size)
+    size_(size),
+    view_(false)
 {
-    raw_data_ = (int*)malloc(sizeof(int)*size_);
-
+    raw_data_ = allocate(size_);
     memset(raw_data_, 0U, sizeof(int)*size_);
 
 }
@@ -40,19 +42,41 @@ TypeBucket::TypeBucket(const int size) :
 // -----------------------------------------------------------------------------
 //
 TypeBucket::TypeBucket(const TypeBucket & other) :
-    size_(other.size_)
+    size_(other.size_),
+    view_(false)
 {
-    raw_data_ = (int*)malloc(sizeof(int)*size_);
+    raw_data_ = allocate(size_);
     memcpy(raw_data_, other.raw_data_, sizeof(int)*size_);
 }
 
 
+// -----------------------------------------------------------------------------
+//
+TypeBucket::TypeBucket(const int * data, const int size) :
+    size_(size),
+    view_(true),
+    raw_data_(const_cast<int*>(data))
+{
+    // NOTHING HERE
+}
+
+
 // -----------------------------------------------------------------------------
 //
 void TypeBucket::operator=(const TypeBucket & other)
 {
-    size_ = other.size_;
-    raw_data_ = (int*)realloc(raw_data_, sizeof(int)*size_);
+    if (this == &other)
+    {
+        return;
+    }
+
+    // Only reallocate if the size changes, and never write through a view.
+    if (size_ != other.size_ || view_)
+    {
+        release();
+        size_ = other.size_;
+        raw_data_ = allocate(size_);
+    }
     memcpy(raw_data_, other.raw_data_, sizeof(int)*size_);
 }
 
@@ -60,7 +84,34 @@ void TypeBucket::operator=(const TypeBucket & other)
 //
 TypeBucket::~TypeBucket()
 {
-    free(raw_data_);
+    release();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+int * TypeBucket::allocate(const int size)
+{
+    if (size <= TYPE_BUCKET_INLINE_SIZE)
+    {
+        return inline_data_;
+    }
+
+    countHeapAllocation();
+    return (int*)malloc(sizeof(int)*size);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+void TypeBucket::release()
+{
+    if (raw_data_ != inline_data_ && !view_)
+    {
+        free(raw_data_);
+    }
+    raw_data_ = inline_data_;
+    view_ = false;
 }
 
 
@@ -21,7 +21,18 @@
 // Forward declarations if any.
 
 
-/*! \brief Class for defining the type bucket data structure.
+/// A bit signature of the types in one or more buckets.
+typedef unsigned long long TypeSignature;
+
+/// The largest bucket size stored inline, without a heap allocation.
+static const int TYPE_BUCKET_INLINE_SIZE = 8;
+
+
+/*! \brief Class for defining the type bucket data structure. Buckets of
+ *         up to TYPE_BUCKET_INLINE_SIZE slots are stored inline, so that
+ *         they can be created and copied without heap allocations, and
+ *         larger buckets on the heap. A bucket may also be a view of slots
+ *         held elsewhere, see TypeBucketArray.
  */
 class TypeBucket {
 
@@ -45,6 +56,14 @@ public:
      */
     TypeBucket(const TypeBucket & other);
 
+    /*! \brief Constructor for a read-only view of slots held elsewhere,
+     *         which must outlive the view. A copy of a view holds its
+     *         slots of its own.
+     *  \param data : Pointer to the first slot.
+     *  \param size : The size of the bucket.
+     */
+    TypeBucket(const int * data, const int size);
+
     // ML
     void operator=(const TypeBucket & other);
 
@@ -110,6 +129,14 @@ public:
     inline
     bool match(const TypeBucket & other) const;
 
+    /*! \brief Get the signature of the occupied slots, with the bit
+     *         (i mod 64) set for each slot i > 0 holding atoms. The
+     *         wildcard slot 0 is not included.
+     *  \return : The signature of the bucket.
+     */
+    inline
+    TypeSignature signature() const;
+
     /*! \brief Element wise addition.
      *  \param other : The other bucket to add.
      *  \return : The element wise addition of this and the other.
@@ -121,15 +148,109 @@ protected:
 
 private:
 
+    /*! \brief Get storage for a number of slots, inline if they fit.
+     *  \param size : The number of slots.
+     *  \return : Pointer to the storage.
+     */
+    int * allocate(const int size);
+
+    /*! \brief Release the storage if it is on the heap.
+     */
+    void release();
+
     /// The size of the bucket.
     int size_;
 
     /// The bucket data field.
     //std::vector<int> data_;
 
-    /// The bucket raw data field.
+    /// If the raw data is held elsewhere.
+    bool view_;
+
+    /// The bucket raw data field, pointing to the inline or heap storage,
+    /// or to the slots of a view.
     int * raw_data_;
 
+    /// The inline storage for small buckets.
+    int inline_data_[TYPE_BUCKET_INLINE_SIZE];
+
+};
+
+
+/*! \brief Class for a read-only view of the type buckets of a number of
+ *         sites, held one bucket after the other in a flat array of type
+ *         counts, e.g. the type counts of a SiteStorage. The buckets are
+ *         returned as views of the counts, without copying them. The
+ *         buckets of sites holding a single atom each may instead be given
+ *         by the type of the atom at each site, and are then set up on
+ *         access.
+ */
+class TypeBucketArray {
+
+public:
+
+    /*! \brief Constructor.
+     *  \param counts    : Pointer to the first count of the first bucket,
+     *                     which must outlive the array and its buckets.
+     *  \param n_buckets : The number of buckets.
+     *  \param n_types   : The number of slots of each bucket.
+     */
+    TypeBucketArray(const int * counts, const size_t n_buckets, const int n_types) :
+        counts_(counts),
+        single_types_(NULL),
+        n_buckets_(n_buckets),
+        n_types_(n_types)
+    {}
+
+    /*! \brief Constructor for buckets holding a single atom each.
+     *  \param single_types : Pointer to the type of the atom in the first
+     *                        bucket, which must outlive the array.
+     *  \param n_buckets    : The number of buckets.
+     *  \param n_types      : The number of slots of each bucket.
+     */
+    TypeBucketArray(const unsigned char * single_types, const size_t n_buckets, const int n_types) :
+        counts_(NULL),
+        single_types_(single_types),
+        n_buckets_(n_buckets),
+        n_types_(n_types)
+    {}
+
+    /*! \brief Query for the number of buckets.
+     *  \return : The number of buckets.
+     */
+    size_t size() const { return n_buckets_; }
+
+    /*! \brief Access operator.
+     *  \param i : The bucket to access.
+     *  \return : A view of the bucket, or a bucket with the single atom
+     *             of the site.
+     */
+    inline
+    const TypeBucket operator[](const size_t i) const;
+
+    /*! \brief Check if the arrays hold the same buckets.
+     *  \param other : The array to compare with.
+     *  \return : True if all counts are equal.
+     */
+    inline
+    bool operator==(const TypeBucketArray & other) const;
+
+protected:
+
+private:
+
+    /// The counts of all buckets, or NULL.
+    const int * counts_;
+
+    /// The type of the single atom of each bucket, or NULL.
+    const unsigned char * single_types_;
+
+    /// The number of buckets.
+    size_t n_buckets_;
+
+    /// The number of slots of each bucket.
+    int n_types_;
+
 };
 
 
@@ -235,6 +356,22 @@ bool TypeBucket::match(const TypeBucket & other) const
 }
 
 
+// -----------------------------------------------------------------------------
+//
+TypeSignature TypeBucket::signature() const
+{
+    TypeSignature signature = 0;
+    for (int i = 1; i < size_; ++i)
+    {
+        if (raw_data_[i] > 0)
+        {
+            signature |= static_cast<TypeSignature>(1) << (i % 64);
+        }
+    }
+    return signature;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 TypeBucket TypeBucket::add(const TypeBucket & other) const
@@ -268,6 +405,46 @@ bool TypeBucket::lessThan(const TypeBucket & other) const
 }
 
 
+// -----------------------------------------------------------------------------
+//
+const TypeBucket TypeBucketArray::operator[](const size_t i) const
+{
+    if (single_types_ != NULL)
+    {
+        TypeBucket bucket(n_types_);
+        bucket[single_types_[i]] = 1;
+        return bucket;
+    }
+    return TypeBucket(counts_ + i * n_types_, n_types_);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+bool TypeBucketArray::operator==(const TypeBucketArray & other) const
+{
+    if (n_buckets_ != other.n_buckets_ || n_types_ != other.n_types_)
+    {
+        return false;
+    }
+
+    if (counts_ != NULL && other.counts_ != NULL)
+    {
+        return std::memcmp(counts_, other.counts_, n_buckets_ * n_types_ * sizeof(int)) == 0;
+    }
+
+    for (size_t i = 0; i < n_buckets_; ++i)
+    {
+        if (!(*this)[i].identical(other[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 // -----------------------------------------------------------------------------
 // NON-MEMBER FUNCTION DECLARATIONS FOLLOW.
 // -----------------------------------------------------------------------------
@@ -10,8 +10,10 @@
 // Include the tests.
 #include "test_latticemodel.h"
 #include "test_configuration.h"
+#include "test_checkpoint.h"
 #include "test_latticemap.h"
 #include "test_process.h"
+#include "test_processtrie.h"
 #include "test_customrateprocess.h"
 #include "test_interactions.h"
 #include "test_coordinate.h"
@@ -20,21 +22,33 @@
 #include "test_matcher.h"
 #include "test_random.h"
 #include "test_simulationtimer.h"
+#include "test_sitematchtable.h"
+#include "test_sitestorage.h"
+#include "test_slotmap.h"
 #include "test_ratecalculator.h"
 #include "test_mpicommons.h"
 #include "test_mpiroutines.h"
 #include "test_ontheflymsd.h"
+#include "test_packedtypes.h"
 #include "test_blocker.h"
 #include "test_hash.h"
 #include "test_ratetable.h"
+#include "test_compositionrejection.h"
+#include "test_ensemble.h"
+#include "test_sublatticemodel.h"
+#include "test_sumtree.h"
+#include "test_threadtasks.h"
 #include "test_typebucket.h"
 
 // -------------------------------------------------------------------------- //
 // Add tests.
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Blocker );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_Checkpoint );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_CompositionRejection );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Configuration );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Coordinate );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_CustomRateProcess );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_Ensemble );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Hash );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Interactions );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_LatticeMap );
@@ -45,9 +59,17 @@ CPPUNIT_TEST_SUITE_REGISTRATION( Test_MatchList );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_MatchListEntry );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Matcher );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_OnTheFlyMSD );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_PackedTypes );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Process );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_ProcessTrie );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_Random );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_RateCalculator );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_RateTable );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_SimulationTimer );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_SiteMatchTable );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_SiteStorage );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_SlotMap );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_SublatticeModel );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_SumTree );
+CPPUNIT_TEST_SUITE_REGISTRATION( Test_ThreadTasks );
 CPPUNIT_TEST_SUITE_REGISTRATION( Test_TypeBucket );
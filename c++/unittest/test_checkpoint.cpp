@@ -0,0 +1,169 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_checkpoint.h"
+
+// Include the files to test.
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+
+
+// -------------------------------------------------------------------------- //
+// Check if a file exists.
+static bool fileExists(const std::string & path)
+{
+    std::ifstream file(path.c_str());
+    return file.good();
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Checkpoint::testRoundTrip()
+{
+    const std::string path = "test_checkpoint_round_trip.kmc";
+
+    // Write values, vectors and sections.
+    {
+        CheckpointWriter writer(path);
+        writer.section("ABCD");
+        writer.write(12);
+        writer.write(3.25);
+        writer.write(true);
+
+        std::vector<double> values;
+        values.push_back(1.0);
+        values.push_back(-2.5);
+        values.push_back(1.0e-300);
+        writer.writeVector(values);
+
+        writer.section("EFGH");
+        writer.writeVector(std::vector<int>());
+        writer.write(-7L);
+        writer.close();
+    }
+
+    // The temporary file is gone after the close.
+    CPPUNIT_ASSERT( fileExists(path) );
+    CPPUNIT_ASSERT( !fileExists(path + ".tmp") );
+
+    // Read them back.
+    {
+        CheckpointReader reader(path);
+        reader.section("ABCD");
+        CPPUNIT_ASSERT_EQUAL( reader.read<int>(), 12 );
+        CPPUNIT_ASSERT_EQUAL( reader.read<double>(), 3.25 );
+        CPPUNIT_ASSERT( reader.read<bool>() );
+
+        std::vector<double> values(7, 0.0);
+        reader.readVector(values);
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(values.size()), 3 );
+        CPPUNIT_ASSERT_EQUAL( values[0], 1.0 );
+        CPPUNIT_ASSERT_EQUAL( values[1], -2.5 );
+        CPPUNIT_ASSERT_EQUAL( values[2], 1.0e-300 );
+
+        reader.section("EFGH");
+        std::vector<int> empty(3, 1);
+        reader.readVector(empty);
+        CPPUNIT_ASSERT( empty.empty() );
+        CPPUNIT_ASSERT_EQUAL( reader.read<long>(), -7L );
+
+        // Everything is read.
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(reader.remaining()), 0 );
+
+        // Reading past the end throws.
+        CPPUNIT_ASSERT_THROW( reader.read<int>(), std::runtime_error );
+    }
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Checkpoint::testSectionMismatch()
+{
+    const std::string path = "test_checkpoint_section.kmc";
+    {
+        CheckpointWriter writer(path);
+        writer.section("ABCD");
+        writer.write(1);
+        writer.close();
+    }
+
+    CheckpointReader reader(path);
+    CPPUNIT_ASSERT_THROW( reader.section("ABCE"), std::runtime_error );
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Checkpoint::testBadFiles()
+{
+    // A missing file.
+    CPPUNIT_ASSERT_THROW( CheckpointReader reader("test_checkpoint_missing.kmc"),
+                          std::runtime_error );
+
+    // A file that is not a checkpoint.
+    const std::string path = "test_checkpoint_bad.kmc";
+    {
+        std::ofstream file(path.c_str());
+        file << "Not a checkpoint file at all.";
+    }
+    CPPUNIT_ASSERT_THROW( CheckpointReader reader(path), std::runtime_error );
+
+    // An empty file.
+    {
+        std::ofstream file(path.c_str());
+    }
+    CPPUNIT_ASSERT_THROW( CheckpointReader reader(path), std::runtime_error );
+
+    // A vector with a size past the end of the file.
+    {
+        CheckpointWriter writer(path);
+        writer.write(1000UL);
+        writer.write(1.0);
+        writer.close();
+    }
+    {
+        CheckpointReader reader(path);
+        std::vector<double> values;
+        CPPUNIT_ASSERT_THROW( reader.readVector(values), std::runtime_error );
+    }
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Checkpoint::testUnclosedWriter()
+{
+    // A writer that is never closed leaves the old file in place.
+    const std::string path = "test_checkpoint_unclosed.kmc";
+    {
+        CheckpointWriter writer(path);
+        writer.write(1);
+        writer.close();
+    }
+    {
+        CheckpointWriter writer(path);
+        writer.write(2);
+    }
+
+    CPPUNIT_ASSERT( !fileExists(path + ".tmp") );
+    CheckpointReader reader(path);
+    CPPUNIT_ASSERT_EQUAL( reader.read<int>(), 1 );
+
+    std::remove(path.c_str());
+}
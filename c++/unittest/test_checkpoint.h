@@ -0,0 +1,39 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_CHECKPOINT__
+#define __TEST_CHECKPOINT__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_Checkpoint : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_Checkpoint );
+    CPPUNIT_TEST( testRoundTrip );
+    CPPUNIT_TEST( testSectionMismatch );
+    CPPUNIT_TEST( testBadFiles );
+    CPPUNIT_TEST( testUnclosedWriter );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testRoundTrip();
+    void testSectionMismatch();
+    void testBadFiles();
+    void testUnclosedWriter();
+};
+
+#endif
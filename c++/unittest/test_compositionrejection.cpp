@@ -0,0 +1,169 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_compositionrejection.h"
+
+// Include the files to test.
+#include "compositionrejection.h"
+
+#include "random.h"
+
+#include <stdexcept>
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_CompositionRejection::testConstruction()
+{
+    // Default construction gives an empty structure.
+    CompositionRejection cr;
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(cr.size()), 0 );
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), 0.0, 1.0e-14 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_CompositionRejection::testPushUpdateAndPop()
+{
+    CompositionRejection cr;
+    const double values[6] = {1.0, 0.5, 0.0, 3.25, 2.0, 7.0};
+    double ref = 0.0;
+    for (int i = 0; i < 6; ++i)
+    {
+        cr.push_back(values[i]);
+        ref += values[i];
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), ref, 1.0e-12 );
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(cr.size()), 6 );
+
+    for (int i = 0; i < 6; ++i)
+    {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.value(i), values[i], 1.0e-14 );
+    }
+
+    // Update a slot to zero and one from zero.
+    cr.update(3, 0.0);
+    cr.update(2, 1.5);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), ref - 3.25 + 1.5, 1.0e-12 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.value(2), 1.5, 1.0e-14 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.value(3), 0.0, 1.0e-14 );
+
+    // Pop the last two.
+    cr.pop_back();
+    cr.pop_back();
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(cr.size()), 4 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), 1.0 + 0.5 + 1.5, 1.0e-12 );
+
+    // A rebuild does not change the total.
+    cr.rebuild();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), 3.0, 1.0e-12 );
+
+    // Clear.
+    cr.clear();
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(cr.size()), 0 );
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), 0.0, 1.0e-14 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_CompositionRejection::testClasses()
+{
+    CompositionRejection cr;
+
+    // 1.0 and 1.5 share the class [1,2), 2.0 and 3.9 share [2,4).
+    cr.push_back(1.0);
+    cr.push_back(1.5);
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 1 );
+    cr.push_back(2.0);
+    cr.push_back(3.9);
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 2 );
+
+    // Zero weights do not belong to any class.
+    cr.push_back(0.0);
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 2 );
+
+    // A very small weight gives a new class.
+    cr.push_back(1.0e-9);
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 3 );
+
+    // Moving the small weight to zero empties its class.
+    cr.update(5, 0.0);
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 2 );
+
+    // Moving both weights out of [1,2) empties that class.
+    cr.update(0, 2.5);
+    cr.update(1, 3.0);
+    CPPUNIT_ASSERT_EQUAL( cr.nClasses(), 1 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( cr.total(), 2.5 + 3.0 + 2.0 + 3.9, 1.0e-12 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_CompositionRejection::testPickDistribution()
+{
+    // Setup weights spread over several orders of magnitude.
+    CompositionRejection cr;
+    cr.push_back(1.0);
+    cr.push_back(40.0);
+    cr.push_back(0.0);
+    cr.push_back(20.0);
+    cr.push_back(0.03);
+    cr.push_back(38.97);
+
+    seedRandom(false, 113);
+    std::vector<int> picked(6, 0);
+    const int n_loop = 1000000;
+    for (int i = 0; i < n_loop; ++i)
+    {
+        ++picked[cr.pick()];
+    }
+
+    // The slots should be picked proportional to their weights.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[0]/n_loop, 0.01, 1.0e-3 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[1]/n_loop, 0.40, 1.0e-2 );
+    CPPUNIT_ASSERT_EQUAL( picked[2], 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[3]/n_loop, 0.20, 1.0e-2 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[4]/n_loop, 0.0003, 1.0e-4 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[5]/n_loop, 0.3897, 1.0e-2 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_CompositionRejection::testPickEmpty()
+{
+    // Picking from an empty structure throws.
+    CompositionRejection cr;
+    CPPUNIT_ASSERT_THROW( cr.pick(), std::runtime_error );
+
+    // So does picking when all weights are zero.
+    cr.push_back(0.0);
+    cr.push_back(0.0);
+    CPPUNIT_ASSERT_THROW( cr.pick(), std::runtime_error );
+
+    // A single non-zero weight is always picked.
+    cr.update(1, 2.5);
+    for (int i = 0; i < 100; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(cr.pick()), 1 );
+    }
+
+    // Setting it back to zero, or removing it, leaves nothing to pick.
+    cr.update(1, 0.0);
+    CPPUNIT_ASSERT_THROW( cr.pick(), std::runtime_error );
+
+    cr.update(1, 3.0);
+    cr.pop_back();
+    CPPUNIT_ASSERT_THROW( cr.pick(), std::runtime_error );
+}
@@ -15,6 +15,10 @@
 #include "latticemap.h"
 #include "process.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
 // -------------------------------------------------------------------------- //
 //
 void Test_Configuration::testConstruction()
@@ -60,7 +64,7 @@ void Test_Configuration::testConstruction()
 
 
     // Extract the member data and check that it is the same as what whent in.
-    std::vector<Coordinate> const & ret_coords = config.coordinates();
+    SiteArray<Coordinate> const & ret_coords = config.coordinates();
     CPPUNIT_ASSERT_EQUAL(static_cast<int>(ret_coords.size()),
                          static_cast<int>(coords.size()));
 
@@ -474,7 +478,7 @@ void Test_Configuration::testPerformProcessVectors()
     p.addSite(1434, 0.0);
 
     // Check that the atom ID's and coordinates are unchanged.
-    const std::vector<int> & atom_id = configuration.atomID();
+    const SiteArray<int> & atom_id = configuration.atomID();
     CPPUNIT_ASSERT_EQUAL( static_cast<int>(atom_id.size()),
                           static_cast<int>(configuration.elements().size()) );
 
@@ -585,7 +589,7 @@ void Test_Configuration::testAtomID()
     Configuration configuration(coords, elements, possible_types);
 
     // Check that the atom ID's are unchanged.
-    const std::vector<int> & atom_id = configuration.atomID();
+    const SiteArray<int> & atom_id = configuration.atomID();
     CPPUNIT_ASSERT_EQUAL( static_cast<int>(atom_id.size()),
                           static_cast<int>(configuration.elements().size()) );
 
@@ -1337,3 +1341,510 @@ void Test_Configuration::testParticlesPerType()
 
     // DONE
 }
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Configuration::testMatchListSignature()
+{
+    // Setup a periodic chain.
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 3;
+
+    const std::string chain = "AAAABAAAAC";
+    std::vector<std::vector<double> > coordinates(chain.size(), std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    Configuration config(coordinates, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = chain.size();
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // The signature holds the types within one cell of each site.
+    const TypeSignature a = 2;
+    const TypeSignature b = 4;
+    const TypeSignature c = 8;
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(0), a | c );
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(2), a );
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(3), a | b );
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(4), a | b );
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(9), a | c );
+
+    // Perform a process that turns the B into a C.
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    const Configuration first(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "B")), possible_types);
+    const Configuration second(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "C")), possible_types);
+    Process process(first, second, 1.0, std::vector<int>(1, 0));
+    config.performBucketProcess(process, 4, lattice_map);
+
+    // The entries of the match lists follow the types right away.
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        const ConfigBucketMatchList & match_list = config.configMatchList(i);
+        for (size_t j = 0; j < match_list.size(); ++j)
+        {
+            CPPUNIT_ASSERT( match_list[j].match_types == config.types()[match_list[j].index] );
+        }
+    }
+
+    // The signatures follow the match lists when they are updated.
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(3), a | b );
+    config.updateMatchList(3);
+    config.updateMatchList(4);
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(3), a | c );
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(4), a | c );
+    CPPUNIT_ASSERT_EQUAL( config.matchListSignature(3), presentTypes(config.configMatchList(3)) );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Configuration::testPackedMatchTypes()
+{
+    // Setup a periodic chain.
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    const std::string chain = "AAABAA";
+    std::vector<std::vector<double> > coordinates(chain.size(), std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    Configuration config(coordinates, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = chain.size();
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // The packed types hold the types of each match list.
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        PackedTypes packed;
+        CPPUNIT_ASSERT( packMatchTypes(config.configMatchList(i), packed) );
+        CPPUNIT_ASSERT( config.packedMatchTypes(i) == packed );
+    }
+
+    // The B at the center of its match list.
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(config.packedMatchTypes(3)[0]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(config.packedMatchTypes(3)[1]), 1 );
+
+    // Perform a process that turns the B into an A.
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    const Configuration first(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "B")), possible_types);
+    const Configuration second(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "A")), possible_types);
+    Process process(first, second, 1.0, std::vector<int>(1, 0));
+    config.performBucketProcess(process, 3, lattice_map);
+
+    // The packed types follow the types as they change.
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(config.packedMatchTypes(3)[0]), 1 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(config.packedMatchTypes(3)[1]), 0 );
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        PackedTypes packed;
+        CPPUNIT_ASSERT( packMatchTypes(config.configMatchList(i), packed) );
+        CPPUNIT_ASSERT( config.packedMatchTypes(i) == packed );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Configuration::testSingleOccupancy()
+{
+    // Setup a periodic chain.
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    const std::string chain = "AAABAA";
+    std::vector<std::vector<double> > coordinates(chain.size(), std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    Configuration config(coordinates, elements, possible_types);
+    CPPUNIT_ASSERT( !config.singleOccupancy() );
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = chain.size();
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // Setting the mode releases the packed match lists, and the types of
+    // each match list are gathered from the single type of each site.
+    CPPUNIT_ASSERT( config.setSingleOccupancy(true) );
+    CPPUNIT_ASSERT( config.singleOccupancy() );
+    PackedTypes site_types;
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        PackedTypes packed;
+        CPPUNIT_ASSERT( packSiteTypes(config.configMatchList(i), packed) );
+        config.siteMatchTypes(i, site_types);
+        CPPUNIT_ASSERT( site_types == packed );
+    }
+
+    // The B at the center of its match list.
+    config.siteMatchTypes(3, site_types);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(site_types[0]), 2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(site_types[1]), 1 );
+    config.siteMatchTypes(2, site_types);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(site_types[0]), 1 );
+
+    // Perform a process that turns the B into an A.
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    const Configuration first(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "B")), possible_types);
+    const Configuration second(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "A")), possible_types);
+    Process process(first, second, 1.0, std::vector<int>(1, 0));
+    config.performBucketProcess(process, 3, lattice_map);
+
+    // The single types follow the types as they change.
+    CPPUNIT_ASSERT( config.singleOccupancy() );
+    config.siteMatchTypes(3, site_types);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(site_types[0]), 1 );
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        PackedTypes packed;
+        CPPUNIT_ASSERT( packSiteTypes(config.configMatchList(i), packed) );
+        config.siteMatchTypes(i, site_types);
+        CPPUNIT_ASSERT( site_types == packed );
+    }
+
+    // The types, the elements and the particles per type are set up from
+    // the single types.
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        CPPUNIT_ASSERT( config.types()[i] == 1 );
+        CPPUNIT_ASSERT( config.siteTypes(i) == 1 );
+        CPPUNIT_ASSERT_EQUAL( config.firstType(i), 1 );
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(config.elements()[i].size()), 1 );
+        CPPUNIT_ASSERT_EQUAL( config.elements()[i][0], std::string("A") );
+    }
+    CPPUNIT_ASSERT_EQUAL( config.particlesPerType()[1], 6 );
+    CPPUNIT_ASSERT_EQUAL( config.particlesPerType()[2], 0 );
+
+    // A process that puts a second atom on a site leaves the mode, and
+    // the match lists are packed with one lane per type again.
+    std::vector<std::vector<std::string> > two_atoms(1, std::vector<std::string>(1, "A"));
+    two_atoms[0].push_back("B");
+    const Configuration bucket_second(process_coordinates, two_atoms, possible_types);
+    const Configuration bucket_first(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "A")), possible_types);
+    Process bucket_process(bucket_first, bucket_second, 1.0, std::vector<int>(1, 0));
+    config.performBucketProcess(bucket_process, 3, lattice_map);
+
+    CPPUNIT_ASSERT( !config.singleOccupancy() );
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        PackedTypes packed;
+        CPPUNIT_ASSERT( packMatchTypes(config.configMatchList(i), packed) );
+        CPPUNIT_ASSERT( config.packedMatchTypes(i) == packed );
+    }
+
+    // The type counts are restored from the single types before the
+    // process is performed.
+    CPPUNIT_ASSERT_EQUAL( config.types()[3][1], 1 );
+    CPPUNIT_ASSERT_EQUAL( config.types()[3][2], 1 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(config.elements()[3].size()), 2 );
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        if (i != 3)
+        {
+            CPPUNIT_ASSERT( config.types()[i] == 1 );
+            CPPUNIT_ASSERT_EQUAL( config.firstType(i), 1 );
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( config.particlesPerType()[1], 6 );
+    CPPUNIT_ASSERT_EQUAL( config.particlesPerType()[2], 1 );
+
+    // The mode can not be set with more than one atom at a site.
+    CPPUNIT_ASSERT( !config.setSingleOccupancy(true) );
+    CPPUNIT_ASSERT( !config.singleOccupancy() );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Configuration::testMatchListGeometry()
+{
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    // Setup a 6x5 square lattice with two basis sites, periodic along a
+    // and not along b.
+    const int nI = 6;
+    const int nJ = 5;
+    const int n_basis = 2;
+    std::vector<std::vector<double> > coordinates;
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < nI; ++i)
+    {
+        for (int j = 0; j < nJ; ++j)
+        {
+            for (int b = 0; b < n_basis; ++b)
+            {
+                std::vector<double> c(3, 0.0);
+                c[0] = i + 0.5 * b;
+                c[1] = j + 0.5 * b;
+                coordinates.push_back(c);
+                elements.push_back(std::vector<std::string>(1, ((i + j + b) % 3 == 0) ? "B" : "A"));
+            }
+        }
+    }
+    Configuration config(coordinates, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = nI;
+    repetitions[1] = nJ;
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(n_basis, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // Each basis site has one geometry in the bulk and one at each of
+    // the two non-periodic edges.
+    CPPUNIT_ASSERT_EQUAL( config.nMatchListGeometries(), 3 * n_basis );
+
+    // The match lists combine the shared geometry with the indices and
+    // types of each site, and are the same as when calculated directly.
+    for (size_t index = 0; index < coordinates.size(); ++index)
+    {
+        const std::vector<int> neighbourhood = lattice_map.neighbourIndices(index, 1);
+        const ConfigBucketMatchList reference = config.configMatchList(index, neighbourhood, lattice_map);
+        const ConfigBucketMatchList match_list = config.configMatchList(index);
+
+        CPPUNIT_ASSERT_EQUAL( match_list.size(), reference.size() );
+        CPPUNIT_ASSERT_EQUAL( config.matchListGeometry(index).size(), reference.size() );
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL( match_list[i].index, reference[i].index );
+            CPPUNIT_ASSERT_EQUAL( config.matchListIndices(index)[i], reference[i].index );
+            CPPUNIT_ASSERT( samePoint(match_list[i], reference[i]) );
+            CPPUNIT_ASSERT( samePoint(config.matchListGeometry(index)[i], reference[i]) );
+            CPPUNIT_ASSERT( match_list[i].match_types == reference[i].match_types );
+        }
+    }
+
+    // Setting up the match lists on several threads gives the same.
+    for (int n_threads = 2; n_threads <= 7; n_threads += 5)
+    {
+        Configuration threaded(coordinates, elements, possible_types);
+        threaded.initMatchLists(lattice_map, 1, n_threads);
+        CPPUNIT_ASSERT_EQUAL( threaded.nMatchListGeometries(), config.nMatchListGeometries() );
+
+        for (size_t index = 0; index < coordinates.size(); ++index)
+        {
+            const ConfigBucketMatchList & geometry = config.matchListGeometry(index);
+            const size_t n_entries = geometry.size();
+            CPPUNIT_ASSERT_EQUAL( threaded.matchListGeometry(index).size(), n_entries );
+            for (size_t i = 0; i < n_entries; ++i)
+            {
+                CPPUNIT_ASSERT( samePoint(threaded.matchListGeometry(index)[i], geometry[i]) );
+            }
+            CPPUNIT_ASSERT( std::equal(config.matchListIndices(index),
+                                       config.matchListIndices(index) + n_entries,
+                                       threaded.matchListIndices(index)) );
+            CPPUNIT_ASSERT_EQUAL( threaded.matchListSignature(index), config.matchListSignature(index) );
+            CPPUNIT_ASSERT( threaded.packedMatchTypes(index) == config.packedMatchTypes(index) );
+        }
+    }
+
+    // The match lists follow the types at their sites.
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    const Configuration first(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "B")), possible_types);
+    const Configuration second(process_coordinates, std::vector<std::vector<std::string> >(1, std::vector<std::string>(1, "A")), possible_types);
+    Process process(first, second, 1.0, std::vector<int>(1, 0));
+    config.performBucketProcess(process, 0, lattice_map);
+    CPPUNIT_ASSERT_EQUAL( config.types()[0][1], 1 );
+
+    for (size_t index = 0; index < coordinates.size(); ++index)
+    {
+        const ConfigBucketMatchList match_list = config.configMatchList(index);
+        for (size_t i = 0; i < match_list.size(); ++i)
+        {
+            CPPUNIT_ASSERT( match_list[i].match_types == config.types()[match_list[i].index] );
+        }
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Configuration::testLazyElements()
+{
+    // Setup a periodic chain, with two atoms at the last site.
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    const std::string chain = "AAABAA";
+    std::vector<std::vector<double> > coordinates(chain.size(), std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    elements[5].insert(elements[5].begin(), "B");
+    Configuration config(coordinates, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = chain.size();
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // The atom id types and the first types are given by the first
+    // element at each site.
+    CPPUNIT_ASSERT_EQUAL( config.firstType(0), 1 );
+    CPPUNIT_ASSERT_EQUAL( config.firstType(3), 2 );
+    CPPUNIT_ASSERT_EQUAL( config.firstType(5), 2 );
+    CPPUNIT_ASSERT_EQUAL( config.atomIDTypes()[5], 2 );
+    CPPUNIT_ASSERT_EQUAL( config.atomIDElements()[5], std::string("B") );
+    CPPUNIT_ASSERT( config.elements() == elements );
+
+    // Perform a process that turns the B into an A, and one that turns
+    // the first A into a B, without querying the elements in between.
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    const std::vector<std::vector<std::string> > a(1, std::vector<std::string>(1, "A"));
+    const std::vector<std::vector<std::string> > b(1, std::vector<std::string>(1, "B"));
+    const Configuration config_a(process_coordinates, a, possible_types);
+    const Configuration config_b(process_coordinates, b, possible_types);
+    Process b_to_a(config_b, config_a, 1.0, std::vector<int>(1, 0));
+    Process a_to_b(config_a, config_b, 1.0, std::vector<int>(1, 0));
+    config.performBucketProcess(b_to_a, 3, lattice_map);
+    config.performBucketProcess(a_to_b, 0, lattice_map);
+
+    // The integer types are updated directly.
+    CPPUNIT_ASSERT_EQUAL( config.firstType(0), 2 );
+    CPPUNIT_ASSERT_EQUAL( config.firstType(3), 1 );
+    CPPUNIT_ASSERT_EQUAL( config.atomIDTypes()[0], 2 );
+    CPPUNIT_ASSERT_EQUAL( config.atomIDTypes()[3], 1 );
+
+    // The elements are brought up to date on query.
+    elements[0][0] = "B";
+    elements[3][0] = "A";
+    CPPUNIT_ASSERT( config.elements() == elements );
+
+    const std::vector<std::string> & atom_id_elements = config.atomIDElements();
+    CPPUNIT_ASSERT_EQUAL( atom_id_elements[0], std::string("B") );
+    CPPUNIT_ASSERT_EQUAL( atom_id_elements[1], std::string("A") );
+    CPPUNIT_ASSERT_EQUAL( atom_id_elements[3], std::string("A") );
+    CPPUNIT_ASSERT_EQUAL( atom_id_elements[5], std::string("B") );
+
+    // Changing a site back and forth gives the same elements.
+    config.performBucketProcess(a_to_b, 3, lattice_map);
+    config.performBucketProcess(b_to_a, 3, lattice_map);
+    CPPUNIT_ASSERT( config.elements() == elements );
+    CPPUNIT_ASSERT_EQUAL( config.atomIDElements()[3], std::string("A") );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Configuration::testSiteStorage()
+{
+    // Setup a periodic chain, with two atoms at the last site.
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    const std::string chain = "AAABAA";
+    std::vector<std::vector<double> > coordinates(chain.size(), std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        coordinates[i][0] = i;
+        coordinates[i][1] = 0.5 * i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    elements[5].push_back("B");
+    const Configuration config(coordinates, elements, possible_types);
+    CPPUNIT_ASSERT( !config.mapped() );
+
+    // Write the storage file and set up a configuration mapping it.
+    const std::string path = "test_configuration_storage.kmc";
+    config.writeStorage(path);
+    Configuration mapped(path, possible_types);
+    CPPUNIT_ASSERT( mapped.mapped() );
+
+    CPPUNIT_ASSERT( mapped.coordinates() == config.coordinates() );
+    CPPUNIT_ASSERT( mapped.atomIDCoordinates() == config.atomIDCoordinates() );
+    CPPUNIT_ASSERT( mapped.atomID() == config.atomID() );
+    CPPUNIT_ASSERT( mapped.atomIDTypes() == config.atomIDTypes() );
+    CPPUNIT_ASSERT( mapped.types() == config.types() );
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( mapped.firstType(i), config.firstType(i) );
+    }
+
+    // The elements are set up from the types on query.
+    CPPUNIT_ASSERT( mapped.elements() == elements );
+    CPPUNIT_ASSERT( mapped.atomIDElements() == config.atomIDElements() );
+
+    // Perform a process on the mapped configuration.
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = chain.size();
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    mapped.initMatchLists(lattice_map, 1);
+
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    const std::vector<std::vector<std::string> > a(1, std::vector<std::string>(1, "A"));
+    const std::vector<std::vector<std::string> > b(1, std::vector<std::string>(1, "B"));
+    const Configuration config_a(process_coordinates, a, possible_types);
+    const Configuration config_b(process_coordinates, b, possible_types);
+    Process a_to_b(config_a, config_b, 1.0, std::vector<int>(1, 0));
+    mapped.performBucketProcess(a_to_b, 1, lattice_map);
+
+    elements[1][0] = "B";
+    CPPUNIT_ASSERT( mapped.elements() == elements );
+    CPPUNIT_ASSERT_EQUAL( mapped.atomIDTypes()[1], 2 );
+    CPPUNIT_ASSERT_EQUAL( mapped.atomIDElements()[1], std::string("B") );
+
+    // The file is not changed, and a storage written from the mapped
+    // configuration has the new types.
+    const Configuration reread(path, possible_types);
+    CPPUNIT_ASSERT( reread.types() == config.types() );
+
+    const std::string changed_path = "test_configuration_storage_changed.kmc";
+    mapped.writeStorage(changed_path);
+    const Configuration changed(changed_path, possible_types);
+    CPPUNIT_ASSERT( changed.types() == mapped.types() );
+    CPPUNIT_ASSERT( changed.elements() == elements );
+
+    // The storage file must have the same number of types.
+    possible_types["C"] = 3;
+    CPPUNIT_ASSERT_THROW( Configuration(path, possible_types), std::runtime_error );
+
+    std::remove(path.c_str());
+    std::remove(changed_path.c_str());
+}
@@ -34,6 +34,12 @@ public:
     CPPUNIT_TEST( testAtomIDElementsCoordinatesMovedIDs );
     CPPUNIT_TEST( testUpdateInfo );
     CPPUNIT_TEST( testParticlesPerType );
+    CPPUNIT_TEST( testMatchListSignature );
+    CPPUNIT_TEST( testPackedMatchTypes );
+    CPPUNIT_TEST( testSingleOccupancy );
+    CPPUNIT_TEST( testMatchListGeometry );
+    CPPUNIT_TEST( testLazyElements );
+    CPPUNIT_TEST( testSiteStorage );
     CPPUNIT_TEST_SUITE_END();
 
     void testConstruction();
@@ -46,6 +52,12 @@ public:
     void testTypeNameQuery();
     void testUpdateInfo();
     void testParticlesPerType();
+    void testMatchListSignature();
+    void testPackedMatchTypes();
+    void testSingleOccupancy();
+    void testMatchListGeometry();
+    void testLazyElements();
+    void testSiteStorage();
 
 };
 
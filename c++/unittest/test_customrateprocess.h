@@ -31,6 +31,7 @@ public:
     CPPUNIT_TEST( testAddAndRemoveSite );
     CPPUNIT_TEST( testPickSite );
     CPPUNIT_TEST( testPickSiteMultiplicity );
+    CPPUNIT_TEST( testPickSiteAfterUpdates );
     CPPUNIT_TEST( testAffectedIndices );
     CPPUNIT_TEST( testCutoffAndRange );
     CPPUNIT_TEST( testProcessNumber );
@@ -44,6 +45,7 @@ public:
     void testAddAndRemoveSite();
     void testPickSite();
     void testPickSiteMultiplicity();
+    void testPickSiteAfterUpdates();
     void testAffectedIndices();
     void testCutoffAndRange();
     void testProcessNumber();
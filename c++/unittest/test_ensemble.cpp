@@ -0,0 +1,294 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_ensemble.h"
+
+// Include the files to test.
+#include "ensemble.h"
+
+// Other inclusions.
+#include "latticemodel.h"
+#include "configuration.h"
+#include "latticemap.h"
+#include "interactions.h"
+#include "random.h"
+#include "simulationtimer.h"
+#include "customrateprocess.h"
+#include "ratecalculator.h"
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+
+// -------------------------------------------------------------------------- //
+// Setup the possible types for the tests below.
+static std::map<std::string, int> possibleTypes()
+{
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["V"] = 2;
+    return possible_types;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup the coordinates of an n x n square lattice.
+static std::vector<std::vector<double> > squareCoordinates(const int n)
+{
+    std::vector<std::vector<double> > coordinates;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> c(3, 0.0);
+            c[0] = i;
+            c[1] = j;
+            coordinates.push_back(c);
+        }
+    }
+    return coordinates;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup a random half filling of A atoms among vacancies.
+static std::vector<std::vector<std::string> > randomElements(const int n_sites)
+{
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < n_sites; ++i)
+    {
+        const std::string element = (randomDouble01() < 0.5) ? "A" : "V";
+        elements.push_back(std::vector<std::string>(1, element));
+    }
+    return elements;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup the processes for an A hopping to a vacant nearest neighbour
+// on the square lattice.
+static std::vector<Process> hoppingProcesses()
+{
+    std::vector<std::vector<std::string> > elements1(2);
+    elements1[0] = std::vector<std::string>(1, "A");
+    elements1[1] = std::vector<std::string>(1, "V");
+
+    std::vector<std::vector<std::string> > elements2(2);
+    elements2[0] = std::vector<std::string>(1, "V");
+    elements2[1] = std::vector<std::string>(1, "A");
+
+    const double dx[4] = {1.0, -1.0, 0.0,  0.0};
+    const double dy[4] = {0.0,  0.0, 1.0, -1.0};
+
+    std::vector<Process> processes;
+    for (int d = 0; d < 4; ++d)
+    {
+        std::vector<std::vector<double> > coordinates(2, std::vector<double>(3, 0.0));
+        coordinates[1][0] = dx[d];
+        coordinates[1][1] = dy[d];
+
+        Configuration c1(coordinates, elements1, possibleTypes());
+        Configuration c2(coordinates, elements2, possibleTypes());
+        processes.push_back(Process(c1, c2, 1.0, std::vector<int>(1, 0)));
+    }
+    return processes;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup the lattice map for an n x n square lattice.
+static LatticeMap squareLatticeMap(const int n)
+{
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = n;
+    repetitions[1] = n;
+    std::vector<bool> periodic(3, true);
+    periodic[2] = false;
+    return LatticeMap(1, repetitions, periodic);
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Ensemble::testConstruction()
+{
+    const int n = 6;
+    seedRandom(false, 3);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    const Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+
+    // Construct.
+    const Ensemble ensemble(configuration, lattice_map, interactions, 3, 11, 2.5);
+    CPPUNIT_ASSERT_EQUAL( ensemble.nReplicas(), 3 );
+
+    // Each replica starts from the configuration and the start time, with
+    // all processes matched.
+    for (int i = 0; i < ensemble.nReplicas(); ++i)
+    {
+        CPPUNIT_ASSERT( ensemble.configuration(i).elements() == configuration.elements() );
+        CPPUNIT_ASSERT( &ensemble.model(i).configuration() == &ensemble.configuration(i) );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( ensemble.simulationTime(i), 2.5, 1.0e-14 );
+        CPPUNIT_ASSERT_EQUAL( ensemble.nSteps(i), 0L );
+        CPPUNIT_ASSERT( ensemble.model(i).interactions().totalAvailableSites() > 0 );
+    }
+
+    // The interactions given are not matched on.
+    CPPUNIT_ASSERT_EQUAL( interactions.totalAvailableSites(), 0 );
+
+    // Invalid parameters.
+    CPPUNIT_ASSERT_THROW( Ensemble(configuration, lattice_map, interactions, 0, 11),
+                          std::runtime_error );
+
+    Ensemble runnable(configuration, lattice_map, interactions, 2, 11);
+    CPPUNIT_ASSERT_THROW( runnable.run(1, 0), std::runtime_error );
+
+    // Custom rates with a calculator that is not thread safe can only be
+    // run on one thread.
+    std::vector<CustomRateProcess> custom_processes;
+    const std::vector<Process> processes = hoppingProcesses();
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+        std::vector<std::vector<std::string> > process_elements(1, std::vector<std::string>(1, "A"));
+        Configuration c1(process_coordinates, process_elements, possibleTypes());
+        custom_processes.push_back(CustomRateProcess(c1, c1, 1.0, std::vector<int>(1, 0), 1.0));
+    }
+    const RateCalculator rate_calculator;
+    const Interactions custom_interactions(custom_processes, true, rate_calculator);
+    Ensemble custom(configuration, lattice_map, custom_interactions, 2, 11);
+    CPPUNIT_ASSERT_THROW( custom.run(1, 2), std::runtime_error );
+    custom.run(1, 1);
+    CPPUNIT_ASSERT_EQUAL( custom.nSteps(0), 1L );
+    CPPUNIT_ASSERT_EQUAL( custom.nSteps(1), 1L );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Ensemble::testRun()
+{
+    const int n = 8;
+    seedRandom(false, 7);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    const Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const std::vector<int> particles = configuration.particlesPerType();
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+
+    const int seed = 19;
+    const int n_replicas = 4;
+    const int n_steps = 50;
+    Ensemble ensemble(configuration, lattice_map, interactions, n_replicas, seed);
+    ensemble.run(n_steps, 3);
+
+    // Each replica took all steps and conserved the atoms.
+    for (int i = 0; i < n_replicas; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( ensemble.nSteps(i), static_cast<long>(n_steps) );
+        CPPUNIT_ASSERT( ensemble.simulationTime(i) > 0.0 );
+        CPPUNIT_ASSERT( ensemble.configuration(i).particlesPerType() == particles );
+    }
+
+    // The replicas are independent.
+    CPPUNIT_ASSERT( ensemble.configuration(0).elements() != ensemble.configuration(1).elements() );
+    CPPUNIT_ASSERT( ensemble.simulationTime(0) != ensemble.simulationTime(1) );
+
+    // The first replica is the same as a lattice model with the first
+    // seed of the ensemble, run while the shared generator is drawn from.
+    std::vector<unsigned int> seeds(n_replicas);
+    std::seed_seq seed_sequence{seed};
+    seed_sequence.generate(seeds.begin(), seeds.end());
+
+    Configuration reference_configuration(configuration);
+    SimulationTimer reference_timer;
+    LatticeModel reference(reference_configuration, reference_timer, lattice_map, interactions);
+    reference.seedRandomStream(seeds[0]);
+    for (int step = 0; step < n_steps; ++step)
+    {
+        reference.propagateTime();
+        randomDouble01();
+        reference.singleStep();
+    }
+
+    CPPUNIT_ASSERT( reference_configuration.elements() == ensemble.configuration(0).elements() );
+    CPPUNIT_ASSERT( reference_configuration.atomIDElements() == ensemble.configuration(0).atomIDElements() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( reference_timer.simulationTime(), ensemble.simulationTime(0), 1.0e-12 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Ensemble::testThreadCountIndependence()
+{
+    const int n = 8;
+    seedRandom(false, 13);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    const Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+
+    // Run the same ensemble on one and on several threads, in two batches.
+    Ensemble serial(configuration, lattice_map, interactions, 6, 23);
+    Ensemble parallel(configuration, lattice_map, interactions, 6, 23);
+    for (int batch = 0; batch < 2; ++batch)
+    {
+        serial.run(40, 1);
+        parallel.run(40, 4);
+    }
+
+    for (int i = 0; i < serial.nReplicas(); ++i)
+    {
+        CPPUNIT_ASSERT( serial.configuration(i).elements() == parallel.configuration(i).elements() );
+        CPPUNIT_ASSERT( serial.configuration(i).atomID() == parallel.configuration(i).atomID() );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( serial.simulationTime(i), parallel.simulationTime(i), 1.0e-12 );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Ensemble::testMappedConfiguration()
+{
+    const int n = 16;
+    seedRandom(false, 29);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    const Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+
+    // The replicas of a mapped configuration map the same file.
+    const std::string path = "test_ensemble_storage.kmc";
+    configuration.writeStorage(path);
+    const Configuration mapped(path, possibleTypes());
+
+    Ensemble heap_ensemble(configuration, lattice_map, interactions, 4, 31);
+    Ensemble mapped_ensemble(mapped, lattice_map, interactions, 4, 31);
+    heap_ensemble.run(200, 2);
+    mapped_ensemble.run(200, 2);
+
+    // The replicas run as the replicas of the configuration on the heap.
+    for (int i = 0; i < mapped_ensemble.nReplicas(); ++i)
+    {
+        CPPUNIT_ASSERT( mapped_ensemble.configuration(i).mapped() );
+        CPPUNIT_ASSERT( mapped_ensemble.configuration(i).elements() == heap_ensemble.configuration(i).elements() );
+        CPPUNIT_ASSERT( mapped_ensemble.configuration(i).atomID() == heap_ensemble.configuration(i).atomID() );
+        CPPUNIT_ASSERT( mapped_ensemble.configuration(i).atomIDCoordinates() == heap_ensemble.configuration(i).atomIDCoordinates() );
+        CPPUNIT_ASSERT_EQUAL( mapped_ensemble.simulationTime(i), heap_ensemble.simulationTime(i) );
+    }
+
+    // The replicas are independent.
+    CPPUNIT_ASSERT( mapped_ensemble.configuration(0).elements() != mapped_ensemble.configuration(1).elements() );
+    CPPUNIT_ASSERT( mapped.elements() == configuration.elements() );
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,41 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_ENSEMBLE__
+#define __TEST_ENSEMBLE__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_Ensemble : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_Ensemble );
+    CPPUNIT_TEST( testConstruction );
+    CPPUNIT_TEST( testRun );
+    CPPUNIT_TEST( testThreadCountIndependence );
+    CPPUNIT_TEST( testMappedConfiguration );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testConstruction();
+    void testRun();
+    void testThreadCountIndependence();
+    void testMappedConfiguration();
+
+};
+
+#endif
+
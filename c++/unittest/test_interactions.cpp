@@ -40,6 +40,46 @@ void Test_Interactions::testConstruction()
 }
 
 
+// -------------------------------------------------------------------------- //
+//
+void Test_Interactions::testCopy()
+{
+    // Copy interactions without custom rates.
+    std::vector<Process> processes(2);
+    const Interactions interactions(processes, false);
+    Interactions copy(interactions);
+    CPPUNIT_ASSERT( !copy.useCustomRates() );
+    CPPUNIT_ASSERT_EQUAL( copy.processes().size(), interactions.processes().size() );
+
+    // The copy has processes of its own, and matching on the copy leaves
+    // the original untouched.
+    for (size_t i = 0; i < copy.processes().size(); ++i)
+    {
+        CPPUNIT_ASSERT( copy.processes()[i] != interactions.processes()[i] );
+    }
+    copy.processes()[1]->addSite(3);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(copy.processes()[1]->nSites()), 1 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(interactions.processes()[1]->nSites()), 0 );
+
+    // The copy uses a rate calculator placeholder of its own.
+    CPPUNIT_ASSERT( &copy.rateCalculator() != &interactions.rateCalculator() );
+
+    // Copy interactions with custom rates, which refer to the same
+    // rate calculator.
+    const RateCalculator rc;
+    std::vector<CustomRateProcess> custom_processes(2);
+    const Interactions custom_interactions(custom_processes, false, rc);
+    const Interactions custom_copy(custom_interactions);
+    CPPUNIT_ASSERT( custom_copy.useCustomRates() );
+    CPPUNIT_ASSERT( &custom_copy.rateCalculator() == &rc );
+    for (size_t i = 0; i < custom_copy.processes().size(); ++i)
+    {
+        CPPUNIT_ASSERT( custom_copy.processes()[i] != custom_interactions.processes()[i] );
+        CPPUNIT_ASSERT( dynamic_cast<CustomRateProcess*>(custom_copy.processes()[i]) != NULL );
+    }
+}
+
+
 // -------------------------------------------------------------------------- //
 //
 void Test_Interactions::testQuery()
@@ -466,6 +506,129 @@ void Test_Interactions::testUpdateAndPickCustom()
 }
 
 
+// -------------------------------------------------------------------------- //
+//
+void Test_Interactions::testUpdateProcessRate()
+{
+    // Setup a list of processes.
+    std::vector<Process> processes;
+
+    std::vector<std::vector<std::string> > process_elements1(1);
+    process_elements1[0] = std::vector<std::string>(1, "A");
+
+    std::vector<std::vector<std::string> > process_elements2(1);
+    process_elements2[0] = std::vector<std::string>(1, "B");
+
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+
+    // Possible types.
+    std::map<std::string, int> possible_types;
+    possible_types["A"] = 0;
+    possible_types["B"] = 1;
+
+    const double rate = 2.0;
+    Configuration c1(process_coordinates, process_elements1, possible_types);
+    Configuration c2(process_coordinates, process_elements2, possible_types);
+    std::vector<int> sites_vector(1,0);
+    processes.push_back(Process(c1,c2,rate,sites_vector));
+    processes.push_back(Process(c1,c2,rate,sites_vector));
+    processes.push_back(Process(c1,c2,rate,sites_vector));
+
+    processes[0].addSite(1);
+    processes[0].addSite(2);
+    processes[2].addSite(3);
+
+    // Setup the interactions object and the initial table.
+    Interactions interactions(processes, true);
+    interactions.updateProbabilityTable();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( interactions.totalRate(), 6.0, 1.0e-12 );
+
+    // Change the sites on two of the processes and push only these changes.
+    interactions.processes()[0]->removeSite(1);
+    interactions.processes()[0]->removeSite(2);
+    interactions.processes()[1]->addSite(7);
+    interactions.updateProcessRate(0);
+    interactions.updateProcessRate(1);
+
+    // The total rate is updated.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( interactions.totalRate(), 4.0, 1.0e-12 );
+
+    // The probability table is left as it was at the last full update.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( interactions.probabilityTable()[2].first, 6.0, 1.0e-12 );
+
+    // The emptied process is never picked and the other two are
+    // picked with equal probability.
+    seedRandom(false, 19);
+    std::vector<int> picked(3,0);
+    const int n_loop = 100000;
+    for (int i = 0; i < n_loop; ++i)
+    {
+        ++picked[interactions.pickProcessIndex()];
+    }
+
+    CPPUNIT_ASSERT_EQUAL( picked[0], 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[1]/n_loop, 0.5, 1.0e-2 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[2]/n_loop, 0.5, 1.0e-2 );
+
+    // Clearing the matching also clears the total rate.
+    interactions.clearMatching();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( interactions.totalRate(), 0.0, 1.0e-12 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Interactions::testResummation()
+{
+    // Setup a list of processes.
+    std::vector<Process> processes;
+
+    std::vector<std::vector<std::string> > process_elements1(1);
+    process_elements1[0] = std::vector<std::string>(1, "A");
+
+    std::vector<std::vector<std::string> > process_elements2(1);
+    process_elements2[0] = std::vector<std::string>(1, "B");
+
+    std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+
+    // Possible types.
+    std::map<std::string, int> possible_types;
+    possible_types["A"] = 0;
+    possible_types["B"] = 1;
+
+    const double rate = 0.1;
+    Configuration c1(process_coordinates, process_elements1, possible_types);
+    Configuration c2(process_coordinates, process_elements2, possible_types);
+    std::vector<int> sites_vector(1,0);
+    processes.push_back(Process(c1,c2,rate,sites_vector));
+    processes.push_back(Process(c1,c2,rate,sites_vector));
+
+    // Setup the interactions object and set the interval on all processes.
+    Interactions interactions(processes, true);
+    CPPUNIT_ASSERT_EQUAL( interactions.resummationInterval(), 1000000 );
+    interactions.setResummationInterval(7);
+    CPPUNIT_ASSERT_EQUAL( interactions.resummationInterval(), 7 );
+    CPPUNIT_ASSERT_EQUAL( interactions.processes()[0]->resummationInterval(), 7 );
+    CPPUNIT_ASSERT_EQUAL( interactions.processes()[1]->resummationInterval(), 7 );
+
+    // Add and remove many sites and push the changes one by one.
+    for (int i = 0; i < 1000; ++i)
+    {
+        interactions.processes()[i%2]->addSite(i);
+        interactions.updateProcessRate(i%2);
+    }
+    for (int i = 0; i < 1000; i += 3)
+    {
+        interactions.processes()[i%2]->removeSite(i);
+        interactions.updateProcessRate(i%2);
+    }
+
+    // The drift stays at the level of round-off.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( interactions.totalRateDrift(), 0.0, 1.0e-12 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( interactions.totalRate(), 0.1 * (1000 - 334), 1.0e-10 );
+}
+
+
 // -------------------------------------------------------------------------- //
 //
 void Test_Interactions::testMaxRange()
@@ -589,6 +752,16 @@ void Test_Interactions::testMaxRange()
     const Interactions interactions7(processes, true);
     CPPUNIT_ASSERT_EQUAL( interactions7.maxRange(), 4 );
 
+    // The min range is given by the two short processes.
+    CPPUNIT_ASSERT_EQUAL( interactions.minRange(),  1 );
+    CPPUNIT_ASSERT_EQUAL( interactions7.minRange(), 1 );
+
+    // With only long processes the min range is the shortest of them.
+    processes[0] = Process(c13,c14,rate,sites_vector);
+    processes[1] = Process(c11,c12,rate,sites_vector);
+    const Interactions interactions8(processes, true);
+    CPPUNIT_ASSERT_EQUAL( interactions8.minRange(), 2 );
+    CPPUNIT_ASSERT_EQUAL( interactions8.maxRange(), 4 );
 }
 
 
@@ -25,9 +25,12 @@ public:
 
     CPPUNIT_TEST_SUITE( Test_Interactions );
     CPPUNIT_TEST( testConstruction );
+    CPPUNIT_TEST( testCopy );
     CPPUNIT_TEST( testQuery );
     CPPUNIT_TEST( testUpdateAndPick );
     CPPUNIT_TEST( testUpdateAndPickCustom );
+    CPPUNIT_TEST( testUpdateProcessRate );
+    CPPUNIT_TEST( testResummation );
     CPPUNIT_TEST( testMaxRange );
     CPPUNIT_TEST( testUpdateProcessMatchLists );
     CPPUNIT_TEST( testUpdateProcessIDMoves );
@@ -35,9 +38,12 @@ public:
     CPPUNIT_TEST_SUITE_END();
 
     void testConstruction();
+    void testCopy();
     void testQuery();
     void testUpdateAndPick();
     void testUpdateAndPickCustom();
+    void testUpdateProcessRate();
+    void testResummation();
     void testMaxRange();
     void testUpdateProcessMatchLists();
     void testUpdateProcessIDMoves();
@@ -406,6 +406,11 @@ void Test_LatticeMap::testNeighbourIndices()
     CPPUNIT_ASSERT_EQUAL(neighbours6[10], 8);
     CPPUNIT_ASSERT_EQUAL(neighbours6[11], 9);
 
+    // Getting the neighbours into a given vector overwrites its content.
+    std::vector<int> reused(3, -1);
+    map6.neighbourIndices(0, 1, reused);
+    CPPUNIT_ASSERT( reused == neighbours6 );
+
     // DONE.
 }
 
@@ -669,6 +674,78 @@ void Test_LatticeMap::testSupersetNeighbourIndices()
 }
 
 
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeMap::testSupersetNeighbourIndicesReuse()
+{
+    // Construct a periodic 3D map with two basis sites.
+    std::vector<int> repetitions(3, 4);
+    std::vector<bool> periodicity(3, true);
+    LatticeMap map(2, repetitions, periodicity);
+
+    // The version writing to a given vector gives the same indices as the
+    // version returning a new vector, also when the vector is reused.
+    std::vector<int> superset(3, -1);
+    for (int n = 1; n < 5; ++n)
+    {
+        std::vector<int> indices;
+        for (int i = 0; i < n; ++i)
+        {
+            indices.push_back((17 * i * n) % 128);
+        }
+
+        map.supersetNeighbourIndices(indices, 1, superset);
+        const std::vector<int> reference = map.supersetNeighbourIndices(indices, 1);
+        CPPUNIT_ASSERT( superset == reference );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeMap::testSupersetNeighbourShells()
+{
+    // Construct a 3D map with two basis sites, periodic in two directions.
+    std::vector<int> repetitions(3, 6);
+    std::vector<bool> periodicity(3, true);
+    periodicity[2] = false;
+    LatticeMap map(2, repetitions, periodicity);
+
+    std::vector<int> indices;
+    indices.push_back(0);
+    indices.push_back(37);
+    indices.push_back(430);
+
+    // The superset is the same as without shells.
+    const int shells = 3;
+    std::vector<int> superset;
+    std::vector<int> superset_shells;
+    map.supersetNeighbourIndices(indices, shells, superset, superset_shells);
+
+    CPPUNIT_ASSERT( superset == map.supersetNeighbourIndices(indices, shells) );
+    CPPUNIT_ASSERT_EQUAL( superset_shells.size(), superset.size() );
+
+    // The shell of each index is the smallest number of shells whose
+    // superset includes it.
+    for (size_t i = 0; i < superset.size(); ++i)
+    {
+        int smallest = -1;
+        for (int s = shells; s >= 0; --s)
+        {
+            const std::vector<int> reference = map.supersetNeighbourIndices(indices, s);
+            if (std::binary_search(reference.begin(), reference.end(), superset[i]))
+            {
+                smallest = s;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL( superset_shells[i], smallest );
+    }
+
+    // The given indices are at shell zero.
+    CPPUNIT_ASSERT_EQUAL( superset_shells[0], 0 );
+}
+
+
 // -------------------------------------------------------------------------- //
 //
 void Test_LatticeMap::testWrap()
@@ -33,6 +33,8 @@ public:
     CPPUNIT_TEST( testNeighbourIndicesMinimal2 );
     CPPUNIT_TEST( testNeighbourIndicesLong );
     CPPUNIT_TEST( testSupersetNeighbourIndices );
+    CPPUNIT_TEST( testSupersetNeighbourIndicesReuse );
+    CPPUNIT_TEST( testSupersetNeighbourShells );
     CPPUNIT_TEST( testWrap );
     CPPUNIT_TEST( testWrapLong );
     CPPUNIT_TEST( testBasisSiteFromIndex );
@@ -47,6 +49,8 @@ public:
     void testNeighbourIndicesMinimal2();
     void testNeighbourIndicesLong();
     void testSupersetNeighbourIndices();
+    void testSupersetNeighbourIndicesReuse();
+    void testSupersetNeighbourShells();
     void testWrap();
     void testWrapLong();
     void testBasisSiteFromIndex();
@@ -18,8 +18,14 @@
 #include "interactions.h"
 #include "random.h"
 #include "simulationtimer.h"
+#include "customrateprocess.h"
+#include "ratecalculator.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <ctime>
+#include <fstream>
+#include <stdexcept>
 
 // -------------------------------------------------------------------------- //
 //
@@ -61,6 +67,12 @@ void Test_LatticeModel::testConstruction()
     // construct.
     LatticeModel model(config, timer, lattice_map, interactions);
 
+    // The time of each phase of the setup is recorded.
+    const SetupTimings & timings = model.setupTimings();
+    CPPUNIT_ASSERT( timings.match_lists >= 0.0 );
+    CPPUNIT_ASSERT( timings.process_match_lists >= 0.0 );
+    CPPUNIT_ASSERT( timings.matching >= 0.0 );
+    CPPUNIT_ASSERT( timings.probability_table >= 0.0 );
 }
 
 
@@ -462,6 +474,631 @@ void Test_LatticeModel::testSingleStepFunction()
     }
 }
 
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testRunSteps()
+{
+    // Setup a chain of ten A sites.
+    const int n_sites = 10;
+    std::vector<std::vector<double> > coords(n_sites, std::vector<double>(3,0.0));
+    for (int i = 0; i < n_sites; ++i)
+    {
+        coords[i][0] = 1.0 * i;
+    }
+    const std::vector<std::vector<std::string> > elements(n_sites, std::vector<std::string>(1, "A"));
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    Configuration config(coords, elements, possible_types);
+
+    std::vector<int> rep(3, 1);
+    rep[0] = n_sites;
+    const std::vector<bool> per(3, true);
+    LatticeMap lattice_map(1, rep, per);
+
+    // A process that turns an A into a B, so that each step removes one
+    // available site.
+    std::vector<Process> processes;
+    {
+        const std::vector<std::vector<std::string> > process_elements1(1,std::vector<std::string>(1,"A"));
+        const std::vector<std::vector<std::string> > process_elements2(1,std::vector<std::string>(1,"B"));
+        const std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+        Configuration c1(process_coordinates, process_elements1, possible_types);
+        Configuration c2(process_coordinates, process_elements2, possible_types);
+        processes.push_back(Process(c1, c2, 1.0, std::vector<int>(1,0)));
+    }
+    Interactions interactions(processes, true);
+    SimulationTimer timer;
+
+    LatticeModel model(config, timer, lattice_map, interactions);
+    CPPUNIT_ASSERT( !model.stepPending() );
+
+    // Run a batch of three steps.
+    seedRandom(false, 17);
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(3), 3 );
+    CPPUNIT_ASSERT( !model.stepPending() );
+    CPPUNIT_ASSERT_EQUAL( model.interactions().totalAvailableSites(), n_sites-3 );
+    const double time_after_three = timer.simulationTime();
+    CPPUNIT_ASSERT( time_after_three > 0.0 );
+
+    // Stop on a time interval, with the time propagated but no step taken.
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(5, 0.0, time_after_three), 0 );
+    CPPUNIT_ASSERT( model.stepPending() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( model.stepStartTime(), time_after_three, 1.0e-14 );
+    CPPUNIT_ASSERT( timer.simulationTime() > time_after_three );
+    CPPUNIT_ASSERT_EQUAL( model.interactions().totalAvailableSites(), n_sites-3 );
+
+    // Complete the pending step.
+    model.singleStep();
+    CPPUNIT_ASSERT_EQUAL( model.interactions().totalAvailableSites(), n_sites-4 );
+
+    // Running out of available sites ends the batch early.
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(100), n_sites-4 );
+    CPPUNIT_ASSERT( !model.stepPending() );
+    CPPUNIT_ASSERT_EQUAL( model.interactions().totalAvailableSites(), 0 );
+    for (int i = 0; i < n_sites; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( config.elements()[i][0], std::string("B") );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+// This proxy class is needed for the LazyRates test below.
+class CountingRateCalc : public RateCalculator {
+public:
+    CountingRateCalc() : n_calls_(0) {}
+    virtual ~CountingRateCalc() {}
+    virtual double backendRateCallback(const std::vector<double> geometry,
+                                       const int len,
+                                       const std::vector<std::string> & types_before,
+                                       const std::vector<std::string> & types_after,
+                                       const double rate_constant,
+                                       const int process_number,
+                                       const double global_x,
+                                       const double global_y,
+                                       const double global_z) const
+        {
+            // Count the calls and return.
+            ++n_calls_;
+            return rate_constant;
+        }
+    mutable int n_calls_;
+};
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testLazyRates()
+{
+    // Setup a chain of A sites.
+    const int n_sites = 10;
+    std::vector<std::vector<double> > coords(n_sites, std::vector<double>(3,0.0));
+    for (int i = 0; i < n_sites; ++i)
+    {
+        coords[i][0] = 1.0 * i;
+    }
+    const std::vector<std::vector<std::string> > elements(n_sites, std::vector<std::string>(1, "A"));
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    Configuration config(coords, elements, possible_types);
+
+    std::vector<int> rep(3, 1);
+    rep[0] = n_sites;
+    const std::vector<bool> per(3, true);
+    LatticeMap lattice_map(1, rep, per);
+
+    // Two processes flipping A to B and back, with rate 1.0 and
+    // a rate upper bound of 4.0.
+    const std::vector<std::vector<std::string> > process_elements_a(1,std::vector<std::string>(1,"A"));
+    const std::vector<std::vector<std::string> > process_elements_b(1,std::vector<std::string>(1,"B"));
+    const std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    Configuration ca(process_coordinates, process_elements_a, possible_types);
+    Configuration cb(process_coordinates, process_elements_b, possible_types);
+
+    const std::vector<int> basis_sites(1, 0);
+    const std::vector<int> move_origins;
+    const std::vector<Coordinate> move_vectors;
+    std::vector<CustomRateProcess> processes;
+    processes.push_back(CustomRateProcess(ca, cb, 1.0, basis_sites, 1.0,
+                                          move_origins, move_vectors, 0, false, 4.0));
+    processes.push_back(CustomRateProcess(cb, ca, 1.0, basis_sites, 1.0,
+                                          move_origins, move_vectors, 1, false, 4.0));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( processes[0].rateUpperBound(), 4.0, 1.0e-14 );
+
+    const CountingRateCalc rate_calculator;
+    Interactions interactions(processes, true, rate_calculator);
+    SimulationTimer timer;
+
+    LatticeModel model(config, timer, lattice_map, interactions);
+
+    // The sites are listed with the bound, without calling the rate calculator.
+    CPPUNIT_ASSERT_EQUAL( rate_calculator.n_calls_, 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( model.interactions().totalRate(), 4.0 * n_sites, 1.0e-12 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(model.nNullEvents()), 0 );
+
+    // Run and check that three out of four events are null events and
+    // that the rate is evaluated once per step.
+    seedRandom(false, 71);
+    const int n_steps = 100000;
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(n_steps), n_steps );
+    CPPUNIT_ASSERT_EQUAL( rate_calculator.n_calls_, n_steps );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0 * model.nNullEvents() / n_steps, 0.75, 1.0e-2 );
+
+    // The time is propagated with the total bound rate.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( timer.simulationTime(), n_steps / (4.0 * n_sites), 0.01 * n_steps / (4.0 * n_sites) );
+}
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testLazyRatesBoundViolation()
+{
+    // Setup a single A site.
+    std::vector<std::vector<double> > coords(1, std::vector<double>(3,0.0));
+    const std::vector<std::vector<std::string> > elements(1, std::vector<std::string>(1, "A"));
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    Configuration config(coords, elements, possible_types);
+
+    const std::vector<int> rep(3, 1);
+    const std::vector<bool> per(3, true);
+    LatticeMap lattice_map(1, rep, per);
+
+    // A process with a rate larger than its bound.
+    const std::vector<std::vector<std::string> > process_elements_a(1,std::vector<std::string>(1,"A"));
+    const std::vector<std::vector<std::string> > process_elements_b(1,std::vector<std::string>(1,"B"));
+    const std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    Configuration ca(process_coordinates, process_elements_a, possible_types);
+    Configuration cb(process_coordinates, process_elements_b, possible_types);
+
+    std::vector<CustomRateProcess> processes;
+    processes.push_back(CustomRateProcess(ca, cb, 1.0, std::vector<int>(1, 0), 1.0,
+                                          std::vector<int>(0), std::vector<Coordinate>(0),
+                                          0, false, 0.5));
+
+    const CountingRateCalc rate_calculator;
+    Interactions interactions(processes, true, rate_calculator);
+    SimulationTimer timer;
+
+    LatticeModel model(config, timer, lattice_map, interactions);
+
+    CPPUNIT_ASSERT_THROW( model.singleStep(), std::runtime_error );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testStepAllocations()
+{
+    // Setup a periodic square lattice with a random half filling of A
+    // atoms among vacancies.
+    const int n = 16;
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["V"] = 2;
+
+    seedRandom(false, 913);
+    std::vector<std::vector<double> > coords;
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> c(3, 0.0);
+            c[0] = i;
+            c[1] = j;
+            coords.push_back(c);
+            const std::string element = (randomDouble01() < 0.5) ? "A" : "V";
+            elements.push_back(std::vector<std::string>(1, element));
+        }
+    }
+    Configuration config(coords, elements, possible_types);
+
+    std::vector<int> rep(3, 1);
+    rep[0] = n;
+    rep[1] = n;
+    std::vector<bool> per(3, true);
+    per[2] = false;
+    LatticeMap lattice_map(1, rep, per);
+
+    // Processes for an A hopping to a vacant nearest neighbour in three
+    // of the directions, so that the matches of each site are stored in
+    // place in the site match table.
+    std::vector<std::vector<std::string> > elements1(2);
+    elements1[0] = std::vector<std::string>(1, "A");
+    elements1[1] = std::vector<std::string>(1, "V");
+    std::vector<std::vector<std::string> > elements2(2);
+    elements2[0] = std::vector<std::string>(1, "V");
+    elements2[1] = std::vector<std::string>(1, "A");
+
+    const double dx[3] = {1.0, -1.0, 0.0};
+    const double dy[3] = {0.0,  0.0, 1.0};
+
+    std::vector<Process> processes;
+    for (int d = 0; d < 3; ++d)
+    {
+        std::vector<std::vector<double> > process_coords(2, std::vector<double>(3, 0.0));
+        process_coords[1][0] = dx[d];
+        process_coords[1][1] = dy[d];
+        const Configuration c1(process_coords, elements1, possible_types);
+        const Configuration c2(process_coords, elements2, possible_types);
+        processes.push_back(Process(c1, c2, 1.0 + d, std::vector<int>(1, 0)));
+    }
+
+    Interactions interactions(processes, true);
+    SimulationTimer timer;
+    LatticeModel model(config, timer, lattice_map, interactions);
+    CPPUNIT_ASSERT_EQUAL( model.nStepAllocations(), 0L );
+
+    // Let the work storage grow to the largest sizes needed.
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(5000), 5000 );
+
+    // Further steps do not allocate.
+    const long n_allocations = model.nStepAllocations();
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(5000), 5000 );
+    CPPUNIT_ASSERT_EQUAL( model.nStepAllocations(), n_allocations );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testMixedRangeRematch()
+{
+    // Setup a periodic square lattice with a random filling of A and B
+    // atoms among vacancies.
+    const int n = 12;
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["V"] = 3;
+
+    seedRandom(false, 2718);
+    std::vector<std::vector<double> > coords;
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> c(3, 0.0);
+            c[0] = i;
+            c[1] = j;
+            coords.push_back(c);
+            const double r = randomDouble01();
+            const std::string element = (r < 0.4) ? "A" : ((r < 0.6) ? "B" : "V");
+            elements.push_back(std::vector<std::string>(1, element));
+        }
+    }
+    Configuration config(coords, elements, possible_types);
+
+    std::vector<int> rep(3, 1);
+    rep[0] = n;
+    rep[1] = n;
+    std::vector<bool> per(3, true);
+    per[2] = false;
+    LatticeMap lattice_map(1, rep, per);
+
+    // Short range processes for an A hopping to a vacant nearest neighbour.
+    std::vector<Process> processes;
+    const double dx[4] = {1.0, -1.0, 0.0,  0.0};
+    const double dy[4] = {0.0,  0.0, 1.0, -1.0};
+    for (int d = 0; d < 4; ++d)
+    {
+        std::vector<std::vector<double> > process_coords(2, std::vector<double>(3, 0.0));
+        process_coords[1][0] = dx[d];
+        process_coords[1][1] = dy[d];
+
+        std::vector<std::vector<std::string> > before(2);
+        before[0] = std::vector<std::string>(1, "A");
+        before[1] = std::vector<std::string>(1, "V");
+        std::vector<std::vector<std::string> > after(2);
+        after[0] = std::vector<std::string>(1, "V");
+        after[1] = std::vector<std::string>(1, "A");
+
+        const Configuration c1(process_coords, before, possible_types);
+        const Configuration c2(process_coords, after, possible_types);
+        processes.push_back(Process(c1, c2, 1.0 + d, std::vector<int>(1, 0)));
+    }
+
+    // Long range processes turning an A into a B when there is an A three
+    // cells away, and a B into an A when there is a vacancy two cells away.
+    {
+        std::vector<std::vector<double> > process_coords(2, std::vector<double>(3, 0.0));
+        process_coords[1][0] = 3.0;
+
+        std::vector<std::vector<std::string> > before(2, std::vector<std::string>(1, "A"));
+        std::vector<std::vector<std::string> > after(2, std::vector<std::string>(1, "A"));
+        after[0][0] = "B";
+
+        const Configuration c1(process_coords, before, possible_types);
+        const Configuration c2(process_coords, after, possible_types);
+        processes.push_back(Process(c1, c2, 0.5, std::vector<int>(1, 0)));
+    }
+    {
+        std::vector<std::vector<double> > process_coords(2, std::vector<double>(3, 0.0));
+        process_coords[1][1] = -2.0;
+
+        std::vector<std::vector<std::string> > before(2, std::vector<std::string>(1, "V"));
+        before[0][0] = "B";
+        std::vector<std::vector<std::string> > after(2, std::vector<std::string>(1, "V"));
+        after[0][0] = "A";
+
+        const Configuration c1(process_coords, before, possible_types);
+        const Configuration c2(process_coords, after, possible_types);
+        processes.push_back(Process(c1, c2, 0.7, std::vector<int>(1, 0)));
+    }
+
+    Interactions interactions(processes, true);
+    CPPUNIT_ASSERT_EQUAL( interactions.minRange(), 1 );
+    CPPUNIT_ASSERT_EQUAL( interactions.maxRange(), 3 );
+
+    SimulationTimer timer;
+    LatticeModel model(config, timer, lattice_map, interactions);
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(3000), 3000 );
+
+    // Matching the final configuration from scratch gives the same sites
+    // for each process as the rematching during the steps. The reference
+    // model needs its own processes.
+    Configuration final_config(coords, config.elements(), possible_types);
+    Interactions reference_interactions(processes, true);
+    SimulationTimer final_timer;
+    const LatticeModel reference(final_config, final_timer, lattice_map, reference_interactions);
+
+    for (size_t p = 0; p < processes.size(); ++p)
+    {
+        std::vector<int> sites = model.interactions().processes()[p]->sites();
+        std::vector<int> reference_sites = reference.interactions().processes()[p]->sites();
+        std::sort(sites.begin(), sites.end());
+        std::sort(reference_sites.begin(), reference_sites.end());
+        CPPUNIT_ASSERT( !reference_sites.empty() );
+        CPPUNIT_ASSERT( sites == reference_sites );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+// This proxy class is needed for the Checkpoint test below.
+class PositionRateCalc : public RateCalculator {
+public:
+    PositionRateCalc() {}
+    virtual ~PositionRateCalc() {}
+    virtual double backendRateCallback(const std::vector<double> geometry,
+                                       const int len,
+                                       const std::vector<std::string> & types_before,
+                                       const std::vector<std::string> & types_after,
+                                       const double rate_constant,
+                                       const int process_number,
+                                       const double global_x,
+                                       const double global_y,
+                                       const double global_z) const
+        {
+            // A rate that depends on the position.
+            return rate_constant * (1.0 + 0.1 * global_x + 0.01 * global_y);
+        }
+};
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testCheckpoint()
+{
+    // Setup a periodic square lattice with a random filling of A and B
+    // atoms among vacancies.
+    const int n = 12;
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["V"] = 3;
+
+    seedRandom(false, 1414);
+    std::vector<std::vector<double> > coords;
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> c(3, 0.0);
+            c[0] = i;
+            c[1] = j;
+            coords.push_back(c);
+            const double r = randomDouble01();
+            const std::string element = (r < 0.4) ? "A" : ((r < 0.6) ? "B" : "V");
+            elements.push_back(std::vector<std::string>(1, element));
+        }
+    }
+
+    std::vector<int> rep(3, 1);
+    rep[0] = n;
+    rep[1] = n;
+    std::vector<bool> per(3, true);
+    per[2] = false;
+    LatticeMap lattice_map(1, rep, per);
+
+    // Processes for an A hopping to a vacant nearest neighbour, with
+    // rates that depend on the position so that the sites of each process
+    // have different rates. Two of the processes have lazy rates, giving
+    // null events.
+    std::vector<CustomRateProcess> processes;
+    const double dx[4] = {1.0, -1.0, 0.0,  0.0};
+    const double dy[4] = {0.0,  0.0, 1.0, -1.0};
+    for (int d = 0; d < 4; ++d)
+    {
+        std::vector<std::vector<double> > process_coords(2, std::vector<double>(3, 0.0));
+        process_coords[1][0] = dx[d];
+        process_coords[1][1] = dy[d];
+
+        std::vector<std::vector<std::string> > before(2);
+        before[0] = std::vector<std::string>(1, "A");
+        before[1] = std::vector<std::string>(1, "V");
+        std::vector<std::vector<std::string> > after(2);
+        after[0] = std::vector<std::string>(1, "V");
+        after[1] = std::vector<std::string>(1, "A");
+
+        const Configuration c1(process_coords, before, possible_types);
+        const Configuration c2(process_coords, after, possible_types);
+
+        std::vector<int> move_origins(2, 0);
+        move_origins[1] = 1;
+        std::vector<Coordinate> move_vectors;
+        move_vectors.push_back(Coordinate(dx[d], dy[d], 0.0));
+        move_vectors.push_back(Coordinate(-dx[d], -dy[d], 0.0));
+
+        processes.push_back(CustomRateProcess(c1, c2, 1.0, std::vector<int>(1, 0), 1.0,
+                                              move_origins, move_vectors, d, false,
+                                              (d < 2) ? 0.0 : 2.5));
+    }
+
+    const PositionRateCalc rate_calculator;
+    const std::string path = "test_latticemodel_checkpoint.kmc";
+
+    Configuration config(coords, elements, possible_types);
+    Interactions interactions(processes, true, rate_calculator);
+    SimulationTimer timer;
+    LatticeModel model(config, timer, lattice_map, interactions, COMPOSITION_REJECTION);
+    model.seedRandomStream(13);
+
+    // Run, save and run further.
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(500), 500 );
+    model.save(path);
+    const double saved_time = timer.simulationTime();
+
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(1000), 1000 );
+    const std::vector<std::vector<std::string> > ref_elements = config.elements();
+    const double ref_time = timer.simulationTime();
+    const SiteArray<int> ref_atom_id = config.atomID();
+    const SiteArray<Coordinate> ref_atom_id_coordinates = config.atomIDCoordinates();
+    const long ref_null_events = model.nNullEvents();
+    std::vector<std::vector<int> > ref_sites;
+    for (size_t p = 0; p < processes.size(); ++p)
+    {
+        ref_sites.push_back(model.interactions().processes()[p]->sites());
+    }
+    CPPUNIT_ASSERT( ref_null_events > 0 );
+
+    // Loading the checkpoint into the model and running the same number
+    // of steps reproduces the run exactly.
+    model.load(path);
+    CPPUNIT_ASSERT_EQUAL( timer.simulationTime(), saved_time );
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(1000), 1000 );
+
+    CPPUNIT_ASSERT( config.elements() == ref_elements );
+    CPPUNIT_ASSERT_EQUAL( timer.simulationTime(), ref_time );
+    CPPUNIT_ASSERT( config.atomID() == ref_atom_id );
+    CPPUNIT_ASSERT( config.atomIDCoordinates() == ref_atom_id_coordinates );
+    CPPUNIT_ASSERT_EQUAL( model.nNullEvents(), ref_null_events );
+    for (size_t p = 0; p < processes.size(); ++p)
+    {
+        CPPUNIT_ASSERT( model.interactions().processes()[p]->sites() == ref_sites[p] );
+    }
+
+    // So does a new model restarted from the checkpoint.
+    Configuration restart_config(coords, elements, possible_types);
+    Interactions restart_interactions(processes, true, rate_calculator);
+    SimulationTimer restart_timer;
+    LatticeModel restart_model(restart_config, restart_timer, lattice_map,
+                               restart_interactions, path);
+    CPPUNIT_ASSERT_EQUAL( restart_timer.simulationTime(), saved_time );
+    CPPUNIT_ASSERT_EQUAL( restart_model.runSteps(1000), 1000 );
+
+    CPPUNIT_ASSERT( restart_config.elements() == ref_elements );
+    CPPUNIT_ASSERT_EQUAL( restart_timer.simulationTime(), ref_time );
+    CPPUNIT_ASSERT( restart_config.atomID() == ref_atom_id );
+    CPPUNIT_ASSERT( restart_config.atomIDCoordinates() == ref_atom_id_coordinates );
+    CPPUNIT_ASSERT_EQUAL( restart_model.nNullEvents(), ref_null_events );
+    for (size_t p = 0; p < processes.size(); ++p)
+    {
+        CPPUNIT_ASSERT( restart_model.interactions().processes()[p]->sites() == ref_sites[p] );
+    }
+
+    // A model of another system can not be restarted from the checkpoint.
+    {
+        std::vector<std::vector<double> > small_coords(coords.begin(), coords.begin() + n);
+        std::vector<std::vector<std::string> > small_elements(elements.begin(), elements.begin() + n);
+        Configuration small_config(small_coords, small_elements, possible_types);
+        std::vector<int> small_rep(3, 1);
+        small_rep[0] = n;
+        LatticeMap small_lattice_map(1, small_rep, per);
+        Interactions small_interactions(processes, true, rate_calculator);
+        SimulationTimer small_timer;
+        CPPUNIT_ASSERT_THROW( LatticeModel(small_config, small_timer, small_lattice_map,
+                                           small_interactions, path),
+                              std::runtime_error );
+    }
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_LatticeModel::testCheckpointInterval()
+{
+    // Setup a chain of A sites with a process flipping A to B and back.
+    const int n_sites = 10;
+    std::vector<std::vector<double> > coords(n_sites, std::vector<double>(3,0.0));
+    for (int i = 0; i < n_sites; ++i)
+    {
+        coords[i][0] = 1.0 * i;
+    }
+    const std::vector<std::vector<std::string> > elements(n_sites, std::vector<std::string>(1, "A"));
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+
+    Configuration config(coords, elements, possible_types);
+
+    std::vector<int> rep(3, 1);
+    rep[0] = n_sites;
+    const std::vector<bool> per(3, true);
+    LatticeMap lattice_map(1, rep, per);
+
+    const std::vector<std::vector<std::string> > process_elements_a(1,std::vector<std::string>(1,"A"));
+    const std::vector<std::vector<std::string> > process_elements_b(1,std::vector<std::string>(1,"B"));
+    const std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+    Configuration ca(process_coordinates, process_elements_a, possible_types);
+    Configuration cb(process_coordinates, process_elements_b, possible_types);
+
+    std::vector<Process> processes;
+    processes.push_back(Process(ca, cb, 1.0, std::vector<int>(1, 0)));
+    processes.push_back(Process(cb, ca, 1.0, std::vector<int>(1, 0)));
+
+    Interactions interactions(processes, false);
+    SimulationTimer timer;
+    LatticeModel model(config, timer, lattice_map, interactions);
+
+    const std::string path = "test_latticemodel_checkpoint_interval.kmc";
+    std::remove(path.c_str());
+
+    // No checkpoints are written without an interval.
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(10), 10 );
+    CPPUNIT_ASSERT( !std::ifstream(path.c_str()).good() );
+
+    // With an interval shorter than a step a checkpoint is written.
+    model.setCheckpointInterval(path, 1.0e-9);
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(10), 10 );
+    CPPUNIT_ASSERT( std::ifstream(path.c_str()).good() );
+
+    // A zero interval turns the checkpoints off again.
+    std::remove(path.c_str());
+    model.setCheckpointInterval(path, 0.0);
+    CPPUNIT_ASSERT_EQUAL( model.runSteps(10), 10 );
+    CPPUNIT_ASSERT( !std::ifstream(path.c_str()).good() );
+}
+
+
 // -------------------------------------------------------------------------- //
 //
 void Test_LatticeModel::testTiming()
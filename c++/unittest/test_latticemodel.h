@@ -27,12 +27,26 @@ public:
     CPPUNIT_TEST( testConstruction );
     CPPUNIT_TEST( testSetupAndQuery );
     CPPUNIT_TEST( testSingleStepFunction );
+    CPPUNIT_TEST( testRunSteps );
+    CPPUNIT_TEST( testLazyRates );
+    CPPUNIT_TEST( testLazyRatesBoundViolation );
+    CPPUNIT_TEST( testStepAllocations );
+    CPPUNIT_TEST( testMixedRangeRematch );
+    CPPUNIT_TEST( testCheckpoint );
+    CPPUNIT_TEST( testCheckpointInterval );
     //CPPUNIT_TEST( testTiming );
     CPPUNIT_TEST_SUITE_END();
 
     void testConstruction();
     void testSetupAndQuery();
     void testSingleStepFunction();
+    void testRunSteps();
+    void testLazyRates();
+    void testLazyRatesBoundViolation();
+    void testStepAllocations();
+    void testMixedRangeRematch();
+    void testCheckpoint();
+    void testCheckpointInterval();
     void testTiming();
 
 };
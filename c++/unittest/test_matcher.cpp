@@ -1210,20 +1210,27 @@ void Test_Matcher::testUpdateProcesses()
         std::vector<CustomRateProcess> processes(4, process);
         Interactions interactions(processes, false, RateCalculator());
 
-        // Populate the processes with indices.
-        interactions.processes()[0]->addSite(0, 1.1);
-        interactions.processes()[0]->addSite(1, 2.2);
-        interactions.processes()[0]->addSite(2, 3.3);
+        // Populate the processes with indices through the matcher, which
+        // keeps the slots of the sites in the processes.
+        const int populate_processes[6] = {0, 0, 0, 1, 1, 2};
+        const int populate_indices[6]   = {0, 1, 2, 0, 1, 0};
+        const double populate_rates[6]  = {1.1, 2.2, 3.3, 11.0, 1.0, 13.7};
 
-        interactions.processes()[1]->addSite(0, 11.0);
-        interactions.processes()[1]->addSite(1, 1.0);
-
-        interactions.processes()[2]->addSite(0, 13.7);
-
-        // Setup a couple of valid add, remove and update tasks.
         std::vector<RemoveTask> rt;
         std::vector<RateTask> at;
         std::vector<RateTask> ut;
+        for (int i = 0; i < 6; ++i)
+        {
+            RateTask task;
+            task.index   = populate_indices[i];
+            task.process = populate_processes[i];
+            task.rate    = populate_rates[i];
+            at.push_back(task);
+        }
+        m.updateProcesses(rt, ut, at, interactions);
+        at.clear();
+
+        // Setup a couple of valid add, remove and update tasks.
 
         RemoveTask rt1;
         rt1.index   = 1;
@@ -1802,3 +1809,126 @@ void Test_Matcher::testUpdateSingleRate()
     CPPUNIT_ASSERT_DOUBLES_EQUAL(ret_rate, std::pow(rate, 3.14159), 1.0e-12);
 
 }
+
+
+// -------------------------------------------------------------------------- //
+// This proxy class is part of the CalculateMatchingThreads test below.
+class ThreadSafeRateCalc : public RateCalculator {
+public:
+    virtual ~ThreadSafeRateCalc() {}
+    virtual double backendRateCallback(const std::vector<double> geometry,
+                                       const int len,
+                                       const std::vector<std::string> & types_before,
+                                       const std::vector<std::string> & types_after,
+                                       const double rate_constant,
+                                       const int process_number,
+                                       const double global_x,
+                                       const double global_y,
+                                       const double global_z) const
+        {
+            // Scale the rate with the number of A atoms around.
+            int n_a = 0;
+            for (size_t i = 0; i < types_before.size(); ++i)
+            {
+                n_a += (types_before[i] == "A");
+            }
+            return rate_constant * (1.0 + n_a);
+        }
+    virtual bool threadSafe() const { return true; }
+};
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Matcher::testCalculateMatchingThreads()
+{
+    // Setup a periodic square lattice with a random half filling of A
+    // atoms among vacancies, large enough to be split over threads.
+    const int n = 64;
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["V"] = 2;
+
+    seedRandom(8723, true);
+    std::vector<std::vector<double> > coords;
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> c(3, 0.0);
+            c[0] = i;
+            c[1] = j;
+            coords.push_back(c);
+            const std::string element = (randomDouble01() < 0.5) ? "A" : "V";
+            elements.push_back(std::vector<std::string>(1, element));
+        }
+    }
+    Configuration config(coords, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = n;
+    repetitions[1] = n;
+    std::vector<bool> periodicity(3, true);
+    periodicity[2] = false;
+    const LatticeMap lattice_map(1, repetitions, periodicity);
+    config.initMatchLists(lattice_map, 1);
+
+    // Setup processes for an A hopping to a vacant nearest neighbour,
+    // with custom rates depending on the neighbourhood.
+    std::vector<std::vector<std::string> > elements1(2);
+    elements1[0] = std::vector<std::string>(1, "A");
+    elements1[1] = std::vector<std::string>(1, "V");
+    std::vector<std::vector<std::string> > elements2(2);
+    elements2[0] = std::vector<std::string>(1, "V");
+    elements2[1] = std::vector<std::string>(1, "A");
+
+    const double dx[4] = {1.0, -1.0, 0.0,  0.0};
+    const double dy[4] = {0.0,  0.0, 1.0, -1.0};
+
+    std::vector<CustomRateProcess> processes;
+    for (int d = 0; d < 4; ++d)
+    {
+        std::vector<std::vector<double> > process_coords(2, std::vector<double>(3, 0.0));
+        process_coords[1][0] = dx[d];
+        process_coords[1][1] = dy[d];
+        const Configuration c1(process_coords, elements1, possible_types);
+        const Configuration c2(process_coords, elements2, possible_types);
+        processes.push_back(CustomRateProcess(c1, c2, 1.0 + d, std::vector<int>(1, 0), 1.2,
+                                              std::vector<int>(0), std::vector<Coordinate>(0), d));
+    }
+
+    // Match all indices with one and with four threads.
+    std::vector<int> indices(n*n);
+    for (int i = 0; i < n*n; ++i)
+    {
+        indices[i] = i;
+    }
+
+    const ThreadSafeRateCalc rate_calculator;
+    std::vector<Interactions> interactions;
+    interactions.reserve(2);
+    const int n_threads[2] = {1, 4};
+
+    for (int t = 0; t < 2; ++t)
+    {
+        interactions.emplace_back(processes, true, rate_calculator);
+        interactions[t].updateProcessMatchLists(config, lattice_map);
+
+        Matcher m(n*n, processes.size());
+        m.setNumberOfThreads(n_threads[t]);
+        CPPUNIT_ASSERT_EQUAL( m.numberOfThreads(), n_threads[t] );
+        m.calculateMatching(interactions[t], config, lattice_map, indices);
+    }
+
+    // The processes must have the same sites in the same order, and
+    // the same total rates.
+    for (size_t p = 0; p < processes.size(); ++p)
+    {
+        const Process & serial   = (*interactions[0].processes()[p]);
+        const Process & threaded = (*interactions[1].processes()[p]);
+        CPPUNIT_ASSERT( serial.nSites() > 0 );
+        CPPUNIT_ASSERT( serial.sites() == threaded.sites() );
+        CPPUNIT_ASSERT_EQUAL( serial.totalRate(), threaded.totalRate() );
+    }
+}
@@ -35,6 +35,7 @@ public:
     CPPUNIT_TEST( testCalculateMatchingInteractions );
     CPPUNIT_TEST( testUpdateRates );
     CPPUNIT_TEST( testUpdateSingleRate );
+    CPPUNIT_TEST( testCalculateMatchingThreads );
     CPPUNIT_TEST_SUITE_END();
 
     void testConstruction();
@@ -48,6 +49,7 @@ public:
     void testCalculateMatchingInteractions();
     void testUpdateRates();
     void testUpdateSingleRate();
+    void testCalculateMatchingThreads();
 
 };
 
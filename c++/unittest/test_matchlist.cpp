@@ -1360,3 +1360,37 @@ void Test_MatchList::testMultiplicity2()
     const double m0 = multiplicity(process_match_list, config_match_list);
     CPPUNIT_ASSERT_DOUBLES_EQUAL(m0, 558144.0, 1.0e-10);
 }
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_MatchList::testTypeSignatures()
+{
+    // Setup a process match list with a wildcard entry.
+    ProcessBucketMatchList process_match_list(3);
+    for (size_t i = 0; i < process_match_list.size(); ++i)
+    {
+        process_match_list[i].match_types = TypeBucket(4);
+    }
+    process_match_list[0].match_types[1] = 1;
+    process_match_list[1].match_types[0] = 1;
+    process_match_list[2].match_types[1] = 2;
+    process_match_list[2].match_types[3] = 1;
+
+    // The wildcard entry does not require anything.
+    CPPUNIT_ASSERT_EQUAL( requiredTypes(process_match_list), static_cast<TypeSignature>(2 + 8) );
+
+    // Setup a configuration match list.
+    ConfigBucketMatchList config_match_list(2);
+    config_match_list[0].match_types = TypeBucket(4);
+    config_match_list[1].match_types = TypeBucket(4);
+    config_match_list[0].match_types[2] = 1;
+    config_match_list[1].match_types[1] = 1;
+    config_match_list[1].match_types[2] = 4;
+
+    CPPUNIT_ASSERT_EQUAL( presentTypes(config_match_list), static_cast<TypeSignature>(2 + 4) );
+
+    // Empty lists.
+    CPPUNIT_ASSERT_EQUAL( requiredTypes(ProcessBucketMatchList(0)), static_cast<TypeSignature>(0) );
+    CPPUNIT_ASSERT_EQUAL( presentTypes(ConfigBucketMatchList(0)), static_cast<TypeSignature>(0) );
+}
@@ -34,6 +34,7 @@ public:
     CPPUNIT_TEST( testConfigurationsToMatchList2 );
     CPPUNIT_TEST( testMultiplicity );
     CPPUNIT_TEST( testMultiplicity2 );
+    CPPUNIT_TEST( testTypeSignatures );
     CPPUNIT_TEST_SUITE_END();
 
     void testCall();
@@ -46,6 +47,7 @@ public:
     void testConfigurationsToMatchList2();
     void testMultiplicity();
     void testMultiplicity2();
+    void testTypeSignatures();
 
 };
 
@@ -174,7 +174,7 @@ void Test_OnTheFlyMSD::testStepX()
                     t0,
                     track_type,
                     abc_to_xyz);
-    const std::vector<int> & atom_id = configuration.atomID();
+    const SiteArray<int> & atom_id = configuration.atomID();
 
     // Peform the process.
     configuration.performBucketProcess(p1, 2, lattice_map);
@@ -447,7 +447,7 @@ void Test_OnTheFlyMSD::testStepY()
                     t0,
                     track_type,
                     abc_to_xyz);
-    const std::vector<int> & atom_id = configuration.atomID();
+    const SiteArray<int> & atom_id = configuration.atomID();
 
     // Peform the process.
     configuration.performBucketProcess(p1, 2, lattice_map);
@@ -718,7 +718,7 @@ void Test_OnTheFlyMSD::testStepZ()
                     t0,
                     track_type,
                     abc_to_xyz);
-    const std::vector<int> & atom_id = configuration.atomID();
+    const SiteArray<int> & atom_id = configuration.atomID();
 
     // Peform the process.
     configuration.performBucketProcess(p1, 2, lattice_map);
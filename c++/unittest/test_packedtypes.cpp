@@ -0,0 +1,431 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_packedtypes.h"
+
+// Include the files to test.
+#include "packedtypes.h"
+
+#include "random.h"
+
+#include <cstdio>
+#include <ctime>
+
+
+// -------------------------------------------------------------------------- //
+// Get a random count between zero and max.
+static int randomCount(const int max)
+{
+    return static_cast<int>(randomDouble01() * (max + 1)) % (max + 1);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup a configuration match list with random counts of each type.
+static ConfigBucketMatchList randomConfigList(const int n_entries,
+                                              const int n_types,
+                                              const int max_count)
+{
+    ConfigBucketMatchList match_list(n_entries);
+    for (int i = 0; i < n_entries; ++i)
+    {
+        match_list[i].match_types = TypeBucket(n_types);
+        for (int j = 1; j < n_types; ++j)
+        {
+            match_list[i].match_types[j] = randomCount(max_count);
+        }
+    }
+    return match_list;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup a process match list from a configuration match list, where each
+// type count is kept, taken in part or dropped, and some entries are
+// wildcards. The process matches the configuration unless a count is
+// raised above it.
+static ProcessBucketMatchList randomProcessList(const ConfigBucketMatchList & config,
+                                                const double p_raise)
+{
+    const int n_types = config[0].match_types.size();
+    ProcessBucketMatchList match_list(config.size());
+    for (size_t i = 0; i < config.size(); ++i)
+    {
+        match_list[i].match_types = TypeBucket(n_types);
+        if (randomDouble01() < 0.1)
+        {
+            match_list[i].match_types[0] = 1;
+            continue;
+        }
+
+        for (int j = 1; j < n_types; ++j)
+        {
+            const int n = config[i].match_types[j];
+            const double r = randomDouble01();
+            int count = 0;
+            if (r < 0.4)
+            {
+                count = n;
+            }
+            else if (r < 0.5)
+            {
+                count = randomCount(n);
+            }
+            if (randomDouble01() < p_raise)
+            {
+                count += 1;
+            }
+            match_list[i].match_types[j] = count;
+        }
+    }
+    return match_list;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Check the match of the types on each entry with the scalar bucket match.
+static bool scalarMatch(const ProcessBucketMatchList & process,
+                        const ConfigBucketMatchList & config)
+{
+    for (size_t i = 0; i < process.size(); ++i)
+    {
+        if (process[i].match_types[0] != 1 &&
+            !process[i].match_types.match(config[i].match_types))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_PackedTypes::testPack()
+{
+    // Pack a configuration match list with three types and a wildcard slot.
+    ConfigBucketMatchList config(2);
+    config[0].match_types = TypeBucket(4);
+    config[0].match_types[1] = 2;
+    config[0].match_types[3] = 1;
+    config[1].match_types = TypeBucket(4);
+    config[1].match_types[2] = 7;
+
+    CPPUNIT_ASSERT_EQUAL( packedLanes(config), 3 );
+
+    PackedTypes packed;
+    CPPUNIT_ASSERT( packMatchTypes(config, packed) );
+
+    // The lanes are followed by the padding, up to the next multiple of
+    // the padding.
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed.size()), 2 * PACKED_TYPES_PADDING );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[0]), 2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[1]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[2]), 1 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[3]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[4]), 7 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[5]), 0 );
+    for (size_t i = 6; i < packed.size(); ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[i]), 0 );
+    }
+
+    // Wildcards in a process match list are packed as zeros.
+    ProcessBucketMatchList process(2);
+    process[0].match_types = TypeBucket(4);
+    process[0].match_types[0] = 1;
+    process[1].match_types = TypeBucket(4);
+    process[1].match_types[3] = 4;
+
+    CPPUNIT_ASSERT( packMatchTypes(process, packed) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed.size()), 2 * PACKED_TYPES_PADDING );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[0]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[1]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[2]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[5]), 4 );
+
+    // An empty list gives only the padding.
+    CPPUNIT_ASSERT_EQUAL( packedLanes(ConfigBucketMatchList(0)), 0 );
+    CPPUNIT_ASSERT( packMatchTypes(ConfigBucketMatchList(0), packed) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed.size()), PACKED_TYPES_PADDING );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_PackedTypes::testPackOverflow()
+{
+    // A count that does not fit in a lane gives empty packed types.
+    ConfigBucketMatchList config(3);
+    for (size_t i = 0; i < config.size(); ++i)
+    {
+        config[i].match_types = TypeBucket(2);
+        config[i].match_types[1] = PACKED_TYPES_MAX_COUNT;
+    }
+
+    PackedTypes packed;
+    CPPUNIT_ASSERT( packMatchTypes(config, packed) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[2]), PACKED_TYPES_MAX_COUNT );
+
+    config[2].match_types[1] = PACKED_TYPES_MAX_COUNT + 1;
+    CPPUNIT_ASSERT( !packMatchTypes(config, packed) );
+    CPPUNIT_ASSERT( packed.empty() );
+
+    // The multiplicity is then calculated without the packed types.
+    ProcessBucketMatchList process(3);
+    for (size_t i = 0; i < process.size(); ++i)
+    {
+        process[i].match_types = TypeBucket(2);
+    }
+    process[2].match_types[1] = 2;
+
+    PackedTypes process_packed;
+    CPPUNIT_ASSERT( packMatchTypes(process, process_packed) );
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( packedMultiplicity(process, process_packed, config, packed),
+                                  multiplicity(process, config), 1.0e-12 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_PackedTypes::testPackSiteTypes()
+{
+    // A configuration match list with a single atom at each entry.
+    ConfigBucketMatchList config(3);
+    config[0].match_types = TypeBucket(4);
+    config[0].match_types[2] = 1;
+    config[1].match_types = TypeBucket(4);
+    config[1].match_types[1] = 1;
+    config[2].match_types = TypeBucket(4);
+    config[2].match_types[3] = 1;
+
+    CPPUNIT_ASSERT_EQUAL( singleType(config[0].match_types), 2 );
+    CPPUNIT_ASSERT_EQUAL( singleType(config[2].match_types), 3 );
+
+    // One byte per entry, followed by the padding.
+    PackedTypes packed;
+    CPPUNIT_ASSERT( packSiteTypes(config, packed) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed.size()), PACKED_TYPES_PADDING * 2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[0]), 2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[1]), 1 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[2]), 3 );
+    for (size_t i = 3; i < packed.size(); ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[i]), 0 );
+    }
+
+    // Wildcards in a process match list are packed as zeros.
+    ProcessBucketMatchList process(2);
+    process[0].match_types = TypeBucket(4);
+    process[0].match_types[0] = 1;
+    process[1].match_types = TypeBucket(4);
+    process[1].match_types[3] = 1;
+
+    CPPUNIT_ASSERT_EQUAL( singleType(process[0].match_types), 0 );
+    CPPUNIT_ASSERT( packSiteTypes(process, packed) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed.size()), PACKED_TYPES_PADDING * 2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[0]), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(packed[1]), 3 );
+
+    // Empty sites and sites with more than one atom can not be packed.
+    config[1].match_types[1] = 0;
+    CPPUNIT_ASSERT_EQUAL( singleType(config[1].match_types), -1 );
+    CPPUNIT_ASSERT( !packSiteTypes(config, packed) );
+    CPPUNIT_ASSERT( packed.empty() );
+
+    config[1].match_types[1] = 2;
+    CPPUNIT_ASSERT_EQUAL( singleType(config[1].match_types), -1 );
+    CPPUNIT_ASSERT( !packSiteTypes(config, packed) );
+
+    config[1].match_types[1] = 1;
+    config[1].match_types[2] = 1;
+    CPPUNIT_ASSERT_EQUAL( singleType(config[1].match_types), -1 );
+    CPPUNIT_ASSERT( !packSiteTypes(config, packed) );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_PackedTypes::testMatch()
+{
+    seedRandom(false, 7731);
+
+    // Check the packed match against the bucket match for lists of
+    // different lengths and numbers of types, spanning several chunks.
+    int n_match = 0;
+    const int n_trials = 2000;
+    for (int trial = 0; trial < n_trials; ++trial)
+    {
+        const int n_entries = 1 + randomCount(40);
+        const int n_types   = 2 + randomCount(6);
+
+        const ConfigBucketMatchList config = randomConfigList(n_entries, n_types, 3);
+        const ProcessBucketMatchList process = randomProcessList(config, 0.01);
+
+        PackedTypes config_packed;
+        PackedTypes process_packed;
+        CPPUNIT_ASSERT( packMatchTypes(config, config_packed) );
+        CPPUNIT_ASSERT( packMatchTypes(process, process_packed) );
+
+        const bool match = packedMatch(&process_packed[0],
+                                       &config_packed[0],
+                                       n_entries * packedLanes(process));
+        CPPUNIT_ASSERT_EQUAL( match, scalarMatch(process, config) );
+
+        if (match)
+        {
+            ++n_match;
+        }
+
+        // A process match list may be shorter than the configuration
+        // match list it is compared with.
+        const ProcessBucketMatchList prefix(process.begin(), process.begin() + (n_entries + 1) / 2);
+        CPPUNIT_ASSERT( packMatchTypes(prefix, process_packed) );
+        CPPUNIT_ASSERT_EQUAL( packedMatch(&process_packed[0],
+                                          &config_packed[0],
+                                          prefix.size() * packedLanes(prefix)),
+                              scalarMatch(prefix, config) );
+    }
+
+    // Both outcomes were tested.
+    CPPUNIT_ASSERT( n_match > n_trials / 10 );
+    CPPUNIT_ASSERT( n_match < n_trials - n_trials / 10 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_PackedTypes::testMultiplicity()
+{
+    seedRandom(false, 5527);
+
+    // Check the packed multiplicity against the scalar one on matching lists.
+    int n_unit = 0;
+    const int n_trials = 2000;
+    for (int trial = 0; trial < n_trials; ++trial)
+    {
+        const int n_entries = 1 + randomCount(40);
+        const int n_types   = 2 + randomCount(6);
+
+        const ConfigBucketMatchList config = randomConfigList(n_entries, n_types, 3);
+        const ProcessBucketMatchList process = randomProcessList(config, 0.0);
+
+        PackedTypes config_packed;
+        PackedTypes process_packed;
+        CPPUNIT_ASSERT( packMatchTypes(config, config_packed) );
+        CPPUNIT_ASSERT( packMatchTypes(process, process_packed) );
+
+        const double m = multiplicity(process, config);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( packedMultiplicity(process, process_packed, config, config_packed),
+                                      m, 1.0e-12 );
+
+        const bool unit = packedUnitMultiplicity(&process_packed[0],
+                                                 &config_packed[0],
+                                                 n_entries * packedLanes(process));
+        CPPUNIT_ASSERT_EQUAL( unit, m == 1.0 );
+
+        if (unit)
+        {
+            ++n_unit;
+        }
+    }
+
+    // Both outcomes were tested.
+    CPPUNIT_ASSERT( n_unit > n_trials / 10 );
+    CPPUNIT_ASSERT( n_unit < n_trials - n_trials / 10 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_PackedTypes::testTiming()
+{
+    seedRandom(false, 4913);
+
+    // Time the match and multiplicity of a set of processes on a set of
+    // sites, with single occupancy of two types on a square lattice as in
+    // the Ising spin functest, and with up to three atoms of five types in
+    // the buckets of a cubic lattice as in the buckets functest.
+    const char * names[2] = { "Ising", "Buckets" };
+    const int entries[2]  = { 9, 27 };
+    const int types[2]    = { 3, 6 };
+    const int counts[2]   = { 1, 3 };
+
+    const int n_sites     = 1000;
+    const int n_processes = 20;
+    const int n_loop      = 50;
+
+    for (int t = 0; t < 2; ++t)
+    {
+        std::vector<ConfigBucketMatchList> config(n_sites);
+        std::vector<PackedTypes> config_packed(n_sites);
+        for (int i = 0; i < n_sites; ++i)
+        {
+            config[i] = randomConfigList(entries[t], types[t], counts[t]);
+            packMatchTypes(config[i], config_packed[i]);
+        }
+
+        std::vector<ProcessBucketMatchList> process(n_processes);
+        std::vector<PackedTypes> process_packed(n_processes);
+        for (int p = 0; p < n_processes; ++p)
+        {
+            process[p] = randomProcessList(config[p], 0.0);
+            packMatchTypes(process[p], process_packed[p]);
+        }
+
+        const int n_bytes = entries[t] * (types[t] - 1);
+
+        // The bucket match and scalar multiplicity.
+        double sum_scalar = 0.0;
+        const clock_t t0 = clock();
+        for (int l = 0; l < n_loop; ++l)
+        {
+            for (int i = 0; i < n_sites; ++i)
+            {
+                for (int p = 0; p < n_processes; ++p)
+                {
+                    if (scalarMatch(process[p], config[i]))
+                    {
+                        sum_scalar += multiplicity(process[p], config[i]);
+                    }
+                }
+            }
+        }
+
+        // The packed kernels.
+        double sum_packed = 0.0;
+        const clock_t t1 = clock();
+        for (int l = 0; l < n_loop; ++l)
+        {
+            for (int i = 0; i < n_sites; ++i)
+            {
+                for (int p = 0; p < n_processes; ++p)
+                {
+                    if (packedMatch(&process_packed[p][0], &config_packed[i][0], n_bytes))
+                    {
+                        sum_packed += packedMultiplicity(process[p], process_packed[p],
+                                                         config[i], config_packed[i]);
+                    }
+                }
+            }
+        }
+        const clock_t t2 = clock();
+
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( sum_scalar, sum_packed, 1.0e-6 );
+
+        const double scalar_time = static_cast<double>(t1 - t0) / CLOCKS_PER_SEC;
+        const double packed_time = static_cast<double>(t2 - t1) / CLOCKS_PER_SEC;
+        printf("\nTIMING: %s match lists, %i comparisons: bucket %f s, packed %f s\n",
+               names[t],
+               n_loop * n_sites * n_processes,
+               scalar_time,
+               packed_time);
+    }
+}
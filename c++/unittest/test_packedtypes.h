@@ -0,0 +1,41 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_PACKEDTYPES__
+#define __TEST_PACKEDTYPES__
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_PackedTypes : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_PackedTypes );
+    CPPUNIT_TEST( testPack );
+    CPPUNIT_TEST( testPackOverflow );
+    CPPUNIT_TEST( testPackSiteTypes );
+    CPPUNIT_TEST( testMatch );
+    CPPUNIT_TEST( testMultiplicity );
+    //CPPUNIT_TEST( testTiming );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testPack();
+    void testPackOverflow();
+    void testPackSiteTypes();
+    void testMatch();
+    void testMultiplicity();
+    void testTiming();
+
+};
+
+#endif
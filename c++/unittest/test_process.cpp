@@ -16,6 +16,7 @@
 #include "random.h"
 
 #include <cmath>
+#include <algorithm>
 
 // -------------------------------------------------------------------------- //
 //
@@ -849,6 +850,195 @@ void Test_Process::testClearSites()
 }
 
 
+// -------------------------------------------------------------------------- //
+//
+void Test_Process::testAddAndRemoveSiteSlots()
+{
+    // Setup a valid possible types map.
+    std::map<std::string,int> possible_types;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 0;
+
+    // Setup the two configurations.
+    std::vector<std::vector<std::string> > elements1;
+    elements1.push_back(std::vector<std::string>(1, "A"));
+    elements1.push_back(std::vector<std::string>(1, "B"));
+
+    std::vector<std::vector<std::string> > elements2;
+    elements2.push_back(std::vector<std::string>(1, "C"));
+    elements2.push_back(std::vector<std::string>(1, "B"));
+
+    // Setup coordinates.
+    std::vector<std::vector<double> > coords(2,std::vector<double>(3,0.0));
+    coords[1][0] =  1.0;
+    coords[1][1] =  1.3;
+    coords[1][2] = -4.4;
+
+    // The configurations.
+    const Configuration config1(coords, elements1, possible_types);
+    const Configuration config2(coords, elements2, possible_types);
+
+    // Construct the process.
+    const double rate = 1.0;
+    const std::vector<int> basis_sites(1,0);
+    Process process(config1, config2, rate, basis_sites);
+
+    // Randomly add and remove sites and compare against a reference.
+    const int n_indices = 200;
+    std::vector<bool> listed(n_indices, false);
+    seedRandom(false, 131);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const int index = static_cast<int>(randomDouble01() * n_indices);
+        if (listed[index])
+        {
+            process.removeSite(index);
+        }
+        else
+        {
+            process.addSite(index);
+        }
+        listed[index] = !listed[index];
+    }
+
+    int n_listed = 0;
+    for (int i = 0; i < n_indices; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( process.isListed(i), static_cast<bool>(listed[i]) );
+        if (listed[i])
+        {
+            ++n_listed;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(process.nSites()), n_listed );
+
+    // All listed sites appear exactly once.
+    std::vector<int> sites = process.sites();
+    std::sort(sites.begin(), sites.end());
+    CPPUNIT_ASSERT( std::unique(sites.begin(), sites.end()) == sites.end() );
+
+    // Clearing removes all sites from the lookup.
+    process.clearSites();
+    for (int i = 0; i < n_indices; ++i)
+    {
+        CPPUNIT_ASSERT( !process.isListed(i) );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Process::testRemoveSiteAt()
+{
+    // Setup a valid possible types map.
+    std::map<std::string,int> possible_types;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 0;
+
+    // Setup the two configurations.
+    std::vector<std::vector<std::string> > elements1;
+    elements1.push_back(std::vector<std::string>(1, "A"));
+    elements1.push_back(std::vector<std::string>(1, "B"));
+
+    std::vector<std::vector<std::string> > elements2;
+    elements2.push_back(std::vector<std::string>(1, "C"));
+    elements2.push_back(std::vector<std::string>(1, "B"));
+
+    // Setup coordinates.
+    std::vector<std::vector<double> > coords(2,std::vector<double>(3,0.0));
+    coords[1][0] =  1.0;
+    coords[1][1] =  1.3;
+    coords[1][2] = -4.4;
+
+    // The configurations.
+    const Configuration config1(coords, elements1, possible_types);
+    const Configuration config2(coords, elements2, possible_types);
+
+    // Construct the process.
+    const double rate = 1.0;
+    const std::vector<int> basis_sites(1,0);
+    Process process(config1, config2, rate, basis_sites);
+
+    // Randomly add and remove sites by slot, keeping the slots outside
+    // the process as the matcher does.
+    const int n_indices = 200;
+    std::vector<int> slots(n_indices, -1);
+    seedRandom(false, 137);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const int index = static_cast<int>(randomDouble01() * n_indices);
+        if (slots[index] >= 0)
+        {
+            const int slot = slots[index];
+            process.removeSiteAt(slot);
+            slots[index] = -1;
+            if (slot < static_cast<int>(process.nSites()))
+            {
+                slots[process.sites()[slot]] = slot;
+            }
+        }
+        else
+        {
+            process.addSite(index);
+            slots[index] = process.nSites() - 1;
+        }
+    }
+
+    // The kept slots match the sites of the process.
+    int n_listed = 0;
+    for (int i = 0; i < n_indices; ++i)
+    {
+        if (slots[i] >= 0)
+        {
+            CPPUNIT_ASSERT_EQUAL( process.sites()[slots[i]], i );
+            ++n_listed;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(process.nSites()), n_listed );
+
+    // Lookup by index still works, and is kept up to date from then on.
+    for (int i = 0; i < n_indices; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( process.isListed(i), slots[i] >= 0 );
+    }
+
+    // Toggle every other index by index, and remove the first slot.
+    std::vector<bool> listed(n_indices, false);
+    for (int i = 0; i < n_indices; ++i)
+    {
+        listed[i] = (slots[i] >= 0);
+    }
+
+    for (int i = 0; i < n_indices; i += 2)
+    {
+        if (listed[i])
+        {
+            process.removeSite(i);
+        }
+        else
+        {
+            process.addSite(i);
+        }
+        listed[i] = !listed[i];
+    }
+    listed[process.sites()[0]] = false;
+    process.removeSiteAt(0);
+
+    n_listed = 0;
+    for (int i = 0; i < n_indices; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( process.isListed(i), static_cast<bool>(listed[i]) );
+        if (listed[i])
+        {
+            ++n_listed;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(process.nSites()), n_listed );
+}
+
+
 // -------------------------------------------------------------------------- //
 //
 void Test_Process::testAddAndRemoveSiteMultiplicity()
@@ -1098,6 +1288,271 @@ void Test_Process::testPickSiteMultiplicity()
 }
 
 
+// -------------------------------------------------------------------------- //
+//
+void Test_Process::testPickSiteSelectionEngine()
+{
+    // Setup a valid possible types map.
+    std::map<std::string,int> possible_types;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 0;
+
+    // Setup the two configurations.
+    std::vector<std::vector<std::string> > elements1;
+    elements1.push_back(std::vector<std::string>(1, "A"));
+    elements1.push_back(std::vector<std::string>(1, "B"));
+
+    std::vector<std::vector<std::string> > elements2;
+    elements2.push_back(std::vector<std::string>(1, "C"));
+    elements2.push_back(std::vector<std::string>(1, "B"));
+
+    // Setup coordinates.
+    std::vector<std::vector<double> > coords(2,std::vector<double>(3,0.0));
+    coords[1][0] =  1.0;
+    coords[1][1] =  1.3;
+    coords[1][2] = -4.4;
+
+    // The configurations.
+    const Configuration config1(coords, elements1, possible_types);
+    const Configuration config2(coords, elements2, possible_types);
+
+    // Construct the process.
+    const double rate = 1.0;
+    const std::vector<int> basis_sites(1,0);
+    Process process(config1, config2, rate, basis_sites);
+    CPPUNIT_ASSERT_EQUAL( process.selectionEngine(), SUM_TREE );
+
+    // Add sites with the default engine and switch afterwards, so that
+    // the present site rates must be moved over.
+    process.addSite(12,  1.0, 3.0);
+    process.addSite(199, 1.0, 5.0);
+    process.addSite(3,   1.0, 2.0);
+    process.setSelectionEngine(COMPOSITION_REJECTION);
+    CPPUNIT_ASSERT_EQUAL( process.selectionEngine(), COMPOSITION_REJECTION );
+
+    // Add and remove sites with the new engine.
+    process.addSite(19,  1.0, 7.0);
+    process.removeSite(3);
+    process.updateRateTable();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( process.totalRate(), 15.0, 1.0e-12 );
+
+    // Get the sites.
+    int counter12  = 0;
+    int counter19  = 0;
+    int counter199 = 0;
+
+    seedRandom(false, 97);
+    const int n_loop = 1000000;
+
+    for (int i = 0; i < n_loop; ++i)
+    {
+        const int site = process.pickSite();
+        CPPUNIT_ASSERT( ! (site != 12 && site != 199 && site != 19) );
+
+        // Count how often each gets selected.
+        if (site == 12)
+        {
+            ++counter12;
+        }
+
+        if (site == 199)
+        {
+            ++counter199;
+        }
+
+        if (site == 19)
+        {
+            ++counter19;
+        }
+    }
+
+    // Test.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 3.0/15.0, 1.0 * counter12  / n_loop, 1.0e-2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.0/15.0, 1.0 * counter199 / n_loop, 1.0e-2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 7.0/15.0, 1.0 * counter19  / n_loop, 1.0e-2);
+
+    // Switch back and remove a site. Only site 19 may be picked after
+    // removing the other two.
+    process.setSelectionEngine(SUM_TREE);
+    process.removeSite(12);
+    process.removeSite(199);
+    for (int i = 0; i < 100; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( process.pickSite(), 19 );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Process::testUniformSiteRates()
+{
+    // Setup a valid possible types map.
+    std::map<std::string,int> possible_types;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 0;
+
+    // Setup the two configurations.
+    std::vector<std::vector<std::string> > elements1;
+    elements1.push_back(std::vector<std::string>(1, "A"));
+    elements1.push_back(std::vector<std::string>(1, "B"));
+
+    std::vector<std::vector<std::string> > elements2;
+    elements2.push_back(std::vector<std::string>(1, "C"));
+    elements2.push_back(std::vector<std::string>(1, "B"));
+
+    // Setup coordinates.
+    std::vector<std::vector<double> > coords(2,std::vector<double>(3,0.0));
+    coords[1][0] =  1.0;
+    coords[1][1] =  1.3;
+    coords[1][2] = -4.4;
+
+    // The configurations.
+    const Configuration config1(coords, elements1, possible_types);
+    const Configuration config2(coords, elements2, possible_types);
+
+    // Construct the process.
+    const double rate = 2.0;
+    const std::vector<int> basis_sites(1,0);
+    Process process(config1, config2, rate, basis_sites);
+    CPPUNIT_ASSERT( process.uniformSiteRates() );
+
+    // Sites with unit multiplicity keep the process in the uniform mode.
+    process.addSite(12);
+    process.addSite(199);
+    process.addSite(3);
+    process.removeSite(12);
+    CPPUNIT_ASSERT( process.uniformSiteRates() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( process.totalRate(), 4.0, 1.0e-12 );
+
+    seedRandom(false, 97);
+    const int n_loop = 1000000;
+    int counter3   = 0;
+    int counter199 = 0;
+    for (int i = 0; i < n_loop; ++i)
+    {
+        const int site = process.pickSite();
+        CPPUNIT_ASSERT( site == 3 || site == 199 );
+        if (site == 3)
+        {
+            ++counter3;
+        }
+        else
+        {
+            ++counter199;
+        }
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.5, 1.0 * counter3   / n_loop, 1.0e-2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.5, 1.0 * counter199 / n_loop, 1.0e-2);
+
+    // A site with a multiplicity larger than one makes the process fall
+    // back on the stored site rates.
+    process.addSite(19, 0.0, 2.0);
+    CPPUNIT_ASSERT( !process.uniformSiteRates() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( process.totalRate(), 8.0, 1.0e-12 );
+
+    counter3   = 0;
+    counter199 = 0;
+    int counter19 = 0;
+    for (int i = 0; i < n_loop; ++i)
+    {
+        const int site = process.pickSite();
+        if (site == 3)
+        {
+            ++counter3;
+        }
+        else if (site == 199)
+        {
+            ++counter199;
+        }
+        else if (site == 19)
+        {
+            ++counter19;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( counter3 + counter199 + counter19, n_loop );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.25, 1.0 * counter3   / n_loop, 1.0e-2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.25, 1.0 * counter199 / n_loop, 1.0e-2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.50, 1.0 * counter19  / n_loop, 1.0e-2);
+
+    // Removing sites with stored rates keeps the storage consistent.
+    process.removeSite(3);
+    process.removeSite(19);
+    for (int i = 0; i < 100; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( process.pickSite(), 199 );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Process::testTotalRateCompensation()
+{
+    // Setup a valid possible types map.
+    std::map<std::string,int> possible_types;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 0;
+
+    // Setup the two configurations.
+    std::vector<std::vector<std::string> > elements1;
+    elements1.push_back(std::vector<std::string>(1, "A"));
+    elements1.push_back(std::vector<std::string>(1, "B"));
+
+    std::vector<std::vector<std::string> > elements2;
+    elements2.push_back(std::vector<std::string>(1, "C"));
+    elements2.push_back(std::vector<std::string>(1, "B"));
+
+    // Setup coordinates.
+    std::vector<std::vector<double> > coords(2,std::vector<double>(3,0.0));
+    coords[1][0] =  1.0;
+    coords[1][1] =  1.3;
+    coords[1][2] = -4.4;
+
+    // The configurations.
+    const Configuration config1(coords, elements1, possible_types);
+    const Configuration config2(coords, elements2, possible_types);
+
+    // Construct the process without automatic resummation.
+    const double rate = 1.0;
+    const std::vector<int> basis_sites(1,0);
+    Process process(config1, config2, rate, basis_sites);
+    CPPUNIT_ASSERT_EQUAL( process.resummationInterval(), 1000000 );
+    process.setResummationInterval(0);
+    CPPUNIT_ASSERT_EQUAL( process.resummationInterval(), 0 );
+
+    // Adding unit rates to a very large rate loses them in a plain sum,
+    // since 1.0e16 + 1.0 rounds back to 1.0e16.
+    process.addSite(0, 0.0, 1.0e16);
+    for (int i = 1; i <= 1000; ++i)
+    {
+        process.addSite(i);
+    }
+
+    // Remove the large rate. The compensated total keeps the small ones.
+    process.removeSite(0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( process.totalRate(), 1000.0, 1.0e-12 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( process.totalRateDrift(), 0.0, 1.0e-12 );
+
+    // An explicit resummation gives the exact total.
+    process.resumTotalRate();
+    CPPUNIT_ASSERT_EQUAL( process.totalRate(), 1000.0 );
+    CPPUNIT_ASSERT_EQUAL( process.totalRateDrift(), 0.0 );
+
+    // With an interval the resummation happens automatically, which
+    // is seen by a total that is exactly the sum over the sites.
+    process.setResummationInterval(3);
+    process.addSite(1001, 0.0, 0.1);
+    process.addSite(1002, 0.0, 0.2);
+    process.addSite(1003, 0.0, 0.3);
+    CPPUNIT_ASSERT_EQUAL( process.totalRateDrift(), 0.0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( process.totalRate(), 1000.6, 1.0e-10 );
+}
+
+
 // -------------------------------------------------------------------------- //
 //
 void Test_Process::testAffectedIndices()
@@ -33,9 +33,14 @@ public:
     CPPUNIT_TEST( testMatchListLong );
     CPPUNIT_TEST( testAddAndRemoveSite );
     CPPUNIT_TEST( testClearSites );
+    CPPUNIT_TEST( testAddAndRemoveSiteSlots );
+    CPPUNIT_TEST( testRemoveSiteAt );
     CPPUNIT_TEST( testAddAndRemoveSiteMultiplicity );
     CPPUNIT_TEST( testPickSite );
     CPPUNIT_TEST( testPickSiteMultiplicity );
+    CPPUNIT_TEST( testPickSiteSelectionEngine );
+    CPPUNIT_TEST( testUniformSiteRates );
+    CPPUNIT_TEST( testTotalRateCompensation );
     CPPUNIT_TEST( testAffectedIndices );
     CPPUNIT_TEST( testCutoffAndRange );
     CPPUNIT_TEST( testProcessNumber );
@@ -51,9 +56,14 @@ public:
     void testMatchListLong();
     void testAddAndRemoveSite();
     void testClearSites();
+    void testAddAndRemoveSiteSlots();
+    void testRemoveSiteAt();
     void testAddAndRemoveSiteMultiplicity();
     void testPickSite();
     void testPickSiteMultiplicity();
+    void testPickSiteSelectionEngine();
+    void testUniformSiteRates();
+    void testTotalRateCompensation();
     void testAffectedIndices();
     void testCutoffAndRange();
     void testProcessNumber();
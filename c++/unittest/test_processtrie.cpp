@@ -0,0 +1,376 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_processtrie.h"
+
+// Include the files to test.
+#include "processtrie.h"
+
+#include "process.h"
+#include "configuration.h"
+#include "latticemap.h"
+#include "matchlist.h"
+#include "packedtypes.h"
+
+#include <algorithm>
+
+
+// -------------------------------------------------------------------------- //
+// Setup a process on a chain from the element at the center and
+// optionally at the left and right neighbours.
+static Process chainProcess(const std::string & center,
+                            const std::string & left,
+                            const std::string & right)
+{
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 3;
+
+    std::vector<std::vector<double> > coordinates(1, std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(1, std::vector<std::string>(1, center));
+
+    if (left != "")
+    {
+        std::vector<double> c(3, 0.0);
+        c[0] = -1.0;
+        coordinates.push_back(c);
+        elements.push_back(std::vector<std::string>(1, left));
+    }
+    if (right != "")
+    {
+        std::vector<double> c(3, 0.0);
+        c[0] = 1.0;
+        coordinates.push_back(c);
+        elements.push_back(std::vector<std::string>(1, right));
+    }
+
+    const Configuration config(coordinates, elements, possible_types);
+    return Process(config, config, 1.0, std::vector<int>(1, 0));
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ProcessTrie::testConstruction()
+{
+    // Default construction gives only the root, which matches nothing.
+    ProcessTrie trie;
+    CPPUNIT_ASSERT_EQUAL( trie.nNodes(), 1 );
+
+    std::vector<int> matching;
+    trie.match(ConfigBucketMatchList(0), matching);
+    CPPUNIT_ASSERT( matching.empty() );
+
+    // Building from no processes gives the same.
+    trie.build(std::vector<Process*>(0));
+    CPPUNIT_ASSERT_EQUAL( trie.nNodes(), 1 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ProcessTrie::testBuild()
+{
+    std::vector<Process> processes;
+    processes.push_back(chainProcess("A", "A", "B"));
+    processes.push_back(chainProcess("A", "A", "A"));
+    processes.push_back(chainProcess("A", "B", ""));
+    processes.push_back(chainProcess("B", "", ""));
+    processes.push_back(chainProcess("A", "A", "B"));
+    processes.push_back(chainProcess("A", "*", "B"));
+
+    std::vector<Process*> process_pointers;
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        process_pointers.push_back(&processes[i]);
+    }
+
+    ProcessTrie trie;
+    trie.build(process_pointers);
+
+    // The root, then A, AA, AAB, AAA, AB, B, A* and A*B, where the
+    // identical processes share the leaf.
+    CPPUNIT_ASSERT_EQUAL( trie.nNodes(), 9 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ProcessTrie::testMatch()
+{
+    // Setup a periodic chain.
+    const std::string chain = "AABABBBA";
+    const int n_sites = chain.size();
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 3;
+
+    std::vector<std::vector<double> > coordinates(n_sites, std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(n_sites);
+    for (int i = 0; i < n_sites; ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    Configuration config(coordinates, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = n_sites;
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // Setup processes with shared prefixes.
+    const std::string centers = "AB";
+    const std::string neighbours[4] = {"", "A", "B", "*"};
+    std::vector<Process> processes;
+    for (int c = 0; c < 2; ++c)
+    {
+        for (int l = 0; l < 4; ++l)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                if (neighbours[l] == "" && neighbours[r] != "")
+                {
+                    continue;
+                }
+                processes.push_back(chainProcess(centers.substr(c, 1), neighbours[l], neighbours[r]));
+            }
+        }
+    }
+
+    std::vector<Process*> process_pointers;
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        process_pointers.push_back(&processes[i]);
+    }
+
+    ProcessTrie trie;
+    trie.build(process_pointers);
+    CPPUNIT_ASSERT( trie.nNodes() < static_cast<int>(processes.size()) * 3 );
+
+    // Check against matching each process on its own.
+    for (int index = 0; index < n_sites; ++index)
+    {
+        const ConfigBucketMatchList & config_match_list = config.configMatchList(index);
+
+        std::vector<int> matching;
+        trie.match(config_match_list, matching);
+        std::sort(matching.begin(), matching.end());
+
+        std::vector<int> reference;
+        for (size_t p = 0; p < processes.size(); ++p)
+        {
+            if (whateverMatch(processes[p].processMatchList(), config_match_list))
+            {
+                reference.push_back(p);
+            }
+        }
+
+        CPPUNIT_ASSERT( !reference.empty() );
+        CPPUNIT_ASSERT( matching == reference );
+
+        // The same with the packed types of the configuration.
+        std::vector<int> packed_matching;
+        trie.match(config_match_list,
+                   config.packedMatchTypes(index),
+                   config.matchListSignature(index),
+                   packed_matching);
+        std::sort(packed_matching.begin(), packed_matching.end());
+        CPPUNIT_ASSERT( packed_matching == reference );
+
+        // And the packed types of each matching process give the
+        // multiplicity.
+        for (size_t i = 0; i < matching.size(); ++i)
+        {
+            const Process & process = processes[matching[i]];
+            CPPUNIT_ASSERT( !trie.packedMatchTypes(matching[i]).empty() );
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( packedMultiplicity(process.processMatchList(),
+                                                             trie.packedMatchTypes(matching[i]),
+                                                             config_match_list,
+                                                             config.packedMatchTypes(index)),
+                                          multiplicity(process.processMatchList(), config_match_list),
+                                          1.0e-12 );
+        }
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ProcessTrie::testMatchTypeSignature()
+{
+    // Setup a periodic chain without any C.
+    const std::string chain = "AABAABBA";
+    const int n_sites = chain.size();
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 3;
+
+    std::vector<std::vector<double> > coordinates(n_sites, std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(n_sites);
+    for (int i = 0; i < n_sites; ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    Configuration config(coordinates, elements, possible_types);
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = n_sites;
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    // Processes where some require a C.
+    std::vector<Process> processes;
+    processes.push_back(chainProcess("A", "A", "C"));
+    processes.push_back(chainProcess("A", "C", ""));
+    processes.push_back(chainProcess("A", "A", "B"));
+    processes.push_back(chainProcess("B", "*", "A"));
+    processes.push_back(chainProcess("C", "", ""));
+    processes.push_back(chainProcess("A", "*", "*"));
+
+    std::vector<Process*> process_pointers;
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        process_pointers.push_back(&processes[i]);
+    }
+
+    ProcessTrie trie;
+    trie.build(process_pointers);
+
+    // Matching with the signature of the configuration gives the same
+    // result as matching each process on its own.
+    for (int index = 0; index < n_sites; ++index)
+    {
+        const ConfigBucketMatchList & config_match_list = config.configMatchList(index);
+
+        std::vector<int> matching;
+        trie.match(config_match_list, config.matchListSignature(index), matching);
+        std::sort(matching.begin(), matching.end());
+
+        std::vector<int> reference;
+        for (size_t p = 0; p < processes.size(); ++p)
+        {
+            if (whateverMatch(processes[p].processMatchList(), config_match_list))
+            {
+                reference.push_back(p);
+            }
+        }
+
+        CPPUNIT_ASSERT( matching == reference );
+        CPPUNIT_ASSERT( std::find(matching.begin(), matching.end(), 0) == matching.end() );
+        CPPUNIT_ASSERT( std::find(matching.begin(), matching.end(), 1) == matching.end() );
+        CPPUNIT_ASSERT( std::find(matching.begin(), matching.end(), 4) == matching.end() );
+    }
+
+    // With no types present nothing matches, since all processes require
+    // a type at the center.
+    std::vector<int> matching;
+    trie.match(config.configMatchList(0), 0, matching);
+    CPPUNIT_ASSERT( matching.empty() );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ProcessTrie::testMatchSiteTypes()
+{
+    // Setup a periodic chain.
+    const std::string chain = "AABAABBA";
+    const int n_sites = chain.size();
+
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["B"] = 2;
+    possible_types["C"] = 3;
+
+    std::vector<std::vector<double> > coordinates(n_sites, std::vector<double>(3, 0.0));
+    std::vector<std::vector<std::string> > elements(n_sites);
+    for (int i = 0; i < n_sites; ++i)
+    {
+        coordinates[i][0] = i;
+        elements[i] = std::vector<std::string>(1, chain.substr(i, 1));
+    }
+    Configuration config(coordinates, elements, possible_types);
+    CPPUNIT_ASSERT( config.setSingleOccupancy(true) );
+
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = n_sites;
+    std::vector<bool> periodic(3, false);
+    periodic[0] = true;
+    const LatticeMap lattice_map(1, repetitions, periodic);
+    config.initMatchLists(lattice_map, 1);
+
+    std::vector<Process> processes;
+    processes.push_back(chainProcess("A", "A", "B"));
+    processes.push_back(chainProcess("B", "*", "A"));
+    processes.push_back(chainProcess("A", "*", "*"));
+    processes.push_back(chainProcess("B", "B", "A"));
+    processes.push_back(chainProcess("B", "A", "B"));
+    processes.push_back(chainProcess("A", "", ""));
+
+    std::vector<Process*> process_pointers;
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        process_pointers.push_back(&processes[i]);
+    }
+
+    ProcessTrie trie;
+    trie.build(process_pointers);
+    CPPUNIT_ASSERT( trie.singleOccupancy() );
+
+    // Matching on the single type of each entry gives the same result as
+    // matching each process on its own.
+    for (int index = 0; index < n_sites; ++index)
+    {
+        const ConfigBucketMatchList & config_match_list = config.configMatchList(index);
+
+        PackedTypes site_types;
+        config.siteMatchTypes(index, site_types);
+
+        std::vector<int> matching;
+        trie.match(config.matchListGeometry(index),
+                   site_types,
+                   config.matchListSignature(index),
+                   matching,
+                   true);
+        std::sort(matching.begin(), matching.end());
+
+        std::vector<int> reference;
+        for (size_t p = 0; p < processes.size(); ++p)
+        {
+            if (whateverMatch(processes[p].processMatchList(), config_match_list))
+            {
+                reference.push_back(p);
+            }
+        }
+
+        CPPUNIT_ASSERT( !reference.empty() );
+        CPPUNIT_ASSERT( matching == reference );
+    }
+
+    // A process requiring two atoms at a site can not be matched on
+    // single types.
+    processes[0].processMatchList()[0].match_types[1] = 2;
+    trie.build(process_pointers);
+    CPPUNIT_ASSERT( !trie.singleOccupancy() );
+}
@@ -0,0 +1,42 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_PROCESSTRIE__
+#define __TEST_PROCESSTRIE__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_ProcessTrie : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_ProcessTrie );
+    CPPUNIT_TEST( testConstruction );
+    CPPUNIT_TEST( testBuild );
+    CPPUNIT_TEST( testMatch );
+    CPPUNIT_TEST( testMatchTypeSignature );
+    CPPUNIT_TEST( testMatchSiteTypes );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testConstruction();
+    void testBuild();
+    void testMatch();
+    void testMatchTypeSignature();
+    void testMatchSiteTypes();
+
+};
+
+#endif
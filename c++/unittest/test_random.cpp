@@ -13,6 +13,10 @@
 #include "random.h"
 
 #include <cmath>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 
 // -------------------------------------------------------------------------- //
@@ -242,3 +246,114 @@ void Test_Random::testCallMINSTD()
     CPPUNIT_ASSERT_DOUBLES_EQUAL(rnd4, ref_rnd4, 1.0e-10);
 
 }
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Random::testThreadRandom()
+{
+    // Seed the shared generator.
+    setRngType(MT);
+    seedRandom(false, 13);
+
+    // Draw on a thread with its own stream.
+    std::vector<double> thread_numbers(3);
+    std::thread worker([&thread_numbers]()
+                       {
+                           seedThreadRandom(131);
+                           for (size_t i = 0; i < thread_numbers.size(); ++i)
+                           {
+                               thread_numbers[i] = randomDouble01();
+                           }
+                       });
+    worker.join();
+
+    // The thread stream is a std::mt19937 with the given seed.
+    std::mt19937 reference(131);
+    for (size_t i = 0; i < thread_numbers.size(); ++i)
+    {
+        const double ref = std::generate_canonical<double, 32>(reference);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(thread_numbers[i], ref, 1.0e-14);
+    }
+
+    // The shared generator on this thread is untouched.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), 0.777702410239726, 1.0e-10);
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Random::testScopedRandomStream()
+{
+    // Seed the shared generator and draw the reference numbers.
+    seedRandom(false, 17);
+    const double shared0 = randomDouble01();
+    const double shared1 = randomDouble01();
+    seedRandom(false, 17);
+
+    // Draw from a stream of our own while the scoped stream lives.
+    RandomStream stream(29);
+    RandomStream reference(29);
+    {
+        const ScopedRandomStream scoped(&stream);
+        const double number0 = std::generate_canonical<double, 32>(reference);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), number0, 1.0e-14);
+
+        // A NULL stream keeps the stream in use.
+        {
+            const ScopedRandomStream keep(NULL);
+            const double number1 = std::generate_canonical<double, 32>(reference);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), number1, 1.0e-14);
+        }
+        const double number2 = std::generate_canonical<double, 32>(reference);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), number2, 1.0e-14);
+    }
+
+    // The shared generator is used again, and was not drawn from.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), shared0, 1.0e-14);
+
+    // Scoped streams nest.
+    RandomStream other(31);
+    RandomStream other_reference(31);
+    {
+        const ScopedRandomStream scoped(&stream);
+        {
+            const ScopedRandomStream inner(&other);
+            const double number3 = std::generate_canonical<double, 32>(other_reference);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), number3, 1.0e-14);
+        }
+        const double number4 = std::generate_canonical<double, 32>(reference);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), number4, 1.0e-14);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(randomDouble01(), shared1, 1.0e-14);
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_Random::testRandomState()
+{
+    // Store the state, draw, restore and draw again.
+    seedRandom(false, 17);
+    randomDouble01();
+    const std::string state = randomState();
+    const double rnd0 = randomDouble01();
+    const double rnd1 = randomDouble01();
+    setRandomState(state);
+    CPPUNIT_ASSERT_EQUAL( randomDouble01(), rnd0 );
+    CPPUNIT_ASSERT_EQUAL( randomDouble01(), rnd1 );
+
+    // The same for another type of generator.
+    setRngType(RANLUX24);
+    seedRandom(false, 17);
+    const std::string ranlux_state = randomState();
+    const double rnd2 = randomDouble01();
+    setRandomState(ranlux_state);
+    CPPUNIT_ASSERT_EQUAL( randomDouble01(), rnd2 );
+
+    // A state of another type of generator is not accepted.
+    CPPUNIT_ASSERT_THROW( setRandomState(state), std::runtime_error );
+
+    // Reset.
+    setRngType(MT);
+}
@@ -29,6 +29,9 @@ public:
     CPPUNIT_TEST( testCallRANLUX24 );
     CPPUNIT_TEST( testCallRANLUX48 );
     CPPUNIT_TEST( testCallMINSTD );
+    CPPUNIT_TEST( testThreadRandom );
+    CPPUNIT_TEST( testScopedRandomStream );
+    CPPUNIT_TEST( testRandomState );
     CPPUNIT_TEST_SUITE_END();
 
     void testSeedAndCall();
@@ -36,6 +39,9 @@ public:
     void testCallRANLUX24();
     void testCallRANLUX48();
     void testCallMINSTD();
+    void testThreadRandom();
+    void testScopedRandomStream();
+    void testRandomState();
 
 };
 
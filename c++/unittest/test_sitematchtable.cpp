@@ -0,0 +1,129 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_sitematchtable.h"
+
+// Include the files to test.
+#include "sitematchtable.h"
+
+#include <algorithm>
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteMatchTable::testConstruction()
+{
+    // Construct and check that nothing is listed.
+    const SiteMatchTable table(17);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(table.size()), 17 );
+
+    for (int i = 0; i < 17; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( table.nListed(i), 0 );
+        CPPUNIT_ASSERT( !table.isListed(i, 0) );
+        CPPUNIT_ASSERT( !table.isListed(i, 3) );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteMatchTable::testAddAndRemove()
+{
+    SiteMatchTable table(5);
+
+    table.add(2, 7, 0);
+    table.add(2, 1, 5);
+    table.add(4, 7, 1);
+
+    CPPUNIT_ASSERT_EQUAL( table.nListed(2), 2 );
+    CPPUNIT_ASSERT_EQUAL( table.nListed(4), 1 );
+    CPPUNIT_ASSERT_EQUAL( table.nListed(3), 0 );
+    CPPUNIT_ASSERT( table.isListed(2, 7) );
+    CPPUNIT_ASSERT( table.isListed(2, 1) );
+    CPPUNIT_ASSERT( table.isListed(4, 7) );
+    CPPUNIT_ASSERT( !table.isListed(4, 1) );
+    CPPUNIT_ASSERT( !table.isListed(3, 7) );
+
+    // Each entry carries the slot of the site in the process.
+    CPPUNIT_ASSERT_EQUAL( table.slot(2, 7), 0 );
+    CPPUNIT_ASSERT_EQUAL( table.slot(2, 1), 5 );
+    CPPUNIT_ASSERT_EQUAL( table.slot(4, 7), 1 );
+    CPPUNIT_ASSERT_EQUAL( table.listedSlot(2, 1), 5 );
+
+    // Move the site of the first process to a different slot.
+    table.setSlot(4, 7, 0);
+    CPPUNIT_ASSERT_EQUAL( table.slot(4, 7), 0 );
+    CPPUNIT_ASSERT_EQUAL( table.slot(2, 7), 0 );
+    CPPUNIT_ASSERT_EQUAL( table.slot(2, 1), 5 );
+
+    // Remove the first entry, the last is moved into its place.
+    CPPUNIT_ASSERT_EQUAL( table.remove(2, 7), 0 );
+    CPPUNIT_ASSERT_EQUAL( table.nListed(2), 1 );
+    CPPUNIT_ASSERT_EQUAL( table.listed(2, 0), 1 );
+    CPPUNIT_ASSERT_EQUAL( table.listedSlot(2, 0), 5 );
+    CPPUNIT_ASSERT( !table.isListed(2, 7) );
+    CPPUNIT_ASSERT( table.isListed(4, 7) );
+
+    // Remove the last entry.
+    CPPUNIT_ASSERT_EQUAL( table.remove(2, 1), 5 );
+    CPPUNIT_ASSERT_EQUAL( table.nListed(2), 0 );
+    CPPUNIT_ASSERT( !table.isListed(2, 1) );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteMatchTable::testOverflow()
+{
+    // List more processes than fit in place.
+    SiteMatchTable table(3);
+    const int n = 11;
+    for (int p = 0; p < n; ++p)
+    {
+        table.add(1, 3*p, 100 + p);
+    }
+    CPPUNIT_ASSERT_EQUAL( table.nListed(1), n );
+
+    for (int p = 0; p < 3*n; ++p)
+    {
+        CPPUNIT_ASSERT_EQUAL( table.isListed(1, p), p % 3 == 0 );
+    }
+
+    // Remove in a mixed order and check the remaining list each time.
+    std::vector<int> remaining;
+    for (int p = 0; p < n; ++p)
+    {
+        remaining.push_back(3*p);
+    }
+
+    const int order[11] = {4, 0, 10, 7, 1, 2, 9, 3, 5, 8, 6};
+    for (int i = 0; i < n; ++i)
+    {
+        const int process = 3*order[i];
+        CPPUNIT_ASSERT_EQUAL( table.slot(1, process), 100 + order[i] );
+        CPPUNIT_ASSERT_EQUAL( table.remove(1, process), 100 + order[i] );
+        remaining.erase(std::find(remaining.begin(), remaining.end(), process));
+
+        CPPUNIT_ASSERT_EQUAL( table.nListed(1), static_cast<int>(remaining.size()) );
+
+        std::vector<int> listed;
+        for (int j = 0; j < table.nListed(1); ++j)
+        {
+            listed.push_back(table.listed(1, j));
+            CPPUNIT_ASSERT_EQUAL( table.listedSlot(1, j), 100 + table.listed(1, j) / 3 );
+        }
+        std::sort(listed.begin(), listed.end());
+        CPPUNIT_ASSERT( listed == remaining );
+    }
+
+    // The other sites are untouched.
+    CPPUNIT_ASSERT_EQUAL( table.nListed(0), 0 );
+    CPPUNIT_ASSERT_EQUAL( table.nListed(2), 0 );
+}
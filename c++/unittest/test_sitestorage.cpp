@@ -0,0 +1,303 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_sitestorage.h"
+
+// Include the files to test.
+#include "sitestorage.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+
+// -------------------------------------------------------------------------- //
+// Create a storage file with a single atom at each site.
+static void createStorage(const std::string & path, const int n_sites, const int n_types)
+{
+    SiteStorage storage(path, n_sites, n_types);
+    for (int i = 0; i < n_sites; ++i)
+    {
+        storage.setSite(i, Coordinate(1.0 * i, 2.0 * i, 0.5), 1 + i % (n_types - 1));
+    }
+    storage.flush();
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteStorage::testHeapStorage()
+{
+    SiteStorage storage(4, 3);
+    CPPUNIT_ASSERT( !storage.mapped() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.size()), 4 );
+    CPPUNIT_ASSERT_EQUAL( storage.nTypes(), 3 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.typeCounts().size()), 12 );
+    CPPUNIT_ASSERT_EQUAL( storage.atomID()[3], 0 );
+
+    // Set a site.
+    storage.setSite(2, Coordinate(1.0, 2.0, 3.0), 2);
+    CPPUNIT_ASSERT( storage.coordinates()[2] == Coordinate(1.0, 2.0, 3.0) );
+    CPPUNIT_ASSERT( storage.atomIDCoordinates()[2] == Coordinate(1.0, 2.0, 3.0) );
+    CPPUNIT_ASSERT_EQUAL( storage.atomID()[2], 2 );
+    CPPUNIT_ASSERT_EQUAL( storage.firstTypes()[2], 2 );
+    CPPUNIT_ASSERT_EQUAL( storage.atomIDTypes()[2], 2 );
+    CPPUNIT_ASSERT_EQUAL( storage.typeCounts()[6], 0 );
+    CPPUNIT_ASSERT_EQUAL( storage.typeCounts()[7], 0 );
+    CPPUNIT_ASSERT_EQUAL( storage.typeCounts()[8], 1 );
+
+    // A copy holds its own values.
+    SiteStorage copy(storage);
+    CPPUNIT_ASSERT( !copy.mapped() );
+    CPPUNIT_ASSERT( copy.atomID() == storage.atomID() );
+    copy.atomID()[2] = 7;
+    CPPUNIT_ASSERT_EQUAL( storage.atomID()[2], 2 );
+    CPPUNIT_ASSERT( copy.atomID() != storage.atomID() );
+
+    // So does a copy of an array.
+    SiteArray<int> types = storage.firstTypes();
+    types[2] = 1;
+    CPPUNIT_ASSERT_EQUAL( storage.firstTypes()[2], 2 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteStorage::testCreateAndMap()
+{
+    const std::string path = "test_sitestorage_map.kmc";
+    const int n_sites = 3000;
+    createStorage(path, n_sites, 4);
+
+    const SiteStorage storage(path);
+    CPPUNIT_ASSERT( storage.mapped() );
+    CPPUNIT_ASSERT_EQUAL( storage.path(), path );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.size()), n_sites );
+    CPPUNIT_ASSERT_EQUAL( storage.nTypes(), 4 );
+
+    for (int i = 0; i < n_sites; ++i)
+    {
+        const int type = 1 + i % 3;
+        CPPUNIT_ASSERT_EQUAL( storage.coordinates()[i].x(), 1.0 * i );
+        CPPUNIT_ASSERT_EQUAL( storage.coordinates()[i].y(), 2.0 * i );
+        CPPUNIT_ASSERT_EQUAL( storage.coordinates()[i].z(), 0.5 );
+        CPPUNIT_ASSERT_EQUAL( storage.atomIDCoordinates()[i].x(), 1.0 * i );
+        CPPUNIT_ASSERT_EQUAL( storage.atomID()[i], i );
+        CPPUNIT_ASSERT_EQUAL( storage.firstTypes()[i], type );
+        CPPUNIT_ASSERT_EQUAL( storage.atomIDTypes()[i], type );
+        for (int j = 0; j < 4; ++j)
+        {
+            CPPUNIT_ASSERT_EQUAL( storage.typeCounts()[4 * i + j], (j == type) ? 1 : 0 );
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteStorage::testLayout()
+{
+    const std::string path = "test_sitestorage_layout.kmc";
+    const int n_sites = 200;
+    createStorage(path, n_sites, 3);
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+    file.close();
+
+    // The header.
+    CPPUNIT_ASSERT( std::memcmp(&bytes[0], "KMCLIBSS", 8) == 0 );
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned long long n;
+    unsigned long long m;
+    std::memcpy(&version, &bytes[8], 4);
+    std::memcpy(&byte_order, &bytes[12], 4);
+    std::memcpy(&n, &bytes[16], 8);
+    std::memcpy(&m, &bytes[24], 8);
+    CPPUNIT_ASSERT_EQUAL( version, SITE_STORAGE_VERSION );
+    CPPUNIT_ASSERT_EQUAL( byte_order, 0x01020304U );
+    CPPUNIT_ASSERT_EQUAL( n, 200ULL );
+    CPPUNIT_ASSERT_EQUAL( m, 3ULL );
+
+    // Each array starts on the next multiple of the alignment.
+    const size_t a = SITE_STORAGE_ALIGNMENT;
+    const size_t coordinates = a;
+    const size_t atom_id_coordinates = coordinates + a * ((n_sites * 24 + a - 1) / a);
+    const size_t atom_ids = atom_id_coordinates + a * ((n_sites * 24 + a - 1) / a);
+    const size_t first_types = atom_ids + a * ((n_sites * 4 + a - 1) / a);
+    const size_t atom_id_types = first_types + a * ((n_sites * 4 + a - 1) / a);
+    const size_t type_counts = atom_id_types + a * ((n_sites * 4 + a - 1) / a);
+    const size_t end = type_counts + a * ((n_sites * 12 + a - 1) / a);
+    CPPUNIT_ASSERT_EQUAL( bytes.size(), end );
+
+    const int site = 123;
+    double x[3];
+    std::memcpy(x, &bytes[coordinates + 24 * site], 24);
+    CPPUNIT_ASSERT_EQUAL( x[0], 123.0 );
+    CPPUNIT_ASSERT_EQUAL( x[1], 246.0 );
+    CPPUNIT_ASSERT_EQUAL( x[2], 0.5 );
+    std::memcpy(x, &bytes[atom_id_coordinates + 24 * site], 24);
+    CPPUNIT_ASSERT_EQUAL( x[1], 246.0 );
+
+    int value;
+    std::memcpy(&value, &bytes[atom_ids + 4 * site], 4);
+    CPPUNIT_ASSERT_EQUAL( value, site );
+    std::memcpy(&value, &bytes[first_types + 4 * site], 4);
+    CPPUNIT_ASSERT_EQUAL( value, 2 );
+    std::memcpy(&value, &bytes[atom_id_types + 4 * site], 4);
+    CPPUNIT_ASSERT_EQUAL( value, 2 );
+    std::memcpy(&value, &bytes[type_counts + 12 * site + 8], 4);
+    CPPUNIT_ASSERT_EQUAL( value, 1 );
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteStorage::testCopyMapped()
+{
+    const std::string path = "test_sitestorage_copy.kmc";
+    const int n_sites = 5000;
+    createStorage(path, n_sites, 3);
+
+    SiteStorage storage(path);
+    storage.atomIDTypes()[10] = 2;
+    storage.atomIDCoordinates()[4000] = Coordinate(-1.0, -2.0, -3.0);
+
+    // The copy maps the file and has the changes of the original.
+    SiteStorage copy(storage);
+    CPPUNIT_ASSERT( copy.mapped() );
+    CPPUNIT_ASSERT( copy.coordinates().data() != storage.coordinates().data() );
+    CPPUNIT_ASSERT( copy.coordinates() == storage.coordinates() );
+    CPPUNIT_ASSERT( copy.atomIDTypes() == storage.atomIDTypes() );
+    CPPUNIT_ASSERT( copy.atomIDCoordinates() == storage.atomIDCoordinates() );
+    CPPUNIT_ASSERT_EQUAL( copy.atomIDTypes()[10], 2 );
+
+    // Changes to the copy are its own, and neither is written to the file.
+    copy.atomID()[20] = 21;
+    CPPUNIT_ASSERT_EQUAL( storage.atomID()[20], 20 );
+
+    const SiteStorage reread(path);
+    CPPUNIT_ASSERT_EQUAL( reread.atomIDTypes()[10], 1 + 10 % 2 );
+    CPPUNIT_ASSERT_EQUAL( reread.atomID()[20], 20 );
+
+    // Assignment of a storage on the heap.
+    copy = SiteStorage(2, 3);
+    CPPUNIT_ASSERT( !copy.mapped() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(copy.size()), 2 );
+
+    // Assignment of a mapped storage.
+    copy = storage;
+    CPPUNIT_ASSERT( copy.mapped() );
+    CPPUNIT_ASSERT( copy.atomIDCoordinates() == storage.atomIDCoordinates() );
+
+    std::remove(path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteStorage::testReleaseTypes()
+{
+    const std::string path = "test_sitestorage_release.kmc";
+    const std::string written_path = "test_sitestorage_release_written.kmc";
+    const int n_sites = 3000;
+    createStorage(path, n_sites, 3);
+
+    // Releasing the types of a mapped storage empties the arrays, also of
+    // a copy.
+    SiteStorage storage(path);
+    storage.typeCounts()[1] = 0;
+    storage.releaseTypes();
+    CPPUNIT_ASSERT( storage.typesReleased() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.firstTypes().size()), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.typeCounts().size()), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.atomIDTypes().size()), n_sites );
+
+    const SiteStorage copy(storage);
+    CPPUNIT_ASSERT( copy.typesReleased() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(copy.typeCounts().size()), 0 );
+
+    // Writing needs the types to be given, and writes a single atom of
+    // the given type at each site.
+    CPPUNIT_ASSERT_THROW( storage.write(written_path), std::runtime_error );
+    std::vector<unsigned char> single_types(n_sites, 2);
+    single_types[7] = 1;
+    storage.write(written_path, &single_types[0]);
+    {
+        const SiteStorage written(written_path);
+        CPPUNIT_ASSERT( !written.typesReleased() );
+        CPPUNIT_ASSERT_EQUAL( written.firstTypes()[7], 1 );
+        CPPUNIT_ASSERT_EQUAL( written.firstTypes()[8], 2 );
+        CPPUNIT_ASSERT_EQUAL( written.typeCounts()[7 * 3 + 1], 1 );
+        CPPUNIT_ASSERT_EQUAL( written.typeCounts()[7 * 3 + 2], 0 );
+        CPPUNIT_ASSERT_EQUAL( written.typeCounts()[8 * 3 + 1], 0 );
+        CPPUNIT_ASSERT_EQUAL( written.typeCounts()[8 * 3 + 2], 1 );
+        CPPUNIT_ASSERT( written.coordinates() == storage.coordinates() );
+    }
+
+    // Restoring the types of a mapped storage reads them from the file.
+    storage.restoreTypes();
+    CPPUNIT_ASSERT( !storage.typesReleased() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(storage.typeCounts().size()), 3 * n_sites );
+    CPPUNIT_ASSERT_EQUAL( storage.typeCounts()[1], 1 );
+    CPPUNIT_ASSERT_EQUAL( storage.firstTypes()[1], 2 );
+
+    // The types of a storage on the heap are restored as zeros.
+    SiteStorage heap(4, 3);
+    heap.typeCounts()[5] = 1;
+    heap.releaseTypes();
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(heap.typeCounts().size()), 0 );
+    heap.restoreTypes();
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(heap.typeCounts().size()), 12 );
+    CPPUNIT_ASSERT_EQUAL( heap.typeCounts()[5], 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(heap.firstTypes().size()), 4 );
+
+    std::remove(path.c_str());
+    std::remove(written_path.c_str());
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SiteStorage::testBadFiles()
+{
+    // A missing file.
+    CPPUNIT_ASSERT_THROW( SiteStorage storage("test_sitestorage_missing.kmc"),
+                          std::runtime_error );
+
+    // A file that is not a storage file.
+    const std::string path = "test_sitestorage_bad.kmc";
+    {
+        std::ofstream file(path.c_str());
+        file << "Not a site storage file, but long enough for the header.";
+    }
+    CPPUNIT_ASSERT_THROW( SiteStorage storage(path), std::runtime_error );
+
+    // A truncated file.
+    createStorage(path, 2000, 3);
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        std::vector<char> bytes(8192);
+        in.read(&bytes[0], bytes.size());
+        in.close();
+        std::ofstream out(path.c_str(), std::ios::binary);
+        out.write(&bytes[0], bytes.size());
+    }
+    CPPUNIT_ASSERT_THROW( SiteStorage storage(path), std::runtime_error );
+
+    std::remove(path.c_str());
+}
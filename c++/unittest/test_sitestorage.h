@@ -0,0 +1,43 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_SITESTORAGE__
+#define __TEST_SITESTORAGE__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_SiteStorage : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_SiteStorage );
+    CPPUNIT_TEST( testHeapStorage );
+    CPPUNIT_TEST( testCreateAndMap );
+    CPPUNIT_TEST( testLayout );
+    CPPUNIT_TEST( testCopyMapped );
+    CPPUNIT_TEST( testReleaseTypes );
+    CPPUNIT_TEST( testBadFiles );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testHeapStorage();
+    void testCreateAndMap();
+    void testLayout();
+    void testCopyMapped();
+    void testReleaseTypes();
+    void testBadFiles();
+};
+
+#endif
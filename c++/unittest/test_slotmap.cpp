@@ -0,0 +1,153 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_slotmap.h"
+
+// Include the files to test.
+#include "slotmap.h"
+
+#include "random.h"
+
+#include <algorithm>
+#include <map>
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SlotMap::testConstruction()
+{
+    // Default construction gives an empty map.
+    const SlotMap map;
+    CPPUNIT_ASSERT_EQUAL( map.size(), static_cast<size_t>(0) );
+    CPPUNIT_ASSERT_EQUAL( map.find(0), -1L );
+    CPPUNIT_ASSERT_EQUAL( map.find(12), -1L );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SlotMap::testSetFindErase()
+{
+    SlotMap map;
+
+    // Insert keys past the initial number of buckets.
+    for (int i = 0; i < 20; ++i)
+    {
+        map.set(3 * i, i);
+    }
+    CPPUNIT_ASSERT_EQUAL( map.size(), static_cast<size_t>(20) );
+
+    for (int i = 0; i < 20; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( map.find(3 * i), static_cast<long>(i) );
+        CPPUNIT_ASSERT_EQUAL( map.find(3 * i + 1), -1L );
+    }
+
+    // Setting a present key changes its slot.
+    map.set(9, 100);
+    CPPUNIT_ASSERT_EQUAL( map.size(), static_cast<size_t>(20) );
+    CPPUNIT_ASSERT_EQUAL( map.find(9), 100L );
+
+    // Erasing gives back the slot.
+    CPPUNIT_ASSERT_EQUAL( map.erase(9), static_cast<size_t>(100) );
+    CPPUNIT_ASSERT_EQUAL( map.erase(0), static_cast<size_t>(0) );
+    CPPUNIT_ASSERT_EQUAL( map.size(), static_cast<size_t>(18) );
+    CPPUNIT_ASSERT_EQUAL( map.find(9), -1L );
+    CPPUNIT_ASSERT_EQUAL( map.find(0), -1L );
+    CPPUNIT_ASSERT_EQUAL( map.find(57), 19L );
+
+    // Clear.
+    map.clear();
+    CPPUNIT_ASSERT_EQUAL( map.size(), static_cast<size_t>(0) );
+    CPPUNIT_ASSERT_EQUAL( map.find(57), -1L );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SlotMap::testRandomOperations()
+{
+    // Check a long random sequence of operations against a std::map.
+    seedRandom(false, 1391);
+
+    SlotMap map;
+    std::map<int, size_t> reference;
+
+    for (int n = 0; n < 20000; ++n)
+    {
+        const int key = static_cast<int>(randomDouble01() * 300);
+        std::map<int, size_t>::iterator it = reference.find(key);
+
+        if (it != reference.end() && randomDouble01() < 0.5)
+        {
+            CPPUNIT_ASSERT_EQUAL( map.erase(key), it->second );
+            reference.erase(it);
+        }
+        else
+        {
+            map.set(key, n);
+            reference[key] = n;
+        }
+
+        CPPUNIT_ASSERT_EQUAL( map.size(), reference.size() );
+    }
+
+    for (int key = 0; key < 300; ++key)
+    {
+        std::map<int, size_t>::const_iterator it = reference.find(key);
+        const long slot = (it == reference.end()) ? -1 : static_cast<long>(it->second);
+        CPPUNIT_ASSERT_EQUAL( map.find(key), slot );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SlotMap::testStridedKeys()
+{
+    // Keys with a power of two stride, e.g. the first site of each cell
+    // of a lattice, must still be spread over all buckets.
+    const int strides[] = {1, 64, 1024, 1 << 16};
+    for (size_t s = 0; s < 4; ++s)
+    {
+        const int stride = strides[s];
+        const int n_keys = 4096;
+
+        SlotMap map;
+        for (int i = 0; i < n_keys; ++i)
+        {
+            map.set(i * stride, i);
+        }
+        CPPUNIT_ASSERT_EQUAL( map.size(), static_cast<size_t>(n_keys) );
+
+        size_t max_probes = 0;
+        size_t sum_probes = 0;
+        for (int i = 0; i < n_keys; ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL( map.find(i * stride), static_cast<long>(i) );
+            const size_t probes = map.probes(i * stride);
+            max_probes = std::max(max_probes, probes);
+            sum_probes += probes;
+        }
+
+        // The probe sequences stay short at the at most half full table.
+        CPPUNIT_ASSERT( max_probes <= 16 );
+        CPPUNIT_ASSERT( sum_probes <= 2 * static_cast<size_t>(n_keys) );
+
+        // Erasing every other key keeps the rest reachable.
+        for (int i = 0; i < n_keys; i += 2)
+        {
+            CPPUNIT_ASSERT_EQUAL( map.erase(i * stride), static_cast<size_t>(i) );
+        }
+        for (int i = 0; i < n_keys; ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL( map.find(i * stride), (i % 2) ? static_cast<long>(i) : -1L );
+        }
+    }
+}
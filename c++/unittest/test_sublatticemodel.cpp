@@ -0,0 +1,302 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_sublatticemodel.h"
+
+// Include the files to test.
+#include "sublatticemodel.h"
+
+// Other inclusions.
+#include "latticemodel.h"
+#include "configuration.h"
+#include "latticemap.h"
+#include "interactions.h"
+#include "random.h"
+#include "simulationtimer.h"
+#include "customrateprocess.h"
+#include "ratecalculator.h"
+
+#include <stdexcept>
+
+
+// -------------------------------------------------------------------------- //
+// Setup the possible types for the tests below.
+static std::map<std::string, int> possibleTypes()
+{
+    std::map<std::string, int> possible_types;
+    possible_types["*"] = 0;
+    possible_types["A"] = 1;
+    possible_types["V"] = 2;
+    return possible_types;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup the coordinates of an n x n square lattice.
+static std::vector<std::vector<double> > squareCoordinates(const int n)
+{
+    std::vector<std::vector<double> > coordinates;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> c(3, 0.0);
+            c[0] = i;
+            c[1] = j;
+            coordinates.push_back(c);
+        }
+    }
+    return coordinates;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup a random half filling of A atoms among vacancies.
+static std::vector<std::vector<std::string> > randomElements(const int n_sites)
+{
+    std::vector<std::vector<std::string> > elements;
+    for (int i = 0; i < n_sites; ++i)
+    {
+        const std::string element = (randomDouble01() < 0.5) ? "A" : "V";
+        elements.push_back(std::vector<std::string>(1, element));
+    }
+    return elements;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup the processes for an A hopping to a vacant nearest neighbour
+// on the square lattice.
+static std::vector<Process> hoppingProcesses()
+{
+    std::vector<std::vector<std::string> > elements1(2);
+    elements1[0] = std::vector<std::string>(1, "A");
+    elements1[1] = std::vector<std::string>(1, "V");
+
+    std::vector<std::vector<std::string> > elements2(2);
+    elements2[0] = std::vector<std::string>(1, "V");
+    elements2[1] = std::vector<std::string>(1, "A");
+
+    const double dx[4] = {1.0, -1.0, 0.0,  0.0};
+    const double dy[4] = {0.0,  0.0, 1.0, -1.0};
+
+    std::vector<Process> processes;
+    for (int d = 0; d < 4; ++d)
+    {
+        std::vector<std::vector<double> > coordinates(2, std::vector<double>(3, 0.0));
+        coordinates[1][0] = dx[d];
+        coordinates[1][1] = dy[d];
+
+        Configuration c1(coordinates, elements1, possibleTypes());
+        Configuration c2(coordinates, elements2, possibleTypes());
+        processes.push_back(Process(c1, c2, 1.0, std::vector<int>(1, 0)));
+    }
+    return processes;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Setup the lattice map for an n x n square lattice.
+static LatticeMap squareLatticeMap(const int n)
+{
+    std::vector<int> repetitions(3, 1);
+    repetitions[0] = n;
+    repetitions[1] = n;
+    std::vector<bool> periodic(3, true);
+    periodic[2] = false;
+    return LatticeMap(1, repetitions, periodic);
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SublatticeModel::testConstruction()
+{
+    const int n = 6;
+    seedRandom(false, 3);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+    SimulationTimer timer;
+
+    // Construct.
+    SublatticeModel model(configuration, timer, lattice_map, interactions, 2, 0.5);
+    CPPUNIT_ASSERT_EQUAL( model.nThreads(), 2 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( model.timeWindow(), 0.5, 1.0e-14 );
+
+    // Invalid parameters.
+    CPPUNIT_ASSERT_THROW( SublatticeModel(configuration, timer, lattice_map, interactions, 0, 0.5),
+                          std::runtime_error );
+    CPPUNIT_ASSERT_THROW( SublatticeModel(configuration, timer, lattice_map, interactions, 2, 0.0),
+                          std::runtime_error );
+
+    // Custom rates are not supported.
+    std::vector<CustomRateProcess> custom_processes;
+    const std::vector<Process> processes = hoppingProcesses();
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        std::vector<std::vector<double> > process_coordinates(1, std::vector<double>(3, 0.0));
+        std::vector<std::vector<std::string> > process_elements(1, std::vector<std::string>(1, "A"));
+        Configuration c1(process_coordinates, process_elements, possibleTypes());
+        custom_processes.push_back(CustomRateProcess(c1, c1, 1.0, std::vector<int>(1, 0), 1.0));
+    }
+    const RateCalculator rate_calculator;
+    const Interactions custom_interactions(custom_processes, true, rate_calculator);
+    CPPUNIT_ASSERT_THROW( SublatticeModel(configuration, timer, lattice_map, custom_interactions, 2, 0.5),
+                          std::runtime_error );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SublatticeModel::testPartition()
+{
+    // A 12 x 12 lattice with range one gives blocks of three cells.
+    const int n = 12;
+    seedRandom(false, 5);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+    CPPUNIT_ASSERT_EQUAL( interactions.maxRange(), 1 );
+    SimulationTimer timer;
+
+    SublatticeModel model(configuration, timer, lattice_map, interactions, 4, 0.1);
+
+    CPPUNIT_ASSERT_EQUAL( model.blocksPerDirection()[0], 4 );
+    CPPUNIT_ASSERT_EQUAL( model.blocksPerDirection()[1], 4 );
+    CPPUNIT_ASSERT_EQUAL( model.blocksPerDirection()[2], 1 );
+    CPPUNIT_ASSERT_EQUAL( model.nBlocks(), 16 );
+    CPPUNIT_ASSERT_EQUAL( model.nColours(), 4 );
+
+    // Check the block of each index, and that neighbouring blocks have
+    // different colours.
+    for (int index = 0; index < n*n; ++index)
+    {
+        int i, j, k;
+        lattice_map.indexToCell(index, i, j, k);
+        const int block = model.blockOfIndex(index);
+        CPPUNIT_ASSERT_EQUAL( block, (i / 3) * 4 + j / 3 );
+
+        const int block_i = ((i / 3 + 1) % 4) * 4 + j / 3;
+        const int block_j = (i / 3) * 4 + (j / 3 + 1) % 4;
+        CPPUNIT_ASSERT( model.colourOfBlock(block) != model.colourOfBlock(block_i) );
+        CPPUNIT_ASSERT( model.colourOfBlock(block) != model.colourOfBlock(block_j) );
+    }
+
+    // Each block lists only its own sites.
+    for (int block = 0; block < model.nBlocks(); ++block)
+    {
+        const std::vector<Process*> & processes = model.blockInteractions(block).processes();
+        for (size_t p = 0; p < processes.size(); ++p)
+        {
+            const std::vector<int> & sites = processes[p]->sites();
+            for (size_t s = 0; s < sites.size(); ++s)
+            {
+                CPPUNIT_ASSERT_EQUAL( model.blockOfIndex(sites[s]), block );
+            }
+        }
+    }
+
+    // The matching is the same as for the serial model.
+    Configuration reference_configuration(coordinates, configuration.elements(), possibleTypes());
+    SimulationTimer reference_timer;
+    LatticeModel reference(reference_configuration, reference_timer, lattice_map, interactions);
+    CPPUNIT_ASSERT_EQUAL( model.totalAvailableSites(), reference.interactions().totalAvailableSites() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( model.totalRate(), reference.interactions().totalRate(), 1.0e-10 );
+
+    // A lattice too small to be divided gives a single block.
+    const int n_small = 5;
+    const std::vector<std::vector<double> > small_coordinates = squareCoordinates(n_small);
+    Configuration small_configuration(small_coordinates, randomElements(n_small*n_small), possibleTypes());
+    SublatticeModel small_model(small_configuration, timer, squareLatticeMap(n_small), interactions, 4, 0.1);
+    CPPUNIT_ASSERT_EQUAL( small_model.nBlocks(), 1 );
+    CPPUNIT_ASSERT_EQUAL( small_model.nColours(), 1 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SublatticeModel::testRunCycles()
+{
+    const int n = 24;
+    seedRandom(false, 7);
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    Configuration configuration(coordinates, randomElements(n*n), possibleTypes());
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+    SimulationTimer timer;
+
+    const std::vector<int> particles_before = configuration.particlesPerType();
+    const std::vector<std::vector<std::string> > elements_before = configuration.elements();
+
+    SublatticeModel model(configuration, timer, lattice_map, interactions, 4, 0.2);
+    CPPUNIT_ASSERT_EQUAL( model.nBlocks(), 64 );
+
+    // Run and check that events were performed and the time propagated.
+    const int n_cycles = 50;
+    const long n_events = model.runCycles(n_cycles);
+    CPPUNIT_ASSERT( n_events > 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( timer.simulationTime(), n_cycles * 0.2, 1.0e-10 );
+
+    // The hopping conserves the number of atoms.
+    const std::vector<int> particles_after = configuration.particlesPerType();
+    CPPUNIT_ASSERT( particles_before == particles_after );
+
+    // The configuration has changed.
+    CPPUNIT_ASSERT( elements_before != configuration.elements() );
+
+    // With the boundaries reconciled after each window the matching is
+    // the same as a fresh matching of the final configuration.
+    Configuration reference_configuration(coordinates, configuration.elements(), possibleTypes());
+    SimulationTimer reference_timer;
+    LatticeModel reference(reference_configuration, reference_timer, lattice_map, interactions);
+    CPPUNIT_ASSERT_EQUAL( model.totalAvailableSites(), reference.interactions().totalAvailableSites() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( model.totalRate(), reference.interactions().totalRate(), 1.0e-10 );
+
+    for (size_t p = 0; p < reference.interactions().processes().size(); ++p)
+    {
+        const Process & reference_process = (*reference.interactions().processes()[p]);
+        for (int index = 0; index < n*n; ++index)
+        {
+            const Process & process = (*model.blockInteractions(model.blockOfIndex(index)).processes()[p]);
+            CPPUNIT_ASSERT_EQUAL( process.isListed(index), reference_process.isListed(index) );
+        }
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SublatticeModel::testThreadCountIndependence()
+{
+    // Each block is seeded from the main stream, so the trajectory does
+    // not depend on the number of threads.
+    const int n = 12;
+    const std::vector<std::vector<double> > coordinates = squareCoordinates(n);
+    const LatticeMap lattice_map = squareLatticeMap(n);
+    const Interactions interactions(hoppingProcesses(), true);
+
+    seedRandom(false, 11);
+    Configuration configuration1(coordinates, randomElements(n*n), possibleTypes());
+    SimulationTimer timer1;
+    SublatticeModel model1(configuration1, timer1, lattice_map, interactions, 1, 0.3);
+    const long n_events1 = model1.runCycles(20);
+
+    seedRandom(false, 11);
+    Configuration configuration2(coordinates, randomElements(n*n), possibleTypes());
+    SimulationTimer timer2;
+    SublatticeModel model2(configuration2, timer2, lattice_map, interactions, 5, 0.3);
+    const long n_events2 = model2.runCycles(20);
+
+    CPPUNIT_ASSERT_EQUAL( n_events1, n_events2 );
+    CPPUNIT_ASSERT( configuration1.elements() == configuration2.elements() );
+    CPPUNIT_ASSERT( configuration1.atomID() == configuration2.atomID() );
+}
@@ -0,0 +1,41 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_SUBLATTICEMODEL__
+#define __TEST_SUBLATTICEMODEL__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_SublatticeModel : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_SublatticeModel );
+    CPPUNIT_TEST( testConstruction );
+    CPPUNIT_TEST( testPartition );
+    CPPUNIT_TEST( testRunCycles );
+    CPPUNIT_TEST( testThreadCountIndependence );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testConstruction();
+    void testPartition();
+    void testRunCycles();
+    void testThreadCountIndependence();
+
+};
+
+#endif
+
@@ -0,0 +1,239 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_sumtree.h"
+
+// Include the files to test.
+#include "sumtree.h"
+
+#include "random.h"
+
+#include <cmath>
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testConstruction()
+{
+    // Default construction gives an empty tree.
+    SumTree empty;
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(empty.size()), 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( empty.total(), 0.0, 1.0e-14 );
+
+    // Construct with a size.
+    SumTree tree(13);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.size()), 13 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 0.0, 1.0e-14 );
+
+    for (size_t i = 0; i < tree.size(); ++i)
+    {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.value(i), 0.0, 1.0e-14 );
+    }
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testUpdateAndSum()
+{
+    // Setup a tree of odd size to cover the incomplete branches.
+    SumTree tree(7);
+    const double values[7] = {1.0, 0.5, 0.0, 3.25, 2.0, 0.0, 7.0};
+
+    for (int i = 0; i < 7; ++i)
+    {
+        tree.update(i, values[i]);
+    }
+
+    // Check the partial sums against a reference.
+    double ref = 0.0;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.partialSum(0), 0.0, 1.0e-14 );
+    for (int i = 0; i < 7; ++i)
+    {
+        ref += values[i];
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.partialSum(i+1), ref, 1.0e-12 );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.value(i), values[i], 1.0e-14 );
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 13.75, 1.0e-12 );
+
+    // Change a weight and check that the difference propagates.
+    tree.update(3, 1.25);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 11.75, 1.0e-12 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.partialSum(3), 1.5, 1.0e-12 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.partialSum(4), 2.75, 1.0e-12 );
+
+    // Rebuilding does not change the sums.
+    tree.rebuild();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 11.75, 1.0e-12 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.partialSum(4), 2.75, 1.0e-12 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testResize()
+{
+    SumTree tree(3);
+    tree.update(0, 1.0);
+    tree.update(1, 2.0);
+    tree.update(2, 3.0);
+
+    // Grow the tree, new slots are zero.
+    tree.resize(9);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.size()), 9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 6.0, 1.0e-12 );
+    tree.update(8, 4.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 10.0, 1.0e-12 );
+
+    // Shrink it again.
+    tree.resize(2);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.size()), 2 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 3.0, 1.0e-12 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testPushAndPop()
+{
+    // Grow a tree one slot at a time and compare with a reference sum.
+    SumTree tree;
+    double ref = 0.0;
+    for (int i = 0; i < 37; ++i)
+    {
+        const double value = 0.5 * (i % 5) + 0.25;
+        tree.push_back(value);
+        ref += value;
+
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.size()), i+1 );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), ref, 1.0e-12 );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.value(i), value, 1.0e-14 );
+    }
+
+    // The partial sums are identical to those of a rebuilt tree.
+    SumTree rebuilt = tree;
+    rebuilt.rebuild();
+    for (size_t i = 0; i <= tree.size(); ++i)
+    {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.partialSum(i), rebuilt.partialSum(i), 1.0e-12 );
+    }
+
+    // The search works on the grown tree.
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(0.1)), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(tree.partialSum(20) + 0.1)), 20 );
+
+    // Shrink it again.
+    for (int i = 36; i >= 0; --i)
+    {
+        ref -= tree.value(i);
+        tree.pop_back();
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.size()), i );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), ref, 1.0e-12 );
+    }
+
+    // Push on the emptied tree and clear.
+    tree.push_back(3.0);
+    tree.push_back(1.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 4.0, 1.0e-12 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(3.5)), 1 );
+
+    tree.clear();
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.size()), 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( tree.total(), 0.0, 1.0e-14 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testSearch()
+{
+    SumTree tree(6);
+    tree.update(0, 1.0);
+    tree.update(1, 0.0);
+    tree.update(2, 2.0);
+    tree.update(3, 0.0);
+    tree.update(4, 0.0);
+    tree.update(5, 1.0);
+
+    // Check the search at and around the slot boundaries.
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(0.0)),   0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(0.999)), 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(1.0)),   2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(2.999)), 2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(3.0)),   5 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(3.999)), 5 );
+
+    // A target at or beyond the total gives the last slot with weight.
+    tree.update(5, 0.0);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(3.0)),   2 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(100.0)), 2 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testSearchRoundOff()
+{
+    // Setting weights back to zero leaves round-off in the partial sums,
+    // here a total larger than the sum of the remaining weights.
+    SumTree tree(4);
+    tree.update(0, 0.1);
+    tree.update(1, 0.2);
+    tree.update(2, 0.7);
+    tree.update(3, 0.1);
+    tree.update(2, 0.0);
+    tree.update(3, 0.0);
+    CPPUNIT_ASSERT( tree.total() > tree.value(0) + tree.value(1) );
+
+    // A target in the round-off never gives a slot with zero weight.
+    const double target = std::nextafter(tree.total(), 0.0);
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(target)), 1 );
+
+    // Zero weight slots are skipped forward to the next slot with weight.
+    tree.update(3, 0.5);
+    for (int i = 0; i < 1000; ++i)
+    {
+        const size_t slot = tree.search(i * tree.total() / 1000.0);
+        CPPUNIT_ASSERT( tree.value(slot) > 0.0 );
+    }
+
+    // The same after a rebuild.
+    tree.rebuild();
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(0.31)), 3 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(tree.search(0.29)), 1 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_SumTree::testSearchDistribution()
+{
+    // Setup a tree with known weights.
+    SumTree tree(5);
+    tree.update(0, 1.0);
+    tree.update(1, 4.0);
+    tree.update(2, 0.0);
+    tree.update(3, 2.0);
+    tree.update(4, 3.0);
+
+    seedRandom(false, 113);
+    std::vector<int> picked(5, 0);
+    const int n_loop = 1000000;
+    for (int i = 0; i < n_loop; ++i)
+    {
+        ++picked[tree.search(randomDouble01() * tree.total())];
+    }
+
+    // The slots should be picked proportional to their weights.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[0]/n_loop, 0.1, 1.0e-2 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[1]/n_loop, 0.4, 1.0e-2 );
+    CPPUNIT_ASSERT_EQUAL( picked[2], 0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[3]/n_loop, 0.2, 1.0e-2 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0*picked[4]/n_loop, 0.3, 1.0e-2 );
+}
@@ -0,0 +1,45 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_SUMTREE__
+#define __TEST_SUMTREE__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_SumTree : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_SumTree );
+    CPPUNIT_TEST( testConstruction );
+    CPPUNIT_TEST( testUpdateAndSum );
+    CPPUNIT_TEST( testResize );
+    CPPUNIT_TEST( testPushAndPop );
+    CPPUNIT_TEST( testSearch );
+    CPPUNIT_TEST( testSearchRoundOff );
+    CPPUNIT_TEST( testSearchDistribution );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testConstruction();
+    void testUpdateAndSum();
+    void testResize();
+    void testPushAndPop();
+    void testSearch();
+    void testSearchRoundOff();
+    void testSearchDistribution();
+};
+
+#endif
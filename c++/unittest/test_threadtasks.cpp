@@ -0,0 +1,191 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Include the test definition.
+#include "test_threadtasks.h"
+
+// Include the files to test.
+#include "threadtasks.h"
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ThreadTasks::testRunOnThreads()
+{
+    // Run more tasks than threads, each writing its own slot.
+    const int n_tasks = 37;
+    std::vector<int> results(n_tasks, 0);
+    std::vector<std::thread::id> ids(n_tasks);
+
+    runOnThreads(4, n_tasks, [&](const int task)
+                 {
+                     results[task] += task * task;
+                     ids[task] = std::this_thread::get_id();
+                 });
+
+    // Each task is run exactly once and never on the calling thread.
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( results[i], i * i );
+        CPPUNIT_ASSERT( ids[i] != std::this_thread::get_id() );
+    }
+
+    // More threads than tasks, and no tasks at all.
+    results = std::vector<int>(3, 0);
+    runOnThreads(8, 3, [&](const int task) { results[task] = 1; });
+    CPPUNIT_ASSERT_EQUAL( results[0] + results[1] + results[2], 3 );
+
+    runOnThreads(2, 0, [&](const int task) { results[task] = 2; });
+    CPPUNIT_ASSERT_EQUAL( results[0] + results[1] + results[2], 3 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ThreadTasks::testThreadPool()
+{
+    // An empty pool starts its threads when first run.
+    ThreadPool pool;
+    CPPUNIT_ASSERT_EQUAL( pool.size(), 0 );
+
+    const int n_tasks = 23;
+    std::vector<int> results(n_tasks, 0);
+    std::vector<std::thread::id> ids(n_tasks);
+    std::set<std::thread::id> used_ids;
+
+    pool.run(3, n_tasks, [&](const int task)
+             {
+                 results[task] += task;
+                 ids[task] = std::this_thread::get_id();
+             });
+    CPPUNIT_ASSERT_EQUAL( pool.size(), 3 );
+
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( results[i], i );
+        CPPUNIT_ASSERT( ids[i] != std::this_thread::get_id() );
+    }
+
+    // The threads of the pool run the tasks of later calls.
+    for (int run = 0; run < 50; ++run)
+    {
+        pool.run(3, n_tasks, [&](const int task)
+                 {
+                     results[task] += task;
+                     ids[task] = std::this_thread::get_id();
+                 });
+
+        used_ids.insert(ids.begin(), ids.end());
+    }
+    CPPUNIT_ASSERT_EQUAL( pool.size(), 3 );
+    CPPUNIT_ASSERT( used_ids.size() <= 3 );
+
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( results[i], 51 * i );
+    }
+
+    // Fewer threads, more threads and no tasks.
+    pool.run(1, n_tasks, [&](const int task) { results[task] = 1; });
+    CPPUNIT_ASSERT_EQUAL( pool.size(), 3 );
+    pool.run(5, n_tasks, [&](const int task) { results[task] += 1; });
+    CPPUNIT_ASSERT_EQUAL( pool.size(), 5 );
+    pool.run(5, 0, [&](const int task) { results[task] = 0; });
+
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( results[i], 2 );
+    }
+
+    // A copy does not share the threads.
+    ThreadPool copy(pool);
+    CPPUNIT_ASSERT_EQUAL( copy.size(), 0 );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ThreadTasks::testThreadPoolException()
+{
+    // An error in a pooled task is rethrown on the calling thread, after
+    // all the other tasks have been run.
+    ThreadPool pool;
+    const int n_tasks = 20;
+    std::vector<int> results(n_tasks, 0);
+
+    bool thrown = false;
+    try
+    {
+        pool.run(3, n_tasks, [&](const int task)
+                 {
+                     if (task == 7)
+                     {
+                         throw std::runtime_error("Error in task 7.");
+                     }
+                     results[task] = task;
+                 });
+    }
+    catch (const std::runtime_error & error)
+    {
+        thrown = true;
+        CPPUNIT_ASSERT_EQUAL( std::string(error.what()), std::string("Error in task 7.") );
+    }
+    CPPUNIT_ASSERT( thrown );
+
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( results[i], (i == 7 ? 0 : i) );
+    }
+
+    // The pool is still usable and does not throw again.
+    pool.run(3, n_tasks, [&](const int task) { results[task] = 2 * task; });
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( results[i], 2 * i );
+    }
+
+    // The same holds for the threads started for a single call.
+    CPPUNIT_ASSERT_THROW( runOnThreads(2, 4, [](const int task)
+                                       {
+                                           if (task == 3)
+                                           {
+                                               throw std::runtime_error("Error in task 3.");
+                                           }
+                                       }),
+                          std::runtime_error );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_ThreadTasks::testChunkStart()
+{
+    // The chunks cover all items without overlap and differ in size by
+    // at most one.
+    const size_t n_items = 103;
+    const int n_chunks = 7;
+
+    CPPUNIT_ASSERT_EQUAL( chunkStart(n_items, n_chunks, 0), static_cast<size_t>(0) );
+    CPPUNIT_ASSERT_EQUAL( chunkStart(n_items, n_chunks, n_chunks), n_items );
+
+    for (int chunk = 0; chunk < n_chunks; ++chunk)
+    {
+        const size_t size = chunkStart(n_items, n_chunks, chunk+1) - chunkStart(n_items, n_chunks, chunk);
+        CPPUNIT_ASSERT( size == n_items / n_chunks || size == n_items / n_chunks + 1 );
+    }
+
+    // Fewer items than chunks give empty chunks.
+    CPPUNIT_ASSERT_EQUAL( chunkStart(2, 4, 1), static_cast<size_t>(0) );
+    CPPUNIT_ASSERT_EQUAL( chunkStart(2, 4, 4), static_cast<size_t>(2) );
+}
@@ -0,0 +1,40 @@
+/*
+  Copyright (c)  2016  Mikael Leetmaa
+
+  This file is part of the KMCLib project distributed under the terms of the
+  GNU General Public License version 3, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TEST_THREADTASKS__
+#define __TEST_THREADTASKS__
+
+#include <iostream>
+#include <string>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestRunner.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class Test_ThreadTasks : public CppUnit::TestCase {
+
+public:
+
+    CPPUNIT_TEST_SUITE( Test_ThreadTasks );
+    CPPUNIT_TEST( testRunOnThreads );
+    CPPUNIT_TEST( testThreadPool );
+    CPPUNIT_TEST( testThreadPoolException );
+    CPPUNIT_TEST( testChunkStart );
+    CPPUNIT_TEST_SUITE_END();
+
+    void testRunOnThreads();
+    void testThreadPool();
+    void testThreadPoolException();
+    void testChunkStart();
+
+};
+
+#endif
@@ -12,6 +12,10 @@
 // Include the files to test.
 #include "typebucket.h"
 
+#include "allocationcounter.h"
+
+#include <vector>
+
 
 // -------------------------------------------------------------------------- //
 //
@@ -379,3 +383,92 @@ void Test_TypeBucket::testAdd()
     CPPUNIT_ASSERT_EQUAL(t3[2], t1[2] + t2[2]);
 
 }
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_TypeBucket::testSignature()
+{
+    // An empty bucket has no bits set.
+    TypeBucket tb(70);
+    CPPUNIT_ASSERT_EQUAL( tb.signature(), static_cast<TypeSignature>(0) );
+
+    // The wildcard slot is not included.
+    tb[0] = 1;
+    CPPUNIT_ASSERT_EQUAL( tb.signature(), static_cast<TypeSignature>(0) );
+
+    // Each occupied slot sets its bit, independent of the count.
+    tb[2] = 1;
+    tb[5] = 3;
+    CPPUNIT_ASSERT_EQUAL( tb.signature(), static_cast<TypeSignature>(4 + 32) );
+
+    // Slots past 63 wrap around.
+    tb[67] = 2;
+    CPPUNIT_ASSERT_EQUAL( tb.signature(), static_cast<TypeSignature>(4 + 8 + 32) );
+}
+
+
+// -------------------------------------------------------------------------- //
+//
+void Test_TypeBucket::testInlineStorage()
+{
+    // Small buckets are created, copied and added without allocating.
+    const long n_allocations = heapAllocations();
+    int sum = 0;
+    {
+        TypeBucket t1(TYPE_BUCKET_INLINE_SIZE);
+        t1[1] = 3;
+        TypeBucket t2(t1);
+        TypeBucket t3;
+        t3 = t2;
+        t3 = t1.add(t2);
+        sum = t3[1];
+    }
+    const long n_inline_allocations = heapAllocations() - n_allocations;
+    CPPUNIT_ASSERT_EQUAL( n_inline_allocations, 0L );
+    CPPUNIT_ASSERT_EQUAL( sum, 6 );
+
+    // Larger buckets are stored on the heap.
+    TypeBucket large(TYPE_BUCKET_INLINE_SIZE + 4);
+    CPPUNIT_ASSERT( heapAllocations() > n_allocations );
+    large[TYPE_BUCKET_INLINE_SIZE + 3] = 7;
+
+    // Copies own their storage, inline or not.
+    TypeBucket small(3);
+    small[2] = 5;
+    TypeBucket copy(small);
+    copy[2] = 1;
+    CPPUNIT_ASSERT_EQUAL( small[2], 5 );
+
+    TypeBucket large_copy(large);
+    large_copy[TYPE_BUCKET_INLINE_SIZE + 3] = 2;
+    CPPUNIT_ASSERT_EQUAL( large[TYPE_BUCKET_INLINE_SIZE + 3], 7 );
+
+    // Assignment between inline and heap storage in both directions.
+    copy = large;
+    CPPUNIT_ASSERT_EQUAL( copy.size(), TYPE_BUCKET_INLINE_SIZE + 4 );
+    CPPUNIT_ASSERT_EQUAL( copy[TYPE_BUCKET_INLINE_SIZE + 3], 7 );
+    CPPUNIT_ASSERT( copy == large );
+
+    large_copy = small;
+    CPPUNIT_ASSERT_EQUAL( large_copy.size(), 3 );
+    CPPUNIT_ASSERT( large_copy == small );
+
+    // Self assignment keeps the data.
+    TypeBucket & same = copy;
+    copy = same;
+    CPPUNIT_ASSERT( copy == large );
+
+    // Buckets in a vector stay valid when it grows.
+    std::vector<TypeBucket> buckets;
+    for (int i = 0; i < 100; ++i)
+    {
+        TypeBucket t(4);
+        t[3] = i;
+        buckets.push_back(t);
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL( buckets[i][3], i );
+    }
+}
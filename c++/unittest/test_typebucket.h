@@ -36,6 +36,8 @@ public:
     CPPUNIT_TEST( testComparisonOperator );
     CPPUNIT_TEST( testMatch );
     CPPUNIT_TEST( testAdd );
+    CPPUNIT_TEST( testSignature );
+    CPPUNIT_TEST( testInlineStorage );
     CPPUNIT_TEST_SUITE_END();
 
     void testDefaultConstruction();
@@ -51,6 +53,8 @@ public:
     void testComparisonOperator();
     void testMatch();
     void testAdd();
+    void testSignature();
+    void testInlineStorage();
 
 };
 
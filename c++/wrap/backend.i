@@ -12,9 +12,11 @@
 #pragma SWIG nowarn=389
 
 // Define the content of our modeule.
-%module(directors="1") Backend
+%module(directors="1", threads="1") Backend
 %{
 #include "latticemodel.h"
+#include "sublatticemodel.h"
+#include "ensemble.h"
 #include "latticemap.h"
 #include "configuration.h"
 #include "interactions.h"
@@ -23,14 +25,23 @@
 #include "coordinate.h"
 #include "matchlistentry.h"
 #include "typebucket.h"
+#include "sitestorage.h"
 #include "matchlist.h"
 #include "simulationtimer.h"
 #include "ratecalculator.h"
 #include "mpicommons.h"
 #include "ontheflymsd.h"
 #include "random.h"
+#include "allocationcounter.h"
 %}
 
+// Only release the GIL in the batched run loops. Director calls back into
+// Python, e.g. for custom rates, re-acquire it.
+%nothread;
+%thread LatticeModel::runSteps;
+%thread SublatticeModel::runCycles;
+%thread Ensemble::run;
+
 // Use directors on the RateCalculator for using the python callback.
 %feature("director") SimpleDummyBaseClass;
 %feature("director") RateCalculator;
@@ -73,9 +84,40 @@
 %template(StdVectorStdPairIntInt) std::vector<std::pair<int, int> >;
 %template(StdVectorTypeBucket) std::vector<TypeBucket>;
 
+// The type signatures and packed types are used in headers included
+// before typebucket.h.
+typedef unsigned long long TypeSignature;
+typedef std::vector<unsigned char> PackedTypes;
+
 // Include the definitions.
 %include "latticemodel.h"
+%include "sublatticemodel.h"
+%include "ensemble.h"
 %include "latticemap.h"
+%include "sitestorage.h"
+
+// This extends the SiteArray class with python indexing support.
+%extend SiteArray
+{
+    T __getitem__(unsigned int i)
+    {
+        // Check bounds.
+        if (i >= (*self).size())
+        {
+            throw std::out_of_range("SiteArray index out of range.");
+        }
+        return (*self)[i];
+    };
+
+    int __len__()
+    {
+        return (*self).size();
+    }
+};
+
+%template(SiteArrayCoordinate) SiteArray<Coordinate>;
+%template(SiteArrayInt) SiteArray<int>;
+
 %include "configuration.h"
 %include "interactions.h"
 %include "process.h"
@@ -88,8 +130,14 @@
 %include "ratecalculator.h"
 %include "mpicommons.h"
 %include "ontheflymsd.h"
+// The scoped random number streams are for use within the backend only.
+%ignore ScopedRandomStream;
 %include "random.h"
 
+// Only the query of the allocation counter is of use from Python.
+%ignore countHeapAllocation;
+%include "allocationcounter.h"
+
 
 // This extends the Coordinate class with python indexing support.
 %extend Coordinate
@@ -144,3 +192,22 @@
         return (*self).size();
     }
 };
+
+// This extends the TypeBucketArray class with python indexing support.
+%extend TypeBucketArray
+{
+    TypeBucket __getitem__(unsigned int i)
+    {
+        // Check bounds.
+        if (i >= (*self).size())
+        {
+            throw std::out_of_range("TypeBucketArray index out of range.");
+        }
+        return (*self)[i];
+    };
+
+    int __len__()
+    {
+        return (*self).size();
+    }
+};
@@ -22,7 +22,9 @@ class KMCControlParameters(object):
                  analysis_interval=None,
                  seed=None,
                  dump_time_interval=None,
-                 rng_type=None):
+                 rng_type=None,
+                 selection_engine=None,
+                 n_threads=None):
         """
         Constructuor for the KMCControlParameters object that
         holds all parameters controlling the flow of the KMC simulation.
@@ -71,6 +73,25 @@ class KMCControlParameters(object):
                          sure it works as you expect if you have a random device installed, since this
                          has not been tested with a random device by the KMCLib developers.
         :type rng_type: str
+
+        :param selection_engine: The algorithm used for picking a site within a
+                                 selected process, weighted by the site rates.
+
+                                 'SUM_TREE' for a binary indexed sum tree with O(log N)
+                                 cost per pick (Default),
+                                 'COMPOSITION_REJECTION' for composition-rejection over
+                                 power-of-two rate classes, with a cost per pick that is
+                                 independent of the number of sites. This pays off for
+                                 large systems with many sites per process.
+        :type selection_engine: str
+
+        :param n_threads: The number of backend threads used for matching sites with
+                          processes after each step. Rates from custom rate calculators
+                          are only evaluated on several threads if the calculator is
+                          implemented in C++ and reports itself as thread safe. The
+                          simulation result does not depend on the number of threads.
+                          The default value is 1.
+        :type n_threads: int
         """
         # Check and set the number of steps.
         self.__number_of_steps = checkPositiveInteger(number_of_steps,
@@ -111,6 +132,16 @@ class KMCControlParameters(object):
         # Check and set the random number generator type.
         self.__rng_type  = self.__checkRngType(rng_type, "MT")
 
+        # Check and set the site selection engine.
+        self.__selection_engine = self.__checkSelectionEngine(selection_engine, "SUM_TREE")
+
+        # Check and set the number of threads.
+        self.__n_threads = checkPositiveInteger(n_threads,
+                                                1,
+                                                "n_threads")
+        if self.__n_threads < 1:
+            raise Error("The parameter 'n_threads' must be at least 1.")
+
     def __checkRngType(self, rng_type, default):
         """
         Private helper function to check the random number generator input.
@@ -130,6 +161,22 @@ class KMCControlParameters(object):
 
         return rng_dict[rng_type]
 
+    def __checkSelectionEngine(self, selection_engine, default):
+        """
+        Private helper function to check the site selection engine input.
+        """
+        if selection_engine is None:
+            selection_engine = default
+
+        engine_dict = { "SUM_TREE"              : Backend.SUM_TREE,
+                        "COMPOSITION_REJECTION" : Backend.COMPOSITION_REJECTION,
+                        }
+
+        if not selection_engine in engine_dict.keys():
+            raise Error("'selection_engine' input must be one of 'SUM_TREE' or 'COMPOSITION_REJECTION'. Default is 'SUM_TREE'.")
+
+        return engine_dict[selection_engine]
+
     def numberOfSteps(self):
         """
         Query for the number of steps.
@@ -184,3 +231,14 @@ class KMCControlParameters(object):
         """
         return self.__rng_type
 
+    def selectionEngine(self):
+        """
+        Query for the site selection engine.
+        """
+        return self.__selection_engine
+
+    def numberOfThreads(self):
+        """
+        Query for the number of backend threads.
+        """
+        return self.__n_threads
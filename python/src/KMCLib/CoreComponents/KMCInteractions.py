@@ -242,6 +242,13 @@ the KMCRateCalculatorPlugin class itself. """
                     cache_rate = (self.__rate_calculator.cacheRates() and \
                                       not process_number in self.__rate_calculator.excludeFromCaching())
 
+                    # Get the rate upper bound for lazy rate evaluation.
+                    rate_upper_bound = self.__rate_calculator.rateUpperBound(process_number)
+                    if rate_upper_bound is None:
+                        rate_upper_bound = 0.0
+                    elif not rate_upper_bound > 0.0:
+                        raise Error("The rate upper bound of a process must be positive or None.")
+
                     cpp_processes.push_back(Backend.CustomRateProcess(cpp_config1,
                                                                       cpp_config2,
                                                                       rate_constant,
@@ -250,7 +257,8 @@ the KMCRateCalculatorPlugin class itself. """
                                                                       cpp_move_origins,
                                                                       cpp_move_vectors,
                                                                       process_number,
-                                                                      cache_rate))
+                                                                      cache_rate,
+                                                                      float(rate_upper_bound)))
                 else:
                     cpp_processes.push_back(Backend.Process(cpp_config1,
                                                             cpp_config2,
@@ -63,10 +63,16 @@ class KMCLatticeModel(object):
         # Set the verbosity level of output to minimal.
         self.__verbosity_level = 0
 
-    def _backend(self):
+    def _backend(self, selection_engine=None, n_threads=None):
         """
         Function for generating the C++ backend reperesentation of this object.
 
+        :param selection_engine: The backend site selection engine to use when the
+                                 backend is generated. Defaults to Backend.SUM_TREE.
+
+        :param n_threads: The number of backend threads to use for matching when the
+                          backend is generated. Defaults to 1.
+
         :returns: The C++ LatticeModel based on the parameters given to this class on construction.
         """
         if self.__backend is None:
@@ -79,11 +85,19 @@ class KMCLatticeModel(object):
             # Construct a timer.
             self.__cpp_timer = Backend.SimulationTimer()
 
+            if selection_engine is None:
+                selection_engine = Backend.SUM_TREE
+
+            if n_threads is None:
+                n_threads = 1
+
             # Construct the backend object.
             self.__backend = Backend.LatticeModel(cpp_config,
                                                   self.__cpp_timer,
                                                   cpp_lattice_map,
-                                                  cpp_interactions)
+                                                  cpp_interactions,
+                                                  selection_engine,
+                                                  n_threads)
         # Return.
         return self.__backend
 
@@ -161,7 +175,13 @@ must be given as string."""
         # Construct the C++ lattice model.
         prettyPrint(" KMCLib: setting up the backend C++ object.")
 
-        cpp_model = self._backend()
+        cpp_model = self._backend(control_parameters.selectionEngine(),
+                                  control_parameters.numberOfThreads())
+
+        # Report the time spent in each phase of the setup.
+        timings = cpp_model.setupTimings()
+        prettyPrint(" KMCLib: setup took %.3f s for match lists, %.3f s for wildcards, %.3f s for matching and %.3f s for the probability table."%(
+            timings.match_lists, timings.process_match_lists, timings.matching, timings.probability_table))
 
         # Print the initial matching information if above the verbosity threshold.
         if self.__verbosity_level > 9:
@@ -205,24 +225,31 @@ must be given as string."""
 
         # Run the KMC simulation.
         try:
-            # Loop over the steps.
+            # Loop over batches of steps, where each batch runs natively in
+            # the backend until the next step Python needs to act on.
             step = 0
             time_step = 0
             while(step < n_steps):
-                step += 1
 
-                # Check if it is possible to take a step.
-                nP = cpp_model.interactions().totalAvailableSites()
-                if nP == 0:
-                    raise Error("No more available processes.")
+                # Find the number of steps to the next dump, analysis or breaker step.
+                n_batch = n_steps - step
+                if dump_time is None:
+                    n_batch = min(n_batch, n_dump - step%n_dump)
+                n_batch = min(n_batch, n_analyse - step%n_analyse)
+                for b in breakers:
+                    n_batch = min(n_batch, b.interval() - step%b.interval())
 
-                # Take a step.
-                time_before = self.__cpp_timer.simulationTime()
-                cpp_model.propagateTime()
-                time_after  = self.__cpp_timer.simulationTime()
+                # Take the steps.
+                if dump_time is None:
+                    n_done = cpp_model.runSteps(n_batch)
+                else:
+                    n_done = cpp_model.runSteps(n_batch, dump_time, last_time)
+                step += n_done
 
                 # Check if it is time to dump the previous step to the equidistant trajectory.
-                if ((dump_time is not None) and ((time_after-last_time) >= dump_time)):
+                if cpp_model.stepPending():
+                    step += 1
+                    time_before = cpp_model.stepStartTime()
                     time_step += 1
                     sample_time = time_step * dump_time
                     prettyPrint(" KMCLib: %14i steps executed. time: %20.10e"%(step-1, sample_time))
@@ -234,8 +261,12 @@ must be given as string."""
                                           step             = step-1,
                                           configuration    = self.__configuration)
 
-                # Update the model.
-                cpp_model.singleStep()
+                    # Update the model to complete the step.
+                    cpp_model.singleStep()
+
+                # Check if the batch stopped since no step was possible.
+                elif n_done < n_batch:
+                    raise Error("No more available processes.")
 
                 # Get the current simulation time.
                 now = self.__cpp_timer.simulationTime()
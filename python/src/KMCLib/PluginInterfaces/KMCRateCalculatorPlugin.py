@@ -168,7 +168,20 @@ class KMCRateCalculatorPlugin(Backend.RateCalculator):
         """
         return ()
 
+    def rateUpperBound(self, process_number):
+        """
+        Method for giving an upper bound of the custom rates of a process.
+        If a bound is given the sites of the process are listed with the
+        bound as rate, and the custom rate function is only called when a
+        site is selected. The event is then accepted with probability
+        rate/bound, and otherwise counted as a null event that only advances
+        the time. This can reduce the number of rate function calls by orders
+        of magnitude. Overload for custom behavior.
 
+        :param process_number: The number of the process to get the bound for.
+        :type process_number: int
 
-
-
+        :returns: The rate upper bound, or None for evaluating all rates directly. Defaults to None.
+        :rtype: float
+        """
+        return None
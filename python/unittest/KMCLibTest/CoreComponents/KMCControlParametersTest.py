@@ -76,6 +76,35 @@ class KMCControlParametersTest(unittest.TestCase):
         self.assertRaises( Error,
                            lambda : KMCControlParameters(rng_type=123))
 
+    def testSelectionEngineInput(self):
+        """ Test all valid values of the selection_engine parameter. """
+        control_params = KMCControlParameters()
+        self.assertEqual(control_params.selectionEngine(), Backend.SUM_TREE)
+
+        control_params = KMCControlParameters(selection_engine='SUM_TREE')
+        self.assertEqual(control_params.selectionEngine(), Backend.SUM_TREE)
+
+        control_params = KMCControlParameters(selection_engine='COMPOSITION_REJECTION')
+        self.assertEqual(control_params.selectionEngine(), Backend.COMPOSITION_REJECTION)
+
+        # Wrong value.
+        self.assertRaises( Error,
+                           lambda : KMCControlParameters(selection_engine='ABC'))
+
+    def testNumberOfThreadsInput(self):
+        """ Test the n_threads parameter. """
+        control_params = KMCControlParameters()
+        self.assertEqual(control_params.numberOfThreads(), 1)
+
+        control_params = KMCControlParameters(n_threads=4)
+        self.assertEqual(control_params.numberOfThreads(), 4)
+
+        # Wrong values.
+        self.assertRaises( Error,
+                           lambda : KMCControlParameters(n_threads=0))
+        self.assertRaises( Error,
+                           lambda : KMCControlParameters(n_threads=2.0))
+
     def testConstructionAndQuery2(self):
         """ Test the construction of the control parametes object with a dump time interval """
         # Non-default construction.
@@ -1571,6 +1571,24 @@ STEP 1000
             ref_ta = [[(1, 'A')],[(2,'A'), (1, 'B')],[]]
             self.assertEqual(interactions.rateCalculator().global_types_after, ref_ta)
 
+    def testStepAllocations(self):
+        """ Test that steady-state stepping does not allocate. """
+        # Construct the model.
+        model = getValidModel()
+        cpp_model = model._backend()
+
+        # The allocations are only counted with the COUNT_ALLOCATIONS option.
+        if cpp_model.nStepAllocations() < 0:
+            self.skipTest("The backend does not count the allocations.")
+
+        # Let the work storage grow to the largest sizes needed.
+        self.assertEqual(cpp_model.runSteps(5000), 5000)
+
+        # Further steps do not allocate.
+        n_allocations = cpp_model.nStepAllocations()
+        self.assertEqual(cpp_model.runSteps(5000), 5000)
+        self.assertEqual(cpp_model.nStepAllocations() - n_allocations, 0)
+
     def testBackend(self):
         """ Test that the backend object is correctly constructed. """
         # Construct the model.
@@ -52,6 +52,12 @@ class KMCRateCalculatorPluginTest(unittest.TestCase):
         self.assertTrue(hasattr(rc, "cutoff"))
         self.assertTrue(rc.cutoff() is None)
 
+    def testRateUpperBound(self):
+        """ Test that the base class has the rate upper bound function. """
+        rc = KMCRateCalculatorPlugin("DummyConfig")
+        self.assertTrue(hasattr(rc, "rateUpperBound"))
+        self.assertTrue(rc.rateUpperBound(0) is None)
+
     def testUsage(self):
         """ Test that the KMCRateCalculatorPlugin can be used in a simulation. """
         # To get the random numbers and process numbers returned.